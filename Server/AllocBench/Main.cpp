@@ -0,0 +1,277 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+/**
+ * Measures what building ProjectM::Actor frames costs in allocation, for each place a
+ * FlatBufferBuilder can get its buffer from:
+ *
+ *   malloc         a new builder per message on flatbuffers' DefaultAllocator (new[]/delete[])
+ *   pool           a new builder per message on FPooledFrameAllocator, the size-classed pool
+ *   arena          a new builder per message on the thread's FFrameArena
+ *   arena+escape   as arena, with the finished frame copied out by FFrameArena::Escape
+ *   builders       FBuilderPool as the client and server use it, on the size-classed pool
+ *   builders+arena FBuilderPool with SetFrameArena
+ *
+ * Messages are built in ticks of --tick frames that are all held, as a send queue would hold
+ * them, and freed at the end of the tick, after which the arena is Reset. "arena" and
+ * "builders+arena" leave the frames in the arena, as if they were all sent within the tick;
+ * "arena+escape" pays for a copy that would survive any tick. Modes alternate within each
+ * round and the median round is reported.
+ *
+ * Build from this directory:
+ *
+ *   g++ -std=c++14 -O2 -pthread -I../../Source/SocketSample -I../../Source/SocketSample/flatbuffer/include \
+ *       Main.cpp -o AllocBench
+ *
+ * Usage: AllocBench [--messages 200000] [--rounds 9] [--tick 256] [--snapshot 32] [--initial 1024]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "FrameBuilder.h"
+#include "FrameArena.h"
+#include "BuilderPool.h"
+#include "ProjectM_generated.h"
+
+namespace
+{
+	enum class EMode
+	{
+		Malloc,
+		Pool,
+		Arena,
+		ArenaEscape,
+		Builders,
+		BuildersArena,
+		Count
+	};
+
+	const char* const ModeNames[] = { "malloc", "pool", "arena", "arena+escape", "builders", "builders+arena" };
+
+	/** What to build next and the data to build it from, generated outside the timed section. */
+	struct FMessage
+	{
+		MsgId Id;
+
+		uint64_t Actor;
+
+		std::vector<uint64_t> Ids;
+
+		std::vector<ProjectM::Actor::Transform> Transforms;
+	};
+
+	/** 40% moves, 20% snapshots, 10% each of spawns, destroys, pongs and logins. */
+	std::vector<FMessage> MakeMessages(int32_t NumMessages, int32_t SnapshotSize)
+	{
+		std::mt19937 Random(11);
+		std::uniform_int_distribution<int32_t> Kind(0, 9);
+		std::uniform_int_distribution<uint64_t> Actor(1, 100000);
+		std::uniform_real_distribution<float> Coordinate(-5000.f, 5000.f);
+
+		auto AddActors = [&](FMessage& Message, int32_t Count)
+		{
+			for (int32_t i = 0; i < Count; ++i)
+			{
+				Message.Ids.push_back(Actor(Random));
+				Message.Transforms.push_back(ProjectM::Actor::Transform(ProjectM::Actor::Vec3(Coordinate(Random), Coordinate(Random), 90.f),
+					ProjectM::Actor::Vec3(0.f, Coordinate(Random) / 30.f, 0.f), ProjectM::Actor::Vec3(1.f, 1.f, 1.f)));
+			}
+		};
+
+		std::vector<FMessage> Messages(NumMessages);
+		for (FMessage& Message : Messages)
+		{
+			const int32_t Roll = Kind(Random);
+			Message.Actor = Actor(Random);
+			if (Roll < 4)
+			{
+				Message.Id = MsgId::S2C_SyncLocation;
+				AddActors(Message, 1);
+			}
+			else if (Roll < 6)
+			{
+				Message.Id = MsgId::S2C_WorldSnapshot;
+				AddActors(Message, SnapshotSize);
+			}
+			else if (Roll < 7)
+			{
+				Message.Id = MsgId::S2C_SpawnActors;
+				AddActors(Message, 8);
+			}
+			else if (Roll < 8)
+			{
+				Message.Id = MsgId::S2C_DestroyActor;
+			}
+			else if (Roll < 9)
+			{
+				Message.Id = MsgId::S2C_Pong;
+			}
+			else
+			{
+				Message.Id = MsgId::S2C_Login;
+			}
+		}
+		return Messages;
+	}
+
+	void Build(flatbuffers::FlatBufferBuilder& fbb, const FMessage& Message)
+	{
+		switch (Message.Id)
+		{
+		case MsgId::S2C_SyncLocation:
+			FinishFrame(fbb, Message.Id, ProjectM::Actor::CreateS2C_SyncLocation(fbb, Message.Actor, &Message.Transforms[0]));
+			break;
+		case MsgId::S2C_WorldSnapshot:
+			FinishFrame(fbb, Message.Id, ProjectM::Actor::CreateS2C_WorldSnapshotDirect(fbb, static_cast<uint32_t>(Message.Actor), &Message.Ids, &Message.Transforms));
+			break;
+		case MsgId::S2C_SpawnActors:
+			FinishFrame(fbb, Message.Id, ProjectM::Actor::CreateS2C_SpawnActorsDirect(fbb, &Message.Ids, &Message.Transforms));
+			break;
+		case MsgId::S2C_DestroyActor:
+			FinishFrame(fbb, Message.Id, ProjectM::Actor::CreateS2C_DestroyActor(fbb, Message.Actor));
+			break;
+		case MsgId::S2C_Pong:
+			FinishFrame(fbb, Message.Id, ProjectM::Actor::CreateS2C_Pong(fbb, Message.Actor, Message.Actor + 1, Message.Actor + 2));
+			break;
+		default:
+			FinishFrame(fbb, Message.Id, ProjectM::Actor::CreateS2C_Login(fbb, Message.Actor));
+			break;
+		}
+	}
+
+	flatbuffers::DetachedBuffer BuildOne(EMode Mode, const FMessage& Message, size_t InitialSize)
+	{
+		if (Mode == EMode::Builders || Mode == EMode::BuildersArena)
+		{
+			FBuilderPool::FHandle fbb = FBuilderPool::Get().Acquire(Message.Id);
+			Build(*fbb, Message);
+			return fbb.Release();
+		}
+
+		flatbuffers::Allocator* Allocator = nullptr;
+		if (Mode == EMode::Pool)
+		{
+			Allocator = &FPooledFrameAllocator::Get();
+		}
+		else if (Mode == EMode::Arena || Mode == EMode::ArenaEscape)
+		{
+			Allocator = &FFrameArena::Get();
+		}
+
+		flatbuffers::FlatBufferBuilder fbb(InitialSize, Allocator);
+		Build(fbb, Message);
+		if (Mode == EMode::ArenaEscape)
+		{
+			return FFrameArena::Escape(fbb.Release());
+		}
+		return fbb.Release();
+	}
+
+	/** Nanoseconds per message for one pass over Messages. */
+	double RunPass(EMode Mode, const std::vector<FMessage>& Messages, int32_t TickSize, size_t InitialSize, uint64_t& Checksum)
+	{
+		FBuilderPool::Get().SetFrameArena(Mode == EMode::BuildersArena ? &FFrameArena::Get() : nullptr);
+
+		std::vector<flatbuffers::DetachedBuffer> Tick;
+		Tick.reserve(TickSize);
+
+		const std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < Messages.size(); ++i)
+		{
+			Tick.push_back(BuildOne(Mode, Messages[i], InitialSize));
+
+			if (Tick.size() == static_cast<size_t>(TickSize) || i + 1 == Messages.size())
+			{
+				for (const flatbuffers::DetachedBuffer& Frame : Tick)
+				{
+					Checksum += Frame.size();
+				}
+				Tick.clear();
+				FFrameArena::Get().Reset();
+			}
+		}
+		return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - Start).count() / Messages.size();
+	}
+}
+
+int main(int argc, char** argv)
+{
+	int32_t NumMessages = 200000;
+	int32_t Rounds = 9;
+	int32_t TickSize = 256;
+	int32_t SnapshotSize = 32;
+	size_t InitialSize = 1024;
+
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (strcmp(argv[i], "--messages") == 0)
+		{
+			NumMessages = atoi(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "--rounds") == 0)
+		{
+			Rounds = atoi(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "--tick") == 0)
+		{
+			TickSize = std::max(1, atoi(argv[i + 1]));
+		}
+		else if (strcmp(argv[i], "--snapshot") == 0)
+		{
+			SnapshotSize = atoi(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "--initial") == 0)
+		{
+			InitialSize = static_cast<size_t>(atoi(argv[i + 1]));
+		}
+		else
+		{
+			fprintf(stderr, "Unknown option %s\n", argv[i]);
+			return 1;
+		}
+	}
+
+	const std::vector<FMessage> Messages = MakeMessages(NumMessages, SnapshotSize);
+	const int32_t NumModes = static_cast<int32_t>(EMode::Count);
+	uint64_t Checksum = 0;
+
+	// Warm every pool and arena before anything is measured.
+	for (int32_t Mode = 0; Mode < NumModes; ++Mode)
+	{
+		RunPass(static_cast<EMode>(Mode), Messages, TickSize, InitialSize, Checksum);
+	}
+
+	std::vector<std::vector<double>> Times(NumModes);
+	for (int32_t Round = 0; Round < Rounds; ++Round)
+	{
+		for (int32_t Mode = 0; Mode < NumModes; ++Mode)
+		{
+			Times[Mode].push_back(RunPass(static_cast<EMode>(Mode), Messages, TickSize, InitialSize, Checksum));
+		}
+	}
+
+	auto Median = [](std::vector<double> Values)
+	{
+		std::sort(Values.begin(), Values.end());
+		return Values[Values.size() / 2];
+	};
+
+	const double Baseline = Median(Times[0]);
+	printf("%d messages x %d rounds, %d per tick, %d-actor snapshots, %zu-byte initial buffers, median round:\n",
+		NumMessages, Rounds, TickSize, SnapshotSize, InitialSize);
+	for (int32_t Mode = 0; Mode < NumModes; ++Mode)
+	{
+		const double Time = Median(Times[Mode]);
+		printf("  %-15s %8.1f ns/message  %+6.1f%%\n", ModeNames[Mode], Time, (Time - Baseline) / Baseline * 100.0);
+	}
+	printf("arena peak %zu bytes per tick, %zu chunks pinned at the last reset\n",
+		FFrameArena::Get().GetPeakFrameBytes(), FFrameArena::Get().GetNumPinnedChunks());
+	printf("(checksum %llu)\n", static_cast<unsigned long long>(Checksum));
+
+	return 0;
+}
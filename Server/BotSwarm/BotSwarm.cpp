@@ -0,0 +1,603 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "BotSwarm.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "ProtocolCore.h"
+#include "ProjectM_generated.h"
+
+namespace
+{
+	const size_t NumIds = static_cast<size_t>(MsgId::MAX);
+
+	const size_t MinRecvSize = 16 * 1024;
+
+	const size_t MaxEvents = 256;
+
+	/**
+	 * Bots never roll, so a C2S_SyncLocation carries its send time in the roll angle: microseconds
+	 * modulo 2^24, which a float holds exactly. Whoever receives the rebroadcast S2C_SyncLocation
+	 * gets the one-way bot -> server -> bot latency without any protocol change, as long as it
+	 * stays under 16 seconds.
+	 */
+	const uint64_t StampModulus = 1ull << 24;
+
+	uint64_t NowMicroseconds()
+	{
+		return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	float EncodeStamp(uint64_t Now)
+	{
+		return static_cast<float>(Now % StampModulus);
+	}
+
+	uint64_t GetStampAge(uint64_t Now, float Stamp)
+	{
+		return (Now % StampModulus + StampModulus - static_cast<uint64_t>(Stamp)) % StampModulus;
+	}
+
+	void Count(FBotMessageStats& Stats, size_t Bytes)
+	{
+		Stats.Count.fetch_add(1, std::memory_order_relaxed);
+		Stats.Bytes.fetch_add(Bytes, std::memory_order_relaxed);
+	}
+}
+
+FBotThread::FBotThread(const FBotSwarmSettings& InSettings, int32_t InFirstBot, int32_t InNumBots, uint64_t InStartTime)
+	: Settings(InSettings)
+	, FirstBot(InFirstBot)
+	, StartTime(InStartTime)
+{
+	EpollFd = epoll_create1(EPOLL_CLOEXEC);
+
+	const float Spacing = Settings.Radius * 3.f;
+	const int32_t GridWidth = static_cast<int32_t>(std::ceil(std::sqrt(static_cast<double>(Settings.NumBots))));
+	for (int32_t i = 0; i < InNumBots; ++i)
+	{
+		const int32_t BotIndex = FirstBot + i;
+		std::unique_ptr<FBot> Bot(new FBot());
+		Bot->Index = BotIndex;
+		Bot->CenterX = (BotIndex % GridWidth) * Spacing;
+		Bot->CenterY = (BotIndex / GridWidth) * Spacing;
+		Bot->Phase = static_cast<float>(BotIndex) * 2.399963f; // golden angle, so neighbours are out of step
+		Bot->ConnectTime = StartTime + static_cast<uint64_t>(Settings.RampUp * 1e6 * BotIndex / Settings.NumBots);
+		Bots.push_back(std::move(Bot));
+	}
+}
+
+FBotThread::~FBotThread()
+{
+	for (std::unique_ptr<FBot>& Bot : Bots)
+	{
+		if (Bot->Socket >= 0)
+		{
+			close(Bot->Socket);
+		}
+	}
+	close(EpollFd);
+}
+
+void FBotThread::Run()
+{
+	const uint64_t EndTime = StartTime + static_cast<uint64_t>(Settings.Duration * 1e6);
+	const uint64_t SendInterval = Settings.SendRate > 0.0 ? static_cast<uint64_t>(1e6 / Settings.SendRate) : 0;
+	size_t NextToConnect = 0;
+	epoll_event Events[MaxEvents];
+
+	for (uint64_t Now = NowMicroseconds(); Now < EndTime; Now = NowMicroseconds())
+	{
+		while (NextToConnect < Bots.size() && Bots[NextToConnect]->ConnectTime <= Now)
+		{
+			Connect(*Bots[NextToConnect++], Now);
+		}
+
+		if (SendInterval > 0)
+		{
+			for (std::unique_ptr<FBot>& Bot : Bots)
+			{
+				if (Bot->ActorUID != 0 && Bot->Socket >= 0 && Bot->NextSendTime <= Now)
+				{
+					SendMove(*Bot, Now);
+					// Skip sends missed while the thread was busy instead of bursting them.
+					Bot->NextSendTime = Bot->NextSendTime + SendInterval > Now ? Bot->NextSendTime + SendInterval : Now + SendInterval;
+				}
+			}
+		}
+
+		const int32_t NumEvents = epoll_wait(EpollFd, Events, MaxEvents, 1);
+		Now = NowMicroseconds();
+		for (int32_t i = 0; i < NumEvents; ++i)
+		{
+			FBot& Bot = *static_cast<FBot*>(Events[i].data.ptr);
+			if (Bot.Socket < 0)
+			{
+				continue;
+			}
+
+			if (Bot.bConnecting)
+			{
+				int Error = 0;
+				socklen_t Length = sizeof(Error);
+				getsockopt(Bot.Socket, SOL_SOCKET, SO_ERROR, &Error, &Length);
+				if (Error != 0)
+				{
+					Fail(Bot);
+					continue;
+				}
+				OnConnected(Bot, Now);
+				continue;
+			}
+
+			if (Events[i].events & EPOLLIN)
+			{
+				Read(Bot, Now);
+			}
+			else if (Events[i].events & (EPOLLERR | EPOLLHUP))
+			{
+				Fail(Bot);
+			}
+
+			if (Bot.Socket >= 0 && (Events[i].events & EPOLLOUT))
+			{
+				Write(Bot);
+			}
+		}
+	}
+}
+
+void FBotThread::Connect(FBot& Bot, uint64_t Now)
+{
+	Bot.Socket = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (Bot.Socket < 0)
+	{
+		Stats.Errors.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	const int Enable = 1;
+	setsockopt(Bot.Socket, IPPROTO_TCP, TCP_NODELAY, &Enable, sizeof(Enable));
+
+	sockaddr_in Address = {};
+	Address.sin_family = AF_INET;
+	Address.sin_port = htons(Settings.Port);
+	inet_pton(AF_INET, Settings.Host.c_str(), &Address.sin_addr);
+
+	if (connect(Bot.Socket, reinterpret_cast<sockaddr*>(&Address), sizeof(Address)) == 0)
+	{
+		UpdateInterest(Bot, true);
+		OnConnected(Bot, Now);
+		return;
+	}
+
+	if (errno != EINPROGRESS)
+	{
+		close(Bot.Socket);
+		Bot.Socket = -1;
+		Stats.Errors.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	Bot.bConnecting = true;
+	UpdateInterest(Bot, true);
+}
+
+void FBotThread::OnConnected(FBot& Bot, uint64_t Now)
+{
+	Bot.bConnecting = false;
+	UpdateInterest(Bot, false);
+	Stats.Connected.fetch_add(1, std::memory_order_relaxed);
+
+	char Token[32];
+	snprintf(Token, sizeof(Token), "bot%d", Bot.Index);
+	Bot.LoginSentTime = Now;
+	Bot.bAwaitingSpawnList = true;
+	Send(Bot, ProtocolCore::MakeLogin(Token), MsgId::C2S_Login);
+}
+
+void FBotThread::Read(FBot& Bot, uint64_t Now)
+{
+	for (;;)
+	{
+		uint8_t* Buffer = Bot.Decoder.GetWriteBuffer(MinRecvSize);
+		const ssize_t Received = recv(Bot.Socket, Buffer, Bot.Decoder.GetWritableSize(), 0);
+		if (Received > 0)
+		{
+			Bot.Decoder.CommitWrite(static_cast<size_t>(Received));
+			continue;
+		}
+
+		if (Received == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+		{
+			Fail(Bot);
+			return;
+		}
+		break;
+	}
+
+	FFrameView View;
+	while (Bot.Decoder.Next(View))
+	{
+		ProtocolCore::UnpackFrame(View, [this, &Bot, Now](MsgId Id, const uint8_t* Data, size_t Size)
+		{
+			HandleMessage(Bot, Id, Data, Size, Now);
+		});
+	}
+
+	if (Bot.Decoder.HasError())
+	{
+		Fail(Bot);
+	}
+}
+
+void FBotThread::HandleMessage(FBot& Bot, MsgId Id, const uint8_t* Data, size_t Size, uint64_t Now)
+{
+	const size_t Index = static_cast<size_t>(Id);
+	if (Index >= NumIds)
+	{
+		Stats.Errors.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	FBotMessageStats& MessageStats = Stats.Received[Index];
+	Count(MessageStats, Size + FFrameHeader::Size);
+
+	switch (Id)
+	{
+	case MsgId::S2C_Login:
+		if (Bot.ActorUID == 0)
+		{
+			Bot.ActorUID = flatbuffers::GetRoot<ProjectM::Actor::S2C_Login>(Data)->actor_id();
+			Stats.LoggedIn.fetch_add(1, std::memory_order_relaxed);
+			MessageStats.Latency.Record(Now - Bot.LoginSentTime);
+
+			// Spread the first sends over one interval so the bots do not move in lockstep.
+			const double Interval = Settings.SendRate > 0.0 ? 1e6 / Settings.SendRate : 0.0;
+			Bot.NextSendTime = Now + static_cast<uint64_t>(Interval * std::fmod(Bot.Phase, 1.f));
+		}
+		break;
+
+	case MsgId::S2C_SpawnActors:
+		if (Bot.bAwaitingSpawnList && Bot.ActorUID != 0)
+		{
+			Bot.bAwaitingSpawnList = false;
+			MessageStats.Latency.Record(Now - Bot.LoginSentTime);
+		}
+		break;
+
+	case MsgId::S2C_SyncLocation:
+	{
+		const ProjectM::Actor::Transform* Transform = flatbuffers::GetRoot<ProjectM::Actor::S2C_SyncLocation>(Data)->transform();
+		if (Transform)
+		{
+			MessageStats.Actors.fetch_add(1, std::memory_order_relaxed);
+			MessageStats.Latency.Record(GetStampAge(Now, Transform->rotation().z()));
+		}
+		break;
+	}
+
+	case MsgId::S2C_WorldSnapshot:
+	{
+		const flatbuffers::Vector<const ProjectM::Actor::Transform*>* Transforms = flatbuffers::GetRoot<ProjectM::Actor::S2C_WorldSnapshot>(Data)->transform();
+		if (Transforms)
+		{
+			MessageStats.Actors.fetch_add(Transforms->size(), std::memory_order_relaxed);
+			for (const ProjectM::Actor::Transform* Transform : *Transforms)
+			{
+				MessageStats.Latency.Record(GetStampAge(Now, Transform->rotation().z()));
+			}
+		}
+		break;
+	}
+
+	case MsgId::S2C_CompactSnapshot:
+	{
+		// Quantisation drops the stamp in the roll, so no latency. Decoded and acked like the
+		// client does, so the server keeps delta-encoding against what this bot holds.
+		const ProjectM::Actor::S2C_CompactSnapshot* Snapshot = flatbuffers::GetRoot<ProjectM::Actor::S2C_CompactSnapshot>(Data);
+		const flatbuffers::Vector<uint64_t>* Ids = Snapshot->actor_id();
+		const flatbuffers::Vector<uint8_t>* Bits = Snapshot->data();
+		if (Ids == nullptr || Bits == nullptr)
+		{
+			break;
+		}
+
+		FBitReader Reader(Bits->data(), Bits->size());
+		for (flatbuffers::uoffset_t i = 0; i < Ids->size(); ++i)
+		{
+			FQuantizedTransform State;
+			if (!TransformCodec::Decode(Reader, State, Bot.Baselines.Find(Ids->Get(i), Snapshot->baseline_tick())))
+			{
+				Stats.Errors.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+			Bot.Baselines.Record(Ids->Get(i), Snapshot->server_tick(), State);
+		}
+
+		MessageStats.Actors.fetch_add(Ids->size(), std::memory_order_relaxed);
+		Send(Bot, ProtocolCore::MakeSnapshotAck(Snapshot->server_tick()), MsgId::C2S_SnapshotAck);
+		break;
+	}
+
+	case MsgId::S2C_DestroyActor:
+		Bot.Baselines.Remove(flatbuffers::GetRoot<ProjectM::Actor::S2C_DestroyActor>(Data)->actor_id());
+		break;
+
+	default:
+		break;
+	}
+}
+
+void FBotThread::SendMove(FBot& Bot, uint64_t Now)
+{
+	const float Time = static_cast<float>((Now - StartTime) / 1e6);
+	const float Angle = Bot.Phase + Settings.Speed / Settings.Radius * Time;
+	const float RadToDeg = 57.2957795f;
+
+	const ProjectM::Actor::Transform Transform(
+		ProjectM::Actor::Vec3(Bot.CenterX + Settings.Radius * std::cos(Angle), Bot.CenterY + Settings.Radius * std::sin(Angle), 100.f),
+		ProjectM::Actor::Vec3(0.f, std::fmod(Angle * RadToDeg + 90.f, 360.f), EncodeStamp(Now)),
+		ProjectM::Actor::Vec3(1.f, 1.f, 1.f));
+
+	Send(Bot, ProtocolCore::MakeSyncLocation(Bot.ActorUID, Transform), MsgId::C2S_SyncLocation);
+}
+
+void FBotThread::Send(FBot& Bot, const flatbuffers::DetachedBuffer& Frame, MsgId Id)
+{
+	Count(Stats.Sent[static_cast<size_t>(Id)], Frame.size());
+
+	const uint8_t* Data = Frame.data();
+	size_t Size = Frame.size();
+
+	if (Bot.OutputOffset == Bot.Output.size())
+	{
+		const ssize_t Sent = send(Bot.Socket, Data, Size, MSG_NOSIGNAL);
+		if (Sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+		{
+			Fail(Bot);
+			return;
+		}
+		if (Sent > 0)
+		{
+			Data += Sent;
+			Size -= static_cast<size_t>(Sent);
+		}
+	}
+
+	if (Size > 0)
+	{
+		Bot.Output.insert(Bot.Output.end(), Data, Data + Size);
+		if (!Bot.bWantsWrite)
+		{
+			Bot.bWantsWrite = true;
+			UpdateInterest(Bot, false);
+		}
+	}
+}
+
+void FBotThread::Write(FBot& Bot)
+{
+	while (Bot.OutputOffset < Bot.Output.size())
+	{
+		const ssize_t Sent = send(Bot.Socket, Bot.Output.data() + Bot.OutputOffset, Bot.Output.size() - Bot.OutputOffset, MSG_NOSIGNAL);
+		if (Sent > 0)
+		{
+			Bot.OutputOffset += static_cast<size_t>(Sent);
+			continue;
+		}
+		if (Sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+		{
+			return;
+		}
+		Fail(Bot);
+		return;
+	}
+
+	Bot.Output.clear();
+	Bot.OutputOffset = 0;
+	if (Bot.bWantsWrite)
+	{
+		Bot.bWantsWrite = false;
+		UpdateInterest(Bot, false);
+	}
+}
+
+void FBotThread::Fail(FBot& Bot)
+{
+	Stats.Errors.fetch_add(1, std::memory_order_relaxed);
+	if (!Bot.bConnecting)
+	{
+		Stats.Connected.fetch_sub(1, std::memory_order_relaxed);
+	}
+	if (Bot.ActorUID != 0)
+	{
+		Stats.LoggedIn.fetch_sub(1, std::memory_order_relaxed);
+	}
+
+	epoll_ctl(EpollFd, EPOLL_CTL_DEL, Bot.Socket, nullptr);
+	close(Bot.Socket);
+	Bot.Socket = -1;
+	Bot.ActorUID = 0;
+	Bot.bConnecting = false;
+}
+
+void FBotThread::UpdateInterest(FBot& Bot, bool bAdd)
+{
+	epoll_event Event = {};
+	Event.events = EPOLLIN | (Bot.bConnecting || Bot.bWantsWrite ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+	Event.data.ptr = &Bot;
+	epoll_ctl(EpollFd, bAdd ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, Bot.Socket, &Event);
+}
+
+FBotSwarm::FBotSwarm(const FBotSwarmSettings& InSettings)
+	: Settings(InSettings)
+{
+	if (Settings.NumThreads <= 0)
+	{
+		Settings.NumThreads = static_cast<int32_t>(std::thread::hardware_concurrency());
+		Settings.NumThreads = Settings.NumThreads > 0 ? Settings.NumThreads : 1;
+	}
+	Settings.NumThreads = Settings.NumThreads < Settings.NumBots ? Settings.NumThreads : (Settings.NumBots > 0 ? Settings.NumBots : 1);
+}
+
+void FBotSwarm::Run(double ReportInterval)
+{
+	const uint64_t StartTime = NowMicroseconds();
+
+	int32_t FirstBot = 0;
+	for (int32_t Index = 0; Index < Settings.NumThreads; ++Index)
+	{
+		const int32_t NumBots = Settings.NumBots / Settings.NumThreads + (Index < Settings.NumBots % Settings.NumThreads ? 1 : 0);
+		Threads.emplace_back(new FBotThread(Settings, FirstBot, NumBots, StartTime));
+		FirstBot += NumBots;
+	}
+
+	std::vector<std::thread> Workers;
+	for (std::unique_ptr<FBotThread>& Thread : Threads)
+	{
+		FBotThread* ThreadPtr = Thread.get();
+		Workers.emplace_back([ThreadPtr]() { ThreadPtr->Run(); });
+	}
+
+	uint64_t LastReport = StartTime;
+	uint64_t LastSent = 0;
+	uint64_t LastReceived = 0;
+	for (;;)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		const uint64_t Now = NowMicroseconds();
+		const bool bDone = Now >= StartTime + static_cast<uint64_t>(Settings.Duration * 1e6);
+		if (!bDone && Now - LastReport < static_cast<uint64_t>(ReportInterval * 1e6))
+		{
+			continue;
+		}
+
+		int64_t Connected = 0, LoggedIn = 0;
+		uint64_t Sent = 0, Received = 0;
+		FLatencyHistogram::FCounts SyncLatency;
+		for (std::unique_ptr<FBotThread>& Thread : Threads)
+		{
+			FBotThreadStats& Stats = Thread->GetStats();
+			Connected += Stats.Connected.load(std::memory_order_relaxed);
+			LoggedIn += Stats.LoggedIn.load(std::memory_order_relaxed);
+			for (size_t Index = 0; Index < NumIds; ++Index)
+			{
+				Sent += Stats.Sent[Index].Count.load(std::memory_order_relaxed);
+				Received += Stats.Received[Index].Count.load(std::memory_order_relaxed);
+			}
+
+			FLatencyHistogram::FCounts Counts;
+			Stats.Received[static_cast<size_t>(MsgId::S2C_SyncLocation)].Latency.Take(Counts, false);
+			SyncLatency.Merge(Counts);
+		}
+
+		const double Interval = (Now - LastReport) / 1e6;
+		fprintf(stderr, "%6.1fs | connected %" PRId64 " logged in %" PRId64 " | sent %.0f msg/s | received %.0f msg/s | S2C_SyncLocation us p50 %.0f p99 %.0f\n",
+			(Now - StartTime) / 1e6, Connected, LoggedIn, (Sent - LastSent) / Interval, (Received - LastReceived) / Interval,
+			static_cast<double>(SyncLatency.Percentile(0.5)), static_cast<double>(SyncLatency.Percentile(0.99)));
+
+		LastReport = Now;
+		LastSent = Sent;
+		LastReceived = Received;
+		if (bDone)
+		{
+			break;
+		}
+	}
+
+	for (std::thread& Worker : Workers)
+	{
+		Worker.join();
+	}
+	Elapsed = (NowMicroseconds() - StartTime) / 1e6;
+}
+
+std::string FBotSwarm::GetSummaryJson() const
+{
+	std::string Json;
+	char Line[512];
+
+	int64_t Connected = 0, LoggedIn = 0;
+	uint64_t Errors = 0;
+	for (const std::unique_ptr<FBotThread>& Thread : Threads)
+	{
+		FBotThreadStats& Stats = Thread->GetStats();
+		Connected += Stats.Connected.load(std::memory_order_relaxed);
+		LoggedIn += Stats.LoggedIn.load(std::memory_order_relaxed);
+		Errors += Stats.Errors.load(std::memory_order_relaxed);
+	}
+
+	snprintf(Line, sizeof(Line),
+		"{\n  \"host\": \"%s\",\n  \"port\": %u,\n  \"bots\": %d,\n  \"threads\": %d,\n  \"send_rate_hz\": %.2f,\n  \"duration_s\": %.3f,\n"
+		"  \"connected\": %" PRId64 ",\n  \"logged_in\": %" PRId64 ",\n  \"errors\": %" PRIu64 ",\n",
+		Settings.Host.c_str(), static_cast<unsigned>(Settings.Port), Settings.NumBots, Settings.NumThreads, Settings.SendRate, Elapsed,
+		Connected, LoggedIn, Errors);
+	Json += Line;
+
+	for (int32_t Direction = 0; Direction < 2; ++Direction)
+	{
+		Json += Direction == 0 ? "  \"sent\": {" : ",\n  \"received\": {";
+		bool bFirst = true;
+		for (size_t Index = 0; Index < NumIds; ++Index)
+		{
+			uint64_t Count = 0, Bytes = 0, Actors = 0;
+			FLatencyHistogram::FCounts Latency;
+			for (const std::unique_ptr<FBotThread>& Thread : Threads)
+			{
+				FBotMessageStats& Stats = Direction == 0 ? Thread->GetStats().Sent[Index] : Thread->GetStats().Received[Index];
+				Count += Stats.Count.load(std::memory_order_relaxed);
+				Bytes += Stats.Bytes.load(std::memory_order_relaxed);
+				Actors += Stats.Actors.load(std::memory_order_relaxed);
+
+				FLatencyHistogram::FCounts Counts;
+				Stats.Latency.Take(Counts, false);
+				Latency.Merge(Counts);
+			}
+			if (Count == 0)
+			{
+				continue;
+			}
+
+			snprintf(Line, sizeof(Line), "%s\n    \"%s\": { \"count\": %" PRIu64 ", \"bytes\": %" PRIu64 ", \"per_second\": %.1f",
+				bFirst ? "" : ",", ProtocolCore::GetMsgIdName(static_cast<MsgId>(Index)), Count, Bytes, Elapsed > 0.0 ? Count / Elapsed : 0.0);
+			Json += Line;
+			bFirst = false;
+
+			if (Actors > 0 && LoggedIn > 0 && Elapsed > 0.0)
+			{
+				// What one bot spends per second on each actor it is kept up to date about.
+				const double PerActor = static_cast<double>(Bytes) / Actors;
+				snprintf(Line, sizeof(Line), ", \"actors\": %" PRIu64 ", \"bytes_per_actor\": %.2f, \"bytes_per_actor_per_second\": %.1f",
+					Actors, PerActor, PerActor * Count / (LoggedIn * Elapsed));
+				Json += Line;
+			}
+
+			if (Latency.Total > 0)
+			{
+				snprintf(Line, sizeof(Line),
+					", \"latency_us\": { \"samples\": %" PRIu64 ", \"p50\": %" PRIu64 ", \"p90\": %" PRIu64 ", \"p99\": %" PRIu64 ", \"p999\": %" PRIu64 ", \"max\": %" PRIu64 " }",
+					Latency.Total, Latency.Percentile(0.5), Latency.Percentile(0.9), Latency.Percentile(0.99), Latency.Percentile(0.999), Latency.Max);
+				Json += Line;
+			}
+			Json += " }";
+		}
+		Json += bFirst ? "}" : "\n  }";
+	}
+
+	Json += "\n}\n";
+	return Json;
+}
@@ -0,0 +1,174 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "flatbuffers/flatbuffers.h"
+
+#include "MsgId.h"
+#include "FrameDecoder.h"
+#include "TransformCodec.h"
+
+#include "LatencyHistogram.h"
+
+struct FBotSwarmSettings
+{
+	std::string Host = "127.0.0.1";
+
+	uint16_t Port = 9810;
+
+	int32_t NumBots = 100;
+
+	/** 0 means one thread per hardware thread. */
+	int32_t NumThreads = 0;
+
+	/** Seconds to run after the first connection. */
+	double Duration = 30.0;
+
+	/** Seconds over which connections are spread, to avoid a SYN flood at startup. */
+	double RampUp = 1.0;
+
+	/** C2S_SyncLocation per bot per second. */
+	double SendRate = 20.0;
+
+	/** Bots walk circles of this radius (cm) at this speed (cm/s). */
+	float Radius = 500.f;
+
+	float Speed = 300.f;
+};
+
+/** Counters and latency histograms for one MsgId. Written by one bot thread, read by the reporter. */
+struct FBotMessageStats
+{
+	std::atomic<uint64_t> Count{ 0 };
+
+	std::atomic<uint64_t> Bytes{ 0 };
+
+	/** Actor transforms carried, for the messages that carry them. */
+	std::atomic<uint64_t> Actors{ 0 };
+
+	/** Only messages whose latency can be measured are recorded; see FBotThread::HandleMessage. */
+	FLatencyHistogram Latency;
+};
+
+struct FBotThreadStats
+{
+	std::atomic<int64_t> Connected{ 0 };
+
+	std::atomic<int64_t> LoggedIn{ 0 };
+
+	std::atomic<uint64_t> Errors{ 0 };
+
+	FBotMessageStats Sent[static_cast<size_t>(MsgId::MAX)];
+
+	FBotMessageStats Received[static_cast<size_t>(MsgId::MAX)];
+};
+
+struct FBot
+{
+	/** Position in the whole swarm, also used for the login token. */
+	int32_t Index = 0;
+
+	int Socket = -1;
+
+	bool bConnecting = false;
+
+	uint64_t ActorUID = 0;
+
+	FFrameDecoder Decoder{ 64 * 1024 };
+
+	std::vector<uint8_t> Output;
+
+	size_t OutputOffset = 0;
+
+	bool bWantsWrite = false;
+
+	/** Microseconds on the swarm clock. */
+	uint64_t ConnectTime = 0;
+
+	uint64_t LoginSentTime = 0;
+
+	/** The first S2C_SpawnActors after login answers it and is timed against LoginSentTime. */
+	bool bAwaitingSpawnList = false;
+
+	uint64_t NextSendTime = 0;
+
+	float CenterX = 0.f;
+
+	float CenterY = 0.f;
+
+	float Phase = 0.f;
+
+	/** Decoded S2C_CompactSnapshot states, as the client keeps them. */
+	FTransformBaselineHistory Baselines;
+};
+
+/** Drives a share of the bots from one epoll loop. */
+class FBotThread
+{
+public:
+	FBotThread(const FBotSwarmSettings& InSettings, int32_t InFirstBot, int32_t InNumBots, uint64_t InStartTime);
+	~FBotThread();
+
+	/** Thread body. Returns once the swarm's duration is over. */
+	void Run();
+
+	FBotThreadStats& GetStats() { return Stats; }
+
+private:
+	void Connect(FBot& Bot, uint64_t Now);
+
+	void OnConnected(FBot& Bot, uint64_t Now);
+
+	void Read(FBot& Bot, uint64_t Now);
+
+	void HandleMessage(FBot& Bot, MsgId Id, const uint8_t* Data, size_t Size, uint64_t Now);
+
+	void SendMove(FBot& Bot, uint64_t Now);
+
+	void Send(FBot& Bot, const flatbuffers::DetachedBuffer& Frame, MsgId Id);
+
+	void Write(FBot& Bot);
+
+	void Fail(FBot& Bot);
+
+	void UpdateInterest(FBot& Bot, bool bAdd);
+
+	const FBotSwarmSettings& Settings;
+
+	int32_t FirstBot;
+
+	uint64_t StartTime;
+
+	int EpollFd = -1;
+
+	std::vector<std::unique_ptr<FBot>> Bots;
+
+	FBotThreadStats Stats;
+};
+
+/** Owns the bot threads and aggregates their stats. */
+class FBotSwarm
+{
+public:
+	explicit FBotSwarm(const FBotSwarmSettings& InSettings);
+
+	/** Runs the whole swarm, printing a progress line every ReportInterval seconds. */
+	void Run(double ReportInterval);
+
+	/** Machine-readable results of the run. */
+	std::string GetSummaryJson() const;
+
+private:
+	FBotSwarmSettings Settings;
+
+	std::vector<std::unique_ptr<FBotThread>> Threads;
+
+	double Elapsed = 0.0;
+};
@@ -0,0 +1,112 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+/**
+ * Headless bot swarm: opens N client connections from a few threads, logs each one in and
+ * walks it in circles, sending C2S_SyncLocation at a fixed rate, using the same protocol core
+ * as the game client (ProtocolCore.h). Linux only, runs against any local server, such as
+ * Server/ReferenceServer.
+ *
+ * Build from this directory:
+ *
+ *   g++ -std=c++14 -O2 -pthread -I. -I../Common -I../../Source/SocketSample -I../../Source/SocketSample/flatbuffer/include \
+ *       Main.cpp BotSwarm.cpp -o BotSwarm
+ *
+ * Usage: BotSwarm [--host 127.0.0.1] [--port 9810] [--bots 100] [--threads N] [--duration 30]
+ *                 [--ramp-up 1] [--rate 20] [--radius 500] [--speed 300] [--interval 1] [--json path]
+ *
+ * Progress goes to stderr. At the end a JSON summary is written to --json, or stdout, with
+ * per-MsgId counts, bytes and rates in each direction and, where it can be measured, receive
+ * latency percentiles in microseconds:
+ *   S2C_Login        round trip from sending C2S_Login
+ *   S2C_SpawnActors  round trip from sending C2S_Login, for the spawn list answering it
+ *   S2C_SyncLocation one way from the sending bot to every receiving bot
+ *   S2C_WorldSnapshot one way, per transform, when the server runs with --relevancy
+ * Messages carrying transforms also report how many they carried, the bytes per transform, and
+ * bytes per second per actor a bot is kept up to date about. Compare a server run with
+ * --relevancy against one with --relevancy --compact to see what S2C_CompactSnapshot saves.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "BotSwarm.h"
+
+int main(int argc, char** argv)
+{
+	FBotSwarmSettings Settings;
+	double Interval = 1.0;
+	const char* JsonPath = nullptr;
+
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		const char* Name = argv[i];
+		const char* Value = argv[i + 1];
+		if (strcmp(Name, "--host") == 0)
+		{
+			Settings.Host = Value;
+		}
+		else if (strcmp(Name, "--port") == 0)
+		{
+			Settings.Port = static_cast<uint16_t>(atoi(Value));
+		}
+		else if (strcmp(Name, "--bots") == 0)
+		{
+			Settings.NumBots = atoi(Value);
+		}
+		else if (strcmp(Name, "--threads") == 0)
+		{
+			Settings.NumThreads = atoi(Value);
+		}
+		else if (strcmp(Name, "--duration") == 0)
+		{
+			Settings.Duration = atof(Value);
+		}
+		else if (strcmp(Name, "--ramp-up") == 0)
+		{
+			Settings.RampUp = atof(Value);
+		}
+		else if (strcmp(Name, "--rate") == 0)
+		{
+			Settings.SendRate = atof(Value);
+		}
+		else if (strcmp(Name, "--radius") == 0)
+		{
+			Settings.Radius = static_cast<float>(atof(Value));
+		}
+		else if (strcmp(Name, "--speed") == 0)
+		{
+			Settings.Speed = static_cast<float>(atof(Value));
+		}
+		else if (strcmp(Name, "--interval") == 0)
+		{
+			Interval = atof(Value);
+		}
+		else if (strcmp(Name, "--json") == 0)
+		{
+			JsonPath = Value;
+		}
+		else
+		{
+			fprintf(stderr, "Unknown option %s\n", Name);
+			return 1;
+		}
+	}
+
+	FBotSwarm Swarm(Settings);
+	Swarm.Run(Interval);
+
+	const std::string Summary = Swarm.GetSummaryJson();
+	FILE* Out = JsonPath ? fopen(JsonPath, "w") : stdout;
+	if (Out == nullptr)
+	{
+		perror(JsonPath);
+		return 1;
+	}
+	fputs(Summary.c_str(), Out);
+	if (Out != stdout)
+	{
+		fclose(Out);
+	}
+	return 0;
+}
@@ -0,0 +1,174 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+/**
+ * Cold against pooled FlatBufferBuilders, ns per message, for every ProjectM::Actor message:
+ *
+ *   cold    a new flatbuffers::FlatBufferBuilder per message, as Login() and Move() used to
+ *   pooled  FBuilderPool::Get().Acquire(Id), as ProtocolCore and the server build today
+ *
+ * Both finish the frame with FinishFrame, take it with Release() and free it, so the only
+ * difference is where the builder and its buffer come from. Snapshot messages carry
+ * --snapshot actors. Modes alternate within each round and the median round is reported.
+ *
+ * Build from this directory:
+ *
+ *   g++ -std=c++14 -O2 -pthread -I../../Source/SocketSample -I../../Source/SocketSample/flatbuffer/include Main.cpp -o BuilderPoolBench
+ *
+ * Usage: BuilderPoolBench [--messages 100000] [--rounds 9] [--snapshot 32]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "FrameBuilder.h"
+#include "BuilderPool.h"
+#include "ProtocolCore.h"
+#include "ProjectM_generated.h"
+
+namespace
+{
+	std::vector<uint64_t> SnapshotIds;
+
+	std::vector<ProjectM::Actor::Transform> SnapshotTransforms;
+
+	std::vector<uint8_t> SnapshotBits;
+
+	uint64_t Checksum = 0;
+
+	void Build(flatbuffers::FlatBufferBuilder& fbb, MsgId Id, uint64_t Index)
+	{
+		const ProjectM::Actor::Transform Transform(ProjectM::Actor::Vec3(static_cast<float>(Index % 1000), 0.f, 100.f),
+			ProjectM::Actor::Vec3(0.f, 90.f, 0.f), ProjectM::Actor::Vec3(1.f, 1.f, 1.f));
+
+		switch (Id)
+		{
+		case MsgId::C2S_Login:
+			FinishFrame(fbb, Id, ProjectM::Actor::CreateC2S_Login(fbb, fbb.CreateString("bot-00042")));
+			break;
+		case MsgId::S2C_Login:
+			FinishFrame(fbb, Id, ProjectM::Actor::CreateS2C_Login(fbb, Index));
+			break;
+		case MsgId::S2C_SpawnActors:
+			FinishFrame(fbb, Id, ProjectM::Actor::CreateS2C_SpawnActorsDirect(fbb, &SnapshotIds, &SnapshotTransforms));
+			break;
+		case MsgId::S2C_DestroyActor:
+			FinishFrame(fbb, Id, ProjectM::Actor::CreateS2C_DestroyActor(fbb, Index));
+			break;
+		case MsgId::C2S_SyncLocation:
+			FinishFrame(fbb, Id, ProjectM::Actor::CreateC2S_SyncLocation(fbb, Index, &Transform));
+			break;
+		case MsgId::S2C_SyncLocation:
+			FinishFrame(fbb, Id, ProjectM::Actor::CreateS2C_SyncLocation(fbb, Index, &Transform));
+			break;
+		case MsgId::S2C_WorldSnapshot:
+			FinishFrame(fbb, Id, ProjectM::Actor::CreateS2C_WorldSnapshotDirect(fbb, static_cast<uint32_t>(Index), &SnapshotIds, &SnapshotTransforms));
+			break;
+		case MsgId::S2C_CompactSnapshot:
+			FinishFrame(fbb, Id, ProjectM::Actor::CreateS2C_CompactSnapshotDirect(fbb, static_cast<uint32_t>(Index), static_cast<uint32_t>(Index - 1), &SnapshotIds, &SnapshotBits));
+			break;
+		case MsgId::C2S_SnapshotAck:
+			FinishFrame(fbb, Id, ProjectM::Actor::CreateC2S_SnapshotAck(fbb, static_cast<uint32_t>(Index)));
+			break;
+		case MsgId::C2S_Ping:
+			FinishFrame(fbb, Id, ProjectM::Actor::CreateC2S_Ping(fbb, Index));
+			break;
+		case MsgId::S2C_Pong:
+			FinishFrame(fbb, Id, ProjectM::Actor::CreateS2C_Pong(fbb, Index, Index + 1, Index + 2));
+			break;
+		default:
+			break;
+		}
+	}
+
+	double MeasureCold(MsgId Id, uint64_t NumMessages, size_t& OutSize)
+	{
+		const std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+		for (uint64_t Index = 0; Index < NumMessages; ++Index)
+		{
+			flatbuffers::FlatBufferBuilder fbb;
+			Build(fbb, Id, Index);
+			const flatbuffers::DetachedBuffer Frame = fbb.Release();
+			Checksum += Frame.data()[0];
+			OutSize = Frame.size();
+		}
+		return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - Start).count() / NumMessages;
+	}
+
+	double MeasurePooled(MsgId Id, uint64_t NumMessages)
+	{
+		const std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+		for (uint64_t Index = 0; Index < NumMessages; ++Index)
+		{
+			FBuilderPool::FHandle fbb = FBuilderPool::Get().Acquire(Id);
+			Build(*fbb, Id, Index);
+			const flatbuffers::DetachedBuffer Frame = fbb.Release();
+			Checksum += Frame.data()[0];
+		}
+		return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - Start).count() / NumMessages;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	uint64_t NumMessages = 100000;
+	int32_t Rounds = 9;
+	int32_t SnapshotSize = 32;
+
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (strcmp(argv[i], "--messages") == 0)
+		{
+			NumMessages = static_cast<uint64_t>(std::max(1LL, atoll(argv[i + 1])));
+		}
+		else if (strcmp(argv[i], "--rounds") == 0)
+		{
+			Rounds = std::max(1, atoi(argv[i + 1]));
+		}
+		else if (strcmp(argv[i], "--snapshot") == 0)
+		{
+			SnapshotSize = std::max(1, atoi(argv[i + 1]));
+		}
+		else
+		{
+			fprintf(stderr, "Unknown option %s\n", argv[i]);
+			return 1;
+		}
+	}
+
+	for (int32_t Actor = 0; Actor < SnapshotSize; ++Actor)
+	{
+		SnapshotIds.push_back(static_cast<uint64_t>(Actor + 1));
+		SnapshotTransforms.emplace_back(ProjectM::Actor::Vec3(Actor * 100.f, 0.f, 100.f), ProjectM::Actor::Vec3(0.f, 0.f, 0.f), ProjectM::Actor::Vec3(1.f, 1.f, 1.f));
+		// Roughly what a compact entry for a walking actor costs.
+		SnapshotBits.insert(SnapshotBits.end(), 6, static_cast<uint8_t>(Actor));
+	}
+
+	printf("%llu messages x %d rounds, %d-actor snapshots, median round:\n", static_cast<unsigned long long>(NumMessages), Rounds, SnapshotSize);
+	printf("  %-20s %8s %12s %12s %8s\n", "message", "bytes", "cold ns", "pooled ns", "saved");
+	for (uint16_t Value = 1; Value < static_cast<uint16_t>(MsgId::MAX); ++Value)
+	{
+		const MsgId Id = static_cast<MsgId>(Value);
+
+		std::vector<double> ColdTimes;
+		std::vector<double> PooledTimes;
+		size_t Size = 0;
+		for (int32_t Round = 0; Round < Rounds; ++Round)
+		{
+			ColdTimes.push_back(MeasureCold(Id, NumMessages, Size));
+			PooledTimes.push_back(MeasurePooled(Id, NumMessages));
+		}
+		std::sort(ColdTimes.begin(), ColdTimes.end());
+		std::sort(PooledTimes.begin(), PooledTimes.end());
+
+		const double Cold = ColdTimes[ColdTimes.size() / 2];
+		const double Pooled = PooledTimes[PooledTimes.size() / 2];
+		printf("  %-20s %8zu %12.1f %12.1f %7.0f%%\n", ProtocolCore::GetMsgIdName(Id), Size, Cold, Pooled, (Cold - Pooled) / Cold * 100.0);
+	}
+	printf("(checksum %llu)\n", static_cast<unsigned long long>(Checksum));
+
+	return 0;
+}
@@ -0,0 +1,129 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Log-linear latency histogram: 8 linear sub-buckets per power of two, so any recorded value
+ * is reported within 12.5%. One thread records, any thread may Take() the counts; buckets are
+ * relaxed atomics, so recording costs a couple of instructions and never blocks.
+ */
+class FLatencyHistogram
+{
+public:
+	static const uint32_t SubBucketBits = 3;
+
+	static const uint32_t SubBucketCount = 1u << SubBucketBits;
+
+	static const size_t NumBuckets = (64 - SubBucketBits + 1) * SubBucketCount;
+
+	/** Plain copy of the counts, for computing percentiles off the recording thread. */
+	struct FCounts
+	{
+		uint64_t Buckets[NumBuckets] = {};
+
+		uint64_t Total = 0;
+
+		uint64_t Max = 0;
+
+		void Merge(const FCounts& Other)
+		{
+			for (size_t i = 0; i < NumBuckets; ++i)
+			{
+				Buckets[i] += Other.Buckets[i];
+			}
+			Total += Other.Total;
+			Max = Other.Max > Max ? Other.Max : Max;
+		}
+
+		/** Upper bound of the bucket holding the Quantile (0..1) value, clamped to the largest recorded value. */
+		uint64_t Percentile(double Quantile) const
+		{
+			if (Total == 0)
+			{
+				return 0;
+			}
+
+			const uint64_t Rank = static_cast<uint64_t>(Quantile * static_cast<double>(Total - 1)) + 1;
+			uint64_t Seen = 0;
+			for (size_t i = 0; i < NumBuckets; ++i)
+			{
+				Seen += Buckets[i];
+				if (Seen >= Rank)
+				{
+					const uint64_t Upper = GetBucketUpperBound(i);
+					return Upper < Max ? Upper : Max;
+				}
+			}
+			return Max;
+		}
+	};
+
+	FLatencyHistogram()
+	{
+		for (std::atomic<uint64_t>& Bucket : Buckets)
+		{
+			Bucket.store(0, std::memory_order_relaxed);
+		}
+	}
+
+	/** Single recording thread only. */
+	void Record(uint64_t Value)
+	{
+		std::atomic<uint64_t>& Bucket = Buckets[GetBucketIndex(Value)];
+		Bucket.store(Bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		if (Value > Max.load(std::memory_order_relaxed))
+		{
+			Max.store(Value, std::memory_order_relaxed);
+		}
+	}
+
+	/** Copies the counts into Out and, if bReset, starts a new interval. */
+	void Take(FCounts& Out, bool bReset)
+	{
+		Out = FCounts();
+		for (size_t i = 0; i < NumBuckets; ++i)
+		{
+			Out.Buckets[i] = bReset ? Buckets[i].exchange(0, std::memory_order_relaxed) : Buckets[i].load(std::memory_order_relaxed);
+			Out.Total += Out.Buckets[i];
+		}
+		Out.Max = bReset ? Max.exchange(0, std::memory_order_relaxed) : Max.load(std::memory_order_relaxed);
+	}
+
+	static size_t GetBucketIndex(uint64_t Value)
+	{
+		if (Value < SubBucketCount)
+		{
+			return static_cast<size_t>(Value);
+		}
+
+		uint32_t Exponent = 63;
+		while ((Value >> Exponent) == 0)
+		{
+			--Exponent;
+		}
+		const uint64_t SubBucket = (Value >> (Exponent - SubBucketBits)) - SubBucketCount;
+		return ((Exponent - SubBucketBits + 1) << SubBucketBits) + static_cast<size_t>(SubBucket);
+	}
+
+	static uint64_t GetBucketUpperBound(size_t Index)
+	{
+		if (Index < SubBucketCount)
+		{
+			return Index;
+		}
+
+		const uint32_t Exponent = static_cast<uint32_t>(Index >> SubBucketBits) + SubBucketBits - 1;
+		const uint64_t SubBucket = Index & (SubBucketCount - 1);
+		const uint64_t Lower = (SubBucketCount + SubBucket) << (Exponent - SubBucketBits);
+		return Lower + (1ull << (Exponent - SubBucketBits)) - 1;
+	}
+
+private:
+	std::atomic<uint64_t> Buckets[NumBuckets];
+
+	std::atomic<uint64_t> Max{ 0 };
+};
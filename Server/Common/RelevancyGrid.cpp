@@ -0,0 +1,172 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "RelevancyGrid.h"
+
+#include <algorithm>
+#include <cmath>
+
+FRelevancyGrid::FRelevancyGrid(float InCellSize)
+	: CellSize(InCellSize > 0.f ? InCellSize : 1.f)
+	, InvCellSize(1.f / CellSize)
+{
+}
+
+uint64_t FRelevancyGrid::GetCell(float X, float Y) const
+{
+	return MakeCell(static_cast<int32_t>(std::floor(X * InvCellSize)), static_cast<int32_t>(std::floor(Y * InvCellSize)));
+}
+
+void FRelevancyGrid::Move(uint64_t Id, float X, float Y, uint64_t Stamp)
+{
+	const uint64_t Cell = GetCell(X, Y);
+
+	auto Found = Entities.find(Id);
+	if (Found != Entities.end())
+	{
+		FEntity& Entity = Found->second;
+		if (Entity.Cell == Cell)
+		{
+			FCellEntry& Entry = Cells[Cell][Entity.Index];
+			Entry.X = X;
+			Entry.Y = Y;
+			Entry.Stamp = Stamp;
+			return;
+		}
+
+		RemoveFromCell(Entity.Cell, Entity.Index);
+	}
+
+	std::vector<FCellEntry>& Entries = Cells[Cell];
+	FEntity& Entity = Entities[Id];
+	Entity.Cell = Cell;
+	Entity.Index = static_cast<uint32_t>(Entries.size());
+	Entries.push_back(FCellEntry{ Id, X, Y, Stamp });
+}
+
+void FRelevancyGrid::Remove(uint64_t Id)
+{
+	auto Found = Entities.find(Id);
+	if (Found == Entities.end())
+	{
+		return;
+	}
+
+	const FEntity Entity = Found->second;
+	Entities.erase(Found);
+	RemoveFromCell(Entity.Cell, Entity.Index);
+}
+
+void FRelevancyGrid::RemoveFromCell(uint64_t Cell, uint32_t Index)
+{
+	auto Found = Cells.find(Cell);
+	std::vector<FCellEntry>& Entries = Found->second;
+
+	if (Index + 1 < Entries.size())
+	{
+		Entries[Index] = Entries.back();
+		Entities[Entries[Index].Id].Index = Index;
+	}
+	Entries.pop_back();
+
+	// Empty cells are kept, with their capacity, for the next entity to walk in; only a very
+	// sparse world would accumulate enough of them to matter.
+}
+
+bool FRelevancyGrid::GetPosition(uint64_t Id, float& OutX, float& OutY) const
+{
+	auto Found = Entities.find(Id);
+	if (Found == Entities.end())
+	{
+		return false;
+	}
+
+	const FCellEntry& Entry = Cells.find(Found->second.Cell)->second[Found->second.Index];
+	OutX = Entry.X;
+	OutY = Entry.Y;
+	return true;
+}
+
+void FRelevancyGrid::Query(float X, float Y, float Radius, uint64_t Exclude, std::vector<FRelevancyEntry>& Out) const
+{
+	Out.clear();
+
+	const float RadiusSquared = Radius * Radius;
+	const int32_t MinX = static_cast<int32_t>(std::floor((X - Radius) * InvCellSize));
+	const int32_t MaxX = static_cast<int32_t>(std::floor((X + Radius) * InvCellSize));
+	const int32_t MinY = static_cast<int32_t>(std::floor((Y - Radius) * InvCellSize));
+	const int32_t MaxY = static_cast<int32_t>(std::floor((Y + Radius) * InvCellSize));
+
+	for (int32_t CellX = MinX; CellX <= MaxX; ++CellX)
+	{
+		for (int32_t CellY = MinY; CellY <= MaxY; ++CellY)
+		{
+			auto Found = Cells.find(MakeCell(CellX, CellY));
+			if (Found == Cells.end())
+			{
+				continue;
+			}
+
+			for (const FCellEntry& Entry : Found->second)
+			{
+				const float DX = Entry.X - X;
+				const float DY = Entry.Y - Y;
+				const float DistanceSquared = DX * DX + DY * DY;
+				if (DistanceSquared <= RadiusSquared && Entry.Id != Exclude)
+				{
+					FRelevancyEntry Result;
+					Result.Id = Entry.Id;
+					Result.Stamp = Entry.Stamp;
+					Result.DistanceSquared = DistanceSquared;
+					Out.push_back(Result);
+				}
+			}
+		}
+	}
+
+	std::sort(Out.begin(), Out.end(), [](const FRelevancyEntry& A, const FRelevancyEntry& B) { return A.Id < B.Id; });
+}
+
+void FRelevantSet::Update(const std::vector<FRelevancyEntry>& Candidates, float EnterRadius, uint64_t Since, FRelevancyChanges& Out)
+{
+	Out.Reset();
+	Scratch.clear();
+
+	const float EnterRadiusSquared = EnterRadius * EnterRadius;
+	size_t Current = 0;
+
+	for (const FRelevancyEntry& Candidate : Candidates)
+	{
+		while (Current < Relevant.size() && Relevant[Current] < Candidate.Id)
+		{
+			Out.Left.push_back(Relevant[Current++]);
+		}
+
+		const bool bWasRelevant = Current < Relevant.size() && Relevant[Current] == Candidate.Id;
+		if (bWasRelevant)
+		{
+			++Current;
+			Scratch.push_back(Candidate.Id);
+			if (Candidate.Stamp > Since)
+			{
+				Out.Updated.push_back(Candidate);
+			}
+		}
+		else if (Candidate.DistanceSquared <= EnterRadiusSquared)
+		{
+			Scratch.push_back(Candidate.Id);
+			Out.Entered.push_back(Candidate.Id);
+		}
+	}
+
+	while (Current < Relevant.size())
+	{
+		Out.Left.push_back(Relevant[Current++]);
+	}
+
+	Relevant.swap(Scratch);
+}
+
+bool FRelevantSet::Contains(uint64_t Id) const
+{
+	return std::binary_search(Relevant.begin(), Relevant.end(), Id);
+}
@@ -0,0 +1,134 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/** One candidate returned by FRelevancyGrid::Query. */
+struct FRelevancyEntry
+{
+	uint64_t Id = 0;
+
+	/** Stamp passed to the entity's last Move. */
+	uint64_t Stamp = 0;
+
+	float DistanceSquared = 0.f;
+};
+
+/**
+ * Uniform 2D grid over Transform.location (x, y) for area-of-interest queries. A Move that stays
+ * in the same cell only rewrites the entity's position; crossing a cell boundary is a swap-remove
+ * from one cell and an append to another, so moving costs O(1) regardless of population. Cells
+ * are hashed, so the world needs no bounds.
+ *
+ * Not thread-safe. Query is const and may run concurrently with other queries, but not with
+ * Move or Remove.
+ */
+class FRelevancyGrid
+{
+public:
+	/** Queries are cheapest when CellSize is close to the query radius. */
+	explicit FRelevancyGrid(float InCellSize);
+
+	/** Inserts Id or updates its position. Stamp is any caller-defined version, e.g. a time. */
+	void Move(uint64_t Id, float X, float Y, uint64_t Stamp);
+
+	void Remove(uint64_t Id);
+
+	bool GetPosition(uint64_t Id, float& OutX, float& OutY) const;
+
+	/** Replaces Out with every entity within Radius of (X, Y) except Exclude, sorted by Id. */
+	void Query(float X, float Y, float Radius, uint64_t Exclude, std::vector<FRelevancyEntry>& Out) const;
+
+	size_t Num() const { return Entities.size(); }
+
+	float GetCellSize() const { return CellSize; }
+
+private:
+	struct FCellEntry
+	{
+		uint64_t Id;
+
+		float X;
+
+		float Y;
+
+		uint64_t Stamp;
+	};
+
+	struct FEntity
+	{
+		uint64_t Cell;
+
+		/** Position in Cells[Cell]. */
+		uint32_t Index;
+	};
+
+	uint64_t GetCell(float X, float Y) const;
+
+	static uint64_t MakeCell(int32_t CellX, int32_t CellY)
+	{
+		return (static_cast<uint64_t>(static_cast<uint32_t>(CellX)) << 32) | static_cast<uint32_t>(CellY);
+	}
+
+	void RemoveFromCell(uint64_t Cell, uint32_t Index);
+
+	float CellSize;
+
+	float InvCellSize;
+
+	std::unordered_map<uint64_t, std::vector<FCellEntry>> Cells;
+
+	std::unordered_map<uint64_t, FEntity> Entities;
+};
+
+/** What changed for one observer since its previous FRelevantSet::Update. */
+struct FRelevancyChanges
+{
+	/** Became relevant: the observer needs a spawn with the full state. */
+	std::vector<uint64_t> Entered;
+
+	/** No longer relevant: the observer should destroy its copy. */
+	std::vector<uint64_t> Left;
+
+	/** Still relevant and moved since the previous update: goes into the observer's snapshot. */
+	std::vector<FRelevancyEntry> Updated;
+
+	void Reset()
+	{
+		Entered.clear();
+		Left.clear();
+		Updated.clear();
+	}
+};
+
+/**
+ * The entities one observer currently knows about. Entities enter within EnterRadius and only
+ * leave beyond LeaveRadius, so something pacing along the boundary does not spawn and despawn
+ * every update.
+ */
+class FRelevantSet
+{
+public:
+	/**
+	 * Diffs Candidates, a Query with LeaveRadius sorted by Id, against the current set and
+	 * replaces the set. Updated only lists entities whose stamp is newer than Since.
+	 */
+	void Update(const std::vector<FRelevancyEntry>& Candidates, float EnterRadius, uint64_t Since, FRelevancyChanges& Out);
+
+	bool Contains(uint64_t Id) const;
+
+	/** Everything in the set leaves, e.g. when the observer disconnects. */
+	void Reset() { Relevant.clear(); }
+
+	const std::vector<uint64_t>& GetRelevant() const { return Relevant; }
+
+private:
+	/** Sorted. */
+	std::vector<uint64_t> Relevant;
+
+	std::vector<uint64_t> Scratch;
+};
@@ -0,0 +1,71 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "SendQueue.h"
+
+#include <cerrno>
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+FSendQueue::EFlushResult FSendQueue::Flush(int Socket, size_t& OutBytesSent)
+{
+	OutBytesSent = 0;
+
+	iovec Vectors[MaxFramesPerSend];
+	while (!Frames.empty())
+	{
+		size_t NumVectors = 0;
+		size_t Requested = 0;
+		for (auto It = Frames.begin(); It != Frames.end() && NumVectors < MaxFramesPerSend; ++It, ++NumVectors)
+		{
+			const size_t Offset = NumVectors == 0 ? HeadOffset : 0;
+			Vectors[NumVectors].iov_base = const_cast<uint8_t*>((*It)->GetData() + Offset);
+			Vectors[NumVectors].iov_len = (*It)->GetSize() - Offset;
+			Requested += Vectors[NumVectors].iov_len;
+		}
+
+		msghdr Message = {};
+		Message.msg_iov = Vectors;
+		Message.msg_iovlen = NumVectors;
+		const ssize_t Sent = sendmsg(Socket, &Message, MSG_NOSIGNAL);
+		if (Sent < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			return errno == EAGAIN || errno == EWOULDBLOCK ? EFlushResult::WouldBlock : EFlushResult::Error;
+		}
+
+		size_t Remaining = static_cast<size_t>(Sent);
+		OutBytesSent += Remaining;
+		PendingBytes -= Remaining;
+		while (Remaining > 0)
+		{
+			const size_t HeadSize = Frames.front()->GetSize() - HeadOffset;
+			if (Remaining < HeadSize)
+			{
+				HeadOffset += Remaining;
+				break;
+			}
+			Remaining -= HeadSize;
+			HeadOffset = 0;
+			Frames.pop_front();
+		}
+
+		// A short write means the socket buffer is full; another call would only hit EAGAIN.
+		if (static_cast<size_t>(Sent) < Requested)
+		{
+			return EFlushResult::WouldBlock;
+		}
+	}
+
+	return EFlushResult::Drained;
+}
+
+void FSendQueue::Reset()
+{
+	Frames.clear();
+	HeadOffset = 0;
+	PendingBytes = 0;
+}
@@ -0,0 +1,58 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+
+#include "EncodedFrame.h"
+
+/**
+ * Per-connection queue of shared frames, written with one sendmsg per batch of up to
+ * MaxFramesPerSend frames instead of copying every frame into a byte buffer first. A frame
+ * stays referenced until the kernel has accepted all of it. Not thread-safe; owned by the loop
+ * that owns the socket.
+ */
+class FSendQueue
+{
+public:
+	enum class EFlushResult
+	{
+		/** Everything queued was sent. */
+		Drained,
+		/** The socket buffer is full; wait for EPOLLOUT and flush again. */
+		WouldBlock,
+		/** The connection is broken and should be closed. */
+		Error,
+	};
+
+	/** Frames gathered into one sendmsg. Well below IOV_MAX (1024 on Linux). */
+	static const size_t MaxFramesPerSend = 64;
+
+	void Push(FEncodedFramePtr Frame)
+	{
+		PendingBytes += Frame->GetSize();
+		Frames.push_back(std::move(Frame));
+	}
+
+	/** Sends as much as the socket accepts. OutBytesSent is what the kernel took in this call. */
+	EFlushResult Flush(int Socket, size_t& OutBytesSent);
+
+	bool IsEmpty() const { return Frames.empty(); }
+
+	size_t GetNumFrames() const { return Frames.size(); }
+
+	/** Bytes not yet accepted by the kernel. */
+	size_t GetPendingBytes() const { return PendingBytes; }
+
+	void Reset();
+
+private:
+	std::deque<FEncodedFramePtr> Frames;
+
+	/** Bytes of Frames.front() already sent. */
+	size_t HeadOffset = 0;
+
+	size_t PendingBytes = 0;
+};
@@ -0,0 +1,339 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+/**
+ * Checks and measures FFrameDecoder the way FNetworkTransport uses it on the client: frames are
+ * unpacked (batches included), sliced out of the decoder (FFrameSlice) and held for a while, as
+ * the inbox holds them until the game thread dispatches them, before being released.
+ *
+ * Streams are recorded of moves, snapshots, spawns, pongs and every --batch-every frames a
+ * batch of small ones. Checks run on a short stream (120 frames, snapshots of up to 24 actors,
+ * so splitting it everywhere stays quick), with the decoder starting at 1 KiB so its buffer is
+ * outgrown and carried over often:
+ *
+ *   split     the stream is fed in two parts, split at every byte boundary in turn
+ *   random    the stream is fed in random reads of 1 to 3000 bytes, many times over
+ *
+ * Every pass must yield the recorded messages, byte for byte, with each slice still intact when
+ * it is released. The tool exits 1 if one does not. The benchmark then feeds a stream of
+ * --frames frames, with snapshots of up to 300 actors, in --read byte reads and reports MB/s
+ * and frames/s for slicing against copying each body into its own heap buffer, which is what
+ * the client did before.
+ *
+ * Build from this directory:
+ *
+ *   g++ -std=c++14 -O2 -I../../Source/SocketSample -I../../Source/SocketSample/flatbuffer/include Main.cpp -o DecoderBench
+ *
+ * Usage: DecoderBench [--frames 400] [--batch-every 16] [--held 256] [--read 16384] [--rounds 9]
+ *   held  slices kept alive before the oldest is released, like an undrained inbox
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <random>
+#include <vector>
+
+#include "FrameDecoder.h"
+#include "FrameBuilder.h"
+#include "ProtocolCore.h"
+#include "ProjectM_generated.h"
+
+namespace
+{
+	/** One message as the receiver should see it. */
+	struct FMessage
+	{
+		MsgId Id;
+
+		std::vector<uint8_t> Body;
+	};
+
+	struct FStream
+	{
+		std::vector<uint8_t> Bytes;
+
+		std::vector<FMessage> Messages;
+	};
+
+	void AppendFrame(std::vector<uint8_t>& Out, const flatbuffers::DetachedBuffer& Frame)
+	{
+		Out.insert(Out.end(), Frame.data(), Frame.data() + Frame.size());
+	}
+
+	flatbuffers::DetachedBuffer BuildMessage(std::mt19937& Random, int32_t Kind, int32_t MaxSnapshot)
+	{
+		std::uniform_real_distribution<float> Coordinate(-5000.f, 5000.f);
+		std::uniform_int_distribution<uint64_t> Actor(1, 100000);
+		auto MakeTransform = [&]()
+		{
+			return ProjectM::Actor::Transform(ProjectM::Actor::Vec3(Coordinate(Random), Coordinate(Random), 90.f),
+				ProjectM::Actor::Vec3(0.f, Coordinate(Random) / 30.f, 0.f), ProjectM::Actor::Vec3(1.f, 1.f, 1.f));
+		};
+
+		flatbuffers::FlatBufferBuilder fbb(1024);
+		if (Kind == 0)
+		{
+			const ProjectM::Actor::Transform Transform = MakeTransform();
+			FinishFrame(fbb, MsgId::S2C_SyncLocation, ProjectM::Actor::CreateS2C_SyncLocation(fbb, Actor(Random), &Transform));
+		}
+		else if (Kind == 1 || Kind == 2)
+		{
+			std::vector<uint64_t> Ids;
+			std::vector<ProjectM::Actor::Transform> Transforms;
+			for (int32_t i = 0, Count = 1 + static_cast<int32_t>(Random() % MaxSnapshot); i < Count; ++i)
+			{
+				Ids.push_back(Actor(Random));
+				Transforms.push_back(MakeTransform());
+			}
+			FinishFrame(fbb, MsgId::S2C_WorldSnapshot, ProjectM::Actor::CreateS2C_WorldSnapshotDirect(fbb, Random(), &Ids, &Transforms));
+		}
+		else if (Kind == 3)
+		{
+			std::vector<uint64_t> Ids = { Actor(Random), Actor(Random) };
+			std::vector<ProjectM::Actor::Transform> Transforms = { MakeTransform(), MakeTransform() };
+			FinishFrame(fbb, MsgId::S2C_SpawnActors, ProjectM::Actor::CreateS2C_SpawnActorsDirect(fbb, &Ids, &Transforms));
+		}
+		else
+		{
+			FinishFrame(fbb, MsgId::S2C_Pong, ProjectM::Actor::CreateS2C_Pong(fbb, Random(), Random(), Random()));
+		}
+		return fbb.Release();
+	}
+
+	FMessage ToMessage(const flatbuffers::DetachedBuffer& Frame)
+	{
+		FFrameHeader Header;
+		Header.Decode(Frame.data());
+		return FMessage{ Header.Id, std::vector<uint8_t>(Frame.data() + FFrameHeader::Size, Frame.data() + Frame.size()) };
+	}
+
+	FStream MakeStream(int32_t NumFrames, int32_t BatchEvery, int32_t MaxSnapshot)
+	{
+		std::mt19937 Random(17);
+		FStream Stream;
+		for (int32_t i = 0; i < NumFrames; ++i)
+		{
+			if (BatchEvery > 0 && i % BatchEvery == BatchEvery - 1)
+			{
+				std::vector<uint8_t> Batch;
+				for (int32_t j = 0, Count = 2 + static_cast<int32_t>(Random() % 6); j < Count; ++j)
+				{
+					const flatbuffers::DetachedBuffer Frame = BuildMessage(Random, j % 2 == 0 ? 0 : 4, MaxSnapshot);
+					AppendFrame(Batch, Frame);
+					Stream.Messages.push_back(ToMessage(Frame));
+				}
+
+				uint8_t Header[FFrameHeader::Size];
+				FFrameHeader(MsgId(0), static_cast<uint32_t>(Batch.size()), FrameFlags::Batched).Encode(Header);
+				Stream.Bytes.insert(Stream.Bytes.end(), Header, Header + sizeof(Header));
+				Stream.Bytes.insert(Stream.Bytes.end(), Batch.begin(), Batch.end());
+				continue;
+			}
+
+			const flatbuffers::DetachedBuffer Frame = BuildMessage(Random, static_cast<int32_t>(Random() % 5), MaxSnapshot);
+			AppendFrame(Stream.Bytes, Frame);
+			Stream.Messages.push_back(ToMessage(Frame));
+		}
+		return Stream;
+	}
+
+	/** Decodes Stream fed in the given read sizes, holding up to Held slices. True if every message matches. */
+	bool Decode(const FStream& Stream, const std::vector<size_t>& Reads, size_t Held)
+	{
+		FFrameDecoder Decoder(1024);
+		std::deque<std::pair<size_t, FFrameSlice>> Slices;
+		size_t NumDecoded = 0;
+		bool bMatched = true;
+
+		auto ReleaseOldest = [&]()
+		{
+			const FMessage& Expected = Stream.Messages[Slices.front().first];
+			const FFrameSlice& Slice = Slices.front().second;
+			bMatched = bMatched && Slice.GetSize() == Expected.Body.size() && memcmp(Slice.GetData(), Expected.Body.data(), Expected.Body.size()) == 0;
+			Slices.pop_front();
+		};
+
+		size_t Offset = 0;
+		for (size_t Read : Reads)
+		{
+			Decoder.Append(Stream.Bytes.data() + Offset, Read);
+			Offset += Read;
+
+			FFrameView View;
+			while (Decoder.Next(View))
+			{
+				ProtocolCore::UnpackFrame(View, [&](MsgId Id, const uint8_t* Data, size_t Size)
+				{
+					bMatched = bMatched && NumDecoded < Stream.Messages.size() && Stream.Messages[NumDecoded].Id == Id;
+					Slices.emplace_back(NumDecoded++, Decoder.Slice(Data, Size));
+					while (Slices.size() > Held)
+					{
+						ReleaseOldest();
+					}
+				});
+			}
+		}
+		while (!Slices.empty())
+		{
+			ReleaseOldest();
+		}
+
+		return bMatched && !Decoder.HasError() && NumDecoded == Stream.Messages.size() && Decoder.GetBufferedSize() == 0;
+	}
+
+	bool RunChecks(const FStream& Stream, size_t Held)
+	{
+		const size_t Size = Stream.Bytes.size();
+
+		size_t SplitFailures = 0;
+		for (size_t Split = 0; Split <= Size; ++Split)
+		{
+			if (!Decode(Stream, { Split, Size - Split }, Split % 2 == 0 ? Held : 0))
+			{
+				++SplitFailures;
+			}
+		}
+		printf("  split   %8zu passes  %s\n", Size + 1, SplitFailures == 0 ? "ok" : "FAILED");
+
+		std::mt19937 Random(23);
+		std::uniform_int_distribution<size_t> ReadSize(1, 3000);
+		const int32_t NumRandom = 2000;
+		size_t RandomFailures = 0;
+		for (int32_t Pass = 0; Pass < NumRandom; ++Pass)
+		{
+			std::vector<size_t> Reads;
+			for (size_t Remaining = Size; Remaining > 0;)
+			{
+				Reads.push_back(std::min(Remaining, ReadSize(Random)));
+				Remaining -= Reads.back();
+			}
+			if (!Decode(Stream, Reads, Random() % (Held + 1)))
+			{
+				++RandomFailures;
+			}
+		}
+		printf("  random  %8d passes  %s\n", NumRandom, RandomFailures == 0 ? "ok" : "FAILED");
+
+		return SplitFailures == 0 && RandomFailures == 0;
+	}
+
+	/** Seconds to decode Repeats copies of the stream in ReadSize reads, keeping each body as a slice or a copy. */
+	template<typename KeepType>
+	double Measure(const FStream& Stream, int32_t Repeats, size_t ReadSize, size_t Held, KeepType&& Keep)
+	{
+		FFrameDecoder Decoder;
+		const std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+		for (int32_t Repeat = 0; Repeat < Repeats; ++Repeat)
+		{
+			for (size_t Offset = 0; Offset < Stream.Bytes.size(); Offset += ReadSize)
+			{
+				const size_t Read = std::min(ReadSize, Stream.Bytes.size() - Offset);
+				memcpy(Decoder.GetWriteBuffer(ReadSize), Stream.Bytes.data() + Offset, Read);
+				Decoder.CommitWrite(Read);
+
+				FFrameView View;
+				while (Decoder.Next(View))
+				{
+					ProtocolCore::UnpackFrame(View, [&](MsgId, const uint8_t* Data, size_t Size)
+					{
+						Keep(Decoder, Data, Size, Held);
+					});
+				}
+			}
+		}
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+	}
+}
+
+int main(int argc, char** argv)
+{
+	int32_t NumFrames = 400;
+	int32_t BatchEvery = 16;
+	size_t Held = 256;
+	size_t ReadSize = 16 * 1024;
+	int32_t Rounds = 9;
+
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (strcmp(argv[i], "--frames") == 0)
+		{
+			NumFrames = std::max(1, atoi(argv[i + 1]));
+		}
+		else if (strcmp(argv[i], "--batch-every") == 0)
+		{
+			BatchEvery = atoi(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "--held") == 0)
+		{
+			Held = static_cast<size_t>(std::max(0, atoi(argv[i + 1])));
+		}
+		else if (strcmp(argv[i], "--read") == 0)
+		{
+			ReadSize = static_cast<size_t>(std::max(1, atoi(argv[i + 1])));
+		}
+		else if (strcmp(argv[i], "--rounds") == 0)
+		{
+			Rounds = std::max(1, atoi(argv[i + 1]));
+		}
+		else
+		{
+			fprintf(stderr, "Unknown option %s\n", argv[i]);
+			return 1;
+		}
+	}
+
+	const FStream CheckStream = MakeStream(120, BatchEvery, 24);
+	printf("checks on %zu messages, %zu bytes:\n", CheckStream.Messages.size(), CheckStream.Bytes.size());
+	const bool bPassed = RunChecks(CheckStream, Held);
+
+	const FStream Stream = MakeStream(NumFrames, BatchEvery, 300);
+
+	// About 64 MB per round.
+	const int32_t Repeats = std::max(1, static_cast<int32_t>((64 << 20) / Stream.Bytes.size()));
+
+	std::deque<FFrameSlice> Slices;
+	auto KeepSlice = [&Slices](FFrameDecoder& Decoder, const uint8_t* Data, size_t Size, size_t Limit)
+	{
+		Slices.push_back(Decoder.Slice(Data, Size));
+		if (Slices.size() > Limit)
+		{
+			Slices.pop_front();
+		}
+	};
+
+	std::deque<std::vector<uint8_t>> Copies;
+	auto KeepCopy = [&Copies](FFrameDecoder&, const uint8_t* Data, size_t Size, size_t Limit)
+	{
+		Copies.emplace_back(Data, Data + Size);
+		if (Copies.size() > Limit)
+		{
+			Copies.pop_front();
+		}
+	};
+
+	std::vector<double> SliceTimes;
+	std::vector<double> CopyTimes;
+	for (int32_t Round = 0; Round < Rounds; ++Round)
+	{
+		SliceTimes.push_back(Measure(Stream, Repeats, ReadSize, Held, KeepSlice));
+		Slices.clear();
+		CopyTimes.push_back(Measure(Stream, Repeats, ReadSize, Held, KeepCopy));
+		Copies.clear();
+	}
+	std::sort(SliceTimes.begin(), SliceTimes.end());
+	std::sort(CopyTimes.begin(), CopyTimes.end());
+
+	const double Megabytes = static_cast<double>(Stream.Bytes.size()) * Repeats / 1e6;
+	const double Frames = static_cast<double>(Stream.Messages.size()) * Repeats;
+	printf("%zu-byte reads, %zu bodies held, median of %d rounds over %.0f MB:\n", ReadSize, Held, Rounds, Megabytes);
+	for (int32_t Mode = 0; Mode < 2; ++Mode)
+	{
+		const double Seconds = (Mode == 0 ? SliceTimes : CopyTimes)[Rounds / 2];
+		printf("  %-6s %10.0f MB/s %12.0f frames/s %8.1f ns/frame\n", Mode == 0 ? "slice" : "copy", Megabytes / Seconds, Frames / Seconds, Seconds * 1e9 / Frames);
+	}
+
+	return bPassed ? 0 : 1;
+}
@@ -0,0 +1,308 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+/**
+ * Dispatch cost per message: the controller's TMessageHandlers::TDispatcher table against the
+ * if/else chain on MsgId that Recv() used before it. Both call the same handlers, each of
+ * which reads one field of the rooted table, in the client's registration order:
+ *
+ *   chain         if (Id == S2C_Login) ... else if ..., GetRoot in each branch, unknown and
+ *                 unhandled ids fall off the end
+ *   table         TDispatcher without verification, as in shipping builds
+ *   table+verify  TDispatcher with MessageHandlerFlags::Verify, as in every other build
+ *
+ * Messages are a shuffled stream of prebuilt frames in one of two mixes:
+ *
+ *   all   every MsgId equally often, including ids the client has no handler for, plus 1% of
+ *         ids outside MsgId
+ *   sync  95% S2C_SyncLocation, the rest as in "all"
+ *
+ * The median round is reported. The tool exits 1 if the table and the chain disagree on what
+ * they handled, or if the table's Unknown and Unhandled counts miss a dropped message.
+ *
+ * Build from this directory:
+ *
+ *   g++ -std=c++14 -O2 -I../../Source/SocketSample -I../../Source/SocketSample/flatbuffer/include Main.cpp -o DispatchBench
+ *
+ * Usage: DispatchBench [--messages 1000000] [--rounds 9]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "flatbuffers/flatbuffers.h"
+
+#include "MsgId.h"
+#include "FrameBuilder.h"
+#include "MessageDispatcher.h"
+#include "ProjectM_generated.h"
+
+namespace
+{
+	struct FMessage
+	{
+		MsgId Id;
+
+		const uint8_t* Data;
+
+		size_t Size;
+	};
+
+	/** Stands in for ASocketPlayerController. Handlers are kept out of line, as the real ones are. */
+	class FReceiver
+	{
+	public:
+		uint64_t Checksum = 0;
+
+		uint64_t Handled = 0;
+
+		__attribute__((noinline)) bool OnLogin(const ProjectM::Actor::S2C_Login& msg, int)
+		{
+			Checksum += msg.actor_id();
+			++Handled;
+			return true;
+		}
+
+		__attribute__((noinline)) bool OnSpawnActors(const ProjectM::Actor::S2C_SpawnActors& msg, int)
+		{
+			Checksum += msg.actor_id() ? msg.actor_id()->size() : 0;
+			++Handled;
+			return true;
+		}
+
+		__attribute__((noinline)) bool OnDestroyActor(const ProjectM::Actor::S2C_DestroyActor& msg, int)
+		{
+			Checksum += msg.actor_id();
+			++Handled;
+			return true;
+		}
+
+		__attribute__((noinline)) bool SyncTransform(const ProjectM::Actor::S2C_SyncLocation& msg, int)
+		{
+			Checksum += msg.actor_id();
+			++Handled;
+			return true;
+		}
+
+		__attribute__((noinline)) bool ApplySnapshot(const ProjectM::Actor::S2C_WorldSnapshot& msg, int)
+		{
+			Checksum += msg.server_tick();
+			++Handled;
+			return true;
+		}
+
+		__attribute__((noinline)) bool ApplyCompactSnapshot(const ProjectM::Actor::S2C_CompactSnapshot& msg, int)
+		{
+			Checksum += msg.server_tick();
+			++Handled;
+			return true;
+		}
+
+		__attribute__((noinline)) bool OnPong(const ProjectM::Actor::S2C_Pong& msg, int)
+		{
+			Checksum += msg.client_time();
+			++Handled;
+			return true;
+		}
+	};
+
+	using FHandlers = TMessageHandlers<FReceiver, int>;
+
+	template<uint32_t Flags>
+	using TReceiverDispatcher = FHandlers::TDispatcher<
+		FHandlers::THandler<MsgId::S2C_Login, ProjectM::Actor::S2C_Login, &FReceiver::OnLogin, Flags>,
+		FHandlers::THandler<MsgId::S2C_SpawnActors, ProjectM::Actor::S2C_SpawnActors, &FReceiver::OnSpawnActors, Flags>,
+		FHandlers::THandler<MsgId::S2C_DestroyActor, ProjectM::Actor::S2C_DestroyActor, &FReceiver::OnDestroyActor, Flags>,
+		FHandlers::THandler<MsgId::S2C_SyncLocation, ProjectM::Actor::S2C_SyncLocation, &FReceiver::SyncTransform, Flags>,
+		FHandlers::THandler<MsgId::S2C_WorldSnapshot, ProjectM::Actor::S2C_WorldSnapshot, &FReceiver::ApplySnapshot, Flags>,
+		FHandlers::THandler<MsgId::S2C_CompactSnapshot, ProjectM::Actor::S2C_CompactSnapshot, &FReceiver::ApplyCompactSnapshot, Flags>,
+		FHandlers::THandler<MsgId::S2C_Pong, ProjectM::Actor::S2C_Pong, &FReceiver::OnPong, Flags>>;
+
+	void DispatchChain(FReceiver& Receiver, const FMessage& Message)
+	{
+		const MsgId id = Message.Id;
+		if (id == MsgId::S2C_Login)
+		{
+			Receiver.OnLogin(*flatbuffers::GetRoot<ProjectM::Actor::S2C_Login>(Message.Data), 0);
+		}
+		else if (id == MsgId::S2C_SpawnActors)
+		{
+			Receiver.OnSpawnActors(*flatbuffers::GetRoot<ProjectM::Actor::S2C_SpawnActors>(Message.Data), 0);
+		}
+		else if (id == MsgId::S2C_DestroyActor)
+		{
+			Receiver.OnDestroyActor(*flatbuffers::GetRoot<ProjectM::Actor::S2C_DestroyActor>(Message.Data), 0);
+		}
+		else if (id == MsgId::S2C_SyncLocation)
+		{
+			Receiver.SyncTransform(*flatbuffers::GetRoot<ProjectM::Actor::S2C_SyncLocation>(Message.Data), 0);
+		}
+		else if (id == MsgId::S2C_WorldSnapshot)
+		{
+			Receiver.ApplySnapshot(*flatbuffers::GetRoot<ProjectM::Actor::S2C_WorldSnapshot>(Message.Data), 0);
+		}
+		else if (id == MsgId::S2C_CompactSnapshot)
+		{
+			Receiver.ApplyCompactSnapshot(*flatbuffers::GetRoot<ProjectM::Actor::S2C_CompactSnapshot>(Message.Data), 0);
+		}
+		else if (id == MsgId::S2C_Pong)
+		{
+			Receiver.OnPong(*flatbuffers::GetRoot<ProjectM::Actor::S2C_Pong>(Message.Data), 0);
+		}
+	}
+
+	/** One finished body per MsgId; bodies start after the frame header FinishFrame wrote. */
+	std::vector<flatbuffers::DetachedBuffer> BuildBodies()
+	{
+		const ProjectM::Actor::Transform Transform(ProjectM::Actor::Vec3(1.f, 2.f, 3.f), ProjectM::Actor::Vec3(0.f, 90.f, 0.f), ProjectM::Actor::Vec3(1.f, 1.f, 1.f));
+		const std::vector<uint64_t> Ids = { 1, 2, 3, 4 };
+		const std::vector<ProjectM::Actor::Transform> Transforms(Ids.size(), Transform);
+		const std::vector<uint8_t> Bits(24, 0x5a);
+
+		std::vector<flatbuffers::DetachedBuffer> Bodies(static_cast<size_t>(MsgId::MAX));
+		for (uint16_t Value = 1; Value < static_cast<uint16_t>(MsgId::MAX); ++Value)
+		{
+			const MsgId Id = static_cast<MsgId>(Value);
+			flatbuffers::FlatBufferBuilder fbb;
+			switch (Id)
+			{
+			case MsgId::C2S_Login: FinishFrame(fbb, Id, ProjectM::Actor::CreateC2S_Login(fbb, fbb.CreateString("token"))); break;
+			case MsgId::S2C_Login: FinishFrame(fbb, Id, ProjectM::Actor::CreateS2C_Login(fbb, 7)); break;
+			case MsgId::S2C_SpawnActors: FinishFrame(fbb, Id, ProjectM::Actor::CreateS2C_SpawnActorsDirect(fbb, &Ids, &Transforms)); break;
+			case MsgId::S2C_DestroyActor: FinishFrame(fbb, Id, ProjectM::Actor::CreateS2C_DestroyActor(fbb, 3)); break;
+			case MsgId::C2S_SyncLocation: FinishFrame(fbb, Id, ProjectM::Actor::CreateC2S_SyncLocation(fbb, 5, &Transform)); break;
+			case MsgId::S2C_SyncLocation: FinishFrame(fbb, Id, ProjectM::Actor::CreateS2C_SyncLocation(fbb, 5, &Transform)); break;
+			case MsgId::S2C_WorldSnapshot: FinishFrame(fbb, Id, ProjectM::Actor::CreateS2C_WorldSnapshotDirect(fbb, 11, &Ids, &Transforms)); break;
+			case MsgId::S2C_CompactSnapshot: FinishFrame(fbb, Id, ProjectM::Actor::CreateS2C_CompactSnapshotDirect(fbb, 12, 11, &Ids, &Bits)); break;
+			case MsgId::C2S_SnapshotAck: FinishFrame(fbb, Id, ProjectM::Actor::CreateC2S_SnapshotAck(fbb, 12)); break;
+			case MsgId::C2S_Ping: FinishFrame(fbb, Id, ProjectM::Actor::CreateC2S_Ping(fbb, 13)); break;
+			case MsgId::S2C_Pong: FinishFrame(fbb, Id, ProjectM::Actor::CreateS2C_Pong(fbb, 13, 14, 15)); break;
+			default: break;
+			}
+			Bodies[Value] = fbb.Release();
+		}
+		return Bodies;
+	}
+
+	std::vector<FMessage> MakeStream(const std::vector<flatbuffers::DetachedBuffer>& Bodies, bool bMostlySync, size_t NumMessages)
+	{
+		std::mt19937 Random(11);
+		std::uniform_int_distribution<uint16_t> AnyId(1, static_cast<uint16_t>(MsgId::MAX) - 1);
+		std::uniform_real_distribution<double> Unit(0.0, 1.0);
+
+		std::vector<FMessage> Stream;
+		Stream.reserve(NumMessages);
+		for (size_t Index = 0; Index < NumMessages; ++Index)
+		{
+			const double Roll = Unit(Random);
+			if (Roll < 0.01)
+			{
+				Stream.push_back(FMessage{ static_cast<MsgId>(200), Bodies[1].data() + FFrameHeader::Size, Bodies[1].size() - FFrameHeader::Size });
+				continue;
+			}
+
+			const uint16_t Value = bMostlySync && Roll < 0.96 ? static_cast<uint16_t>(MsgId::S2C_SyncLocation) : AnyId(Random);
+			Stream.push_back(FMessage{ static_cast<MsgId>(Value), Bodies[Value].data() + FFrameHeader::Size, Bodies[Value].size() - FFrameHeader::Size });
+		}
+		return Stream;
+	}
+
+	template<typename DispatchType>
+	double Measure(const std::vector<FMessage>& Stream, FReceiver& Receiver, DispatchType&& Dispatch)
+	{
+		const std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+		for (const FMessage& Message : Stream)
+		{
+			Dispatch(Receiver, Message);
+		}
+		return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - Start).count() / Stream.size();
+	}
+
+	uint64_t CountDropped(const FMessageDispatchStats& Stats)
+	{
+		uint64_t Dropped = Stats.Unknown;
+		for (const FMessageDispatchStats::FEntry& Entry : Stats.Entries)
+		{
+			Dropped += Entry.Unhandled + Entry.Rejected;
+		}
+		return Dropped;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	size_t NumMessages = 1000000;
+	int32_t Rounds = 9;
+
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (strcmp(argv[i], "--messages") == 0)
+		{
+			NumMessages = static_cast<size_t>(std::max(1LL, atoll(argv[i + 1])));
+		}
+		else if (strcmp(argv[i], "--rounds") == 0)
+		{
+			Rounds = std::max(1, atoi(argv[i + 1]));
+		}
+		else
+		{
+			fprintf(stderr, "Unknown option %s\n", argv[i]);
+			return 1;
+		}
+	}
+
+	const std::vector<flatbuffers::DetachedBuffer> Bodies = BuildBodies();
+	bool bPassed = true;
+
+	printf("%zu messages x %d rounds, median round, ns/message:\n", NumMessages, Rounds);
+	printf("  %-5s %10s %10s %14s\n", "mix", "chain", "table", "table+verify");
+	for (bool bMostlySync : { false, true })
+	{
+		const std::vector<FMessage> Stream = MakeStream(Bodies, bMostlySync, NumMessages);
+
+		std::vector<double> ChainTimes;
+		std::vector<double> TableTimes;
+		std::vector<double> VerifyTimes;
+		for (int32_t Round = 0; Round < Rounds; ++Round)
+		{
+			FReceiver Chain;
+			ChainTimes.push_back(Measure(Stream, Chain, DispatchChain));
+
+			FReceiver Table;
+			FMessageDispatchStats TableStats;
+			TableTimes.push_back(Measure(Stream, Table, [&TableStats](FReceiver& Receiver, const FMessage& Message)
+			{
+				TReceiverDispatcher<MessageHandlerFlags::None>::Dispatch(Receiver, TableStats, Message.Id, Message.Data, Message.Size, 0);
+			}));
+
+			FReceiver Verified;
+			FMessageDispatchStats VerifyStats;
+			VerifyTimes.push_back(Measure(Stream, Verified, [&VerifyStats](FReceiver& Receiver, const FMessage& Message)
+			{
+				TReceiverDispatcher<MessageHandlerFlags::Verify>::Dispatch(Receiver, VerifyStats, Message.Id, Message.Data, Message.Size, 0);
+			}));
+
+			for (const FReceiver* Receiver : { &Table, &Verified })
+			{
+				bPassed &= Receiver->Handled == Chain.Handled && Receiver->Checksum == Chain.Checksum;
+			}
+			bPassed &= CountDropped(TableStats) == Stream.size() - Chain.Handled && CountDropped(VerifyStats) == Stream.size() - Chain.Handled;
+		}
+		std::sort(ChainTimes.begin(), ChainTimes.end());
+		std::sort(TableTimes.begin(), TableTimes.end());
+		std::sort(VerifyTimes.begin(), VerifyTimes.end());
+
+		printf("  %-5s %10.2f %10.2f %14.2f\n", bMostlySync ? "sync" : "all",
+			ChainTimes[ChainTimes.size() / 2], TableTimes[TableTimes.size() / 2], VerifyTimes[VerifyTimes.size() / 2]);
+	}
+
+	if (!bPassed)
+	{
+		printf("FAILED: the table and the chain handled different messages\n");
+	}
+	return bPassed ? 0 : 1;
+}
@@ -0,0 +1,268 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+/**
+ * Measures sender CPU per delivered S2C_SyncLocation when one move fans out to 1..1000
+ * connections, for three ways of producing the bytes:
+ *
+ *   rebuild  build the message again for every recipient, send() it from a byte buffer
+ *   copy     build once, copy the bytes into every recipient's byte buffer, send()
+ *   shared   build once as an FEncodedFrame, queue the pointer, flush with sendmsg (FSendQueue)
+ *
+ * Recipients are AF_UNIX socket pairs drained between rounds outside the timed section, so the
+ * numbers are thread CPU time spent building, queueing and handing bytes to the kernel. Linux only.
+ *
+ * Build from this directory:
+ *
+ *   g++ -std=c++14 -O2 -I../Common -I../../Source/SocketSample -I../../Source/SocketSample/flatbuffer/include \
+ *       Main.cpp ../Common/SendQueue.cpp -o FanOutBench
+ *
+ * Usage: FanOutBench [--moves 16] [--deliveries 2000000] [--snapshot 0]
+ *   moves       messages fanned out per round, i.e. per flush
+ *   deliveries  approximate messages delivered per measurement
+ *   snapshot    if above 0, fan out an S2C_CompactSnapshot of that many actors instead, for
+ *               a larger frame (about 20 bytes per actor)
+ */
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <vector>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "FrameBuilder.h"
+#include "BuilderPool.h"
+#include "EncodedFrame.h"
+#include "ProjectM_generated.h"
+
+#include "SendQueue.h"
+
+namespace
+{
+	enum class EStrategy
+	{
+		Rebuild,
+		Copy,
+		Shared,
+	};
+
+	const char* GetStrategyName(EStrategy Strategy)
+	{
+		switch (Strategy)
+		{
+		case EStrategy::Rebuild: return "rebuild";
+		case EStrategy::Copy:    return "copy";
+		case EStrategy::Shared:  return "shared";
+		}
+		return "?";
+	}
+
+	struct FConnection
+	{
+		int Socket = -1;
+
+		int Peer = -1;
+
+		std::vector<uint8_t> Bytes;
+
+		FSendQueue Queue;
+	};
+
+	uint64_t ThreadCpuNanoseconds()
+	{
+		timespec Time;
+		clock_gettime(CLOCK_THREAD_CPUTIME_ID, &Time);
+		return static_cast<uint64_t>(Time.tv_sec) * 1000000000ull + static_cast<uint64_t>(Time.tv_nsec);
+	}
+
+	int32_t SnapshotActors = 0;
+
+	flatbuffers::DetachedBuffer BuildMove(uint64_t ActorUID, float X)
+	{
+		if (SnapshotActors > 0)
+		{
+			std::vector<uint64_t> Ids(SnapshotActors, ActorUID);
+			std::vector<uint8_t> Data(SnapshotActors * 12, static_cast<uint8_t>(X));
+			FBuilderPool::FHandle fbb = FBuilderPool::Get().Acquire(MsgId::S2C_CompactSnapshot);
+			FinishFrame(*fbb, MsgId::S2C_CompactSnapshot, ProjectM::Actor::CreateS2C_CompactSnapshotDirect(*fbb, static_cast<uint32_t>(X), 0, &Ids, &Data));
+			return fbb.Release();
+		}
+
+		const ProjectM::Actor::Transform Transform(ProjectM::Actor::Vec3(X, 0.f, 0.f), ProjectM::Actor::Vec3(0.f, 0.f, 0.f), ProjectM::Actor::Vec3(1.f, 1.f, 1.f));
+		FBuilderPool::FHandle fbb = FBuilderPool::Get().Acquire(MsgId::S2C_SyncLocation);
+		FinishFrame(*fbb, MsgId::S2C_SyncLocation, ProjectM::Actor::CreateS2C_SyncLocation(*fbb, ActorUID, &Transform));
+		return fbb.Release();
+	}
+
+	bool SendBytes(FConnection& Connection)
+	{
+		size_t Offset = 0;
+		while (Offset < Connection.Bytes.size())
+		{
+			const ssize_t Sent = send(Connection.Socket, Connection.Bytes.data() + Offset, Connection.Bytes.size() - Offset, MSG_NOSIGNAL);
+			if (Sent <= 0)
+			{
+				return false;
+			}
+			Offset += static_cast<size_t>(Sent);
+		}
+		Connection.Bytes.clear();
+		return true;
+	}
+
+	void Drain(FConnection& Connection)
+	{
+		uint8_t Buffer[64 * 1024];
+		while (recv(Connection.Peer, Buffer, sizeof(Buffer), MSG_DONTWAIT) > 0)
+		{
+		}
+	}
+
+	/** Returns CPU nanoseconds per delivered message, or a negative value on a socket error. */
+	double Measure(EStrategy Strategy, std::vector<FConnection>& Connections, int32_t Moves, int64_t Deliveries)
+	{
+		const int64_t Rounds = std::max<int64_t>(Deliveries / (static_cast<int64_t>(Connections.size()) * Moves), 20);
+		uint64_t Elapsed = 0;
+
+		for (int64_t Round = 0; Round < Rounds; ++Round)
+		{
+			const uint64_t Start = ThreadCpuNanoseconds();
+
+			for (int32_t Move = 0; Move < Moves; ++Move)
+			{
+				const uint64_t ActorUID = static_cast<uint64_t>(Move) + 1;
+				const float X = static_cast<float>(Round);
+
+				if (Strategy == EStrategy::Rebuild)
+				{
+					for (FConnection& Connection : Connections)
+					{
+						const flatbuffers::DetachedBuffer Frame = BuildMove(ActorUID, X);
+						Connection.Bytes.insert(Connection.Bytes.end(), Frame.data(), Frame.data() + Frame.size());
+					}
+				}
+				else if (Strategy == EStrategy::Copy)
+				{
+					const flatbuffers::DetachedBuffer Frame = BuildMove(ActorUID, X);
+					for (FConnection& Connection : Connections)
+					{
+						Connection.Bytes.insert(Connection.Bytes.end(), Frame.data(), Frame.data() + Frame.size());
+					}
+				}
+				else
+				{
+					const FEncodedFramePtr Frame = FEncodedFrame::Create(BuildMove(ActorUID, X));
+					for (FConnection& Connection : Connections)
+					{
+						Connection.Queue.Push(Frame);
+					}
+				}
+			}
+
+			for (FConnection& Connection : Connections)
+			{
+				if (Strategy == EStrategy::Shared)
+				{
+					size_t Sent = 0;
+					if (Connection.Queue.Flush(Connection.Socket, Sent) != FSendQueue::EFlushResult::Drained)
+					{
+						return -1.0;
+					}
+				}
+				else if (!SendBytes(Connection))
+				{
+					return -1.0;
+				}
+			}
+
+			Elapsed += ThreadCpuNanoseconds() - Start;
+
+			for (FConnection& Connection : Connections)
+			{
+				Drain(Connection);
+			}
+		}
+
+		return static_cast<double>(Elapsed) / static_cast<double>(Rounds * static_cast<int64_t>(Connections.size()) * Moves);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	int32_t Moves = 16;
+	int64_t Deliveries = 2000000;
+
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (strcmp(argv[i], "--moves") == 0)
+		{
+			Moves = atoi(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "--snapshot") == 0)
+		{
+			SnapshotActors = atoi(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "--deliveries") == 0)
+		{
+			Deliveries = atoll(argv[i + 1]);
+		}
+		else
+		{
+			fprintf(stderr, "Unknown option %s\n", argv[i]);
+			return 1;
+		}
+	}
+
+	const int32_t FanOuts[] = { 1, 10, 100, 1000 };
+	const EStrategy Strategies[] = { EStrategy::Rebuild, EStrategy::Copy, EStrategy::Shared };
+
+	printf("%8s", "fan-out");
+	for (EStrategy Strategy : Strategies)
+	{
+		printf(" %12s", GetStrategyName(Strategy));
+	}
+	printf("   (CPU ns per delivered message, %d moves per flush, %zu byte frames)\n", Moves, BuildMove(1, 0.f).size());
+
+	for (int32_t FanOut : FanOuts)
+	{
+		std::vector<FConnection> Connections(FanOut);
+		for (FConnection& Connection : Connections)
+		{
+			int Pair[2];
+			if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, Pair) < 0)
+			{
+				perror("socketpair");
+				return 1;
+			}
+			Connection.Socket = Pair[0];
+			Connection.Peer = Pair[1];
+		}
+
+		printf("%8d", FanOut);
+		for (EStrategy Strategy : Strategies)
+		{
+			// One untimed pass warms the builder pool, the allocator and the socket buffers.
+			Measure(Strategy, Connections, Moves, Deliveries / 10);
+			const double PerMessage = Measure(Strategy, Connections, Moves, Deliveries);
+			if (PerMessage < 0.0)
+			{
+				perror(GetStrategyName(Strategy));
+				return 1;
+			}
+			printf(" %12.1f", PerMessage);
+		}
+		printf("\n");
+		fflush(stdout);
+
+		for (FConnection& Connection : Connections)
+		{
+			close(Connection.Socket);
+			close(Connection.Peer);
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,201 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+/**
+ * Checks FSnapshotInterpolator and FServerTickClock against known answers, then measures what
+ * the client's per-frame UpdateRemoteCharacters pass costs in them. Checks:
+ *
+ *   interpolate   halfway between two samples renders halfway between their locations
+ *   clamp         a render time far past the newest sample stops MaxExtrapolation past it
+ *   order         a sample older than the newest one is dropped
+ *   burst         two updates a microsecond apart are merged, not turned into a velocity
+ *   ticks         snapshots arriving in bursts are still timed one tick apart
+ *   untimed       a message without a tick, arriving with a burst, is timed among its ticks
+ *
+ * The tool exits 1 if any check fails. The benchmark fills --samples samples per actor, then
+ * times Update over every actor and Push of one new sample per actor, per 1000 actors.
+ *
+ * Build from this directory:
+ *
+ *   g++ -std=c++14 -O2 -I../../Source/SocketSample -I../../Source/SocketSample/flatbuffer/include Main.cpp -o InterpolationBench
+ *
+ * Usage: InterpolationBench [--samples 16] [--rounds 9]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "SnapshotInterpolation.h"
+
+namespace
+{
+	FTransformSample MakeSample(double Time, float X)
+	{
+		return FTransformSample(Time, ProjectM::Actor::Transform(ProjectM::Actor::Vec3(X, 0.f, 0.f),
+			ProjectM::Actor::Vec3(0.f, 0.f, 0.f), ProjectM::Actor::Vec3(1.f, 1.f, 1.f)));
+	}
+
+	/** Location X of the single actor in Interpolator, rendered at RenderTime. */
+	float RenderX(const FSnapshotInterpolator& Interpolator, double RenderTime)
+	{
+		float X = NAN;
+		Interpolator.Update(RenderTime + Interpolator.RenderDelay, [&X](uint64_t, const FTransformSample& Sample)
+		{
+			X = Sample.Location[0];
+		});
+		return X;
+	}
+
+	bool Check(const char* Name, float Value, float Expected, float Tolerance = 0.01f)
+	{
+		const bool bPassed = std::fabs(Value - Expected) < Tolerance;
+		printf("  %-12s %10.2f  expected %10.2f  %s\n", Name, Value, Expected, bPassed ? "ok" : "FAILED");
+		return bPassed;
+	}
+
+	bool CheckAtLeast(const char* Name, float Value, float Minimum)
+	{
+		const bool bPassed = Value >= Minimum;
+		printf("  %-12s %10.2f  at least %10.2f  %s\n", Name, Value, Minimum, bPassed ? "ok" : "FAILED");
+		return bPassed;
+	}
+
+	bool RunChecks()
+	{
+		bool bPassed = true;
+
+		FSnapshotInterpolator Interpolator;
+		Interpolator.Push(1, MakeSample(1.0, 0.f));
+		Interpolator.Push(1, MakeSample(1.1, 100.f));
+		bPassed &= Check("interpolate", RenderX(Interpolator, 1.05), 50.f);
+
+		// 1000 cm/s for at most 0.25 s past the newest sample.
+		bPassed &= Check("clamp", RenderX(Interpolator, 5.0), 100.f + 1000.f * static_cast<float>(Interpolator.MaxExtrapolation));
+
+		Interpolator.Push(1, MakeSample(1.05, -500.f));
+		bPassed &= Check("order", RenderX(Interpolator, 1.1), 100.f);
+
+		// A second update in the same read replaces the first; the velocity is still taken over the
+		// 0.1 s before it, not over the microsecond between the two.
+		Interpolator.Push(1, MakeSample(1.2, 200.f));
+		Interpolator.Push(1, MakeSample(1.200001, 201.f));
+		const double BurstTime = 1.2 + Interpolator.MaxExtrapolation;
+		bPassed &= Check("burst", RenderX(Interpolator, BurstTime), 201.f + static_cast<float>(101.0 * (BurstTime - 1.200001) / 0.100001));
+
+		// Ticks produced 50 ms apart, delivered in bursts of five: consecutive ticks stay at least
+		// half a tick apart while the clock adjusts, and within 5% of a tick once it has.
+		FServerTickClock Clock;
+		double Previous = Clock.Update(0, 10.0);
+		double BurstStart = Previous;
+		float SmallestGap = 1.f;
+		float LastGap = 0.f;
+		for (uint32_t Tick = 1; Tick < 40; ++Tick)
+		{
+			const double Time = Clock.Update(Tick, 10.0 + (Tick / 5) * 0.25);
+			LastGap = static_cast<float>((Time - Previous) / Clock.TickInterval);
+			SmallestGap = std::min(SmallestGap, LastGap);
+			Previous = Time;
+			if (Tick % 5 == 0)
+			{
+				BurstStart = Time;
+			}
+		}
+		bPassed &= CheckAtLeast("ticks", SmallestGap, 0.5f);
+		bPassed &= Check("ticks", LastGap, 1.f, 0.05f);
+
+		// An S2C_SyncLocation read together with the last burst lands among that burst's ticks, in
+		// ticks after its first one, rather than at the last tick's arrival time.
+		const double Untimed = Clock.ToLocalTime(10.0 + (39 / 5) * 0.25);
+		bPassed &= Check("untimed", static_cast<float>((Untimed - BurstStart) / Clock.TickInterval), 2.f, 1.5f);
+
+		return bPassed;
+	}
+
+	/** Nanoseconds per 1000 actors for one Update, and for one Push to each. */
+	void Measure(int32_t NumActors, int32_t NumSamples, double& UpdateTime, double& PushTime)
+	{
+		std::mt19937 Random(3);
+		std::uniform_real_distribution<float> Coordinate(-5000.f, 5000.f);
+
+		FSnapshotInterpolator Interpolator;
+		double Time = 0.0;
+		for (int32_t Sample = 0; Sample < NumSamples; ++Sample)
+		{
+			Time += 0.05;
+			for (int32_t Actor = 0; Actor < NumActors; ++Actor)
+			{
+				Interpolator.Push(static_cast<uint64_t>(Actor + 1), MakeSample(Time, Coordinate(Random)));
+			}
+		}
+
+		// Halfway between two samples, a render delay behind the newest one.
+		float Checksum = 0.f;
+		const std::chrono::steady_clock::time_point UpdateStart = std::chrono::steady_clock::now();
+		Interpolator.Update(Time + 0.025, [&Checksum](uint64_t, const FTransformSample& Sample)
+		{
+			Checksum += Sample.Location[0];
+		});
+		UpdateTime = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - UpdateStart).count() * 1000.0 / NumActors;
+
+		Time += 0.05;
+		const FTransformSample Next = MakeSample(Time, Checksum);
+		const std::chrono::steady_clock::time_point PushStart = std::chrono::steady_clock::now();
+		for (int32_t Actor = 0; Actor < NumActors; ++Actor)
+		{
+			Interpolator.Push(static_cast<uint64_t>(Actor + 1), Next);
+		}
+		PushTime = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - PushStart).count() * 1000.0 / NumActors;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	int32_t NumSamples = 16;
+	int32_t Rounds = 9;
+
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (strcmp(argv[i], "--samples") == 0)
+		{
+			NumSamples = std::max(2, atoi(argv[i + 1]));
+		}
+		else if (strcmp(argv[i], "--rounds") == 0)
+		{
+			Rounds = std::max(1, atoi(argv[i + 1]));
+		}
+		else
+		{
+			fprintf(stderr, "Unknown option %s\n", argv[i]);
+			return 1;
+		}
+	}
+
+	printf("checks:\n");
+	const bool bPassed = RunChecks();
+
+	printf("%d samples per actor, median of %d rounds:\n", NumSamples, Rounds);
+	printf("%8s %16s %16s\n", "actors", "update ns/1k", "push ns/1k");
+	for (int32_t NumActors : { 100, 1000, 10000 })
+	{
+		std::vector<double> UpdateTimes;
+		std::vector<double> PushTimes;
+		for (int32_t Round = 0; Round < Rounds; ++Round)
+		{
+			double UpdateTime = 0.0;
+			double PushTime = 0.0;
+			Measure(NumActors, NumSamples, UpdateTime, PushTime);
+			UpdateTimes.push_back(UpdateTime);
+			PushTimes.push_back(PushTime);
+		}
+		std::sort(UpdateTimes.begin(), UpdateTimes.end());
+		std::sort(PushTimes.begin(), PushTimes.end());
+		printf("%8d %16.0f %16.0f\n", NumActors, UpdateTimes[UpdateTimes.size() / 2], PushTimes[PushTimes.size() / 2]);
+	}
+
+	return bPassed ? 0 : 1;
+}
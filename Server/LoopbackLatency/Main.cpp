@@ -0,0 +1,524 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+/**
+ * End-to-end receive latency of the client's network path, headless, against a loopback echo
+ * server. Linux only. The game thread runs frames at --fps and sends --messages C2S_Ping per
+ * frame, each stamped with the send time; the echo server returns the bytes unchanged and the
+ * game thread times each ping when it handles it. Two client models run one after the other:
+ *
+ *   transport  FNetworkTransport's: a worker thread owns the socket, flushes the outbox, waits
+ *              up to 1 ms for readability, decodes with FFrameDecoder and ProtocolCore and hands
+ *              slices to the game thread through a bounded SPSC ring, drained once per frame
+ *   timer      the controller before it: the game thread sends synchronously, and reads and
+ *              decodes the socket itself from a 10 ms timer
+ *
+ * Reported per model, in microseconds: percentiles of send-to-handled (the whole round trip
+ * as the game sees it) and, for transport, of send-to-inbox (when the worker had the frame);
+ * plus the game thread's own network time per frame, in ns. A ping that never comes back or
+ * does not decode makes the tool exit 1.
+ *
+ * Build from this directory:
+ *
+ *   g++ -std=c++14 -O2 -pthread -I../Common -I../../Source/SocketSample -I../../Source/SocketSample/flatbuffer/include \
+ *       Main.cpp -o LoopbackLatency
+ *
+ * Usage: LoopbackLatency [--fps 60] [--messages 4] [--duration 5] [--inbox 1024]
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "FrameDecoder.h"
+#include "CoalescingOutbox.h"
+#include "ProtocolCore.h"
+#include "ProjectM_generated.h"
+
+#include "LatencyHistogram.h"
+
+namespace
+{
+	const int PollIntervalMs = 1;
+
+	const double TimerInterval = 0.01;
+
+	const size_t MinRecvSize = 16 * 1024;
+
+	uint64_t NowMicroseconds()
+	{
+		return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	uint64_t NowNanoseconds()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	/** FNetFrame with the worker's receive time in microseconds. */
+	struct FFrame
+	{
+		MsgId Id = MsgId(0);
+
+		uint64_t ReceiveTime = 0;
+
+		FFrameSlice Body;
+	};
+
+	/** Bounded single-producer single-consumer ring, as TCircularQueue is used for the inbox. */
+	class FFrameRing
+	{
+	public:
+		explicit FFrameRing(uint32_t Capacity)
+			: Slots(Capacity + 1)
+		{
+		}
+
+		bool IsFull() const
+		{
+			return Next(Head.load(std::memory_order_relaxed)) == Tail.load(std::memory_order_acquire);
+		}
+
+		bool Enqueue(FFrame&& Frame)
+		{
+			const uint32_t CurrentHead = Head.load(std::memory_order_relaxed);
+			if (Next(CurrentHead) == Tail.load(std::memory_order_acquire))
+			{
+				return false;
+			}
+			Slots[CurrentHead] = std::move(Frame);
+			Head.store(Next(CurrentHead), std::memory_order_release);
+			return true;
+		}
+
+		bool Dequeue(FFrame& OutFrame)
+		{
+			const uint32_t CurrentTail = Tail.load(std::memory_order_relaxed);
+			if (CurrentTail == Head.load(std::memory_order_acquire))
+			{
+				return false;
+			}
+			OutFrame = std::move(Slots[CurrentTail]);
+			Tail.store(Next(CurrentTail), std::memory_order_release);
+			return true;
+		}
+
+	private:
+		uint32_t Next(uint32_t Index) const
+		{
+			return Index + 1 == Slots.size() ? 0 : Index + 1;
+		}
+
+		std::vector<FFrame> Slots;
+
+		std::atomic<uint32_t> Head{ 0 };
+
+		std::atomic<uint32_t> Tail{ 0 };
+	};
+
+	struct FResult
+	{
+		FLatencyHistogram::FCounts Handled;
+
+		FLatencyHistogram::FCounts Inbox;
+
+		uint64_t Sent = 0;
+
+		uint64_t Errors = 0;
+
+		double GameThreadTime = 0.0;
+	};
+
+	/** Accepts one connection and echoes everything back until it closes. */
+	void RunEcho(int ListenSocket)
+	{
+		const int Socket = accept(ListenSocket, nullptr, nullptr);
+		if (Socket < 0)
+		{
+			return;
+		}
+		const int One = 1;
+		setsockopt(Socket, IPPROTO_TCP, TCP_NODELAY, &One, sizeof(One));
+
+		std::vector<uint8_t> Buffer(64 * 1024);
+		for (;;)
+		{
+			const ssize_t Read = recv(Socket, Buffer.data(), Buffer.size(), 0);
+			if (Read <= 0)
+			{
+				break;
+			}
+			for (ssize_t Offset = 0; Offset < Read;)
+			{
+				const ssize_t Written = send(Socket, Buffer.data() + Offset, Read - Offset, MSG_NOSIGNAL);
+				if (Written <= 0)
+				{
+					close(Socket);
+					return;
+				}
+				Offset += Written;
+			}
+		}
+		close(Socket);
+	}
+
+	int Connect(uint16_t Port)
+	{
+		const int Socket = socket(AF_INET, SOCK_STREAM, 0);
+		sockaddr_in Address = {};
+		Address.sin_family = AF_INET;
+		Address.sin_port = htons(Port);
+		Address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		if (connect(Socket, reinterpret_cast<sockaddr*>(&Address), sizeof(Address)) != 0)
+		{
+			close(Socket);
+			return -1;
+		}
+
+		const int One = 1;
+		setsockopt(Socket, IPPROTO_TCP, TCP_NODELAY, &One, sizeof(One));
+		fcntl(Socket, F_SETFL, fcntl(Socket, F_GETFL) | O_NONBLOCK);
+		return Socket;
+	}
+
+	/** Reads what the socket has into Decoder. Returns false once the connection is gone. */
+	bool ReadSocket(int Socket, FFrameDecoder& Decoder)
+	{
+		uint8_t* Dest = Decoder.GetWriteBuffer(MinRecvSize);
+		const ssize_t Read = recv(Socket, Dest, Decoder.GetWritableSize(), 0);
+		if (Read < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+		{
+			return true;
+		}
+		if (Read <= 0)
+		{
+			return false;
+		}
+		Decoder.CommitWrite(static_cast<size_t>(Read));
+		return true;
+	}
+
+	/** Sends all of Frame on a non-blocking socket, spinning on a full send buffer. */
+	bool SendAll(int Socket, const uint8_t* Data, size_t Size)
+	{
+		for (size_t Offset = 0; Offset < Size;)
+		{
+			const ssize_t Written = send(Socket, Data + Offset, Size - Offset, MSG_NOSIGNAL);
+			if (Written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			{
+				continue;
+			}
+			if (Written <= 0)
+			{
+				return false;
+			}
+			Offset += static_cast<size_t>(Written);
+		}
+		return true;
+	}
+
+	void HandlePing(const uint8_t* Data, size_t Size, uint64_t Now, FResult& Result, FLatencyHistogram& Histogram)
+	{
+		flatbuffers::Verifier Verifier(Data, Size);
+		if (!Verifier.VerifyBuffer<ProjectM::Actor::C2S_Ping>(nullptr))
+		{
+			++Result.Errors;
+			return;
+		}
+		const uint64_t Stamp = flatbuffers::GetRoot<ProjectM::Actor::C2S_Ping>(Data)->client_time();
+		Histogram.Record(Now > Stamp ? Now - Stamp : 0);
+	}
+
+	/** FNetworkTransport::Run, minus connect and capture. */
+	void RunWorker(int Socket, FCoalescingOutbox& Outbox, FFrameRing& Inbox, FLatencyHistogram& InboxLatency, std::atomic<bool>& bRunning, std::atomic<uint64_t>& Errors)
+	{
+		FFrameDecoder Decoder(MinRecvSize);
+		flatbuffers::DetachedBuffer InFlight;
+
+		while (bRunning)
+		{
+			while (Outbox.Pop(InFlight))
+			{
+				if (!SendAll(Socket, InFlight.data(), InFlight.size()))
+				{
+					Errors.fetch_add(1);
+					return;
+				}
+			}
+
+			if (Inbox.IsFull())
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(PollIntervalMs));
+			}
+			else
+			{
+				pollfd Poll = { Socket, POLLIN, 0 };
+				if (poll(&Poll, 1, PollIntervalMs) > 0 && !ReadSocket(Socket, Decoder))
+				{
+					return;
+				}
+			}
+
+			FFrameView View;
+			while (!Inbox.IsFull() && Decoder.Next(View))
+			{
+				ProtocolCore::UnpackFrame(View, [&](MsgId Id, const uint8_t* Data, size_t Size)
+				{
+					FFrame Frame;
+					Frame.Id = Id;
+					Frame.ReceiveTime = NowMicroseconds();
+					Frame.Body = Decoder.Slice(Data, Size);
+					flatbuffers::Verifier Verifier(Data, Size);
+					if (Id == MsgId::C2S_Ping && Verifier.VerifyBuffer<ProjectM::Actor::C2S_Ping>(nullptr))
+					{
+						InboxLatency.Record(Frame.ReceiveTime - flatbuffers::GetRoot<ProjectM::Actor::C2S_Ping>(Data)->client_time());
+					}
+					Inbox.Enqueue(std::move(Frame));
+				});
+			}
+			if (Decoder.HasError())
+			{
+				Errors.fetch_add(1);
+				return;
+			}
+		}
+	}
+
+	bool Run(bool bTransport, uint16_t Port, double Fps, int32_t NumMessages, double Duration, uint32_t InboxCapacity, FResult& Result)
+	{
+		const int Socket = Connect(Port);
+		if (Socket < 0)
+		{
+			return false;
+		}
+
+		FLatencyHistogram Handled;
+		FLatencyHistogram InboxLatency;
+		FCoalescingOutbox Outbox;
+		FFrameRing Inbox(InboxCapacity);
+		std::atomic<bool> bRunning{ true };
+		std::atomic<uint64_t> WorkerErrors{ 0 };
+		std::thread Worker;
+		if (bTransport)
+		{
+			Worker = std::thread(RunWorker, Socket, std::ref(Outbox), std::ref(Inbox), std::ref(InboxLatency), std::ref(bRunning), std::ref(WorkerErrors));
+		}
+
+		FFrameDecoder Decoder(MinRecvSize);
+		const std::chrono::steady_clock::duration FrameTime = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / Fps));
+		const std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+		std::chrono::steady_clock::time_point NextFrame = Start;
+		double NextTimer = 0.0;
+		uint64_t NetworkTime = 0;
+		uint64_t NumFrames = 0;
+
+		for (; std::chrono::steady_clock::now() - Start < std::chrono::duration<double>(Duration); ++NumFrames)
+		{
+			const uint64_t FrameStart = NowNanoseconds();
+
+			// Recv at the start of the frame, then the frame's sends, as the controller's Tick does.
+			if (bTransport)
+			{
+				FFrame Frame;
+				while (Inbox.Dequeue(Frame))
+				{
+					if (Frame.Id == MsgId::C2S_Ping)
+					{
+						HandlePing(Frame.Body.GetData(), Frame.Body.GetSize(), NowMicroseconds(), Result, Handled);
+					}
+					Frame.Body.Reset();
+				}
+			}
+			else
+			{
+				const double Now = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+				if (Now >= NextTimer)
+				{
+					NextTimer = Now + TimerInterval;
+					while (ReadSocket(Socket, Decoder))
+					{
+						FFrameView View;
+						bool bAny = false;
+						while (Decoder.Next(View))
+						{
+							bAny = true;
+							ProtocolCore::UnpackFrame(View, [&](MsgId Id, const uint8_t* Data, size_t Size)
+							{
+								if (Id == MsgId::C2S_Ping)
+								{
+									HandlePing(Data, Size, NowMicroseconds(), Result, Handled);
+								}
+							});
+						}
+						if (!bAny)
+						{
+							break;
+						}
+					}
+				}
+			}
+
+			for (int32_t Message = 0; Message < NumMessages; ++Message)
+			{
+				flatbuffers::DetachedBuffer Frame = ProtocolCore::MakePing(NowMicroseconds());
+				if (bTransport)
+				{
+					Outbox.Push(std::move(Frame));
+				}
+				else if (!SendAll(Socket, Frame.data(), Frame.size()))
+				{
+					++Result.Errors;
+				}
+				++Result.Sent;
+			}
+
+			NetworkTime += NowNanoseconds() - FrameStart;
+			NextFrame += FrameTime;
+			std::this_thread::sleep_until(NextFrame);
+		}
+
+		// Let the last round trips land before counting what came back.
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		if (bTransport)
+		{
+			FFrame Frame;
+			while (Inbox.Dequeue(Frame))
+			{
+				if (Frame.Id == MsgId::C2S_Ping)
+				{
+					HandlePing(Frame.Body.GetData(), Frame.Body.GetSize(), NowMicroseconds(), Result, Handled);
+				}
+				Frame.Body.Reset();
+			}
+			bRunning = false;
+			Worker.join();
+		}
+		else
+		{
+			while (ReadSocket(Socket, Decoder))
+			{
+				FFrameView View;
+				bool bAny = false;
+				while (Decoder.Next(View))
+				{
+					bAny = true;
+					ProtocolCore::UnpackFrame(View, [&](MsgId Id, const uint8_t* Data, size_t Size)
+					{
+						if (Id == MsgId::C2S_Ping)
+						{
+							HandlePing(Data, Size, NowMicroseconds(), Result, Handled);
+						}
+					});
+				}
+				if (!bAny)
+				{
+					break;
+				}
+			}
+		}
+		close(Socket);
+
+		Handled.Take(Result.Handled, false);
+		InboxLatency.Take(Result.Inbox, false);
+		Result.Errors += WorkerErrors.load();
+		Result.GameThreadTime = NumFrames > 0 ? static_cast<double>(NetworkTime) / NumFrames : 0.0;
+		return true;
+	}
+
+	void PrintCounts(const char* Name, const char* Measure, const FLatencyHistogram::FCounts& Counts)
+	{
+		printf("%-10s %-14s %8" PRIu64 " %8" PRIu64 " %8" PRIu64 " %8" PRIu64 " %8" PRIu64 "\n", Name, Measure,
+			Counts.Percentile(0.5), Counts.Percentile(0.9), Counts.Percentile(0.99), Counts.Max, Counts.Total);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	double Fps = 60.0;
+	int32_t NumMessages = 4;
+	double Duration = 5.0;
+	uint32_t InboxCapacity = 1024;
+
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (strcmp(argv[i], "--fps") == 0)
+		{
+			Fps = std::max(1.0, atof(argv[i + 1]));
+		}
+		else if (strcmp(argv[i], "--messages") == 0)
+		{
+			NumMessages = std::max(1, atoi(argv[i + 1]));
+		}
+		else if (strcmp(argv[i], "--duration") == 0)
+		{
+			Duration = std::max(0.1, atof(argv[i + 1]));
+		}
+		else if (strcmp(argv[i], "--inbox") == 0)
+		{
+			InboxCapacity = static_cast<uint32_t>(std::max(1, atoi(argv[i + 1])));
+		}
+		else
+		{
+			fprintf(stderr, "Unknown option %s\n", argv[i]);
+			return 1;
+		}
+	}
+
+	bool bPassed = true;
+	printf("%.0f fps, %d pings per frame, %.1f s per model, microseconds:\n", Fps, NumMessages, Duration);
+	printf("%-10s %-14s %8s %8s %8s %8s %8s\n", "model", "measure", "p50", "p90", "p99", "max", "samples");
+	for (bool bTransport : { true, false })
+	{
+		const int ListenSocket = socket(AF_INET, SOCK_STREAM, 0);
+		sockaddr_in Address = {};
+		Address.sin_family = AF_INET;
+		Address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		socklen_t Length = sizeof(Address);
+		if (bind(ListenSocket, reinterpret_cast<sockaddr*>(&Address), sizeof(Address)) != 0 || listen(ListenSocket, 1) != 0
+			|| getsockname(ListenSocket, reinterpret_cast<sockaddr*>(&Address), &Length) != 0)
+		{
+			fprintf(stderr, "Cannot listen on loopback: %s\n", strerror(errno));
+			return 1;
+		}
+		std::thread Echo(RunEcho, ListenSocket);
+
+		const char* Name = bTransport ? "transport" : "timer";
+		FResult Result;
+		if (!Run(bTransport, ntohs(Address.sin_port), Fps, NumMessages, Duration, InboxCapacity, Result))
+		{
+			fprintf(stderr, "Cannot connect to the echo server\n");
+			return 1;
+		}
+		Echo.join();
+		close(ListenSocket);
+
+		PrintCounts(Name, "send->handled", Result.Handled);
+		if (bTransport)
+		{
+			PrintCounts(Name, "send->inbox", Result.Inbox);
+		}
+		printf("%-10s %-14s %8.0f ns per frame on the game thread\n", Name, "network", Result.GameThreadTime);
+
+		if (Result.Handled.Total != Result.Sent || Result.Errors > 0)
+		{
+			printf("%-10s FAILED: %" PRIu64 " of %" PRIu64 " pings came back, %" PRIu64 " errors\n", Name, Result.Handled.Total, Result.Sent, Result.Errors);
+			bPassed = false;
+		}
+	}
+
+	return bPassed ? 0 : 1;
+}
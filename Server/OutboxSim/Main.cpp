@@ -0,0 +1,229 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+/**
+ * Drives FCoalescingOutbox the way the client does, against a reader that is slower than the
+ * writer, and prints the queue's depth and counters over time. The game thread pushes one
+ * latest-value C2S_SyncLocation per actor and a reliable frame every so often; the network
+ * thread pops into a non-blocking socket with a small send buffer; the reader drains the other
+ * end at a fixed byte rate. Depth should level off at or below the outbox's byte budget, with
+ * every reliable frame arriving. Linux only.
+ *
+ * Build from this directory:
+ *
+ *   g++ -std=c++14 -O2 -pthread -I../../Source/SocketSample -I../../Source/SocketSample/flatbuffer/include \
+ *       Main.cpp -o OutboxSim
+ *
+ * Usage: OutboxSim [--actors 4] [--rate 120] [--read-rate 4000] [--budget 4096] [--duration 5]
+ *   rate       C2S_SyncLocation per actor per second pushed by the game thread
+ *   read-rate  bytes per second the reader takes off the socket
+ *   budget     outbox byte budget
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "CoalescingOutbox.h"
+#include "FrameDecoder.h"
+#include "ProtocolCore.h"
+
+namespace
+{
+	/** Every this many moves the game thread also sends a reliable frame. */
+	const int32_t ReliableEvery = 50;
+}
+
+int main(int argc, char** argv)
+{
+	int32_t NumActors = 4;
+	double Rate = 120.0;
+	double ReadRate = 4000.0;
+	size_t Budget = 4096;
+	double Duration = 5.0;
+
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (strcmp(argv[i], "--actors") == 0)
+		{
+			NumActors = atoi(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "--rate") == 0)
+		{
+			Rate = atof(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "--read-rate") == 0)
+		{
+			ReadRate = atof(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "--budget") == 0)
+		{
+			Budget = static_cast<size_t>(atoll(argv[i + 1]));
+		}
+		else if (strcmp(argv[i], "--duration") == 0)
+		{
+			Duration = atof(argv[i + 1]);
+		}
+		else
+		{
+			fprintf(stderr, "Unknown option %s\n", argv[i]);
+			return 1;
+		}
+	}
+
+	int Pair[2];
+	if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, Pair) < 0)
+	{
+		perror("socketpair");
+		return 1;
+	}
+
+	// As small as the kernel allows, so the outbox rather than the socket holds the backlog.
+	const int BufferSize = 4096;
+	setsockopt(Pair[0], SOL_SOCKET, SO_SNDBUF, &BufferSize, sizeof(BufferSize));
+	setsockopt(Pair[1], SOL_SOCKET, SO_RCVBUF, &BufferSize, sizeof(BufferSize));
+
+	FCoalescingOutbox Outbox(Budget);
+	std::atomic<bool> bRunning{ true };
+	std::atomic<uint64_t> ReliableSent{ 0 };
+	std::atomic<uint64_t> ReliableReceived{ 0 };
+	std::atomic<uint64_t> MovesReceived{ 0 };
+
+	// Network thread: the same loop shape as FNetworkTransport::FlushOutbox.
+	std::thread Network([&]()
+	{
+		flatbuffers::DetachedBuffer InFlight;
+		size_t Offset = 0;
+		while (bRunning)
+		{
+			if (Offset >= InFlight.size())
+			{
+				Offset = 0;
+				if (!Outbox.Pop(InFlight))
+				{
+					InFlight = flatbuffers::DetachedBuffer();
+					std::this_thread::sleep_for(std::chrono::microseconds(200));
+					continue;
+				}
+			}
+
+			const ssize_t Sent = send(Pair[0], InFlight.data() + Offset, InFlight.size() - Offset, MSG_NOSIGNAL);
+			if (Sent > 0)
+			{
+				Offset += static_cast<size_t>(Sent);
+			}
+			else
+			{
+				std::this_thread::sleep_for(std::chrono::microseconds(200));
+			}
+		}
+	});
+
+	// Slow reader: the server, or the path to it.
+	std::thread Reader([&]()
+	{
+		FFrameDecoder Decoder(64 * 1024);
+		const auto Start = std::chrono::steady_clock::now();
+		double Taken = 0.0;
+		while (bRunning)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			const double Elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+			const size_t Allowance = static_cast<size_t>(Elapsed * ReadRate - Taken);
+			if (Allowance == 0)
+			{
+				continue;
+			}
+
+			uint8_t* Buffer = Decoder.GetWriteBuffer(Allowance);
+			const ssize_t Received = recv(Pair[1], Buffer, Allowance, 0);
+			if (Received <= 0)
+			{
+				continue;
+			}
+			Taken += static_cast<double>(Received);
+			Decoder.CommitWrite(static_cast<size_t>(Received));
+
+			FFrameView View;
+			while (Decoder.Next(View))
+			{
+				if (View.Id == MsgId::C2S_Login)
+				{
+					ReliableReceived.fetch_add(1);
+				}
+				else
+				{
+					MovesReceived.fetch_add(1);
+				}
+			}
+		}
+	});
+
+	printf("%6s %10s %10s %10s %10s %10s %10s %10s\n", "time", "queued B", "peak B", "frames", "pushed", "coalesced", "dropped", "moves in");
+
+	// Game thread.
+	const auto Start = std::chrono::steady_clock::now();
+	const double Interval = 1.0 / Rate;
+	double NextPush = 0.0;
+	double NextReport = 0.5;
+	int32_t Moves = 0;
+	for (;;)
+	{
+		const double Now = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+		if (Now >= Duration)
+		{
+			break;
+		}
+
+		if (Now >= NextPush)
+		{
+			NextPush += Interval;
+			for (int32_t Actor = 1; Actor <= NumActors; ++Actor)
+			{
+				const ProjectM::Actor::Transform Transform(ProjectM::Actor::Vec3(static_cast<float>(Now), 0.f, 0.f), ProjectM::Actor::Vec3(0.f, 0.f, 0.f), ProjectM::Actor::Vec3(1.f, 1.f, 1.f));
+				Outbox.Push(ProtocolCore::MakeSyncLocation(Actor, Transform), FCoalescingOutbox::MakeKey(MsgId::C2S_SyncLocation, Actor));
+			}
+
+			if (++Moves % ReliableEvery == 0)
+			{
+				Outbox.Push(ProtocolCore::MakeLogin("reliable"));
+				ReliableSent.fetch_add(1);
+			}
+		}
+
+		if (Now >= NextReport)
+		{
+			NextReport += 0.5;
+			const FCoalescingOutbox::FStats Stats = Outbox.GetStats();
+			printf("%6.1f %10zu %10zu %10zu %10llu %10llu %10llu %10llu\n", Now, Stats.QueuedBytes, Stats.PeakQueuedBytes, Stats.QueuedFrames,
+				static_cast<unsigned long long>(Stats.Pushed), static_cast<unsigned long long>(Stats.Coalesced),
+				static_cast<unsigned long long>(Stats.Dropped), static_cast<unsigned long long>(MovesReceived.load()));
+		}
+
+		std::this_thread::sleep_for(std::chrono::microseconds(500));
+	}
+
+	// Let the reader catch up on the reliable frames still queued.
+	while (ReliableReceived.load() < ReliableSent.load() && Outbox.GetStats().QueuedBytes > 0)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	}
+	std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+	bRunning = false;
+	Network.join();
+	Reader.join();
+
+	const FCoalescingOutbox::FStats Stats = Outbox.GetStats();
+	printf("reliable %llu sent, %llu received | peak %zu of %zu budget bytes\n",
+		static_cast<unsigned long long>(ReliableSent.load()), static_cast<unsigned long long>(ReliableReceived.load()), Stats.PeakQueuedBytes, Budget);
+
+	close(Pair[0]);
+	close(Pair[1]);
+	return ReliableReceived.load() == ReliableSent.load() ? 0 : 1;
+}
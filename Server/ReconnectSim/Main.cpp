@@ -0,0 +1,408 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+/**
+ * Drives FConnectionStateMachine the way ASocketPlayerController does, with a plain
+ * non-blocking socket standing in for FNetworkTransport, against a local listener that
+ * misbehaves on a schedule:
+ *
+ *   1. nothing listens on the port for --refuse seconds, so every attempt is refused;
+ *   2. the first session is accepted but its login is never answered;
+ *   3. the second session logs in and is dropped by the server --online seconds later;
+ *   4. the third session logs in and stays up.
+ *
+ * Every state change is printed. The run passes, exit code 0, if the client ends up online in
+ * the third session within --timeout seconds, having backed off after each failure. Linux only.
+ *
+ * Build from this directory:
+ *
+ *   g++ -std=c++14 -O2 -pthread -I../../Source/SocketSample -I../../Source/SocketSample/flatbuffer/include \
+ *       Main.cpp -o ReconnectSim
+ *
+ * Usage: ReconnectSim [--refuse 1.5] [--online 0.5] [--timeout 10]
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "ConnectionStateMachine.h"
+#include "FrameDecoder.h"
+#include "ProtocolCore.h"
+
+namespace
+{
+	using FStateMachine = FConnectionStateMachine;
+
+	double GetSeconds()
+	{
+		static const auto Start = std::chrono::steady_clock::now();
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+	}
+
+	const char* GetStateName(FStateMachine::EState State)
+	{
+		switch (State)
+		{
+		case FStateMachine::EState::Closed: return "Closed";
+		case FStateMachine::EState::Connecting: return "Connecting";
+		case FStateMachine::EState::LoggingIn: return "LoggingIn";
+		case FStateMachine::EState::Online: return "Online";
+		case FStateMachine::EState::Backoff: return "Backoff";
+		default: return "Unknown";
+		}
+	}
+
+	/** A free loopback port: bound once to find it, then released so connects to it are refused. */
+	uint16_t FindFreePort()
+	{
+		const int Socket = socket(AF_INET, SOCK_STREAM, 0);
+		sockaddr_in Addr = {};
+		Addr.sin_family = AF_INET;
+		Addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		bind(Socket, reinterpret_cast<sockaddr*>(&Addr), sizeof(Addr));
+
+		socklen_t Length = sizeof(Addr);
+		getsockname(Socket, reinterpret_cast<sockaddr*>(&Addr), &Length);
+		close(Socket);
+		return ntohs(Addr.sin_port);
+	}
+
+	/** The scripted server. Serves sessions one at a time on its own thread. */
+	class FFlakyServer
+	{
+	public:
+		FFlakyServer(uint16_t InPort, double InRefuseSeconds, double InOnlineSeconds)
+			: Port(InPort)
+			, RefuseSeconds(InRefuseSeconds)
+			, OnlineSeconds(InOnlineSeconds)
+		{
+		}
+
+		void Run()
+		{
+			while (bRunning && GetSeconds() < RefuseSeconds)
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			}
+
+			const int Listener = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+			const int Reuse = 1;
+			setsockopt(Listener, SOL_SOCKET, SO_REUSEADDR, &Reuse, sizeof(Reuse));
+
+			sockaddr_in Addr = {};
+			Addr.sin_family = AF_INET;
+			Addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+			Addr.sin_port = htons(Port);
+			if (bind(Listener, reinterpret_cast<sockaddr*>(&Addr), sizeof(Addr)) < 0 || listen(Listener, 4) < 0)
+			{
+				perror("listen");
+				close(Listener);
+				return;
+			}
+			printf("%7.3f server: listening\n", GetSeconds());
+
+			int32_t Session = 0;
+			while (bRunning)
+			{
+				const int Socket = accept4(Listener, nullptr, nullptr, SOCK_NONBLOCK);
+				if (Socket < 0)
+				{
+					std::this_thread::sleep_for(std::chrono::milliseconds(5));
+					continue;
+				}
+
+				++Session;
+				printf("%7.3f server: accepted session %d\n", GetSeconds(), Session);
+				Serve(Socket, Session);
+				close(Socket);
+			}
+			close(Listener);
+		}
+
+		void Stop() { bRunning = false; }
+
+	private:
+		void Serve(int Socket, int32_t Session)
+		{
+			FFrameDecoder Decoder(16 * 1024);
+			double DropTime = 0.0;
+			while (bRunning)
+			{
+				if (DropTime > 0.0 && GetSeconds() >= DropTime)
+				{
+					printf("%7.3f server: dropping session %d\n", GetSeconds(), Session);
+					return;
+				}
+
+				uint8_t* Buffer = Decoder.GetWriteBuffer(4096);
+				const ssize_t Received = recv(Socket, Buffer, Decoder.GetWritableSize(), 0);
+				if (Received == 0 || (Received < 0 && errno != EAGAIN && errno != EWOULDBLOCK))
+				{
+					printf("%7.3f server: session %d closed by client\n", GetSeconds(), Session);
+					return;
+				}
+				if (Received < 0)
+				{
+					std::this_thread::sleep_for(std::chrono::milliseconds(2));
+					continue;
+				}
+				Decoder.CommitWrite(static_cast<size_t>(Received));
+
+				FFrameView View;
+				while (Decoder.Next(View))
+				{
+					if (View.Id != MsgId::C2S_Login)
+					{
+						continue;
+					}
+
+					const ProjectM::Actor::C2S_Login* Login = flatbuffers::GetRoot<ProjectM::Actor::C2S_Login>(View.Data);
+					printf("%7.3f server: session %d login \"%s\"%s\n", GetSeconds(), Session,
+						Login->token() ? Login->token()->c_str() : "", Session == 1 ? ", not answering" : "");
+					if (Session == 1)
+					{
+						continue;
+					}
+
+					FBuilderPool::FHandle fbb = FBuilderPool::Get().Acquire(MsgId::S2C_Login);
+					FinishFrame(*fbb, MsgId::S2C_Login, ProjectM::Actor::CreateS2C_Login(*fbb, static_cast<uint64_t>(Session)));
+					const flatbuffers::DetachedBuffer Reply = fbb.Release();
+					send(Socket, Reply.data(), Reply.size(), MSG_NOSIGNAL);
+
+					if (Session == 2)
+					{
+						DropTime = GetSeconds() + OnlineSeconds;
+					}
+				}
+			}
+		}
+
+		uint16_t Port;
+
+		double RefuseSeconds;
+
+		double OnlineSeconds;
+
+		std::atomic<bool> bRunning{ true };
+	};
+
+	/** The client's side of one connection, in place of FNetworkTransport. */
+	struct FClientSocket
+	{
+		int Socket = -1;
+
+		bool bConnected = false;
+
+		bool bFailed = false;
+
+		FFrameDecoder Decoder{ 16 * 1024 };
+
+		bool Start(uint16_t Port)
+		{
+			Socket = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+			const int NoDelay = 1;
+			setsockopt(Socket, IPPROTO_TCP, TCP_NODELAY, &NoDelay, sizeof(NoDelay));
+
+			sockaddr_in Addr = {};
+			Addr.sin_family = AF_INET;
+			Addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+			Addr.sin_port = htons(Port);
+			return connect(Socket, reinterpret_cast<sockaddr*>(&Addr), sizeof(Addr)) == 0 || errno == EINPROGRESS;
+		}
+
+		/** The FNetworkTransport worker's job: finish the connect, then read until the socket fails. */
+		void Poll()
+		{
+			if (bFailed)
+			{
+				return;
+			}
+
+			if (!bConnected)
+			{
+				pollfd Fd = { Socket, POLLOUT, 0 };
+				if (poll(&Fd, 1, 0) <= 0)
+				{
+					return;
+				}
+
+				int Error = 0;
+				socklen_t Length = sizeof(Error);
+				getsockopt(Socket, SOL_SOCKET, SO_ERROR, &Error, &Length);
+				bConnected = Error == 0;
+				bFailed = !bConnected;
+				return;
+			}
+
+			uint8_t* Buffer = Decoder.GetWriteBuffer(4096);
+			const ssize_t Received = recv(Socket, Buffer, Decoder.GetWritableSize(), 0);
+			if (Received > 0)
+			{
+				Decoder.CommitWrite(static_cast<size_t>(Received));
+			}
+			else if (Received == 0 || (errno != EAGAIN && errno != EWOULDBLOCK))
+			{
+				bConnected = false;
+				bFailed = true;
+			}
+		}
+
+		FStateMachine::ETransportStatus GetStatus() const
+		{
+			return bFailed ? FStateMachine::ETransportStatus::Failed
+				: bConnected ? FStateMachine::ETransportStatus::Connected : FStateMachine::ETransportStatus::Connecting;
+		}
+
+		~FClientSocket()
+		{
+			if (Socket >= 0)
+			{
+				close(Socket);
+			}
+		}
+	};
+}
+
+int main(int argc, char** argv)
+{
+	double RefuseSeconds = 1.5;
+	double OnlineSeconds = 0.5;
+	double Timeout = 10.0;
+
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (strcmp(argv[i], "--refuse") == 0)
+		{
+			RefuseSeconds = atof(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "--online") == 0)
+		{
+			OnlineSeconds = atof(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "--timeout") == 0)
+		{
+			Timeout = atof(argv[i + 1]);
+		}
+		else
+		{
+			fprintf(stderr, "Unknown option %s\n", argv[i]);
+			return 1;
+		}
+	}
+
+	GetSeconds();
+	const uint16_t Port = FindFreePort();
+
+	FFlakyServer Server(Port, RefuseSeconds, OnlineSeconds);
+	std::thread ServerThread([&Server]() { Server.Run(); });
+
+	// Short timeouts and delays so the whole script runs in a few seconds.
+	FStateMachine Connection;
+	Connection.ConnectTimeout = 1.0;
+	Connection.LoginTimeout = 0.5;
+	Connection.InitialBackoff = 0.1;
+	Connection.MaxBackoff = 0.8;
+
+	std::unique_ptr<FClientSocket> Client;
+	const std::string Token = "reconnect-sim";
+	uint64_t ActorUID = 0;
+	int32_t Backoffs = 0;
+	FStateMachine::EState LastState = Connection.GetState();
+
+	Connection.Open(GetSeconds());
+	printf("%7.3f client: open, port %u\n", GetSeconds(), Port);
+
+	bool bPassed = false;
+	while (GetSeconds() < Timeout)
+	{
+		const double Now = GetSeconds();
+
+		if (Client)
+		{
+			Client->Poll();
+
+			FFrameView View;
+			while (Client->Decoder.Next(View))
+			{
+				if (View.Id == MsgId::S2C_Login && Connection.GetState() == FStateMachine::EState::LoggingIn)
+				{
+					ActorUID = flatbuffers::GetRoot<ProjectM::Actor::S2C_Login>(View.Data)->actor_id();
+					Connection.OnLoggedIn(Now);
+				}
+			}
+		}
+
+		switch (Connection.Update(Now, Client ? Client->GetStatus() : FStateMachine::ETransportStatus::Failed))
+		{
+		case FStateMachine::EAction::Connect:
+			Client.reset(new FClientSocket());
+			if (!Client->Start(Port))
+			{
+				Client.reset();
+			}
+			break;
+
+		case FStateMachine::EAction::Login:
+		{
+			const flatbuffers::DetachedBuffer Login = ProtocolCore::MakeLogin(Token.c_str());
+			send(Client->Socket, Login.data(), Login.size(), MSG_NOSIGNAL);
+			break;
+		}
+
+		case FStateMachine::EAction::Disconnect:
+			Client.reset();
+			++Backoffs;
+			break;
+
+		default:
+			break;
+		}
+
+		if (Connection.GetState() != LastState)
+		{
+			LastState = Connection.GetState();
+			if (LastState == FStateMachine::EState::Backoff)
+			{
+				printf("%7.3f client: Backoff, attempt %d, retry in %.3f s\n", Now, Connection.GetAttempt(), Connection.GetRetryTime() - Now);
+			}
+			else if (LastState == FStateMachine::EState::Online)
+			{
+				printf("%7.3f client: Online as actor %llu\n", Now, static_cast<unsigned long long>(ActorUID));
+			}
+			else
+			{
+				printf("%7.3f client: %s\n", Now, GetStateName(LastState));
+			}
+		}
+
+		// Online in the session that stays up, after the login timeout and the drop.
+		if (LastState == FStateMachine::EState::Online && ActorUID == 3)
+		{
+			bPassed = true;
+			break;
+		}
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	Connection.Close(GetSeconds());
+	Client.reset();
+	Server.Stop();
+	ServerThread.join();
+
+	printf("%s: %d backoffs, final actor %llu\n", bPassed ? "PASS" : "FAIL", Backoffs, static_cast<unsigned long long>(ActorUID));
+	return bPassed ? 0 : 1;
+}
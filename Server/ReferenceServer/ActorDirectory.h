@@ -0,0 +1,80 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "ProjectM_generated.h"
+
+/**
+ * Last known transform of every logged-in actor, shared by all server loops. Sharded by
+ * ActorUID so loops updating different actors rarely touch the same lock.
+ */
+class FActorDirectory
+{
+public:
+	static const size_t NumShards = 64;
+
+	void Set(uint64_t ActorUID, const ProjectM::Actor::Transform& Transform)
+	{
+		FShard& Shard = GetShard(ActorUID);
+		std::lock_guard<std::mutex> Lock(Shard.Mutex);
+		Shard.Actors[ActorUID] = Transform;
+	}
+
+	void Remove(uint64_t ActorUID)
+	{
+		FShard& Shard = GetShard(ActorUID);
+		std::lock_guard<std::mutex> Lock(Shard.Mutex);
+		Shard.Actors.erase(ActorUID);
+	}
+
+	bool Get(uint64_t ActorUID, ProjectM::Actor::Transform& OutTransform)
+	{
+		FShard& Shard = GetShard(ActorUID);
+		std::lock_guard<std::mutex> Lock(Shard.Mutex);
+		auto Found = Shard.Actors.find(ActorUID);
+		if (Found == Shard.Actors.end())
+		{
+			return false;
+		}
+		OutTransform = Found->second;
+		return true;
+	}
+
+	/** Appends every actor except Exclude, e.g. to build the S2C_SpawnActors a new session needs. */
+	void Collect(uint64_t Exclude, std::vector<uint64_t>& OutIds, std::vector<ProjectM::Actor::Transform>& OutTransforms)
+	{
+		for (FShard& Shard : Shards)
+		{
+			std::lock_guard<std::mutex> Lock(Shard.Mutex);
+			for (const auto& Actor : Shard.Actors)
+			{
+				if (Actor.first != Exclude)
+				{
+					OutIds.push_back(Actor.first);
+					OutTransforms.push_back(Actor.second);
+				}
+			}
+		}
+	}
+
+private:
+	struct alignas(64) FShard
+	{
+		std::mutex Mutex;
+
+		std::unordered_map<uint64_t, ProjectM::Actor::Transform> Actors;
+	};
+
+	FShard& GetShard(uint64_t ActorUID)
+	{
+		return Shards[ActorUID % NumShards];
+	}
+
+	FShard Shards[NumShards];
+};
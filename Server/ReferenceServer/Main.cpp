@@ -0,0 +1,128 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+/**
+ * Headless reference server for the ProjectM protocol, for load testing the client and bots
+ * locally. Linux only. Handles C2S_Login and C2S_SyncLocation and broadcasts S2C_SpawnActors,
+ * S2C_SyncLocation and S2C_DestroyActor to every other logged-in session. With --relevancy,
+ * each session only hears about actors within that many cm, through spawns, destroys and a
+ * periodic S2C_WorldSnapshot instead (see FReferenceServer::FSettings). --compact sends those
+ * snapshots as delta-encoded S2C_CompactSnapshot, acknowledged by C2S_SnapshotAck.
+ *
+ * Build from this directory:
+ *
+ *   g++ -std=c++14 -O2 -pthread -I. -I../Common -I../../Source/SocketSample -I../../Source/SocketSample/flatbuffer/include \
+ *       Main.cpp ReferenceServer.cpp ServerLoop.cpp ../Common/SendQueue.cpp ../Common/RelevancyGrid.cpp \
+ *       -o ReferenceServer
+ *
+ * Usage: ReferenceServer [--port 9810] [--loops N] [--interval seconds] [--max-output bytes]
+ *                        [--relevancy cm] [--relevancy-interval seconds] [--compact]
+ *
+ * Prints a line per interval with connections, inbound and outbound message and byte rates,
+ * the fan-out factor, and percentiles of the time from reading a message to handing the
+ * resulting broadcast to the kernel. Above a few thousand connections, raise the open file
+ * limit (ulimit -n) first.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#include "ReferenceServer.h"
+
+namespace
+{
+	std::atomic<bool> bQuit{ false };
+
+	void HandleSignal(int)
+	{
+		bQuit = true;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	FReferenceServer::FSettings Settings;
+	double Interval = 5.0;
+
+	for (int i = 1; i < argc; i += 2)
+	{
+		if (strcmp(argv[i], "--compact") == 0)
+		{
+			// The only option without a value.
+			Settings.bCompactSnapshots = true;
+			--i;
+		}
+		else if (i + 1 >= argc)
+		{
+			fprintf(stderr, "Missing value for %s\n", argv[i]);
+			return 1;
+		}
+		else if (strcmp(argv[i], "--port") == 0)
+		{
+			Settings.Port = static_cast<uint16_t>(atoi(argv[i + 1]));
+		}
+		else if (strcmp(argv[i], "--loops") == 0)
+		{
+			Settings.NumLoops = atoi(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "--interval") == 0)
+		{
+			Interval = atof(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "--relevancy") == 0)
+		{
+			Settings.RelevancyRadius = static_cast<float>(atof(argv[i + 1]));
+		}
+		else if (strcmp(argv[i], "--relevancy-interval") == 0)
+		{
+			Settings.RelevancyInterval = atof(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "--max-output") == 0)
+		{
+			Settings.MaxOutputSize = static_cast<size_t>(atoll(argv[i + 1]));
+		}
+		else
+		{
+			fprintf(stderr, "Unknown option %s\n", argv[i]);
+			return 1;
+		}
+	}
+
+	if (Settings.bCompactSnapshots && Settings.RelevancyRadius <= 0.f)
+	{
+		fprintf(stderr, "--compact needs --relevancy\n");
+		return 1;
+	}
+
+	signal(SIGINT, HandleSignal);
+	signal(SIGTERM, HandleSignal);
+	signal(SIGPIPE, SIG_IGN);
+
+	FReferenceServer Server(Settings);
+	if (!Server.Start())
+	{
+		return 1;
+	}
+
+	std::chrono::steady_clock::time_point LastReport = std::chrono::steady_clock::now();
+	while (!bQuit)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+		const std::chrono::steady_clock::time_point Now = std::chrono::steady_clock::now();
+		const double Elapsed = std::chrono::duration<double>(Now - LastReport).count();
+		if (Elapsed >= Interval)
+		{
+			Server.Report(Elapsed);
+			LastReport = Now;
+		}
+	}
+
+	Server.Stop();
+	Server.ReportTotals();
+	return 0;
+}
@@ -0,0 +1,172 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ReferenceServer.h"
+
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+
+namespace
+{
+	/** Entities only leave a bit beyond the radius they enter at, see FRelevantSet. */
+	const float RelevancyLeaveScale = 1.1f;
+
+	uint64_t NowNanoseconds()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+}
+
+FReferenceServer::FReferenceServer(const FSettings& InSettings)
+	: Settings(InSettings)
+	, Relevancy(InSettings.RelevancyRadius * RelevancyLeaveScale)
+{
+	if (Settings.NumLoops <= 0)
+	{
+		Settings.NumLoops = static_cast<int32_t>(std::thread::hardware_concurrency());
+		Settings.NumLoops = Settings.NumLoops > 0 ? Settings.NumLoops : 1;
+	}
+}
+
+FReferenceServer::~FReferenceServer()
+{
+	Stop();
+}
+
+bool FReferenceServer::Start()
+{
+	for (int32_t Index = 0; Index < Settings.NumLoops; ++Index)
+	{
+		std::unique_ptr<FServerLoop> Loop(new FServerLoop(*this));
+		Loop->MaxOutputSize = Settings.MaxOutputSize;
+		if (!Loop->Listen(Settings.Port))
+		{
+			Loops.clear();
+			return false;
+		}
+		Loops.push_back(std::move(Loop));
+	}
+
+	// Loops post to each other, so none may run before all of them exist.
+	for (std::unique_ptr<FServerLoop>& Loop : Loops)
+	{
+		FServerLoop* LoopPtr = Loop.get();
+		Threads.emplace_back([LoopPtr]() { LoopPtr->Run(); });
+	}
+
+	printf("Listening on port %u with %d loops\n", static_cast<unsigned>(Settings.Port), Settings.NumLoops);
+	if (UsesRelevancy())
+	{
+		printf("Relevancy radius %.0f cm, updated every %.0f ms\n", Settings.RelevancyRadius, Settings.RelevancyInterval * 1000.0);
+	}
+	return true;
+}
+
+void FReferenceServer::Stop()
+{
+	for (std::unique_ptr<FServerLoop>& Loop : Loops)
+	{
+		Loop->Stop();
+	}
+
+	for (std::thread& Thread : Threads)
+	{
+		Thread.join();
+	}
+	Threads.clear();
+}
+
+void FReferenceServer::MoveRelevancy(uint64_t ActorUID, const ProjectM::Actor::Transform& Transform)
+{
+	std::lock_guard<std::shared_timed_mutex> Lock(RelevancyMutex);
+	// Stamped under the lock, so a query that misses this move returns an earlier stamp and the
+	// observer's next query still sees it as updated.
+	Relevancy.Move(ActorUID, Transform.location().x(), Transform.location().y(), NowNanoseconds());
+}
+
+void FReferenceServer::RemoveRelevancy(uint64_t ActorUID)
+{
+	std::lock_guard<std::shared_timed_mutex> Lock(RelevancyMutex);
+	Relevancy.Remove(ActorUID);
+}
+
+bool FReferenceServer::QueryRelevancy(uint64_t Observer, std::vector<FRelevancyEntry>& Out, uint64_t& OutStamp)
+{
+	std::shared_lock<std::shared_timed_mutex> Lock(RelevancyMutex);
+	float X, Y;
+	if (!Relevancy.GetPosition(Observer, X, Y))
+	{
+		return false;
+	}
+
+	OutStamp = NowNanoseconds();
+	Relevancy.Query(X, Y, Settings.RelevancyRadius * RelevancyLeaveScale, Observer, Out);
+	return true;
+}
+
+void FReferenceServer::Report(double IntervalSeconds)
+{
+	int64_t Connections = 0;
+	uint64_t MessagesIn = 0, MessagesOut = 0, BytesIn = 0, BytesOut = 0, SlowConsumerDrops = 0;
+	FLatencyHistogram::FCounts Latency;
+
+	for (std::unique_ptr<FServerLoop>& Loop : Loops)
+	{
+		FServerLoopStats& Stats = Loop->GetStats();
+		Connections += Stats.Connections.load(std::memory_order_relaxed);
+		MessagesIn += Stats.MessagesIn.load(std::memory_order_relaxed);
+		MessagesOut += Stats.MessagesOut.load(std::memory_order_relaxed);
+		BytesIn += Stats.BytesIn.load(std::memory_order_relaxed);
+		BytesOut += Stats.BytesOut.load(std::memory_order_relaxed);
+		SlowConsumerDrops += Stats.SlowConsumerDrops.load(std::memory_order_relaxed);
+
+		FLatencyHistogram::FCounts LoopLatency;
+		Stats.FanOutLatency.Take(LoopLatency, true);
+		Latency.Merge(LoopLatency);
+	}
+
+	const double InRate = (MessagesIn - LastMessagesIn) / IntervalSeconds;
+	const double OutRate = (MessagesOut - LastMessagesOut) / IntervalSeconds;
+	printf("conns %" PRId64 " | in %.0f msg/s %.2f MB/s | out %.0f msg/s %.2f MB/s | fan-out x%.1f | latency us p50 %.1f p99 %.1f p99.9 %.1f max %.1f | slow drops %" PRIu64 "\n",
+		Connections,
+		InRate, (BytesIn - LastBytesIn) / IntervalSeconds / (1024.0 * 1024.0),
+		OutRate, (BytesOut - LastBytesOut) / IntervalSeconds / (1024.0 * 1024.0),
+		InRate > 0.0 ? OutRate / InRate : 0.0,
+		Latency.Percentile(0.5) / 1e3, Latency.Percentile(0.99) / 1e3, Latency.Percentile(0.999) / 1e3, Latency.Max / 1e3,
+		SlowConsumerDrops);
+	fflush(stdout);
+
+	LastMessagesIn = MessagesIn;
+	LastMessagesOut = MessagesOut;
+	LastBytesIn = BytesIn;
+	LastBytesOut = BytesOut;
+}
+
+void FReferenceServer::ReportTotals()
+{
+	FMessageDispatchStats Totals;
+	for (std::unique_ptr<FServerLoop>& Loop : Loops)
+	{
+		const FMessageDispatchStats& Stats = Loop->GetDispatchStats();
+		for (size_t Index = 0; Index < FMessageDispatchStats::NumIds; ++Index)
+		{
+			Totals.Entries[Index].Handled += Stats.Entries[Index].Handled;
+			Totals.Entries[Index].Unhandled += Stats.Entries[Index].Unhandled;
+			Totals.Entries[Index].Rejected += Stats.Entries[Index].Rejected;
+		}
+		Totals.Unknown += Stats.Unknown;
+	}
+
+	for (size_t Index = 0; Index < FMessageDispatchStats::NumIds; ++Index)
+	{
+		const FMessageDispatchStats::FEntry& Entry = Totals.Entries[Index];
+		if (Entry.Handled + Entry.Unhandled + Entry.Rejected > 0)
+		{
+			printf("MsgId %zu: %" PRIu64 " handled, %" PRIu64 " unhandled, %" PRIu64 " rejected\n", Index, Entry.Handled, Entry.Unhandled, Entry.Rejected);
+		}
+	}
+	if (Totals.Unknown > 0)
+	{
+		printf("%" PRIu64 " messages with unknown MsgId\n", Totals.Unknown);
+	}
+}
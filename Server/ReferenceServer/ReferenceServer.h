@@ -0,0 +1,110 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+
+#include "ActorDirectory.h"
+#include "ServerLoop.h"
+
+#include "RelevancyGrid.h"
+
+/** Owns the loops and the state they share. */
+class FReferenceServer
+{
+public:
+	struct FSettings
+	{
+		uint16_t Port = 9810;
+
+		/** 0 means one loop per hardware thread. */
+		int32_t NumLoops = 0;
+
+		size_t MaxOutputSize = 8 * 1024 * 1024;
+
+		/**
+		 * Area of interest in cm. 0 sends every move to every session as it arrives. Above 0,
+		 * each session instead gets, every RelevancyInterval seconds, spawns and destroys for
+		 * actors entering and leaving this radius and one S2C_WorldSnapshot of those that moved.
+		 */
+		float RelevancyRadius = 0.f;
+
+		double RelevancyInterval = 0.05;
+
+		/**
+		 * With a relevancy radius, send S2C_CompactSnapshot instead of S2C_WorldSnapshot: quantised
+		 * transforms, each delta-encoded against the last tick the session acknowledged.
+		 */
+		bool bCompactSnapshots = false;
+	};
+
+	explicit FReferenceServer(const FSettings& InSettings);
+	~FReferenceServer();
+
+	bool Start();
+
+	void Stop();
+
+	/** Prints one line of per-interval throughput and latency, and resets the interval counters. */
+	void Report(double IntervalSeconds);
+
+	/** Prints per-MsgId totals. Call after Stop(). */
+	void ReportTotals();
+
+	std::vector<std::unique_ptr<FServerLoop>>& GetLoops() { return Loops; }
+
+	FActorDirectory& GetDirectory() { return Directory; }
+
+	uint64_t AllocateActorUID() { return NextActorUID.fetch_add(1, std::memory_order_relaxed); }
+
+	bool UsesRelevancy() const { return Settings.RelevancyRadius > 0.f; }
+
+	float GetRelevancyRadius() const { return Settings.RelevancyRadius; }
+
+	double GetRelevancyInterval() const { return Settings.RelevancyInterval; }
+
+	bool UsesCompactSnapshots() const { return Settings.bCompactSnapshots; }
+
+	/** Thread-safe. Stamps the move with the current time. */
+	void MoveRelevancy(uint64_t ActorUID, const ProjectM::Actor::Transform& Transform);
+
+	/** Thread-safe. */
+	void RemoveRelevancy(uint64_t ActorUID);
+
+	/**
+	 * Thread-safe. Fills Out with the candidates around Observer, see FRelevantSet::Update, and
+	 * OutStamp with a time no move reflected in Out is newer than, to pass as the next Since.
+	 * Returns false if Observer has no position yet.
+	 */
+	bool QueryRelevancy(uint64_t Observer, std::vector<FRelevancyEntry>& Out, uint64_t& OutStamp);
+
+private:
+	FSettings Settings;
+
+	FActorDirectory Directory;
+
+	std::atomic<uint64_t> NextActorUID{ 1 };
+
+	/** Moves are exclusive and short; every loop's relevancy queries share the lock. */
+	std::shared_timed_mutex RelevancyMutex;
+
+	FRelevancyGrid Relevancy;
+
+	std::vector<std::unique_ptr<FServerLoop>> Loops;
+
+	std::vector<std::thread> Threads;
+
+	/** Running totals at the last Report, to turn the loops' counters into rates. */
+	uint64_t LastMessagesIn = 0;
+
+	uint64_t LastMessagesOut = 0;
+
+	uint64_t LastBytesIn = 0;
+
+	uint64_t LastBytesOut = 0;
+};
@@ -0,0 +1,662 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ServerLoop.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "FrameBuilder.h"
+#include "FrameArena.h"
+#include "BuilderPool.h"
+#include "ProtocolCore.h"
+
+#include "ReferenceServer.h"
+
+namespace
+{
+	using FServerHandlers = TMessageHandlers<FServerLoop, FServerSession&>;
+
+	/** Everything a client sends is untrusted, so every handler verifies. */
+	using FServerDispatcher = FServerHandlers::TDispatcher<
+		FServerHandlers::THandler<MsgId::C2S_Login, ProjectM::Actor::C2S_Login, &FServerLoop::OnLogin, MessageHandlerFlags::Verify>,
+		FServerHandlers::THandler<MsgId::C2S_SyncLocation, ProjectM::Actor::C2S_SyncLocation, &FServerLoop::OnSyncLocation, MessageHandlerFlags::Verify>,
+		FServerHandlers::THandler<MsgId::C2S_Ping, ProjectM::Actor::C2S_Ping, &FServerLoop::OnPing, MessageHandlerFlags::Verify>,
+		FServerHandlers::THandler<MsgId::C2S_SnapshotAck, ProjectM::Actor::C2S_SnapshotAck, &FServerLoop::OnSnapshotAck, MessageHandlerFlags::Verify>>;
+
+	const size_t MaxEvents = 256;
+
+	/** Reads per readable session per iteration, so one busy client cannot starve the rest. */
+	const int32_t MaxReadsPerEvent = 4;
+
+	const size_t MinRecvSize = 16 * 1024;
+
+	uint64_t NowNanoseconds()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	ProjectM::Actor::Transform MakeSpawnTransform()
+	{
+		return ProjectM::Actor::Transform(ProjectM::Actor::Vec3(0.f, 0.f, 0.f), ProjectM::Actor::Vec3(0.f, 0.f, 0.f), ProjectM::Actor::Vec3(1.f, 1.f, 1.f));
+	}
+}
+
+FServerLoop::FServerLoop(FReferenceServer& InServer)
+	: Server(InServer)
+{
+	EpollFd = epoll_create1(EPOLL_CLOEXEC);
+	WakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+	epoll_event Event = {};
+	Event.events = EPOLLIN;
+	Event.data.ptr = &WakeFd;
+	epoll_ctl(EpollFd, EPOLL_CTL_ADD, WakeFd, &Event);
+}
+
+FServerLoop::~FServerLoop()
+{
+	for (auto& Entry : SessionsBySocket)
+	{
+		close(Entry.first);
+	}
+
+	if (ListenSocket >= 0)
+	{
+		close(ListenSocket);
+	}
+	close(WakeFd);
+	close(EpollFd);
+}
+
+bool FServerLoop::Listen(uint16_t Port)
+{
+	ListenSocket = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (ListenSocket < 0)
+	{
+		perror("socket");
+		return false;
+	}
+
+	const int Enable = 1;
+	setsockopt(ListenSocket, SOL_SOCKET, SO_REUSEADDR, &Enable, sizeof(Enable));
+	setsockopt(ListenSocket, SOL_SOCKET, SO_REUSEPORT, &Enable, sizeof(Enable));
+
+	sockaddr_in Address = {};
+	Address.sin_family = AF_INET;
+	Address.sin_addr.s_addr = htonl(INADDR_ANY);
+	Address.sin_port = htons(Port);
+	if (bind(ListenSocket, reinterpret_cast<sockaddr*>(&Address), sizeof(Address)) < 0 || listen(ListenSocket, SOMAXCONN) < 0)
+	{
+		perror("bind/listen");
+		return false;
+	}
+
+	epoll_event Event = {};
+	Event.events = EPOLLIN;
+	Event.data.ptr = &ListenSocket;
+	return epoll_ctl(EpollFd, EPOLL_CTL_ADD, ListenSocket, &Event) == 0;
+}
+
+void FServerLoop::Run()
+{
+	epoll_event Events[MaxEvents];
+
+	const uint64_t RelevancyInterval = static_cast<uint64_t>(Server.GetRelevancyInterval() * 1e9);
+	NextRelevancyTime = NowNanoseconds() + RelevancyInterval;
+
+	// Frames built in one pass of the loop are normally written out by its end.
+	FFrameArena& Arena = FFrameArena::Get();
+	FBuilderPool::Get().SetFrameArena(&Arena);
+
+	while (bRunning.load(std::memory_order_relaxed))
+	{
+		Arena.Reset();
+
+		int32_t Timeout = 100;
+		if (Server.UsesRelevancy())
+		{
+			const uint64_t Now = NowNanoseconds();
+			const uint64_t Remaining = NextRelevancyTime > Now ? NextRelevancyTime - Now : 0;
+			Timeout = static_cast<int32_t>(std::min<uint64_t>(Remaining / 1000000, 100));
+		}
+
+		const int32_t NumEvents = epoll_wait(EpollFd, Events, MaxEvents, Timeout);
+		for (int32_t i = 0; i < NumEvents; ++i)
+		{
+			const epoll_event& Event = Events[i];
+			if (Event.data.ptr == &ListenSocket)
+			{
+				Accept();
+				continue;
+			}
+			if (Event.data.ptr == &WakeFd)
+			{
+				DrainInbox();
+				continue;
+			}
+
+			FServerSession& Session = *static_cast<FServerSession*>(Event.data.ptr);
+			if (Session.bClosing)
+			{
+				continue;
+			}
+			if (Event.events & EPOLLIN)
+			{
+				Read(Session);
+			}
+			else if (Event.events & (EPOLLERR | EPOLLHUP))
+			{
+				Close(Session);
+			}
+			if ((Event.events & EPOLLOUT) && !Session.bClosing)
+			{
+				Write(Session);
+			}
+		}
+
+		if (Server.UsesRelevancy())
+		{
+			const uint64_t Now = NowNanoseconds();
+			if (Now >= NextRelevancyTime)
+			{
+				UpdateRelevancy();
+				// Skip ticks missed while the loop was busy instead of running them back to back.
+				NextRelevancyTime = NextRelevancyTime + RelevancyInterval > Now ? NextRelevancyTime + RelevancyInterval : Now + RelevancyInterval;
+			}
+		}
+
+		FlushBroadcasts();
+
+		for (FServerSession* Session : Dirty)
+		{
+			if (!Session->bClosing)
+			{
+				Write(*Session);
+			}
+		}
+		Dirty.clear();
+
+		DestroyClosedSessions();
+	}
+}
+
+void FServerLoop::Stop()
+{
+	bRunning = false;
+	const uint64_t One = 1;
+	(void)write(WakeFd, &One, sizeof(One));
+}
+
+void FServerLoop::Post(const std::vector<FBroadcastFramePtr>& Frames)
+{
+	bool bWasEmpty;
+	{
+		std::lock_guard<std::mutex> Lock(InboxMutex);
+		bWasEmpty = Inbox.empty();
+		Inbox.insert(Inbox.end(), Frames.begin(), Frames.end());
+	}
+
+	if (bWasEmpty)
+	{
+		const uint64_t One = 1;
+		(void)write(WakeFd, &One, sizeof(One));
+	}
+}
+
+void FServerLoop::DrainInbox()
+{
+	uint64_t Count;
+	(void)read(WakeFd, &Count, sizeof(Count));
+
+	{
+		std::lock_guard<std::mutex> Lock(InboxMutex);
+		InboxScratch.swap(Inbox);
+	}
+
+	Deliver(InboxScratch);
+	InboxScratch.clear();
+}
+
+void FServerLoop::Accept()
+{
+	for (;;)
+	{
+		const int Socket = accept4(ListenSocket, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+		if (Socket < 0)
+		{
+			if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+			{
+				perror("accept4");
+			}
+			return;
+		}
+
+		const int Enable = 1;
+		setsockopt(Socket, IPPROTO_TCP, TCP_NODELAY, &Enable, sizeof(Enable));
+
+		std::unique_ptr<FServerSession> Session(new FServerSession());
+		Session->Socket = Socket;
+		Session->Index = Sessions.size();
+
+		epoll_event Event = {};
+		Event.events = EPOLLIN;
+		Event.data.ptr = Session.get();
+		if (epoll_ctl(EpollFd, EPOLL_CTL_ADD, Socket, &Event) < 0)
+		{
+			close(Socket);
+			continue;
+		}
+
+		Sessions.push_back(Session.get());
+		SessionsBySocket.emplace(Socket, std::move(Session));
+		Stats.Connections.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+void FServerLoop::Read(FServerSession& Session)
+{
+	for (int32_t ReadCount = 0; ReadCount < MaxReadsPerEvent; ++ReadCount)
+	{
+		uint8_t* Buffer = Session.Decoder.GetWriteBuffer(MinRecvSize);
+		const ssize_t Received = recv(Session.Socket, Buffer, Session.Decoder.GetWritableSize(), 0);
+		if (Received > 0)
+		{
+			Session.Decoder.CommitWrite(static_cast<size_t>(Received));
+			Stats.BytesIn.fetch_add(static_cast<uint64_t>(Received), std::memory_order_relaxed);
+			continue;
+		}
+
+		if (Received == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+		{
+			Close(Session);
+			return;
+		}
+		break;
+	}
+
+	Session.ReadTime = NowNanoseconds();
+
+	FFrameView View;
+	while (!Session.bClosing && Session.Decoder.Next(View))
+	{
+		Dispatch(Session, View);
+	}
+
+	if (Session.Decoder.HasError())
+	{
+		Close(Session);
+	}
+}
+
+void FServerLoop::Dispatch(FServerSession& Session, const FFrameView& Frame)
+{
+	ProtocolCore::UnpackFrame(Frame, [this, &Session](MsgId Id, const uint8_t* Data, size_t Size)
+	{
+		Stats.MessagesIn.fetch_add(1, std::memory_order_relaxed);
+		FServerDispatcher::Dispatch(*this, DispatchStats, Id, Data, Size, Session);
+	});
+}
+
+bool FServerLoop::OnLogin(const ProjectM::Actor::C2S_Login& /*msg*/, FServerSession& Session)
+{
+	// Any token is accepted; the reference server has no accounts. Logging in twice is not.
+	if (Session.ActorUID != 0)
+	{
+		return false;
+	}
+
+	// Set before collecting the other actors, so a login racing on another loop either shows up
+	// in the collected list or reaches this session through its broadcast.
+	Session.ActorUID = Server.AllocateActorUID();
+
+	{
+		FBuilderPool::FHandle fbb = FBuilderPool::Get().Acquire(MsgId::S2C_Login);
+		FinishFrame(*fbb, MsgId::S2C_Login, ProjectM::Actor::CreateS2C_Login(*fbb, Session.ActorUID));
+		SendTo(Session, FEncodedFrame::Create(fbb.Release()));
+	}
+
+	const ProjectM::Actor::Transform SpawnTransform = MakeSpawnTransform();
+	if (Server.UsesRelevancy())
+	{
+		// The next relevancy tick sends this session what is around it and spawns it for the
+		// sessions around it.
+		Server.GetDirectory().Set(Session.ActorUID, SpawnTransform);
+		Server.MoveRelevancy(Session.ActorUID, SpawnTransform);
+		return true;
+	}
+
+	std::vector<uint64_t> Ids;
+	std::vector<ProjectM::Actor::Transform> Transforms;
+	Server.GetDirectory().Collect(Session.ActorUID, Ids, Transforms);
+	if (!Ids.empty())
+	{
+		FBuilderPool::FHandle fbb = FBuilderPool::Get().Acquire(MsgId::S2C_SpawnActors);
+		FinishFrame(*fbb, MsgId::S2C_SpawnActors, ProjectM::Actor::CreateS2C_SpawnActorsDirect(*fbb, &Ids, &Transforms));
+		SendTo(Session, FEncodedFrame::Create(fbb.Release()));
+	}
+
+	Server.GetDirectory().Set(Session.ActorUID, SpawnTransform);
+
+	FBuilderPool::FHandle fbb = FBuilderPool::Get().Acquire(MsgId::S2C_SpawnActors);
+	FinishFrame(*fbb, MsgId::S2C_SpawnActors, ProjectM::Actor::CreateS2C_SpawnActors(*fbb, fbb->CreateVector(&Session.ActorUID, 1), fbb->CreateVectorOfStructs(&SpawnTransform, 1)));
+	Broadcast(fbb.Release(), Session.ActorUID, Session.ReadTime);
+	return true;
+}
+
+bool FServerLoop::OnSyncLocation(const ProjectM::Actor::C2S_SyncLocation& msg, FServerSession& Session)
+{
+	const ProjectM::Actor::Transform* Transform = msg.transform();
+	if (Session.ActorUID == 0 || Transform == nullptr)
+	{
+		return false;
+	}
+
+	// The session's own id is used rather than msg.actor_id(), so a client can only move itself.
+	Server.GetDirectory().Set(Session.ActorUID, *Transform);
+	if (Server.UsesRelevancy())
+	{
+		Server.MoveRelevancy(Session.ActorUID, *Transform);
+		return true;
+	}
+
+	FBuilderPool::FHandle fbb = FBuilderPool::Get().Acquire(MsgId::S2C_SyncLocation);
+	FinishFrame(*fbb, MsgId::S2C_SyncLocation, ProjectM::Actor::CreateS2C_SyncLocation(*fbb, Session.ActorUID, Transform));
+	Broadcast(fbb.Release(), Session.ActorUID, Session.ReadTime);
+	return true;
+}
+
+bool FServerLoop::OnPing(const ProjectM::Actor::C2S_Ping& msg, FServerSession& Session)
+{
+	// Answered before login too. The receive time is the read's, so the client does not count
+	// the time the ping waited behind other messages in this read as network delay.
+	FBuilderPool::FHandle fbb = FBuilderPool::Get().Acquire(MsgId::S2C_Pong);
+	FinishFrame(*fbb, MsgId::S2C_Pong, ProjectM::Actor::CreateS2C_Pong(*fbb, msg.client_time(), Session.ReadTime / 1000, NowNanoseconds() / 1000));
+	SendTo(Session, FEncodedFrame::Create(fbb.Release()));
+	return true;
+}
+
+bool FServerLoop::OnSnapshotAck(const ProjectM::Actor::C2S_SnapshotAck& msg, FServerSession& Session)
+{
+	// Acks can be reordered behind a reconnect or forged; never move back or past what was sent.
+	const uint32_t Tick = msg.server_tick();
+	if (Tick > Session.AckedTick && Tick <= RelevancyTick)
+	{
+		Session.AckedTick = Tick;
+	}
+	return true;
+}
+
+void FServerLoop::SendTo(FServerSession& Session, const FEncodedFramePtr& Frame)
+{
+	if (Session.bClosing)
+	{
+		return;
+	}
+
+	const bool bWasEmpty = Session.Output.IsEmpty();
+	if (Session.Output.GetPendingBytes() + Frame->GetSize() > MaxOutputSize)
+	{
+		Stats.SlowConsumerDrops.fetch_add(1, std::memory_order_relaxed);
+		Close(Session);
+		return;
+	}
+
+	Session.Output.Push(Frame);
+	Stats.MessagesOut.fetch_add(1, std::memory_order_relaxed);
+
+	if (bWasEmpty && !Session.bWantsWrite)
+	{
+		Dirty.push_back(&Session);
+	}
+}
+
+void FServerLoop::Broadcast(flatbuffers::DetachedBuffer&& Frame, uint64_t ExcludeActorUID, uint64_t IngressTime)
+{
+	std::shared_ptr<FBroadcastFrame> Shared = std::make_shared<FBroadcastFrame>();
+	Shared->Frame = FEncodedFrame::Create(std::move(Frame));
+	Shared->ExcludeActorUID = ExcludeActorUID;
+	Shared->IngressTime = IngressTime;
+	Outgoing.push_back(std::move(Shared));
+}
+
+void FServerLoop::FlushBroadcasts()
+{
+	std::vector<FBroadcastFramePtr> Sending;
+
+	// Delivering can disconnect slow consumers, whose S2C_DestroyActor lands in Outgoing again.
+	while (!Outgoing.empty())
+	{
+		Sending.swap(Outgoing);
+
+		for (std::unique_ptr<FServerLoop>& Loop : Server.GetLoops())
+		{
+			if (Loop.get() != this)
+			{
+				Loop->Post(Sending);
+			}
+		}
+
+		Deliver(Sending);
+		Sending.clear();
+	}
+}
+
+void FServerLoop::Deliver(const std::vector<FBroadcastFramePtr>& Frames)
+{
+	for (const FBroadcastFramePtr& Entry : Frames)
+	{
+		for (size_t i = 0; i < Sessions.size(); ++i)
+		{
+			FServerSession& Session = *Sessions[i];
+			if (Session.ActorUID != 0 && Session.ActorUID != Entry->ExcludeActorUID)
+			{
+				SendTo(Session, Entry->Frame);
+			}
+		}
+	}
+
+	for (FServerSession* Session : Dirty)
+	{
+		if (!Session->bClosing)
+		{
+			Write(*Session);
+		}
+	}
+	Dirty.clear();
+
+	const uint64_t Now = NowNanoseconds();
+	for (const FBroadcastFramePtr& Entry : Frames)
+	{
+		Stats.FanOutLatency.Record(Now - Entry->IngressTime);
+	}
+}
+
+void FServerLoop::UpdateRelevancy()
+{
+	++RelevancyTick;
+	for (size_t i = 0; i < Sessions.size(); ++i)
+	{
+		FServerSession& Session = *Sessions[i];
+		if (Session.ActorUID != 0 && !Session.bClosing)
+		{
+			UpdateRelevancy(Session);
+		}
+	}
+}
+
+void FServerLoop::UpdateRelevancy(FServerSession& Session)
+{
+	uint64_t Stamp;
+	if (!Server.QueryRelevancy(Session.ActorUID, RelevancyCandidates, Stamp))
+	{
+		return;
+	}
+
+	Session.Relevant.Update(RelevancyCandidates, Server.GetRelevancyRadius(), Session.RelevancyStamp, RelevancyChanges);
+	Session.RelevancyStamp = Stamp;
+
+	FActorDirectory& Directory = Server.GetDirectory();
+	ProjectM::Actor::Transform Transform;
+
+	ScratchIds.clear();
+	ScratchTransforms.clear();
+	for (uint64_t Id : RelevancyChanges.Entered)
+	{
+		// An actor removed since the query leaves again on the next tick.
+		if (Directory.Get(Id, Transform))
+		{
+			ScratchIds.push_back(Id);
+			ScratchTransforms.push_back(Transform);
+		}
+	}
+	if (!ScratchIds.empty())
+	{
+		FBuilderPool::FHandle fbb = FBuilderPool::Get().Acquire(MsgId::S2C_SpawnActors);
+		FinishFrame(*fbb, MsgId::S2C_SpawnActors, ProjectM::Actor::CreateS2C_SpawnActorsDirect(*fbb, &ScratchIds, &ScratchTransforms));
+		SendTo(Session, FEncodedFrame::Create(fbb.Release()));
+	}
+
+	for (uint64_t Id : RelevancyChanges.Left)
+	{
+		// The client drops its baselines on destroy, so a re-entering actor starts from a full state.
+		Session.SentStates.Remove(Id);
+
+		FBuilderPool::FHandle fbb = FBuilderPool::Get().Acquire(MsgId::S2C_DestroyActor);
+		FinishFrame(*fbb, MsgId::S2C_DestroyActor, ProjectM::Actor::CreateS2C_DestroyActor(*fbb, Id));
+		SendTo(Session, FEncodedFrame::Create(fbb.Release()));
+	}
+
+	ScratchIds.clear();
+	ScratchTransforms.clear();
+	for (const FRelevancyEntry& Entry : RelevancyChanges.Updated)
+	{
+		if (Directory.Get(Entry.Id, Transform))
+		{
+			ScratchIds.push_back(Entry.Id);
+			ScratchTransforms.push_back(Transform);
+		}
+	}
+	if (!ScratchIds.empty())
+	{
+		if (Server.UsesCompactSnapshots())
+		{
+			SendCompactSnapshot(Session);
+		}
+		else
+		{
+			FBuilderPool::FHandle fbb = FBuilderPool::Get().Acquire(MsgId::S2C_WorldSnapshot);
+			FinishFrame(*fbb, MsgId::S2C_WorldSnapshot, ProjectM::Actor::CreateS2C_WorldSnapshotDirect(*fbb, RelevancyTick, &ScratchIds, &ScratchTransforms));
+			SendTo(Session, FEncodedFrame::Create(fbb.Release()));
+		}
+
+		const uint64_t Now = NowNanoseconds();
+		for (const FRelevancyEntry& Entry : RelevancyChanges.Updated)
+		{
+			Stats.FanOutLatency.Record(Now > Entry.Stamp ? Now - Entry.Stamp : 0);
+		}
+	}
+}
+
+void FServerLoop::SendCompactSnapshot(FServerSession& Session)
+{
+	// Every entry is encoded against the same acknowledged tick. An actor that was not in that
+	// snapshot has no baseline on either side and goes in full.
+	ScratchBits.clear();
+	{
+		FBitWriter Writer(ScratchBits);
+		for (size_t i = 0; i < ScratchIds.size(); ++i)
+		{
+			const FQuantizedTransform State = TransformCodec::Quantize(ScratchTransforms[i]);
+			const FQuantizedTransform* Baseline = Session.AckedTick != 0 ? Session.SentStates.Find(ScratchIds[i], Session.AckedTick) : nullptr;
+			TransformCodec::Encode(Writer, State, Baseline);
+			Session.SentStates.Record(ScratchIds[i], RelevancyTick, State);
+		}
+	}
+
+	FBuilderPool::FHandle fbb = FBuilderPool::Get().Acquire(MsgId::S2C_CompactSnapshot);
+	FinishFrame(*fbb, MsgId::S2C_CompactSnapshot, ProjectM::Actor::CreateS2C_CompactSnapshotDirect(*fbb, RelevancyTick, Session.AckedTick, &ScratchIds, &ScratchBits));
+	SendTo(Session, FEncodedFrame::Create(fbb.Release()));
+}
+
+void FServerLoop::Write(FServerSession& Session)
+{
+	size_t Sent = 0;
+	const FSendQueue::EFlushResult Result = Session.Output.Flush(Session.Socket, Sent);
+	Stats.BytesOut.fetch_add(static_cast<uint64_t>(Sent), std::memory_order_relaxed);
+
+	if (Result == FSendQueue::EFlushResult::Error)
+	{
+		Close(Session);
+		return;
+	}
+
+	const bool bWantsWrite = Result == FSendQueue::EFlushResult::WouldBlock;
+	if (Session.bWantsWrite != bWantsWrite)
+	{
+		Session.bWantsWrite = bWantsWrite;
+		UpdateInterest(Session);
+	}
+}
+
+void FServerLoop::UpdateInterest(FServerSession& Session)
+{
+	epoll_event Event = {};
+	Event.events = EPOLLIN | (Session.bWantsWrite ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+	Event.data.ptr = &Session;
+	epoll_ctl(EpollFd, EPOLL_CTL_MOD, Session.Socket, &Event);
+}
+
+void FServerLoop::Close(FServerSession& Session)
+{
+	if (Session.bClosing)
+	{
+		return;
+	}
+
+	Session.bClosing = true;
+	epoll_ctl(EpollFd, EPOLL_CTL_DEL, Session.Socket, nullptr);
+	Stats.Connections.fetch_sub(1, std::memory_order_relaxed);
+	Closed.push_back(&Session);
+
+	if (Session.ActorUID != 0)
+	{
+		Server.GetDirectory().Remove(Session.ActorUID);
+		if (Server.UsesRelevancy())
+		{
+			// Observers see it leave on their next relevancy tick.
+			Server.RemoveRelevancy(Session.ActorUID);
+			return;
+		}
+
+		FBuilderPool::FHandle fbb = FBuilderPool::Get().Acquire(MsgId::S2C_DestroyActor);
+		FinishFrame(*fbb, MsgId::S2C_DestroyActor, ProjectM::Actor::CreateS2C_DestroyActor(*fbb, Session.ActorUID));
+		Broadcast(fbb.Release(), Session.ActorUID, NowNanoseconds());
+	}
+}
+
+void FServerLoop::DestroyClosedSessions()
+{
+	for (FServerSession* Session : Closed)
+	{
+		FServerSession* Last = Sessions.back();
+		Sessions[Session->Index] = Last;
+		Last->Index = Session->Index;
+		Sessions.pop_back();
+
+		const int Socket = Session->Socket;
+		close(Socket);
+		SessionsBySocket.erase(Socket);
+	}
+	Closed.clear();
+}
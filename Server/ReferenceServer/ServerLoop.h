@@ -0,0 +1,218 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "flatbuffers/flatbuffers.h"
+
+#include "MsgId.h"
+#include "FrameDecoder.h"
+#include "EncodedFrame.h"
+#include "MessageDispatcher.h"
+#include "ProjectM_generated.h"
+#include "TransformCodec.h"
+
+#include "LatencyHistogram.h"
+#include "RelevancyGrid.h"
+#include "SendQueue.h"
+
+class FReferenceServer;
+
+/** A frame going to every logged-in session except ExcludeActorUID. Immutable once posted. */
+struct FBroadcastFrame
+{
+	FEncodedFramePtr Frame;
+
+	uint64_t ExcludeActorUID = 0;
+
+	/** steady_clock nanoseconds when the message that caused this broadcast was read. */
+	uint64_t IngressTime = 0;
+};
+
+using FBroadcastFramePtr = std::shared_ptr<const FBroadcastFrame>;
+
+struct FServerSession
+{
+	int Socket = -1;
+
+	uint64_t ActorUID = 0;
+
+	FFrameDecoder Decoder{ 16 * 1024 };
+
+	/** Frames not yet fully accepted by the kernel. Broadcasts are shared, not copied, into it. */
+	FSendQueue Output;
+
+	bool bWantsWrite = false;
+
+	bool bClosing = false;
+
+	/** Position in FServerLoop::Sessions, for O(1) removal. */
+	size_t Index = 0;
+
+	/** steady_clock nanoseconds of the read currently being dispatched. */
+	uint64_t ReadTime = 0;
+
+	/** Actors this session has been sent a spawn for. Only used with a relevancy radius. */
+	FRelevantSet Relevant;
+
+	/** Stamp of the last relevancy query; moves newer than this go into the next snapshot. */
+	uint64_t RelevancyStamp = 0;
+
+	/** With compact snapshots, the state each actor was last sent in, per tick, to delta against once acked. */
+	FTransformBaselineHistory SentStates;
+
+	/** Newest snapshot tick the client acknowledged decoding. 0 until the first ack. */
+	uint32_t AckedTick = 0;
+};
+
+/** Counters a loop publishes for the reporter thread. */
+struct FServerLoopStats
+{
+	std::atomic<int64_t> Connections{ 0 };
+
+	std::atomic<uint64_t> MessagesIn{ 0 };
+
+	std::atomic<uint64_t> BytesIn{ 0 };
+
+	/** Frames written to sessions, i.e. broadcast fan-out plus direct replies. */
+	std::atomic<uint64_t> MessagesOut{ 0 };
+
+	std::atomic<uint64_t> BytesOut{ 0 };
+
+	std::atomic<uint64_t> SlowConsumerDrops{ 0 };
+
+	/**
+	 * Read of the causing message to handing the broadcast to the kernel, per frame per loop.
+	 * With a relevancy radius, the move to queueing the snapshot that carries it, per recipient.
+	 */
+	FLatencyHistogram FanOutLatency;
+};
+
+/**
+ * One epoll event loop on its own thread. Every loop listens on the same port with
+ * SO_REUSEPORT, so the kernel shards new connections across loops and a session is only ever
+ * touched by the loop that accepted it. Broadcasts produced during one loop iteration are
+ * delivered to local sessions directly and handed to every other loop in one Post() each.
+ */
+class FServerLoop
+{
+public:
+	explicit FServerLoop(FReferenceServer& InServer);
+	~FServerLoop();
+
+	bool Listen(uint16_t Port);
+
+	/** Thread body. Returns after Stop(). */
+	void Run();
+
+	/** Thread-safe. */
+	void Stop();
+
+	/** Thread-safe. Queues frames produced by another loop for delivery to this loop's sessions. */
+	void Post(const std::vector<FBroadcastFramePtr>& Frames);
+
+	FServerLoopStats& GetStats() { return Stats; }
+
+	// Message handlers, see ServerLoop.cpp for the dispatch table. False rejects the message.
+	bool OnLogin(const ProjectM::Actor::C2S_Login& msg, FServerSession& Session);
+
+	bool OnSyncLocation(const ProjectM::Actor::C2S_SyncLocation& msg, FServerSession& Session);
+
+	bool OnPing(const ProjectM::Actor::C2S_Ping& msg, FServerSession& Session);
+
+	bool OnSnapshotAck(const ProjectM::Actor::C2S_SnapshotAck& msg, FServerSession& Session);
+
+	const FMessageDispatchStats& GetDispatchStats() const { return DispatchStats; }
+
+	/** Largest backlog a session may have before it is disconnected as a slow consumer. */
+	size_t MaxOutputSize = 8 * 1024 * 1024;
+
+private:
+	void Accept();
+
+	void Read(FServerSession& Session);
+
+	void Dispatch(FServerSession& Session, const FFrameView& Frame);
+
+	void Write(FServerSession& Session);
+
+	void Close(FServerSession& Session);
+
+	void DestroyClosedSessions();
+
+	void SendTo(FServerSession& Session, const FEncodedFramePtr& Frame);
+
+	void Broadcast(flatbuffers::DetachedBuffer&& Frame, uint64_t ExcludeActorUID, uint64_t IngressTime);
+
+	/** Delivers Outgoing here and on every other loop. Called once per iteration. */
+	void FlushBroadcasts();
+
+	void Deliver(const std::vector<FBroadcastFramePtr>& Frames);
+
+	void DrainInbox();
+
+	void UpdateInterest(FServerSession& Session);
+
+	/** Sends every session its spawns, destroys and snapshot for the current relevancy tick. */
+	void UpdateRelevancy();
+
+	void UpdateRelevancy(FServerSession& Session);
+
+	/** Encodes ScratchIds/ScratchTransforms as an S2C_CompactSnapshot against the session's acked tick. */
+	void SendCompactSnapshot(FServerSession& Session);
+
+	FReferenceServer& Server;
+
+	int EpollFd = -1;
+
+	int ListenSocket = -1;
+
+	/** Wakes the loop when another loop posts frames or on Stop(). */
+	int WakeFd = -1;
+
+	std::atomic<bool> bRunning{ true };
+
+	std::unordered_map<int, std::unique_ptr<FServerSession>> SessionsBySocket;
+
+	std::vector<FServerSession*> Sessions;
+
+	std::vector<FServerSession*> Closed;
+
+	/** Sessions that were appended to this iteration and need a write attempt. */
+	std::vector<FServerSession*> Dirty;
+
+	std::vector<FBroadcastFramePtr> Outgoing;
+
+	std::mutex InboxMutex;
+
+	std::vector<FBroadcastFramePtr> Inbox;
+
+	/** Swapped with Inbox under the lock so delivery runs unlocked. */
+	std::vector<FBroadcastFramePtr> InboxScratch;
+
+	/** steady_clock nanoseconds of the next UpdateRelevancy. */
+	uint64_t NextRelevancyTime = 0;
+
+	uint32_t RelevancyTick = 0;
+
+	std::vector<FRelevancyEntry> RelevancyCandidates;
+
+	FRelevancyChanges RelevancyChanges;
+
+	std::vector<uint64_t> ScratchIds;
+
+	std::vector<ProjectM::Actor::Transform> ScratchTransforms;
+
+	std::vector<uint8_t> ScratchBits;
+
+	FMessageDispatchStats DispatchStats;
+
+	FServerLoopStats Stats;
+};
@@ -0,0 +1,216 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+/**
+ * Measures FRelevancyGrid and FRelevantSet with every entity both moving and observing, the way
+ * the reference server uses them. Each tick moves every entity (single-threaded, the grid is not
+ * thread-safe for writes), then computes every entity's enter, leave and update sets, split over
+ * 1..N threads (queries are read-only).
+ *
+ * Build from this directory:
+ *
+ *   g++ -std=c++14 -O2 -pthread -I../Common Main.cpp ../Common/RelevancyGrid.cpp -o RelevancyBench
+ *
+ * Usage: RelevancyBench [--entities 10000] [--radius 5000] [--density 50] [--speed 600] [--ticks 100] [--cell 1]
+ *   density  average entities within radius of each other, which sets the world size
+ *   speed    cm per second; ticks are 50 ms apart
+ *   cell     grid cell size as a multiple of the leave radius
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "RelevancyGrid.h"
+
+namespace
+{
+	const double TickSeconds = 0.05;
+
+	struct FEntity
+	{
+		float X;
+
+		float Y;
+
+		float Heading;
+	};
+
+	struct FObserver
+	{
+		FRelevantSet Relevant;
+
+		FRelevancyChanges Changes;
+	};
+
+	struct FWorkerTotals
+	{
+		uint64_t Entered = 0;
+
+		uint64_t Left = 0;
+
+		uint64_t Updated = 0;
+
+		uint64_t Relevant = 0;
+	};
+
+	double Seconds()
+	{
+		return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+}
+
+int main(int argc, char** argv)
+{
+	int32_t NumEntities = 10000;
+	float Radius = 5000.f;
+	float Density = 50.f;
+	float Speed = 600.f;
+	int32_t NumTicks = 100;
+	float CellScale = 1.f;
+
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (strcmp(argv[i], "--entities") == 0)
+		{
+			NumEntities = atoi(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "--radius") == 0)
+		{
+			Radius = static_cast<float>(atof(argv[i + 1]));
+		}
+		else if (strcmp(argv[i], "--density") == 0)
+		{
+			Density = static_cast<float>(atof(argv[i + 1]));
+		}
+		else if (strcmp(argv[i], "--speed") == 0)
+		{
+			Speed = static_cast<float>(atof(argv[i + 1]));
+		}
+		else if (strcmp(argv[i], "--cell") == 0)
+		{
+			CellScale = static_cast<float>(atof(argv[i + 1]));
+		}
+		else if (strcmp(argv[i], "--ticks") == 0)
+		{
+			NumTicks = atoi(argv[i + 1]);
+		}
+		else
+		{
+			fprintf(stderr, "Unknown option %s\n", argv[i]);
+			return 1;
+		}
+	}
+
+	const float LeaveRadius = Radius * 1.1f;
+	const float WorldSize = std::sqrt(NumEntities * 3.14159265f * Radius * Radius / Density);
+	const float Step = static_cast<float>(Speed * TickSeconds);
+
+	std::vector<int32_t> ThreadCounts = { 1, 2, 4 };
+	const int32_t HardwareThreads = static_cast<int32_t>(std::thread::hardware_concurrency());
+	if (HardwareThreads > 4)
+	{
+		ThreadCounts.push_back(HardwareThreads);
+	}
+
+	printf("%d entities, radius %.0f cm, world %.0f cm square, %.0f cm per tick, %d ticks, %d hardware threads\n",
+		NumEntities, Radius, WorldSize, Step, NumTicks, HardwareThreads);
+	printf("%8s %10s %10s %10s %10s %10s %10s %10s\n", "threads", "move ms", "query ms", "tick ms", "relevant", "entered", "left", "updated");
+
+	for (int32_t NumThreads : ThreadCounts)
+	{
+		std::mt19937 Random(1234);
+		std::uniform_real_distribution<float> Position(0.f, WorldSize);
+		std::uniform_real_distribution<float> Turn(-0.3f, 0.3f);
+
+		std::vector<FEntity> Entities(NumEntities);
+		for (FEntity& Entity : Entities)
+		{
+			Entity.X = Position(Random);
+			Entity.Y = Position(Random);
+			Entity.Heading = Position(Random);
+		}
+
+		FRelevancyGrid Grid(LeaveRadius * CellScale);
+		std::vector<FObserver> Observers(NumEntities);
+		std::vector<uint64_t> Stamps(NumEntities, 0);
+		std::vector<FWorkerTotals> Totals(NumThreads);
+		std::vector<std::vector<FRelevancyEntry>> Candidates(NumThreads);
+
+		double MoveTime = 0.0;
+		double QueryTime = 0.0;
+
+		// Tick 0 fills the grid and every observer's set and is not measured.
+		for (int32_t Tick = 0; Tick <= NumTicks; ++Tick)
+		{
+			const double MoveStart = Seconds();
+			for (int32_t i = 0; i < NumEntities; ++i)
+			{
+				FEntity& Entity = Entities[i];
+				Entity.Heading += Turn(Random);
+				Entity.X = std::min(std::max(Entity.X + Step * std::cos(Entity.Heading), 0.f), WorldSize);
+				Entity.Y = std::min(std::max(Entity.Y + Step * std::sin(Entity.Heading), 0.f), WorldSize);
+				Grid.Move(static_cast<uint64_t>(i) + 1, Entity.X, Entity.Y, static_cast<uint64_t>(Tick) + 1);
+			}
+			const double QueryStart = Seconds();
+
+			const uint64_t Since = static_cast<uint64_t>(Tick);
+			auto Work = [&](int32_t Worker)
+			{
+				FWorkerTotals& Total = Totals[Worker];
+				std::vector<FRelevancyEntry>& Scratch = Candidates[Worker];
+				for (int32_t i = Worker; i < NumEntities; i += NumThreads)
+				{
+					FObserver& Observer = Observers[i];
+					Grid.Query(Entities[i].X, Entities[i].Y, LeaveRadius, static_cast<uint64_t>(i) + 1, Scratch);
+					Observer.Relevant.Update(Scratch, Radius, Since, Observer.Changes);
+					if (Tick > 0)
+					{
+						Total.Entered += Observer.Changes.Entered.size();
+						Total.Left += Observer.Changes.Left.size();
+						Total.Updated += Observer.Changes.Updated.size();
+						Total.Relevant += Observer.Relevant.GetRelevant().size();
+					}
+				}
+			};
+
+			std::vector<std::thread> Threads;
+			for (int32_t Worker = 1; Worker < NumThreads; ++Worker)
+			{
+				Threads.emplace_back(Work, Worker);
+			}
+			Work(0);
+			for (std::thread& Thread : Threads)
+			{
+				Thread.join();
+			}
+
+			if (Tick > 0)
+			{
+				MoveTime += QueryStart - MoveStart;
+				QueryTime += Seconds() - QueryStart;
+			}
+		}
+
+		FWorkerTotals Total;
+		for (const FWorkerTotals& WorkerTotal : Totals)
+		{
+			Total.Entered += WorkerTotal.Entered;
+			Total.Left += WorkerTotal.Left;
+			Total.Updated += WorkerTotal.Updated;
+			Total.Relevant += WorkerTotal.Relevant;
+		}
+
+		const double PerObserverTick = static_cast<double>(NumEntities) * NumTicks;
+		printf("%8d %10.3f %10.3f %10.3f %10.1f %10.2f %10.2f %10.1f\n", NumThreads,
+			MoveTime * 1000.0 / NumTicks, QueryTime * 1000.0 / NumTicks, (MoveTime + QueryTime) * 1000.0 / NumTicks,
+			Total.Relevant / PerObserverTick, Total.Entered / PerObserverTick, Total.Left / PerObserverTick, Total.Updated / PerObserverTick);
+	}
+
+	return 0;
+}
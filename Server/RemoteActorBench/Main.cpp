@@ -0,0 +1,257 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+/**
+ * Per-frame cost of keeping --actors remote actors up to date on the game thread, with the
+ * UID lookup done two ways:
+ *
+ *   scan   what FindCharacterByUID did: collect every character, as GetAllActorsOfClass
+ *          does into a fresh array, and walk it, for every actor in every message
+ *   index  what UNetActorRegistry does: one hash map lookup per actor
+ *
+ * The engine's part of the frame, SetActorTransform and the movement components, needs a
+ * world and is not here. What is timed is everything the network side adds per frame, with
+ * plain structs standing in for the characters: at --fps, every third frame decodes and
+ * verifies an S2C_WorldSnapshot of every actor, looks each one up and pushes it into the
+ * FSnapshotInterpolator; every frame interpolates all of them and writes the result to the
+ * stand-in character. Snapshot frames and the frames between them are reported separately,
+ * as p50 and max in microseconds.
+ *
+ * Build from this directory:
+ *
+ *   g++ -std=c++14 -O2 -I../../Source/SocketSample -I../../Source/SocketSample/flatbuffer/include Main.cpp -o RemoteActorBench
+ *
+ * Usage: RemoteActorBench [--actors 5000] [--frames 120] [--fps 60]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "flatbuffers/flatbuffers.h"
+
+#include "FrameBuilder.h"
+#include "SnapshotInterpolation.h"
+#include "ProjectM_generated.h"
+
+namespace
+{
+	/** Stands in for ASocketSampleCharacter. */
+	struct FCharacter
+	{
+		uint64_t ActorUID = 0;
+
+		float Location[3] = { 0.f, 0.f, 0.f };
+
+		float Rotation[4] = { 0.f, 0.f, 0.f, 1.f };
+	};
+
+	/** The spread of frame times in one group, in microseconds. */
+	struct FFrameTimes
+	{
+		std::vector<double> Times;
+
+		double Percentile(double Quantile)
+		{
+			if (Times.empty())
+			{
+				return 0.0;
+			}
+			std::sort(Times.begin(), Times.end());
+			return Times[static_cast<size_t>(Quantile * (Times.size() - 1))];
+		}
+	};
+
+	class FWorld
+	{
+	public:
+		explicit FWorld(int32_t NumActors)
+			: Characters(NumActors)
+		{
+			for (int32_t Index = 0; Index < NumActors; ++Index)
+			{
+				Characters[Index].ActorUID = static_cast<uint64_t>(Index) * 7919 + 1;
+				Registry[Characters[Index].ActorUID] = &Characters[Index];
+			}
+		}
+
+		FCharacter* FindByScan(uint64_t UID) const
+		{
+			std::vector<FCharacter*> Found;
+			for (const FCharacter& Character : Characters)
+			{
+				Found.push_back(const_cast<FCharacter*>(&Character));
+			}
+			for (FCharacter* Character : Found)
+			{
+				if (Character->ActorUID == UID)
+				{
+					return Character;
+				}
+			}
+			return nullptr;
+		}
+
+		FCharacter* FindByIndex(uint64_t UID) const
+		{
+			const auto Found = Registry.find(UID);
+			return Found != Registry.end() ? Found->second : nullptr;
+		}
+
+		std::vector<FCharacter> Characters;
+
+		std::unordered_map<uint64_t, FCharacter*> Registry;
+	};
+
+	flatbuffers::DetachedBuffer BuildSnapshot(const FWorld& World, uint32_t Tick, std::mt19937& Random)
+	{
+		std::uniform_real_distribution<float> Coordinate(-50000.f, 50000.f);
+
+		std::vector<uint64_t> Ids;
+		std::vector<ProjectM::Actor::Transform> Transforms;
+		for (const FCharacter& Character : World.Characters)
+		{
+			Ids.push_back(Character.ActorUID);
+			Transforms.emplace_back(ProjectM::Actor::Vec3(Coordinate(Random), Coordinate(Random), 100.f),
+				ProjectM::Actor::Vec3(0.f, Tick * 3.f, 0.f), ProjectM::Actor::Vec3(1.f, 1.f, 1.f));
+		}
+		// Shuffled, since the server's relevancy order has nothing to do with the client's actor order.
+		std::vector<size_t> Order(Ids.size());
+		for (size_t Index = 0; Index < Order.size(); ++Index)
+		{
+			Order[Index] = Index;
+		}
+		std::shuffle(Order.begin(), Order.end(), Random);
+		std::vector<uint64_t> ShuffledIds;
+		std::vector<ProjectM::Actor::Transform> ShuffledTransforms;
+		for (size_t Index : Order)
+		{
+			ShuffledIds.push_back(Ids[Index]);
+			ShuffledTransforms.push_back(Transforms[Index]);
+		}
+
+		flatbuffers::FlatBufferBuilder fbb(1024 + Ids.size() * 48);
+		FinishFrame(fbb, MsgId::S2C_WorldSnapshot, ProjectM::Actor::CreateS2C_WorldSnapshotDirect(fbb, Tick, &ShuffledIds, &ShuffledTransforms));
+		return fbb.Release();
+	}
+
+	/** Runs NumFrames frames. Returns false if a snapshot failed to verify or named an unknown actor. */
+	template<typename FindType>
+	bool RunFrames(FWorld& World, const std::vector<flatbuffers::DetachedBuffer>& Snapshots, int32_t NumFrames, double Fps, FindType&& Find, FFrameTimes& SnapshotFrames, FFrameTimes& OtherFrames)
+	{
+		FSnapshotInterpolator Interpolator;
+		bool bPassed = true;
+
+		for (int32_t Frame = 0; Frame < NumFrames; ++Frame)
+		{
+			const double Now = Frame / Fps;
+			const bool bSnapshotFrame = Frame % 3 == 0;
+			const std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+
+			if (bSnapshotFrame)
+			{
+				const flatbuffers::DetachedBuffer& Snapshot = Snapshots[(Frame / 3) % Snapshots.size()];
+				const uint8_t* Body = Snapshot.data() + FFrameHeader::Size;
+				const size_t Size = Snapshot.size() - FFrameHeader::Size;
+
+				flatbuffers::Verifier Verifier(Body, Size, 64, 4000000);
+				if (!Verifier.VerifyBuffer<ProjectM::Actor::S2C_WorldSnapshot>(nullptr))
+				{
+					return false;
+				}
+
+				const ProjectM::Actor::S2C_WorldSnapshot* msg = flatbuffers::GetRoot<ProjectM::Actor::S2C_WorldSnapshot>(Body);
+				for (flatbuffers::uoffset_t i = 0; i < msg->actor_id()->size(); ++i)
+				{
+					const uint64_t UID = msg->actor_id()->Get(i);
+					if (Find(World, UID) == nullptr)
+					{
+						bPassed = false;
+						continue;
+					}
+					Interpolator.Push(UID, FTransformSample(Now, *msg->transform()->Get(i)));
+				}
+			}
+
+			Interpolator.Update(Now, [&World, &Find](uint64_t UID, const FTransformSample& Sample)
+			{
+				if (FCharacter* Character = Find(World, UID))
+				{
+					memcpy(Character->Location, Sample.Location, sizeof(Character->Location));
+					memcpy(Character->Rotation, Sample.Rotation, sizeof(Character->Rotation));
+				}
+			});
+
+			const double Time = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - Start).count();
+			(bSnapshotFrame ? SnapshotFrames : OtherFrames).Times.push_back(Time);
+		}
+
+		return bPassed;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	int32_t NumActors = 5000;
+	int32_t NumFrames = 120;
+	double Fps = 60.0;
+
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (strcmp(argv[i], "--actors") == 0)
+		{
+			NumActors = std::max(1, atoi(argv[i + 1]));
+		}
+		else if (strcmp(argv[i], "--frames") == 0)
+		{
+			NumFrames = std::max(3, atoi(argv[i + 1]));
+		}
+		else if (strcmp(argv[i], "--fps") == 0)
+		{
+			Fps = std::max(1.0, atof(argv[i + 1]));
+		}
+		else
+		{
+			fprintf(stderr, "Unknown option %s\n", argv[i]);
+			return 1;
+		}
+	}
+
+	FWorld World(NumActors);
+	std::mt19937 Random(5);
+	std::vector<flatbuffers::DetachedBuffer> Snapshots;
+	for (uint32_t Tick = 1; Tick <= 8; ++Tick)
+	{
+		Snapshots.push_back(BuildSnapshot(World, Tick, Random));
+	}
+
+	bool bPassed = true;
+	printf("%d actors, %d frames at %.0f fps, a snapshot every third frame, microseconds per frame:\n", NumActors, NumFrames, Fps);
+	printf("  %-6s %14s %14s %14s %14s\n", "lookup", "snapshot p50", "snapshot max", "other p50", "other max");
+	for (bool bIndex : { true, false })
+	{
+		FFrameTimes SnapshotFrames;
+		FFrameTimes OtherFrames;
+		if (bIndex)
+		{
+			bPassed &= RunFrames(World, Snapshots, NumFrames, Fps, [](const FWorld& InWorld, uint64_t UID) { return InWorld.FindByIndex(UID); }, SnapshotFrames, OtherFrames);
+		}
+		else
+		{
+			bPassed &= RunFrames(World, Snapshots, NumFrames, Fps, [](const FWorld& InWorld, uint64_t UID) { return InWorld.FindByScan(UID); }, SnapshotFrames, OtherFrames);
+		}
+
+		printf("  %-6s %14.0f %14.0f %14.0f %14.0f\n", bIndex ? "index" : "scan",
+			SnapshotFrames.Percentile(0.5), SnapshotFrames.Percentile(1.0), OtherFrames.Percentile(0.5), OtherFrames.Percentile(1.0));
+	}
+
+	if (!bPassed)
+	{
+		printf("FAILED: a snapshot did not verify or named an actor that does not exist\n");
+	}
+	return bPassed ? 0 : 1;
+}
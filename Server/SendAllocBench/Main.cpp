@@ -0,0 +1,174 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+/**
+ * Counts heap allocations per C2S_SyncLocation on the client's send path by replacing the
+ * global operator new and delete. Each mode runs --warmup messages first, then counts and
+ * times --messages more:
+ *
+ *   legacy   what Move() did before the in-place frame: C2S_SyncLocationT with its
+ *            unique_ptr<Transform>, a new FlatBufferBuilder, and a std::vector the header and
+ *            body were copied into
+ *   build    ProtocolCore::MakeSyncLocation: FBuilderPool, FinishFrame, DetachedBuffer
+ *   send     build, then what Move() and the transport do with it: pushed into the
+ *            FCoalescingOutbox under the actor's latest-value key, popped, written to a
+ *            stand-in socket buffer and freed
+ *
+ * The tool exits 1 if build or send allocates in steady state.
+ *
+ * Build from this directory:
+ *
+ *   g++ -std=c++14 -O2 -pthread -I../../Source/SocketSample -I../../Source/SocketSample/flatbuffer/include Main.cpp -o SendAllocBench
+ *
+ * Usage: SendAllocBench [--messages 1000000] [--warmup 10000]
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <vector>
+
+#include "CoalescingOutbox.h"
+#include "FrameBuilder.h"
+#include "ProtocolCore.h"
+#include "ProjectM_generated.h"
+
+namespace
+{
+	std::atomic<uint64_t> NumAllocations{ 0 };
+
+	void* Allocate(size_t Size)
+	{
+		NumAllocations.fetch_add(1, std::memory_order_relaxed);
+		if (void* Memory = malloc(Size ? Size : 1))
+		{
+			return Memory;
+		}
+		throw std::bad_alloc();
+	}
+}
+
+void* operator new(size_t Size) { return Allocate(Size); }
+void* operator new[](size_t Size) { return Allocate(Size); }
+void operator delete(void* Memory) noexcept { free(Memory); }
+void operator delete[](void* Memory) noexcept { free(Memory); }
+void operator delete(void* Memory, size_t) noexcept { free(Memory); }
+void operator delete[](void* Memory, size_t) noexcept { free(Memory); }
+
+namespace
+{
+	const uint64_t ActorUID = 42;
+
+	/** Stands in for the socket: the bytes are copied out, as send() would. */
+	uint8_t SocketBuffer[4096];
+
+	uint64_t Checksum = 0;
+
+	ProjectM::Actor::Transform MakeTransform(uint64_t Index)
+	{
+		const float X = static_cast<float>(Index % 1000);
+		return ProjectM::Actor::Transform(ProjectM::Actor::Vec3(X, -X, 100.f), ProjectM::Actor::Vec3(0.f, X * 0.36f, 0.f), ProjectM::Actor::Vec3(1.f, 1.f, 1.f));
+	}
+
+	void SendLegacy(uint64_t Index)
+	{
+		flatbuffers::FlatBufferBuilder fbb;
+		ProjectM::Actor::C2S_SyncLocationT loc;
+		loc.actor_id = ActorUID;
+		loc.transform = std::unique_ptr<ProjectM::Actor::Transform>(new ProjectM::Actor::Transform(MakeTransform(Index)));
+		fbb.Finish(ProjectM::Actor::C2S_SyncLocation::Pack(fbb, &loc));
+
+		uint32_t head = ((uint32_t)MsgId::C2S_SyncLocation << 16) | (4 + fbb.GetSize());
+		std::vector<uint8_t> buf(4 + fbb.GetSize());
+		memcpy(&buf[0], &head, sizeof(head));
+		memcpy(&buf[sizeof(head)], fbb.GetBufferPointer(), fbb.GetSize());
+
+		memcpy(SocketBuffer, buf.data(), std::min(buf.size(), sizeof(SocketBuffer)));
+		Checksum += buf.size();
+	}
+
+	void SendBuild(uint64_t Index)
+	{
+		const flatbuffers::DetachedBuffer Frame = ProtocolCore::MakeSyncLocation(ActorUID, MakeTransform(Index));
+		Checksum += Frame.size();
+	}
+
+	void SendThroughOutbox(FCoalescingOutbox& Outbox, flatbuffers::DetachedBuffer& InFlight, uint64_t Index)
+	{
+		Outbox.Push(ProtocolCore::MakeSyncLocation(ActorUID, MakeTransform(Index)), FCoalescingOutbox::MakeKey(MsgId::C2S_SyncLocation, ActorUID));
+		while (Outbox.Pop(InFlight))
+		{
+			memcpy(SocketBuffer, InFlight.data(), std::min(InFlight.size(), sizeof(SocketBuffer)));
+			Checksum += InFlight.size();
+		}
+		InFlight = flatbuffers::DetachedBuffer();
+	}
+
+	template<typename SendType>
+	void Measure(const char* Name, uint64_t NumMessages, uint64_t NumWarmup, SendType&& Send, double& OutAllocations)
+	{
+		for (uint64_t Index = 0; Index < NumWarmup; ++Index)
+		{
+			Send(Index);
+		}
+
+		const uint64_t StartAllocations = NumAllocations.load();
+		const std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+		for (uint64_t Index = 0; Index < NumMessages; ++Index)
+		{
+			Send(NumWarmup + Index);
+		}
+		const double Time = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - Start).count() / NumMessages;
+
+		OutAllocations = static_cast<double>(NumAllocations.load() - StartAllocations) / NumMessages;
+		printf("  %-8s %8.3f allocations/message %8.1f ns/message\n", Name, OutAllocations, Time);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	uint64_t NumMessages = 1000000;
+	uint64_t NumWarmup = 10000;
+
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (strcmp(argv[i], "--messages") == 0)
+		{
+			NumMessages = static_cast<uint64_t>(std::max(1LL, atoll(argv[i + 1])));
+		}
+		else if (strcmp(argv[i], "--warmup") == 0)
+		{
+			NumWarmup = static_cast<uint64_t>(std::max(0LL, atoll(argv[i + 1])));
+		}
+		else
+		{
+			fprintf(stderr, "Unknown option %s\n", argv[i]);
+			return 1;
+		}
+	}
+
+	printf("C2S_SyncLocation, %llu messages after %llu warm-up:\n", static_cast<unsigned long long>(NumMessages), static_cast<unsigned long long>(NumWarmup));
+
+	double Legacy = 0.0;
+	double Build = 0.0;
+	double Send = 0.0;
+	Measure("legacy", NumMessages, NumWarmup, SendLegacy, Legacy);
+	Measure("build", NumMessages, NumWarmup, SendBuild, Build);
+
+	FCoalescingOutbox Outbox;
+	flatbuffers::DetachedBuffer InFlight;
+	Measure("send", NumMessages, NumWarmup, [&Outbox, &InFlight](uint64_t Index) { SendThroughOutbox(Outbox, InFlight, Index); }, Send);
+
+	printf("(checksum %llu)\n", static_cast<unsigned long long>(Checksum));
+
+	const bool bPassed = Build == 0.0 && Send == 0.0;
+	if (!bPassed)
+	{
+		printf("FAILED: the pooled send path allocates in steady state\n");
+	}
+	return bPassed ? 0 : 1;
+}
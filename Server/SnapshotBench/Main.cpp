@@ -0,0 +1,226 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+/**
+ * Compares the two ways the server can tell a client where N actors are:
+ *
+ *   snapshot  one S2C_WorldSnapshot with every actor's id and transform
+ *   sync      one S2C_SyncLocation frame per actor
+ *
+ * For 100, 1000 and 10000 actors it reports the bytes on the wire, including frame headers,
+ * and the time to build the frames into a send buffer and to decode them again the way the
+ * client does: header, flatbuffers verification, then every transform read. Builders are
+ * reused, as FBuilderPool would, so the times are encoding work rather than allocation.
+ * The median round is reported. The tool exits 1 if either form decodes to different
+ * transforms than were built.
+ *
+ * Build from this directory:
+ *
+ *   g++ -std=c++14 -O2 -I../../Source/SocketSample -I../../Source/SocketSample/flatbuffer/include Main.cpp -o SnapshotBench
+ *
+ * Usage: SnapshotBench [--rounds 9]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "FrameBuilder.h"
+#include "FrameHeader.h"
+#include "ProjectM_generated.h"
+
+namespace
+{
+	struct FResult
+	{
+		size_t Bytes = 0;
+
+		double BuildTime = 0.0;
+
+		double DecodeTime = 0.0;
+
+		bool bMatched = false;
+	};
+
+	double Sum(const ProjectM::Actor::Transform& Transform)
+	{
+		return Transform.location().x() + Transform.location().y() + Transform.location().z() + Transform.rotation().y();
+	}
+
+	void Append(std::vector<uint8_t>& Stream, const flatbuffers::FlatBufferBuilder& fbb)
+	{
+		Stream.insert(Stream.end(), fbb.GetBufferPointer(), fbb.GetBufferPointer() + fbb.GetSize());
+	}
+
+	void BuildSnapshot(flatbuffers::FlatBufferBuilder& fbb, const std::vector<uint64_t>& Ids, const std::vector<ProjectM::Actor::Transform>& Transforms, std::vector<uint8_t>& Stream)
+	{
+		fbb.Clear();
+		FinishFrame(fbb, MsgId::S2C_WorldSnapshot, ProjectM::Actor::CreateS2C_WorldSnapshotDirect(fbb, 1, &Ids, &Transforms));
+		Append(Stream, fbb);
+	}
+
+	void BuildSync(flatbuffers::FlatBufferBuilder& fbb, const std::vector<uint64_t>& Ids, const std::vector<ProjectM::Actor::Transform>& Transforms, std::vector<uint8_t>& Stream)
+	{
+		for (size_t i = 0; i < Ids.size(); ++i)
+		{
+			fbb.Clear();
+			FinishFrame(fbb, MsgId::S2C_SyncLocation, ProjectM::Actor::CreateS2C_SyncLocation(fbb, Ids[i], &Transforms[i]));
+			Append(Stream, fbb);
+		}
+	}
+
+	/** Decodes every frame in Stream and returns the sum of what was read, or NAN on a bad frame. */
+	double Decode(const std::vector<uint8_t>& Stream, size_t& NumActors)
+	{
+		double Checksum = 0.0;
+		NumActors = 0;
+
+		size_t Offset = 0;
+		while (Offset < Stream.size())
+		{
+			FFrameHeader Header;
+			if (Stream.size() - Offset < FFrameHeader::Size || !Header.Decode(&Stream[Offset]) || Stream.size() - Offset < Header.GetFrameSize())
+			{
+				return NAN;
+			}
+
+			const uint8_t* Body = &Stream[Offset + FFrameHeader::Size];
+			flatbuffers::Verifier Verifier(Body, Header.BodySize);
+			if (Header.Id == MsgId::S2C_WorldSnapshot)
+			{
+				if (!Verifier.VerifyBuffer<ProjectM::Actor::S2C_WorldSnapshot>(nullptr))
+				{
+					return NAN;
+				}
+
+				const ProjectM::Actor::S2C_WorldSnapshot* Snapshot = flatbuffers::GetRoot<ProjectM::Actor::S2C_WorldSnapshot>(Body);
+				const flatbuffers::Vector<uint64_t>* Ids = Snapshot->actor_id();
+				const flatbuffers::Vector<const ProjectM::Actor::Transform*>* Transforms = Snapshot->transform();
+				if (Ids == nullptr || Transforms == nullptr || Ids->size() != Transforms->size())
+				{
+					return NAN;
+				}
+				for (flatbuffers::uoffset_t i = 0; i < Ids->size(); ++i)
+				{
+					Checksum += Ids->Get(i) + Sum(*Transforms->Get(i));
+				}
+				NumActors += Ids->size();
+			}
+			else if (Header.Id == MsgId::S2C_SyncLocation)
+			{
+				if (!Verifier.VerifyBuffer<ProjectM::Actor::S2C_SyncLocation>(nullptr))
+				{
+					return NAN;
+				}
+
+				const ProjectM::Actor::S2C_SyncLocation* Sync = flatbuffers::GetRoot<ProjectM::Actor::S2C_SyncLocation>(Body);
+				if (Sync->transform() == nullptr)
+				{
+					return NAN;
+				}
+				Checksum += Sync->actor_id() + Sum(*Sync->transform());
+				++NumActors;
+			}
+			else
+			{
+				return NAN;
+			}
+
+			Offset += Header.GetFrameSize();
+		}
+
+		return Checksum;
+	}
+
+	template<typename BuildType>
+	FResult Measure(BuildType&& Build, const std::vector<uint64_t>& Ids, const std::vector<ProjectM::Actor::Transform>& Transforms, double Expected, int32_t Rounds)
+	{
+		flatbuffers::FlatBufferBuilder fbb(1024);
+		std::vector<uint8_t> Stream;
+
+		std::vector<double> BuildTimes;
+		std::vector<double> DecodeTimes;
+		FResult Result;
+		Result.bMatched = true;
+
+		for (int32_t Round = 0; Round < Rounds; ++Round)
+		{
+			// Capacity is kept, as a send buffer's would be.
+			Stream.clear();
+
+			const std::chrono::steady_clock::time_point BuildStart = std::chrono::steady_clock::now();
+			Build(fbb, Ids, Transforms, Stream);
+			const std::chrono::steady_clock::time_point DecodeStart = std::chrono::steady_clock::now();
+			size_t NumActors = 0;
+			const double Checksum = Decode(Stream, NumActors);
+			const std::chrono::steady_clock::time_point End = std::chrono::steady_clock::now();
+
+			BuildTimes.push_back(std::chrono::duration<double, std::nano>(DecodeStart - BuildStart).count());
+			DecodeTimes.push_back(std::chrono::duration<double, std::nano>(End - DecodeStart).count());
+			Result.bMatched &= NumActors == Ids.size() && Checksum == Expected;
+		}
+
+		std::sort(BuildTimes.begin(), BuildTimes.end());
+		std::sort(DecodeTimes.begin(), DecodeTimes.end());
+		Result.Bytes = Stream.size();
+		Result.BuildTime = BuildTimes[BuildTimes.size() / 2];
+		Result.DecodeTime = DecodeTimes[DecodeTimes.size() / 2];
+		return Result;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	int32_t Rounds = 9;
+
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (strcmp(argv[i], "--rounds") == 0)
+		{
+			Rounds = std::max(1, atoi(argv[i + 1]));
+		}
+		else
+		{
+			fprintf(stderr, "Unknown option %s\n", argv[i]);
+			return 1;
+		}
+	}
+
+	bool bPassed = true;
+
+	printf("median of %d rounds, per frame set and per actor:\n", Rounds);
+	printf("%8s %-9s %10s %8s %12s %12s %10s %10s\n", "actors", "form", "bytes", "B/actor", "build us", "decode us", "build ns", "decode ns");
+	for (int32_t NumActors : { 100, 1000, 10000 })
+	{
+		std::mt19937 Random(7);
+		std::uniform_real_distribution<float> Coordinate(-50000.f, 50000.f);
+		std::uniform_real_distribution<float> Angle(0.f, 360.f);
+
+		std::vector<uint64_t> Ids;
+		std::vector<ProjectM::Actor::Transform> Transforms;
+		double Expected = 0.0;
+		for (int32_t Actor = 0; Actor < NumActors; ++Actor)
+		{
+			Ids.push_back(static_cast<uint64_t>(Actor + 1));
+			Transforms.emplace_back(ProjectM::Actor::Vec3(Coordinate(Random), Coordinate(Random), 100.f),
+				ProjectM::Actor::Vec3(0.f, Angle(Random), 0.f), ProjectM::Actor::Vec3(1.f, 1.f, 1.f));
+			Expected += Ids.back() + Sum(Transforms.back());
+		}
+
+		const FResult Snapshot = Measure(BuildSnapshot, Ids, Transforms, Expected, Rounds);
+		const FResult Sync = Measure(BuildSync, Ids, Transforms, Expected, Rounds);
+		for (const FResult* Result : { &Snapshot, &Sync })
+		{
+			printf("%8d %-9s %10zu %8.1f %12.1f %12.1f %10.1f %10.1f%s\n", NumActors, Result == &Snapshot ? "snapshot" : "sync",
+				Result->Bytes, static_cast<double>(Result->Bytes) / NumActors, Result->BuildTime / 1000.0, Result->DecodeTime / 1000.0,
+				Result->BuildTime / NumActors, Result->DecodeTime / NumActors, Result->bMatched ? "" : "  MISMATCH");
+			bPassed &= Result->bMatched;
+		}
+	}
+
+	return bPassed ? 0 : 1;
+}
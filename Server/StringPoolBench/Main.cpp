@@ -0,0 +1,207 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+/**
+ * Measures FlatBufferBuilder::CreateSharedString with the default std::set string pool against
+ * the hash pool (the builder's hash_string_pool constructor argument) on three workloads:
+ *
+ *   chat    chat lines: sender names from a few hundred players, mostly unique text, a few
+ *           stock phrases
+ *   names   an actor name table: a few hundred distinct names over many actors
+ *   paths   asset paths: long shared prefixes, the worst case for ordered comparisons
+ *
+ * Every string of a workload goes through CreateSharedString and the results into a vector as
+ * the root. Both pools must produce identical bytes; the tool exits 1 if they do not.
+ *
+ * Build from this directory:
+ *
+ *   g++ -std=c++14 -O2 -I../../Source/SocketSample/flatbuffer/include Main.cpp -o StringPoolBench
+ *
+ * Usage: StringPoolBench [--strings 100000] [--rounds 7]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "flatbuffers/flatbuffers.h"
+
+namespace
+{
+	struct FWorkload
+	{
+		const char* Name;
+
+		std::vector<std::string> Strings;
+	};
+
+	/** Index in [0, Count), skewed towards small values the way popularity usually is. */
+	size_t Skewed(std::mt19937& Random, size_t Count)
+	{
+		std::uniform_real_distribution<double> Uniform(0.0, 1.0);
+		const double Value = Uniform(Random);
+		return std::min(Count - 1, static_cast<size_t>(Value * Value * Value * Count));
+	}
+
+	std::string RandomWord(std::mt19937& Random, int32_t MinLength, int32_t MaxLength)
+	{
+		std::uniform_int_distribution<int32_t> Length(MinLength, MaxLength);
+		std::uniform_int_distribution<int32_t> Letter('a', 'z');
+		std::string Word(static_cast<size_t>(Length(Random)), ' ');
+		for (char& Character : Word)
+		{
+			Character = static_cast<char>(Letter(Random));
+		}
+		return Word;
+	}
+
+	std::vector<FWorkload> MakeWorkloads(int32_t NumStrings)
+	{
+		std::mt19937 Random(5);
+		std::uniform_int_distribution<int32_t> Percent(0, 99);
+		std::vector<FWorkload> Workloads;
+
+		// Alternating sender and line; a fifth of the lines are stock phrases.
+		{
+			std::vector<std::string> Players;
+			for (int32_t i = 0; i < 300; ++i)
+			{
+				Players.push_back(RandomWord(Random, 4, 14));
+			}
+			const std::vector<std::string> Phrases = { "gg", "lol", "wp", "need heal", "on my way", "thanks!", "afk 5 min", "push mid" };
+
+			FWorkload Chat{ "chat", {} };
+			while (static_cast<int32_t>(Chat.Strings.size()) < NumStrings)
+			{
+				Chat.Strings.push_back(Players[Skewed(Random, Players.size())]);
+				if (Percent(Random) < 20)
+				{
+					Chat.Strings.push_back(Phrases[Skewed(Random, Phrases.size())]);
+				}
+				else
+				{
+					std::string Line;
+					for (int32_t Word = 0, Words = 3 + Percent(Random) % 10; Word < Words; ++Word)
+					{
+						Line += RandomWord(Random, 2, 8) + " ";
+					}
+					Chat.Strings.push_back(Line);
+				}
+			}
+			Chat.Strings.resize(NumStrings);
+			Workloads.push_back(Chat);
+		}
+
+		{
+			std::vector<std::string> Names;
+			for (int32_t i = 0; i < 500; ++i)
+			{
+				Names.push_back("BP_" + RandomWord(Random, 5, 12) + "_C");
+			}
+
+			FWorkload Table{ "names", {} };
+			for (int32_t i = 0; i < NumStrings; ++i)
+			{
+				Table.Strings.push_back(Names[Skewed(Random, Names.size())]);
+			}
+			Workloads.push_back(Table);
+		}
+
+		{
+			const std::vector<std::string> Roots = { "/Game/Characters/", "/Game/Environment/Props/", "/Game/Environment/Foliage/", "/Game/FX/Particles/", "/Game/UI/Widgets/" };
+			std::vector<std::string> Assets;
+			for (int32_t i = 0; i < 4000; ++i)
+			{
+				const std::string Folder = Roots[i % Roots.size()] + RandomWord(Random, 6, 10) + "/";
+				const std::string Asset = "SM_" + RandomWord(Random, 6, 16);
+				Assets.push_back(Folder + Asset + "." + Asset);
+			}
+
+			FWorkload Paths{ "paths", {} };
+			for (int32_t i = 0; i < NumStrings; ++i)
+			{
+				Paths.Strings.push_back(Assets[Skewed(Random, Assets.size())]);
+			}
+			Workloads.push_back(Paths);
+		}
+
+		return Workloads;
+	}
+
+	/** Nanoseconds per string. */
+	double Build(flatbuffers::FlatBufferBuilder& fbb, const std::vector<std::string>& Strings, std::vector<flatbuffers::Offset<flatbuffers::String>>& Offsets)
+	{
+		fbb.Clear();
+		Offsets.clear();
+
+		const std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+		for (const std::string& String : Strings)
+		{
+			Offsets.push_back(fbb.CreateSharedString(String));
+		}
+		fbb.Finish(fbb.CreateVector(Offsets));
+
+		return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - Start).count() / Strings.size();
+	}
+}
+
+int main(int argc, char** argv)
+{
+	int32_t NumStrings = 100000;
+	int32_t Rounds = 7;
+
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (strcmp(argv[i], "--strings") == 0)
+		{
+			NumStrings = std::max(1, atoi(argv[i + 1]));
+		}
+		else if (strcmp(argv[i], "--rounds") == 0)
+		{
+			Rounds = std::max(1, atoi(argv[i + 1]));
+		}
+		else
+		{
+			fprintf(stderr, "Unknown option %s\n", argv[i]);
+			return 1;
+		}
+	}
+
+	printf("%-6s %8s %10s %10s %10s %9s %10s\n", "", "strings", "duplicate", "set ns", "hash ns", "speedup", "bytes");
+
+	bool bIdentical = true;
+	for (const FWorkload& Workload : MakeWorkloads(NumStrings))
+	{
+		const std::unordered_set<std::string> Unique(Workload.Strings.begin(), Workload.Strings.end());
+
+		flatbuffers::FlatBufferBuilder Ordered;
+		flatbuffers::FlatBufferBuilder Hashed(1024, nullptr, false, flatbuffers::AlignOf<flatbuffers::largest_scalar_t>(), true);
+		std::vector<flatbuffers::Offset<flatbuffers::String>> Offsets;
+
+		std::vector<double> SetTimes;
+		std::vector<double> HashTimes;
+		for (int32_t Round = 0; Round < Rounds; ++Round)
+		{
+			SetTimes.push_back(Build(Ordered, Workload.Strings, Offsets));
+			HashTimes.push_back(Build(Hashed, Workload.Strings, Offsets));
+		}
+		std::sort(SetTimes.begin(), SetTimes.end());
+		std::sort(HashTimes.begin(), HashTimes.end());
+
+		const bool bSame = Ordered.GetSize() == Hashed.GetSize() && memcmp(Ordered.GetBufferPointer(), Hashed.GetBufferPointer(), Ordered.GetSize()) == 0;
+		bIdentical = bIdentical && bSame;
+
+		const double SetTime = SetTimes[SetTimes.size() / 2];
+		const double HashTime = HashTimes[HashTimes.size() / 2];
+		printf("%-6s %8zu %9.1f%% %10.1f %10.1f %8.1fx %10u%s\n", Workload.Name, Workload.Strings.size(),
+			100.0 * (Workload.Strings.size() - Unique.size()) / Workload.Strings.size(), SetTime, HashTime, SetTime / HashTime,
+			Ordered.GetSize(), bSame ? "" : "  MISMATCH");
+	}
+
+	return bIdentical ? 0 : 1;
+}
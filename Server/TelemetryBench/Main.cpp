@@ -0,0 +1,270 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+/**
+ * Measures what FNetTelemetry costs on the client's receive path. A recorded stream of
+ * S2C_SyncLocation, S2C_WorldSnapshot and S2C_Pong frames is dispatched through the same
+ * TMessageHandlers table shape as ASocketPlayerController, with verification on and handlers
+ * that look actors up and push their transforms into the real FSnapshotInterpolator, once bare
+ * and once wrapped in FNetTelemetry::RecordHandled. Passes alternate, the overhead of each
+ * round is taken against the bare pass next to it, and the median round is reported. Exits 1
+ * if the default configuration costs more than --limit percent of handler time. Linux only.
+ *
+ * Build from this directory:
+ *
+ *   g++ -std=c++14 -O2 -I../../Source/SocketSample -I../../Source/SocketSample/flatbuffer/include \
+ *       Main.cpp -o TelemetryBench
+ *
+ * Usage: TelemetryBench [--messages 200000] [--rounds 15] [--actors 256] [--snapshot 16] [--limit 1]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "MessageDispatcher.h"
+#include "NetTelemetry.h"
+#include "ProtocolCore.h"
+#include "SnapshotInterpolation.h"
+
+namespace
+{
+	struct FRecordedFrame
+	{
+		MsgId Id;
+
+		std::vector<uint8_t> Bytes;
+	};
+
+	/** Stands in for the controller: a registry lookup and PushRemoteTransform per actor. */
+	class FFakeClient
+	{
+	public:
+		explicit FFakeClient(int32_t NumActors)
+		{
+			for (int32_t Actor = 1; Actor <= NumActors; ++Actor)
+			{
+				Registry[static_cast<uint64_t>(Actor)] = Actor;
+			}
+		}
+
+		bool SyncTransform(const ProjectM::Actor::S2C_SyncLocation& msg, int)
+		{
+			Push(msg.actor_id(), *msg.transform());
+			return true;
+		}
+
+		bool ApplySnapshot(const ProjectM::Actor::S2C_WorldSnapshot& msg, int)
+		{
+			const flatbuffers::Vector<uint64_t>* Ids = msg.actor_id();
+			const flatbuffers::Vector<const ProjectM::Actor::Transform*>* Transforms = msg.transform();
+			for (flatbuffers::uoffset_t i = 0; i < std::min(Ids->size(), Transforms->size()); ++i)
+			{
+				Push(Ids->Get(i), *Transforms->Get(i));
+			}
+			return true;
+		}
+
+		bool OnPong(const ProjectM::Actor::S2C_Pong& msg, int)
+		{
+			Checksum += msg.server_send_time() - msg.server_receive_time();
+			return true;
+		}
+
+		uint64_t Checksum = 0;
+
+	private:
+		void Push(uint64_t UID, const ProjectM::Actor::Transform& Transform)
+		{
+			if (Registry.find(UID) == Registry.end())
+			{
+				return;
+			}
+
+			Time += 0.001;
+			Interpolation.Push(UID, FTransformSample(Time, Transform));
+			++Checksum;
+		}
+
+		std::unordered_map<uint64_t, int32_t> Registry;
+
+		FSnapshotInterpolator Interpolation;
+
+		double Time = 0.0;
+	};
+
+	using FHandlers = TMessageHandlers<FFakeClient, int>;
+
+	using FDispatcher = FHandlers::TDispatcher<
+		FHandlers::THandler<MsgId::S2C_SyncLocation, ProjectM::Actor::S2C_SyncLocation, &FFakeClient::SyncTransform, MessageHandlerFlags::Verify>,
+		FHandlers::THandler<MsgId::S2C_WorldSnapshot, ProjectM::Actor::S2C_WorldSnapshot, &FFakeClient::ApplySnapshot, MessageHandlerFlags::Verify>,
+		FHandlers::THandler<MsgId::S2C_Pong, ProjectM::Actor::S2C_Pong, &FFakeClient::OnPong, MessageHandlerFlags::Verify>>;
+
+	FRecordedFrame Record(flatbuffers::FlatBufferBuilder& fbb, MsgId Id)
+	{
+		FRecordedFrame Frame;
+		Frame.Id = Id;
+		Frame.Bytes.assign(fbb.GetBufferPointer() + FFrameHeader::Size, fbb.GetBufferPointer() + fbb.GetSize());
+		fbb.Clear();
+		return Frame;
+	}
+
+	/** 70% single moves, 25% snapshots, the rest pongs. */
+	std::vector<FRecordedFrame> MakeStream(int32_t NumMessages, int32_t NumActors, int32_t SnapshotSize)
+	{
+		std::mt19937 Random(7);
+		std::uniform_int_distribution<int32_t> Kind(0, 99);
+		std::uniform_int_distribution<uint64_t> Actor(1, static_cast<uint64_t>(NumActors));
+		std::uniform_real_distribution<float> Coordinate(-5000.f, 5000.f);
+
+		auto MakeTransform = [&]()
+		{
+			return ProjectM::Actor::Transform(ProjectM::Actor::Vec3(Coordinate(Random), Coordinate(Random), 90.f),
+				ProjectM::Actor::Vec3(0.f, Coordinate(Random) / 30.f, 0.f), ProjectM::Actor::Vec3(1.f, 1.f, 1.f));
+		};
+
+		flatbuffers::FlatBufferBuilder fbb;
+		std::vector<FRecordedFrame> Stream;
+		Stream.reserve(NumMessages);
+		for (int32_t i = 0; i < NumMessages; ++i)
+		{
+			const int32_t Roll = Kind(Random);
+			if (Roll < 70)
+			{
+				const ProjectM::Actor::Transform Transform = MakeTransform();
+				FinishFrame(fbb, MsgId::S2C_SyncLocation, ProjectM::Actor::CreateS2C_SyncLocation(fbb, Actor(Random), &Transform));
+				Stream.push_back(Record(fbb, MsgId::S2C_SyncLocation));
+			}
+			else if (Roll < 95)
+			{
+				std::vector<uint64_t> Ids;
+				std::vector<ProjectM::Actor::Transform> Transforms;
+				for (int32_t j = 0; j < SnapshotSize; ++j)
+				{
+					Ids.push_back(Actor(Random));
+					Transforms.push_back(MakeTransform());
+				}
+				FinishFrame(fbb, MsgId::S2C_WorldSnapshot, ProjectM::Actor::CreateS2C_WorldSnapshotDirect(fbb, static_cast<uint32_t>(i), &Ids, &Transforms));
+				Stream.push_back(Record(fbb, MsgId::S2C_WorldSnapshot));
+			}
+			else
+			{
+				FinishFrame(fbb, MsgId::S2C_Pong, ProjectM::Actor::CreateS2C_Pong(fbb, i, 1000 + i, 1010 + i));
+				Stream.push_back(Record(fbb, MsgId::S2C_Pong));
+			}
+		}
+		return Stream;
+	}
+
+	/** Nanoseconds per message for one pass over Stream, through Telemetry if it is set. */
+	double RunPass(const std::vector<FRecordedFrame>& Stream, FFakeClient& Client, FMessageDispatchStats& Stats, FNetTelemetry* Telemetry)
+	{
+		const std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+		for (const FRecordedFrame& Frame : Stream)
+		{
+			const uint8_t* Data = Frame.Bytes.data();
+			const size_t Size = Frame.Bytes.size();
+			if (Telemetry)
+			{
+				Telemetry->RecordHandled(Frame.Id, FFrameHeader::Size + Size, [&]()
+				{
+					FDispatcher::Dispatch(Client, Stats, Frame.Id, Data, Size, 0);
+				});
+			}
+			else
+			{
+				FDispatcher::Dispatch(Client, Stats, Frame.Id, Data, Size, 0);
+			}
+		}
+		return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - Start).count() / Stream.size();
+	}
+}
+
+int main(int argc, char** argv)
+{
+	int32_t NumMessages = 200000;
+	int32_t Rounds = 15;
+	int32_t NumActors = 256;
+	int32_t SnapshotSize = 16;
+	double Limit = 1.0;
+
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (strcmp(argv[i], "--messages") == 0)
+		{
+			NumMessages = atoi(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "--rounds") == 0)
+		{
+			Rounds = atoi(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "--actors") == 0)
+		{
+			NumActors = atoi(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "--snapshot") == 0)
+		{
+			SnapshotSize = atoi(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "--limit") == 0)
+		{
+			Limit = atof(argv[i + 1]);
+		}
+		else
+		{
+			fprintf(stderr, "Unknown option %s\n", argv[i]);
+			return 1;
+		}
+	}
+
+	const std::vector<FRecordedFrame> Stream = MakeStream(NumMessages, NumActors, SnapshotSize);
+	FFakeClient Client(NumActors);
+	FMessageDispatchStats Stats;
+
+	std::unique_ptr<FNetTelemetry> Sampled(new FNetTelemetry());
+	std::unique_ptr<FNetTelemetry> Full(new FNetTelemetry());
+	Full->TimingSampleShift = 0;
+
+	// Warm the caches and the per-actor buffers before anything is measured.
+	RunPass(Stream, Client, Stats, nullptr);
+
+	std::vector<double> Bare;
+	std::vector<double> SampledOverhead;
+	std::vector<double> FullOverhead;
+	for (int32_t Round = 0; Round < Rounds; ++Round)
+	{
+		const double BareTime = RunPass(Stream, Client, Stats, nullptr);
+		const double SampledTime = RunPass(Stream, Client, Stats, Sampled.get());
+		const double FullTime = RunPass(Stream, Client, Stats, Full.get());
+		const double BareAgain = RunPass(Stream, Client, Stats, nullptr);
+
+		// Against the mean of the bare passes either side, so drift across the round cancels.
+		const double Baseline = (BareTime + BareAgain) * 0.5;
+		Bare.push_back(Baseline);
+		SampledOverhead.push_back((SampledTime - Baseline) / Baseline * 100.0);
+		FullOverhead.push_back((FullTime - Baseline) / Baseline * 100.0);
+	}
+
+	auto Median = [](std::vector<double> Values)
+	{
+		std::sort(Values.begin(), Values.end());
+		return Values[Values.size() / 2];
+	};
+
+	const double MedianOverhead = Median(SampledOverhead);
+	printf("%d messages x %d rounds, median round:\n", NumMessages, Rounds);
+	printf("  bare                   %8.1f ns/message\n", Median(Bare));
+	printf("  telemetry, timing 1/%-3u %+7.2f%%\n", 1u << Sampled->TimingSampleShift, MedianOverhead);
+	printf("  telemetry, timing all  %+7.2f%%\n", Median(FullOverhead));
+
+	std::unique_ptr<FNetTelemetry::FCounts> Counts(new FNetTelemetry::FCounts());
+	Sampled->Take(*Counts);
+	printf("\n%s", FNetTelemetry::ToCsv(*Counts, 1.0).c_str());
+	printf("(checksum %llu)\n", static_cast<unsigned long long>(Client.Checksum));
+
+	return MedianOverhead <= Limit ? 0 : 1;
+}
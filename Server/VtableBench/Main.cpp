@@ -0,0 +1,111 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+/**
+ * Measures FlatBufferBuilder::EndTable's vtable deduplication on buffers of 10^3 to 10^5
+ * tables, scanning every earlier vtable (the flatbuffers default) against the hash index
+ * (IndexVtables). Each table sets a different combination of up to 20 uint32 fields, so a
+ * buffer holds up to --layouts distinct vtables, the way a world dump holding many table types
+ * would. Both strategies must produce identical bytes; the tool exits 1 if they do not.
+ *
+ * Build from this directory:
+ *
+ *   g++ -std=c++14 -O2 -I../../Source/SocketSample/flatbuffer/include Main.cpp -o VtableBench
+ *
+ * Usage: VtableBench [--layouts 0] [--rounds 3]
+ *   layouts  distinct vtables per buffer; 0 makes every table's vtable different
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "flatbuffers/flatbuffers.h"
+
+namespace
+{
+	const int32_t NumFields = 20;
+
+	/** Builds NumTables tables and a vector of them as the root. Returns milliseconds. */
+	double Build(flatbuffers::FlatBufferBuilder& fbb, int32_t NumTables, int32_t NumLayouts, bool bIndex)
+	{
+		fbb.Clear();
+		fbb.IndexVtables(bIndex);
+
+		std::vector<flatbuffers::Offset<void>> Tables;
+		Tables.reserve(NumTables);
+
+		const std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+		for (int32_t i = 0; i < NumTables; ++i)
+		{
+			// Layout numbers start at 1 so every table sets at least one field.
+			const uint32_t Layout = static_cast<uint32_t>(NumLayouts > 0 ? i % NumLayouts : i) + 1;
+			const flatbuffers::uoffset_t TableStart = fbb.StartTable();
+			for (int32_t Field = 0; Field < NumFields; ++Field)
+			{
+				if (Layout & (1u << Field))
+				{
+					fbb.AddElement<uint32_t>(flatbuffers::FieldIndexToOffset(static_cast<flatbuffers::voffset_t>(Field)), static_cast<uint32_t>(i + 1), 0);
+				}
+			}
+			Tables.push_back(flatbuffers::Offset<void>(fbb.EndTable(TableStart)));
+		}
+		fbb.Finish(fbb.CreateVector(Tables));
+
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Start).count();
+	}
+}
+
+int main(int argc, char** argv)
+{
+	int32_t NumLayouts = 0;
+	int32_t Rounds = 3;
+
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (strcmp(argv[i], "--layouts") == 0)
+		{
+			NumLayouts = atoi(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "--rounds") == 0)
+		{
+			Rounds = std::max(1, atoi(argv[i + 1]));
+		}
+		else
+		{
+			fprintf(stderr, "Unknown option %s\n", argv[i]);
+			return 1;
+		}
+	}
+
+	printf("%8s %10s %12s %12s %9s %10s\n", "tables", "vtables", "scan ms", "index ms", "speedup", "bytes");
+
+	bool bIdentical = true;
+	for (int32_t NumTables : { 1000, 3000, 10000, 30000, 100000 })
+	{
+		flatbuffers::FlatBufferBuilder Scanned;
+		flatbuffers::FlatBufferBuilder Indexed;
+
+		std::vector<double> ScanTimes;
+		std::vector<double> IndexTimes;
+		for (int32_t Round = 0; Round < Rounds; ++Round)
+		{
+			ScanTimes.push_back(Build(Scanned, NumTables, NumLayouts, false));
+			IndexTimes.push_back(Build(Indexed, NumTables, NumLayouts, true));
+		}
+		std::sort(ScanTimes.begin(), ScanTimes.end());
+		std::sort(IndexTimes.begin(), IndexTimes.end());
+
+		const bool bSame = Scanned.GetSize() == Indexed.GetSize() && memcmp(Scanned.GetBufferPointer(), Indexed.GetBufferPointer(), Scanned.GetSize()) == 0;
+		bIdentical = bIdentical && bSame;
+
+		const double ScanTime = ScanTimes[ScanTimes.size() / 2];
+		const double IndexTime = IndexTimes[IndexTimes.size() / 2];
+		printf("%8d %10d %12.2f %12.2f %8.1fx %10u%s\n", NumTables, NumLayouts > 0 ? std::min(NumLayouts, NumTables) : NumTables,
+			ScanTime, IndexTime, ScanTime / IndexTime, Scanned.GetSize(), bSame ? "" : "  MISMATCH");
+	}
+
+	return bIdentical ? 0 : 1;
+}
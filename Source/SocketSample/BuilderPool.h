@@ -0,0 +1,213 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "flatbuffers/flatbuffers.h"
+
+#include "MsgId.h"
+#include "FrameBuilder.h"
+#include "FrameArena.h"
+
+/**
+ * Per-thread pool of FlatBufferBuilders, keyed by MsgId.
+ *
+ * Builders are Clear()ed and reused instead of being constructed for every message, and each
+ * MsgId remembers how large its recent messages were so a builder starts out big enough for
+ * the next one. All buffers come from FPooledFrameAllocator, so a builder whose buffer was
+ * Release()d to the transport gets a recycled block on its next use. With SetFrameArena,
+ * builders draw from the thread's FFrameArena instead.
+ *
+ * Each thread has its own pool (see Get), so there is no locking on the acquire/return path.
+ */
+class FBuilderPool
+{
+public:
+	/** Smallest initial size handed to a new builder. */
+	static const size_t MinInitialSize = 256;
+
+	/** Arena chunks that may stay pinned by unsent frames before Release copies frames out of it. */
+	static const size_t MaxPinnedChunks = 4;
+
+	/** Scoped loan of a builder. Goes back to the pool when destroyed. */
+	class FHandle
+	{
+	public:
+		FHandle(FHandle&& Other)
+			: Pool(Other.Pool)
+			, Id(Other.Id)
+			, Generation(Other.Generation)
+			, Builder(std::move(Other.Builder))
+		{
+		}
+
+		~FHandle()
+		{
+			if (Builder)
+			{
+				const size_t Size = Builder->GetSize();
+				Pool.Return(Id, Generation, std::move(Builder), Size);
+			}
+		}
+
+		flatbuffers::FlatBufferBuilder& operator*() const { return *Builder; }
+
+		flatbuffers::FlatBufferBuilder* operator->() const { return Builder.get(); }
+
+		/** Detaches the finished buffer and records its size for this MsgId's history. */
+		flatbuffers::DetachedBuffer Release()
+		{
+			const size_t Size = Builder->GetSize();
+			flatbuffers::DetachedBuffer Buffer = Builder->Release();
+			// A frame still queued at the end of the tick pins its arena chunk. While too many
+			// are pinned, e.g. behind a stalled receiver, frames are copied out instead.
+			if (Pool.Arena && Pool.Arena->GetNumPinnedChunks() > MaxPinnedChunks)
+			{
+				Buffer = FFrameArena::Escape(Buffer);
+			}
+			Pool.Return(Id, Generation, std::move(Builder), Size);
+			return Buffer;
+		}
+
+	private:
+		friend class FBuilderPool;
+
+		FHandle(FBuilderPool& InPool, MsgId InId, uint32_t InGeneration, std::unique_ptr<flatbuffers::FlatBufferBuilder>&& InBuilder)
+			: Pool(InPool)
+			, Id(InId)
+			, Generation(InGeneration)
+			, Builder(std::move(InBuilder))
+		{
+		}
+
+		FHandle(const FHandle&) = delete;
+		FHandle& operator=(const FHandle&) = delete;
+
+		FBuilderPool& Pool;
+
+		MsgId Id;
+
+		/** The pool's ArenaGeneration when the builder was lent. */
+		uint32_t Generation;
+
+		std::unique_ptr<flatbuffers::FlatBufferBuilder> Builder;
+	};
+
+	/** The calling thread's pool. */
+	static FBuilderPool& Get()
+	{
+		static thread_local FBuilderPool Instance;
+		return Instance;
+	}
+
+	FHandle Acquire(MsgId Id)
+	{
+		FSlot& Slot = GetSlot(Id);
+
+		std::unique_ptr<flatbuffers::FlatBufferBuilder> Builder;
+		if (!Slot.Free.empty())
+		{
+			Builder = std::move(Slot.Free.back());
+			Slot.Free.pop_back();
+		}
+		else
+		{
+			flatbuffers::Allocator* Allocator = Arena ? static_cast<flatbuffers::Allocator*>(Arena) : &FPooledFrameAllocator::Get();
+			Builder.reset(new flatbuffers::FlatBufferBuilder(Slot.InitialSize, Allocator));
+		}
+
+		return FHandle(*this, Id, ArenaGeneration, std::move(Builder));
+	}
+
+	/**
+	 * Builds in InArena, which must be this thread's and is Reset by the caller every frame or
+	 * tick, or in FPooledFrameAllocator if null. Builders on loan when it changes are dropped
+	 * when they come back rather than pooled with their old allocator.
+	 */
+	void SetFrameArena(FFrameArena* InArena)
+	{
+		Arena = InArena;
+		++ArenaGeneration;
+		for (FSlot& Slot : Slots)
+		{
+			Slot.Free.clear();
+		}
+	}
+
+	/** Initial buffer size new builders for Id currently get. */
+	size_t GetInitialSize(MsgId Id)
+	{
+		return GetSlot(Id).InitialSize;
+	}
+
+private:
+	struct FSlot
+	{
+		std::vector<std::unique_ptr<flatbuffers::FlatBufferBuilder>> Free;
+
+		/** Decaying high-water mark of recent message sizes. */
+		size_t SizeHint = 0;
+
+		size_t InitialSize = MinInitialSize;
+	};
+
+	FSlot& GetSlot(MsgId Id)
+	{
+		const size_t Index = static_cast<size_t>(Id);
+		if (Index >= Slots.size())
+		{
+			Slots.resize(Index + 1);
+		}
+		return Slots[Index];
+	}
+
+	void Return(MsgId Id, uint32_t Generation, std::unique_ptr<flatbuffers::FlatBufferBuilder>&& Builder, size_t MessageSize)
+	{
+		FSlot& Slot = GetSlot(Id);
+
+		Slot.SizeHint = MessageSize > Slot.SizeHint - Slot.SizeHint / 16 ? MessageSize : Slot.SizeHint - Slot.SizeHint / 16;
+
+		// vector_downward fixes its initial size at construction, so a builder that keeps
+		// outgrowing it is replaced rather than left to reallocate on every message.
+		size_t WantedSize = Slot.InitialSize;
+		while (WantedSize < Slot.SizeHint)
+		{
+			WantedSize *= 2;
+		}
+
+		if (WantedSize > Slot.InitialSize)
+		{
+			Slot.InitialSize = WantedSize;
+			Slot.Free.clear();
+			return;
+		}
+
+		// Lent before SetFrameArena: its buffer belongs to the previous allocator.
+		if (Generation != ArenaGeneration)
+		{
+			return;
+		}
+
+		// An arena buffer must not outlive the frame, so pooled builders give theirs back.
+		if (Arena)
+		{
+			Builder->Reset();
+		}
+		else
+		{
+			Builder->Clear();
+		}
+		Slot.Free.push_back(std::move(Builder));
+	}
+
+	std::vector<FSlot> Slots;
+
+	FFrameArena* Arena = nullptr;
+
+	/** Bumped by SetFrameArena; see FHandle::Generation. */
+	uint32_t ArenaGeneration = 0;
+};
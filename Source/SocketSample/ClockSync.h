@@ -0,0 +1,167 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+/**
+ * Round-trip time, jitter and server clock offset from C2S_Ping/S2C_Pong exchanges, NTP style.
+ * Each pong carries four timestamps: T0 ping sent and T3 pong received on the client clock,
+ * T1 ping received and T2 pong sent on the server clock. From those,
+ *
+ *   delay  = (T3 - T0) - (T2 - T1)
+ *   offset = ((T1 - T0) + (T2 - T3)) / 2,  so server time = client time + offset
+ *
+ * An offset is off by at most half its sample's delay, and queueing only ever adds delay, so,
+ * like NTP's clock filter, the offset is taken from the lowest-delay of the last FilterSize
+ * samples. RTT and jitter are smoothed the way TCP smooths SRTT and RTTVAR (RFC 6298), and
+ * every RTT also goes into a fixed-width histogram that can be graphed per session.
+ * Engine-independent; all times are seconds.
+ */
+class FClockSync
+{
+public:
+	static const int32_t FilterSize = 8;
+
+	static const int32_t NumHistogramBuckets = 64;
+
+	/** Seconds between pings. */
+	double PingInterval = 0.5;
+
+	/** Width of one RTT histogram bucket in seconds. The last bucket also counts everything slower. */
+	double HistogramBucketWidth = 0.005;
+
+	/** True once every PingInterval; the caller then sends a C2S_Ping stamped with Now. */
+	bool ShouldPing(double Now)
+	{
+		if (Now < NextPingTime)
+		{
+			return false;
+		}
+
+		NextPingTime = Now + PingInterval;
+		++PingsSent;
+		return true;
+	}
+
+	/** Adds one exchange. Returns false, ignoring it, if its timestamps are out of order. */
+	bool AddSample(double T0, double T1, double T2, double T3)
+	{
+		if (T3 < T0 || T2 < T1)
+		{
+			return false;
+		}
+
+		// Clock granularity can make a loopback delay come out slightly negative.
+		const double Delay = std::max(0.0, (T3 - T0) - (T2 - T1));
+		const double Offset = ((T1 - T0) + (T2 - T3)) * 0.5;
+
+		if (NumSamples == 0)
+		{
+			SmoothedRtt = Delay;
+			RttVariation = Delay * 0.5;
+			MinRtt = Delay;
+		}
+		else
+		{
+			RttVariation = 0.75 * RttVariation + 0.25 * std::fabs(SmoothedRtt - Delay);
+			SmoothedRtt = 0.875 * SmoothedRtt + 0.125 * Delay;
+			MinRtt = std::min(MinRtt, Delay);
+		}
+		LastRtt = Delay;
+
+		Filter[NextFilter] = FSample{ Delay, Offset };
+		NextFilter = (NextFilter + 1) % FilterSize;
+		NumFiltered = std::min(NumFiltered + 1, FilterSize);
+
+		const FSample* Best = &Filter[0];
+		for (int32_t i = 1; i < NumFiltered; ++i)
+		{
+			Best = Filter[i].Delay < Best->Delay ? &Filter[i] : Best;
+		}
+		ServerOffset = Best->Offset;
+		OffsetError = Best->Delay * 0.5;
+
+		const int32_t Bucket = static_cast<int32_t>(Delay / HistogramBucketWidth);
+		++Histogram[std::min(Bucket, NumHistogramBuckets - 1)];
+
+		++NumSamples;
+		return true;
+	}
+
+	/** Forgets every sample, e.g. on reconnect, which may land on another server. */
+	void Reset()
+	{
+		const double SavedPingInterval = PingInterval;
+		const double SavedBucketWidth = HistogramBucketWidth;
+		*this = FClockSync();
+		PingInterval = SavedPingInterval;
+		HistogramBucketWidth = SavedBucketWidth;
+	}
+
+	bool HasSamples() const { return NumSamples > 0; }
+
+	/** Smoothed round-trip time. */
+	double GetRtt() const { return SmoothedRtt; }
+
+	/** Smoothed mean deviation of the round-trip time. */
+	double GetJitter() const { return RttVariation; }
+
+	double GetLastRtt() const { return LastRtt; }
+
+	double GetMinRtt() const { return MinRtt; }
+
+	/** Server clock minus client clock. */
+	double GetServerOffset() const { return ServerOffset; }
+
+	/** Bound on the offset's error: half the delay of the sample it came from. */
+	double GetOffsetError() const { return OffsetError; }
+
+	double ToServerTime(double ClientTime) const { return ClientTime + ServerOffset; }
+
+	double ToClientTime(double ServerTime) const { return ServerTime - ServerOffset; }
+
+	uint64_t GetNumSamples() const { return NumSamples; }
+
+	/** Pings sent that have not been answered, or not yet. */
+	uint64_t GetNumLost() const { return PingsSent > NumSamples ? PingsSent - NumSamples : 0; }
+
+	/** RTT counts per HistogramBucketWidth bucket, NumHistogramBuckets of them. */
+	const uint32_t* GetHistogram() const { return Histogram; }
+
+private:
+	struct FSample
+	{
+		double Delay = 0.0;
+
+		double Offset = 0.0;
+	};
+
+	FSample Filter[FilterSize];
+
+	int32_t NextFilter = 0;
+
+	int32_t NumFiltered = 0;
+
+	double SmoothedRtt = 0.0;
+
+	double RttVariation = 0.0;
+
+	double LastRtt = 0.0;
+
+	double MinRtt = 0.0;
+
+	double ServerOffset = 0.0;
+
+	double OffsetError = 0.0;
+
+	double NextPingTime = 0.0;
+
+	uint64_t PingsSent = 0;
+
+	uint64_t NumSamples = 0;
+
+	uint32_t Histogram[NumHistogramBuckets] = {};
+};
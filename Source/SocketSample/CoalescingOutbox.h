@@ -0,0 +1,269 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "flatbuffers/flatbuffers.h"
+
+#include "MsgId.h"
+
+/**
+ * Outbound frame queue between the game thread and the network thread, for a socket that can
+ * fall behind.
+ *
+ * Every frame is pushed with a key. Key 0 is reliable: kept and sent in order, never dropped.
+ * Any other key is latest-value: a queued frame with the same key is replaced in place by the
+ * newer one, which keeps the older one's place in line, so a backed-up socket sends one current
+ * C2S_SyncLocation per actor instead of a backlog of stale ones. Once the queue holds MaxBytes,
+ * the oldest latest-value frames are dropped to make room; reliable frames are always accepted.
+ *
+ * Frames taken with Pop belong to the caller and are no longer coalesced. Thread-safe.
+ * Once the queue has grown to its working size, Push and Pop do not allocate.
+ */
+class FCoalescingOutbox
+{
+public:
+	static const uint64_t Reliable = 0;
+
+	struct FStats
+	{
+		uint64_t Pushed = 0;
+
+		/** Frames replaced by a newer frame with the same key before being sent. */
+		uint64_t Coalesced = 0;
+
+		/** Latest-value frames dropped to stay within MaxBytes. */
+		uint64_t Dropped = 0;
+
+		uint64_t Popped = 0;
+
+		size_t QueuedBytes = 0;
+
+		size_t PeakQueuedBytes = 0;
+
+		size_t QueuedFrames = 0;
+	};
+
+	explicit FCoalescingOutbox(size_t InMaxBytes = 64 * 1024)
+		: MaxBytes(InMaxBytes)
+	{
+	}
+
+	/** Key for latest-value frames: one per message type and subject, e.g. C2S_SyncLocation per actor. */
+	static uint64_t MakeKey(MsgId Id, uint64_t Subject = 0)
+	{
+		return (static_cast<uint64_t>(Id) << 48) | (Subject & 0xFFFFFFFFFFFFull);
+	}
+
+	void Push(flatbuffers::DetachedBuffer&& Frame, uint64_t Key = Reliable)
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		++Stats.Pushed;
+
+		if (Key != Reliable)
+		{
+			FEntry* Queued = FindLatest(Key);
+			if (Queued)
+			{
+				FEntry& Entry = *Queued;
+				Stats.QueuedBytes -= Entry.Frame.size();
+				Stats.QueuedBytes += Frame.size();
+				Entry.Frame = std::move(Frame);
+				++Stats.Coalesced;
+				UpdatePeak();
+				return;
+			}
+		}
+
+		// The oldest latest-value frames are the stalest data in the queue.
+		for (size_t Index = 0; Index < NumEntries && Stats.QueuedBytes + Frame.size() > MaxBytes; ++Index)
+		{
+			FEntry& Entry = At(Index);
+			if (Entry.Key != Reliable && Entry.Frame.size() > 0)
+			{
+				Stats.QueuedBytes -= Entry.Frame.size();
+				--Stats.QueuedFrames;
+				Entry.Frame = flatbuffers::DetachedBuffer();
+				++Stats.Dropped;
+				++NumDropped;
+			}
+		}
+
+		if (NumDropped > Stats.QueuedFrames)
+		{
+			Compact();
+		}
+
+		if (Key != Reliable && Stats.QueuedBytes + Frame.size() > MaxBytes)
+		{
+			// Only reliable frames are left ahead of it.
+			++Stats.Dropped;
+			return;
+		}
+
+		if (Key != Reliable)
+		{
+			Latest[Key] = FrontSequence + NumEntries;
+		}
+		Stats.QueuedBytes += Frame.size();
+		++Stats.QueuedFrames;
+		UpdatePeak();
+
+		FEntry Entry;
+		Entry.Key = Key;
+		Entry.Frame = std::move(Frame);
+		PushBack(std::move(Entry));
+	}
+
+	/** Takes the next frame to send. Returns false if the queue is empty. */
+	bool Pop(flatbuffers::DetachedBuffer& OutFrame)
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		while (NumEntries > 0)
+		{
+			FEntry Entry = std::move(At(0));
+			Head = (Head + 1) & (Entries.size() - 1);
+			--NumEntries;
+			++FrontSequence;
+
+			// Dropped frames leave an empty entry behind so sequence numbers stay valid.
+			if (Entry.Frame.size() == 0)
+			{
+				--NumDropped;
+				continue;
+			}
+
+			// Its key stays in Latest, pointing behind FrontSequence, so the next push reuses the node.
+			Stats.QueuedBytes -= Entry.Frame.size();
+			--Stats.QueuedFrames;
+			++Stats.Popped;
+			OutFrame = std::move(Entry.Frame);
+			return true;
+		}
+		return false;
+	}
+
+	void Reset()
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		FrontSequence += NumEntries;
+		for (size_t Index = 0; Index < NumEntries; ++Index)
+		{
+			At(Index) = FEntry();
+		}
+		Head = 0;
+		NumEntries = 0;
+		Latest.clear();
+		NumDropped = 0;
+		Stats.QueuedBytes = 0;
+		Stats.QueuedFrames = 0;
+	}
+
+	FStats GetStats() const
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		return Stats;
+	}
+
+	size_t GetMaxBytes() const { return MaxBytes; }
+
+private:
+	struct FEntry
+	{
+		uint64_t Key = Reliable;
+
+		flatbuffers::DetachedBuffer Frame;
+	};
+
+	FEntry& At(size_t Index)
+	{
+		return Entries[(Head + Index) & (Entries.size() - 1)];
+	}
+
+	/** The queued frame for Key, or null. Latest may still hold keys whose frame was sent or dropped. */
+	FEntry* FindLatest(uint64_t Key)
+	{
+		const auto Found = Latest.find(Key);
+		if (Found == Latest.end() || Found->second < FrontSequence || Found->second - FrontSequence >= NumEntries)
+		{
+			return nullptr;
+		}
+
+		FEntry& Entry = At(static_cast<size_t>(Found->second - FrontSequence));
+		return Entry.Key == Key && Entry.Frame.size() > 0 ? &Entry : nullptr;
+	}
+
+	/** Entries is a ring with a power-of-two size that only grows. */
+	void PushBack(FEntry&& Entry)
+	{
+		if (NumEntries == Entries.size())
+		{
+			std::vector<FEntry> Grown(Entries.empty() ? 16 : Entries.size() * 2);
+			for (size_t Index = 0; Index < NumEntries; ++Index)
+			{
+				Grown[Index] = std::move(At(Index));
+			}
+			Entries.swap(Grown);
+			Head = 0;
+		}
+		At(NumEntries++) = std::move(Entry);
+	}
+
+	/** Removes the empty entries dropped frames left behind, so a stalled socket cannot grow Entries without bound. */
+	void Compact()
+	{
+		size_t NumLive = 0;
+		for (size_t Index = 0; Index < NumEntries; ++Index)
+		{
+			FEntry& Entry = At(Index);
+			if (Entry.Frame.size() > 0)
+			{
+				if (Entry.Key != Reliable)
+				{
+					Latest[Entry.Key] = FrontSequence + NumLive;
+				}
+				if (NumLive != Index)
+				{
+					At(NumLive) = std::move(Entry);
+					Entry = FEntry();
+				}
+				++NumLive;
+			}
+		}
+		NumEntries = NumLive;
+		NumDropped = 0;
+	}
+
+	void UpdatePeak()
+	{
+		Stats.PeakQueuedBytes = Stats.QueuedBytes > Stats.PeakQueuedBytes ? Stats.QueuedBytes : Stats.PeakQueuedBytes;
+	}
+
+	const size_t MaxBytes;
+
+	mutable std::mutex Mutex;
+
+	std::vector<FEntry> Entries;
+
+	/** Slot of the oldest entry in Entries. */
+	size_t Head = 0;
+
+	size_t NumEntries = 0;
+
+	/** Sequence number of the oldest entry; an entry's sequence minus this is its index. */
+	uint64_t FrontSequence = 0;
+
+	/** Key to the sequence number of the last frame pushed with it, which may have left the queue since. */
+	std::unordered_map<uint64_t, uint64_t> Latest;
+
+	/** Empty entries left in Entries by dropped frames. */
+	size_t NumDropped = 0;
+
+	FStats Stats;
+};
@@ -0,0 +1,190 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+
+/**
+ * Drives connecting, logging in and reconnecting without ever blocking the caller.
+ *
+ *   Closed --Open--> Connecting --connected--> LoggingIn --OnLoggedIn--> Online
+ *                        |                         |                       |
+ *                        +----failed / timeout-----+--------dropped--------+--> Backoff --delay--> Connecting
+ *
+ * Update is called every frame with how the current transport is doing and returns what the
+ * caller should do next. Retry delays grow by BackoffMultiplier from InitialBackoff up to
+ * MaxBackoff, each randomly shortened by up to BackoffJitter of itself so that many clients
+ * dropped together do not reconnect in lockstep, and start over once a login succeeds.
+ * Engine-independent; the caller owns the clock, the socket and the login message.
+ */
+class FConnectionStateMachine
+{
+public:
+	enum class EState : uint8_t
+	{
+		Closed,
+		Connecting,
+		LoggingIn,
+		Online,
+		Backoff,
+	};
+
+	enum class ETransportStatus : uint8_t
+	{
+		/** No transport, or the connection attempt has not completed yet. */
+		Connecting,
+		Connected,
+		/** The attempt failed or an established connection dropped. */
+		Failed,
+	};
+
+	enum class EAction : uint8_t
+	{
+		None,
+		/** Create a transport and start connecting. */
+		Connect,
+		/** Send the login with the stored token. */
+		Login,
+		/** Close and discard the transport. Entering Backoff. */
+		Disconnect,
+	};
+
+	/** Seconds a connection attempt may take. */
+	double ConnectTimeout = 5.0;
+
+	/** Seconds from sending the login to the server answering it. */
+	double LoginTimeout = 5.0;
+
+	double InitialBackoff = 0.5;
+
+	double MaxBackoff = 30.0;
+
+	double BackoffMultiplier = 2.0;
+
+	/** 0 waits exactly the computed delay, 1 anywhere between none and all of it. */
+	double BackoffJitter = 0.5;
+
+	explicit FConnectionStateMachine(uint32_t Seed = std::random_device()())
+		: Random(Seed)
+	{
+	}
+
+	/** Starts connecting on the next Update. */
+	void Open(double Now)
+	{
+		Attempt = 0;
+		Enter(EState::Connecting, Now);
+		bPendingConnect = true;
+	}
+
+	/** Stops, without reconnecting. The caller closes its transport itself. */
+	void Close(double Now)
+	{
+		Enter(EState::Closed, Now);
+		bPendingConnect = false;
+	}
+
+	/** The server accepted the login. */
+	void OnLoggedIn(double Now)
+	{
+		if (State == EState::LoggingIn)
+		{
+			Attempt = 0;
+			Enter(EState::Online, Now);
+		}
+	}
+
+	EAction Update(double Now, ETransportStatus Transport)
+	{
+		switch (State)
+		{
+		case EState::Connecting:
+			if (bPendingConnect)
+			{
+				bPendingConnect = false;
+				StateTime = Now;
+				return EAction::Connect;
+			}
+			if (Transport == ETransportStatus::Connected)
+			{
+				Enter(EState::LoggingIn, Now);
+				return EAction::Login;
+			}
+			if (Transport == ETransportStatus::Failed || Now - StateTime >= ConnectTimeout)
+			{
+				return StartBackoff(Now);
+			}
+			return EAction::None;
+
+		case EState::LoggingIn:
+			if (Transport == ETransportStatus::Failed || Now - StateTime >= LoginTimeout)
+			{
+				return StartBackoff(Now);
+			}
+			return EAction::None;
+
+		case EState::Online:
+			return Transport == ETransportStatus::Failed ? StartBackoff(Now) : EAction::None;
+
+		case EState::Backoff:
+			if (Now >= RetryTime)
+			{
+				Enter(EState::Connecting, Now);
+				return EAction::Connect;
+			}
+			return EAction::None;
+
+		default:
+			return EAction::None;
+		}
+	}
+
+	EState GetState() const { return State; }
+
+	/** Seconds since the current state was entered. */
+	double GetTimeInState(double Now) const { return Now - StateTime; }
+
+	/** When Backoff ends. Only meaningful in Backoff. */
+	double GetRetryTime() const { return RetryTime; }
+
+	/** Failed attempts since the last successful login. */
+	int32_t GetAttempt() const { return Attempt; }
+
+private:
+	void Enter(EState NewState, double Now)
+	{
+		State = NewState;
+		StateTime = Now;
+	}
+
+	EAction StartBackoff(double Now)
+	{
+		double Delay = InitialBackoff;
+		for (int32_t i = 0; i < Attempt && Delay < MaxBackoff; ++i)
+		{
+			Delay *= BackoffMultiplier;
+		}
+		Delay = std::min(Delay, MaxBackoff);
+		Delay *= 1.0 - BackoffJitter * std::uniform_real_distribution<double>(0.0, 1.0)(Random);
+
+		++Attempt;
+		RetryTime = Now + Delay;
+		Enter(EState::Backoff, Now);
+		return EAction::Disconnect;
+	}
+
+	EState State = EState::Closed;
+
+	double StateTime = 0.0;
+
+	double RetryTime = 0.0;
+
+	int32_t Attempt = 0;
+
+	/** Open defers its Connect action to the next Update, so all actions come from one place. */
+	bool bPendingConnect = false;
+
+	std::minstd_rand Random;
+};
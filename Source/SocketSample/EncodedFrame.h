@@ -0,0 +1,57 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include "flatbuffers/flatbuffers.h"
+
+#include "MsgId.h"
+#include "FrameHeader.h"
+
+class FEncodedFrame;
+
+using FEncodedFramePtr = std::shared_ptr<const FEncodedFrame>;
+
+/**
+ * A finished frame, header included (see FinishFrame), that owns its DetachedBuffer and never
+ * changes after creation. Broadcasts build one of these and queue the same pointer on every
+ * recipient, so fan-out costs a reference count per recipient instead of a build or a copy.
+ * Safe to share between threads.
+ */
+class FEncodedFrame
+{
+public:
+	/** Bytes must start with a frame header, as produced by FinishFrame and Release. */
+	static FEncodedFramePtr Create(flatbuffers::DetachedBuffer&& Bytes)
+	{
+		return std::make_shared<const FEncodedFrame>(std::move(Bytes));
+	}
+
+	explicit FEncodedFrame(flatbuffers::DetachedBuffer&& InBytes)
+		: Bytes(std::move(InBytes))
+	{
+		FFrameHeader Header;
+		if (Bytes.size() >= FFrameHeader::Size && Header.Decode(Bytes.data()))
+		{
+			Id = Header.Id;
+		}
+	}
+
+	FEncodedFrame(const FEncodedFrame&) = delete;
+	FEncodedFrame& operator=(const FEncodedFrame&) = delete;
+
+	const uint8_t* GetData() const { return Bytes.data(); }
+
+	size_t GetSize() const { return Bytes.size(); }
+
+	MsgId GetId() const { return Id; }
+
+private:
+	flatbuffers::DetachedBuffer Bytes;
+
+	MsgId Id = MsgId(0);
+};
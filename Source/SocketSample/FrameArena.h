@@ -0,0 +1,243 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "flatbuffers/flatbuffers.h"
+
+#include "FrameBuilder.h"
+
+/**
+ * Per-thread bump allocator for FlatBufferBuilder buffers, rewound once per game frame or
+ * server tick (see Reset). Allocating is a pointer bump, and a builder that outgrows its buffer
+ * while it is the newest allocation grows in place instead of copying. Freeing the newest
+ * allocation on the owning thread hands its bytes straight back, so the usual acquire, build,
+ * release, free sequence keeps reusing the same few cache-warm kilobytes.
+ *
+ * A buffer may outlive the frame it was built in: every chunk counts its live allocations, and
+ * Reset sets aside rather than rewinds a chunk something still points into, until that is
+ * freed. So a frame queued for sending can be handed out as is, and costs nothing extra as long
+ * as it is usually sent within the tick; one that is known to be kept for long should go
+ * through Escape instead, so it does not pin a whole chunk. Buffers may be freed from any
+ * thread; allocating and Reset belong to the owning thread.
+ */
+class FFrameArena : public flatbuffers::Allocator
+{
+public:
+	/** Size of a regular chunk. Larger requests get a chunk of their own. */
+	static const size_t ChunkSize = 256 * 1024;
+
+	static const size_t Alignment = 16;
+
+	/** Empty chunks kept for reuse across Resets; the rest are freed. */
+	static const size_t MaxFreeChunks = 8;
+
+	FFrameArena()
+		: Owner(std::this_thread::get_id())
+	{
+	}
+
+	virtual ~FFrameArena()
+	{
+		for (FChunk* Chunk : Free)
+		{
+			DeleteChunk(Chunk);
+		}
+		// A chunk something still points into is leaked rather than freed under it.
+		for (FChunk* Chunk : Chunks)
+		{
+			if (Chunk->Live.load(std::memory_order_acquire) == 0)
+			{
+				DeleteChunk(Chunk);
+			}
+		}
+	}
+
+	/** The calling thread's arena. */
+	static FFrameArena& Get()
+	{
+		static thread_local FFrameArena Instance;
+		return Instance;
+	}
+
+	/**
+	 * Copies a finished buffer into FPooledFrameAllocator, so it can outlive the frame. Buffer
+	 * itself may come from any allocator and is left to free its own memory.
+	 */
+	static flatbuffers::DetachedBuffer Escape(const flatbuffers::DetachedBuffer& Buffer)
+	{
+		FPooledFrameAllocator& Pool = FPooledFrameAllocator::Get();
+		const size_t Size = Buffer.size();
+		uint8_t* Block = Pool.allocate(Size);
+		memcpy(Block, Buffer.data(), Size);
+		return flatbuffers::DetachedBuffer(&Pool, false, Block, Size, Block, Size);
+	}
+
+	virtual uint8_t* allocate(size_t size) override
+	{
+		const size_t Needed = GetBlockSize(size);
+		if (!Current || Current->Size - Current->Used < Needed)
+		{
+			Current = NewChunk(Needed);
+		}
+
+		uint8_t* Block = Current->Data + Current->Used;
+		Current->Used += Needed;
+		Current->Live.fetch_add(1, std::memory_order_relaxed);
+		memcpy(Block, &Current, sizeof(FChunk*));
+
+		FrameBytes += Needed;
+		PeakFrameBytes = std::max(PeakFrameBytes, FrameBytes);
+		return Block + HeaderSize;
+	}
+
+	virtual void deallocate(uint8_t* p, size_t size) override
+	{
+		FChunk* Chunk = GetChunk(p);
+		if (std::this_thread::get_id() == Owner && IsNewest(Chunk, p, size))
+		{
+			Chunk->Used -= GetBlockSize(size);
+			FrameBytes -= GetBlockSize(size);
+		}
+		Chunk->Live.fetch_sub(1, std::memory_order_release);
+	}
+
+	virtual uint8_t* reallocate_downward(uint8_t* old_p, size_t old_size, size_t new_size, size_t in_use_back, size_t in_use_front) override
+	{
+		FChunk* Chunk = GetChunk(old_p);
+		const size_t Growth = GetBlockSize(new_size) - GetBlockSize(old_size);
+		if (IsNewest(Chunk, old_p, old_size) && Chunk->Size - Chunk->Used >= Growth)
+		{
+			// The front stays where it is; only the back moves up to the new end.
+			memmove(old_p + new_size - in_use_back, old_p + old_size - in_use_back, in_use_back);
+			Chunk->Used += Growth;
+			FrameBytes += Growth;
+			PeakFrameBytes = std::max(PeakFrameBytes, FrameBytes);
+			return old_p;
+		}
+
+		return flatbuffers::Allocator::reallocate_downward(old_p, old_size, new_size, in_use_back, in_use_front);
+	}
+
+	/**
+	 * Starts a new frame: every chunk with no live allocation is rewound. Call once per game
+	 * frame or server tick, on the owning thread.
+	 */
+	void Reset()
+	{
+		NumPinnedChunks = 0;
+
+		size_t Kept = 0;
+		for (FChunk* Chunk : Chunks)
+		{
+			if (Chunk->Live.load(std::memory_order_acquire) != 0)
+			{
+				Chunks[Kept++] = Chunk;
+				++NumPinnedChunks;
+			}
+			else if (Chunk->Size == ChunkSize && Free.size() < MaxFreeChunks)
+			{
+				Chunk->Used = 0;
+				Free.push_back(Chunk);
+			}
+			else
+			{
+				DeleteChunk(Chunk);
+			}
+		}
+		Chunks.resize(Kept);
+
+		Current = nullptr;
+		FrameBytes = 0;
+	}
+
+	/** Bytes in use since the last Reset, including headers and padding. */
+	size_t GetFrameBytes() const { return FrameBytes; }
+
+	size_t GetPeakFrameBytes() const { return PeakFrameBytes; }
+
+	/** Chunks the last Reset could not rewind because an allocation in them was still live. */
+	size_t GetNumPinnedChunks() const { return NumPinnedChunks; }
+
+private:
+	struct FChunk
+	{
+		uint8_t* Base = nullptr;
+
+		uint8_t* Data = nullptr;
+
+		size_t Size = 0;
+
+		size_t Used = 0;
+
+		std::atomic<uint32_t> Live{ 0 };
+	};
+
+	/** Each block starts with a pointer to its chunk, padded to keep the block aligned. */
+	static const size_t HeaderSize = Alignment;
+
+	static size_t GetBlockSize(size_t Size)
+	{
+		return HeaderSize + ((Size + Alignment - 1) & ~(Alignment - 1));
+	}
+
+	static FChunk* GetChunk(uint8_t* p)
+	{
+		FChunk* Chunk;
+		memcpy(&Chunk, p - HeaderSize, sizeof(FChunk*));
+		return Chunk;
+	}
+
+	bool IsNewest(FChunk* Chunk, uint8_t* p, size_t Size) const
+	{
+		return Chunk == Current && p - HeaderSize + GetBlockSize(Size) == Chunk->Data + Chunk->Used;
+	}
+
+	FChunk* NewChunk(size_t Needed)
+	{
+		FChunk* Chunk = nullptr;
+		if (Needed <= ChunkSize && !Free.empty())
+		{
+			Chunk = Free.back();
+			Free.pop_back();
+		}
+		else
+		{
+			Chunk = new FChunk();
+			Chunk->Size = Needed > ChunkSize ? Needed : ChunkSize;
+			// new[] only promises alignment for fundamental types, so over-allocate and align by hand.
+			Chunk->Base = new uint8_t[Chunk->Size + Alignment];
+			Chunk->Data = Chunk->Base + (Alignment - reinterpret_cast<uintptr_t>(Chunk->Base) % Alignment) % Alignment;
+		}
+		Chunks.push_back(Chunk);
+		return Chunk;
+	}
+
+	static void DeleteChunk(FChunk* Chunk)
+	{
+		delete[] Chunk->Base;
+		delete Chunk;
+	}
+
+	std::thread::id Owner;
+
+	/** Chunks allocated from since the last Reset, and pinned ones. */
+	std::vector<FChunk*> Chunks;
+
+	std::vector<FChunk*> Free;
+
+	FChunk* Current = nullptr;
+
+	size_t FrameBytes = 0;
+
+	size_t PeakFrameBytes = 0;
+
+	size_t NumPinnedChunks = 0;
+};
@@ -0,0 +1,140 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "flatbuffers/flatbuffers.h"
+
+#include "MsgId.h"
+#include "FrameHeader.h"
+
+/**
+ * Finishes Root and writes the frame header in front of it inside the builder's own buffer,
+ * the same way FinishSizePrefixed writes its length prefix. After this, fbb.Release() yields a
+ * DetachedBuffer holding exactly the bytes to put on the wire, with no further copies.
+ *
+ * The body is padded to a multiple of the header size so the next frame in the stream, and
+ * therefore its body, starts aligned on the receiving side.
+ */
+template<typename T>
+inline void FinishFrame(flatbuffers::FlatBufferBuilder& fbb, MsgId Id, flatbuffers::Offset<T> Root, uint8_t Flags = FrameFlags::None)
+{
+	fbb.TrackMinAlign(FFrameHeader::Size);
+	fbb.Finish(Root);
+
+	uint8_t Header[FFrameHeader::Size];
+	FFrameHeader(Id, fbb.GetSize(), Flags).Encode(Header);
+	fbb.PushBytes(Header, sizeof(Header));
+}
+
+/**
+ * Recycles builder buffers in power-of-two size classes so that building, detaching, sending
+ * and freeing a frame does not touch the heap once the pool is warm. Buffers are typically
+ * allocated on the game thread and freed on the network thread, so the free lists are locked.
+ * Requests above MaxPooledSize go straight to new/delete.
+ */
+class FPooledFrameAllocator : public flatbuffers::Allocator
+{
+public:
+	static const size_t MinPooledSize = 256;
+
+	static const size_t MaxPooledSize = 1024 * 1024;
+
+	static const size_t MaxBlocksPerClass = 64;
+
+	FPooledFrameAllocator()
+	{
+		for (std::vector<uint8_t*>& FreeList : FreeLists)
+		{
+			FreeList.reserve(MaxBlocksPerClass);
+		}
+	}
+
+	virtual ~FPooledFrameAllocator()
+	{
+		for (std::vector<uint8_t*>& FreeList : FreeLists)
+		{
+			for (uint8_t* Block : FreeList)
+			{
+				delete[] Block;
+			}
+		}
+	}
+
+	/** Process-wide pool. Outlives every DetachedBuffer that references it. */
+	static FPooledFrameAllocator& Get()
+	{
+		static FPooledFrameAllocator Instance;
+		return Instance;
+	}
+
+	virtual uint8_t* allocate(size_t size) override
+	{
+		const int32_t Class = GetSizeClass(size);
+		if (Class < 0)
+		{
+			return new uint8_t[size];
+		}
+
+		{
+			std::lock_guard<std::mutex> Lock(Mutex);
+			std::vector<uint8_t*>& FreeList = FreeLists[Class];
+			if (!FreeList.empty())
+			{
+				uint8_t* Block = FreeList.back();
+				FreeList.pop_back();
+				return Block;
+			}
+		}
+
+		return new uint8_t[GetClassSize(Class)];
+	}
+
+	virtual void deallocate(uint8_t* p, size_t size) override
+	{
+		const int32_t Class = GetSizeClass(size);
+		if (Class >= 0)
+		{
+			std::lock_guard<std::mutex> Lock(Mutex);
+			std::vector<uint8_t*>& FreeList = FreeLists[Class];
+			if (FreeList.size() < MaxBlocksPerClass)
+			{
+				FreeList.push_back(p);
+				return;
+			}
+		}
+
+		delete[] p;
+	}
+
+private:
+	static const int32_t NumClasses = 13; // 256 B .. 1 MiB
+
+	static int32_t GetSizeClass(size_t Size)
+	{
+		if (Size > MaxPooledSize)
+		{
+			return -1;
+		}
+
+		int32_t Class = 0;
+		while (GetClassSize(Class) < Size)
+		{
+			++Class;
+		}
+		return Class;
+	}
+
+	static size_t GetClassSize(int32_t Class)
+	{
+		return MinPooledSize << Class;
+	}
+
+	std::mutex Mutex;
+
+	std::vector<uint8_t*> FreeLists[NumClasses];
+};
@@ -0,0 +1,436 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#include "MsgId.h"
+#include "FrameHeader.h"
+
+/** A complete frame inside FFrameDecoder's buffer. Only valid until the next call into the decoder. */
+struct FFrameView
+{
+	MsgId Id = MsgId(0);
+
+	uint8_t Flags = FrameFlags::None;
+
+	const uint8_t* Data = nullptr;
+
+	size_t Size = 0;
+};
+
+/** Reference-counted receive buffer; see FFrameChunkPool and FFrameSlice. */
+struct FFrameChunk
+{
+	std::atomic<uint32_t> Refs{ 0 };
+
+	int32_t SizeClass = 0;
+
+	size_t Capacity = 0;
+
+	uint8_t* Data = nullptr;
+};
+
+/**
+ * Recycles FFrameDecoder buffers in power-of-two size classes. A chunk is only returned once
+ * the decoder and every FFrameSlice of it have released it, which happens on whichever thread
+ * drops the last reference, so the free lists are locked; that is once per chunk, not per frame.
+ */
+class FFrameChunkPool
+{
+public:
+	static const int32_t MinSizeClass = 10;
+
+	static const int32_t NumSizeClasses = 32;
+
+	static const size_t MaxChunksPerClass = 16;
+
+	~FFrameChunkPool()
+	{
+		for (std::vector<FFrameChunk*>& FreeList : FreeLists)
+		{
+			for (FFrameChunk* Chunk : FreeList)
+			{
+				Delete(Chunk);
+			}
+		}
+	}
+
+	/** Process-wide pool. Outlives every decoder and slice. */
+	static FFrameChunkPool& Get()
+	{
+		static FFrameChunkPool Instance;
+		return Instance;
+	}
+
+	/** A chunk of at least MinCapacity bytes holding one reference, the caller's. */
+	FFrameChunk* Acquire(size_t MinCapacity)
+	{
+		int32_t SizeClass = MinSizeClass;
+		while ((size_t(1) << SizeClass) < MinCapacity)
+		{
+			++SizeClass;
+		}
+
+		FFrameChunk* Chunk = nullptr;
+		{
+			std::lock_guard<std::mutex> Lock(Mutex);
+			std::vector<FFrameChunk*>& FreeList = FreeLists[SizeClass];
+			if (!FreeList.empty())
+			{
+				Chunk = FreeList.back();
+				FreeList.pop_back();
+			}
+		}
+
+		if (Chunk == nullptr)
+		{
+			Chunk = new FFrameChunk();
+			Chunk->SizeClass = SizeClass;
+			Chunk->Capacity = size_t(1) << SizeClass;
+			Chunk->Data = new uint8_t[Chunk->Capacity];
+		}
+		Chunk->Refs.store(1, std::memory_order_relaxed);
+		return Chunk;
+	}
+
+	static void AddRef(FFrameChunk* Chunk)
+	{
+		Chunk->Refs.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void Release(FFrameChunk* Chunk)
+	{
+		if (Chunk->Refs.fetch_sub(1, std::memory_order_acq_rel) != 1)
+		{
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> Lock(Mutex);
+			std::vector<FFrameChunk*>& FreeList = FreeLists[Chunk->SizeClass];
+			if (FreeList.size() < MaxChunksPerClass)
+			{
+				FreeList.push_back(Chunk);
+				return;
+			}
+		}
+
+		Delete(Chunk);
+	}
+
+	/** No other reference to Chunk is left, so its bytes may be moved. Only meaningful to a holder. */
+	static bool IsUnique(const FFrameChunk* Chunk)
+	{
+		return Chunk->Refs.load(std::memory_order_acquire) == 1;
+	}
+
+private:
+	static void Delete(FFrameChunk* Chunk)
+	{
+		delete[] Chunk->Data;
+		delete Chunk;
+	}
+
+	std::mutex Mutex;
+
+	std::vector<FFrameChunk*> FreeLists[NumSizeClasses];
+};
+
+/**
+ * A frame body that stays valid after it leaves the decoder, e.g. to cross to the game thread.
+ * It points into the decoder's chunk and holds a reference to it instead of copying, and drops
+ * that reference when destroyed or Reset, from any thread. Move-only. All zero bytes is a valid
+ * empty slice, so it can live in containers that zero-fill their storage.
+ */
+class FFrameSlice
+{
+public:
+	FFrameSlice() = default;
+
+	/** Borrows Data without a reference; the caller keeps it alive for as long as the slice. */
+	FFrameSlice(const uint8_t* InData, size_t InSize)
+		: Data(InData)
+		, Size(InSize)
+	{
+	}
+
+	FFrameSlice(FFrameChunk* InChunk, const uint8_t* InData, size_t InSize)
+		: Chunk(InChunk)
+		, Data(InData)
+		, Size(InSize)
+	{
+		FFrameChunkPool::AddRef(Chunk);
+	}
+
+	FFrameSlice(FFrameSlice&& Other) noexcept
+		: Chunk(Other.Chunk)
+		, Data(Other.Data)
+		, Size(Other.Size)
+	{
+		Other.Chunk = nullptr;
+		Other.Data = nullptr;
+		Other.Size = 0;
+	}
+
+	FFrameSlice& operator=(FFrameSlice&& Other) noexcept
+	{
+		if (this != &Other)
+		{
+			Reset();
+			Chunk = Other.Chunk;
+			Data = Other.Data;
+			Size = Other.Size;
+			Other.Chunk = nullptr;
+			Other.Data = nullptr;
+			Other.Size = 0;
+		}
+		return *this;
+	}
+
+	FFrameSlice(const FFrameSlice&) = delete;
+
+	FFrameSlice& operator=(const FFrameSlice&) = delete;
+
+	~FFrameSlice()
+	{
+		Reset();
+	}
+
+	void Reset()
+	{
+		if (Chunk != nullptr)
+		{
+			FFrameChunkPool::Get().Release(Chunk);
+		}
+		Chunk = nullptr;
+		Data = nullptr;
+		Size = 0;
+	}
+
+	const uint8_t* GetData() const
+	{
+		return Data;
+	}
+
+	size_t GetSize() const
+	{
+		return Size;
+	}
+
+private:
+	FFrameChunk* Chunk = nullptr;
+
+	const uint8_t* Data = nullptr;
+
+	size_t Size = 0;
+};
+
+/**
+ * Reassembles frames from an arbitrarily chunked TCP byte stream.
+ *
+ * Bytes are written straight into the decoder's buffer (GetWriteBuffer/CommitWrite, or Append),
+ * and complete frames are handed out as views into that same buffer, so flatbuffers::GetRoot
+ * can read them in place. A view can be turned into an FFrameSlice (Slice) that keeps its bytes
+ * alive past the next call, without a copy. The buffer is a pooled FFrameChunk: consumed space
+ * is reclaimed by sliding the unread tail back to the front while no slice refers to the chunk,
+ * and by moving the tail to a fresh chunk when one does, which keeps every frame contiguous and
+ * leaves sliced bytes where they are. Steady state does no allocation. Does not depend on the
+ * engine.
+ */
+class FFrameDecoder
+{
+public:
+	explicit FFrameDecoder(size_t InitialCapacity = 64 * 1024)
+		: Chunk(FFrameChunkPool::Get().Acquire(InitialCapacity))
+	{
+	}
+
+	FFrameDecoder(FFrameDecoder&& Other) noexcept
+		: Chunk(Other.Chunk)
+		, ReadPos(Other.ReadPos)
+		, WritePos(Other.WritePos)
+		, bError(Other.bError)
+	{
+		Other.Chunk = nullptr;
+		Other.ReadPos = Other.WritePos = 0;
+	}
+
+	FFrameDecoder& operator=(FFrameDecoder&& Other) noexcept
+	{
+		if (this != &Other)
+		{
+			if (Chunk != nullptr)
+			{
+				FFrameChunkPool::Get().Release(Chunk);
+			}
+			Chunk = Other.Chunk;
+			ReadPos = Other.ReadPos;
+			WritePos = Other.WritePos;
+			bError = Other.bError;
+			Other.Chunk = nullptr;
+			Other.ReadPos = Other.WritePos = 0;
+		}
+		return *this;
+	}
+
+	FFrameDecoder(const FFrameDecoder&) = delete;
+
+	FFrameDecoder& operator=(const FFrameDecoder&) = delete;
+
+	~FFrameDecoder()
+	{
+		if (Chunk != nullptr)
+		{
+			FFrameChunkPool::Get().Release(Chunk);
+		}
+	}
+
+	/** Returns a pointer to at least MinSize writable bytes. Invalidates outstanding frame views. */
+	uint8_t* GetWriteBuffer(size_t MinSize)
+	{
+		// Everything was read: start over at the front, unless the last frames were sliced.
+		if (ReadPos == WritePos && FFrameChunkPool::IsUnique(Chunk))
+		{
+			ReadPos = WritePos = 0;
+		}
+		Reserve(MinSize);
+		return Chunk->Data + WritePos;
+	}
+
+	/** Writable bytes behind the pointer returned by the last GetWriteBuffer. */
+	size_t GetWritableSize() const
+	{
+		return Chunk->Capacity - WritePos;
+	}
+
+	void CommitWrite(size_t Size)
+	{
+		assert(WritePos + Size <= Chunk->Capacity);
+		WritePos += Size;
+	}
+
+	void Append(const uint8_t* Data, size_t Size)
+	{
+		memcpy(GetWriteBuffer(Size), Data, Size);
+		CommitWrite(Size);
+	}
+
+	/** Pops the next complete frame, if there is one. */
+	bool Next(FFrameView& OutFrame)
+	{
+		const size_t Available = WritePos - ReadPos;
+		if (bError || Available < FFrameHeader::Size)
+		{
+			return false;
+		}
+
+		FFrameHeader Header;
+		if (!Header.Decode(Chunk->Data + ReadPos))
+		{
+			bError = true;
+			return false;
+		}
+
+		const size_t FrameSize = Header.GetFrameSize();
+		if (Available < FrameSize)
+		{
+			// Make sure the rest of a large frame fits without growing one read at a time.
+			Reserve(FrameSize - Available);
+			return false;
+		}
+
+		OutFrame.Id = Header.Id;
+		OutFrame.Flags = Header.Flags;
+		OutFrame.Data = Chunk->Data + ReadPos + FFrameHeader::Size;
+		OutFrame.Size = Header.BodySize;
+
+		ReadPos += FrameSize;
+		return true;
+	}
+
+	/**
+	 * Keeps Size bytes at Data, which must lie in a view from the last Next (a whole body, or a
+	 * sub-frame of a batch), alive without copying them.
+	 */
+	FFrameSlice Slice(const uint8_t* Data, size_t Size) const
+	{
+		assert(Data >= Chunk->Data && Data + Size <= Chunk->Data + WritePos);
+		return FFrameSlice(Chunk, Data, Size);
+	}
+
+	/** Set once the stream contained a malformed header. The connection cannot be resynchronised after that. */
+	bool HasError() const
+	{
+		return bError;
+	}
+
+	size_t GetBufferedSize() const
+	{
+		return WritePos - ReadPos;
+	}
+
+	size_t GetCapacity() const
+	{
+		return Chunk->Capacity;
+	}
+
+	void Reset()
+	{
+		ReadPos = WritePos = 0;
+		bError = false;
+		if (!FFrameChunkPool::IsUnique(Chunk))
+		{
+			// Slices still read the old bytes; write the new stream elsewhere.
+			const size_t Capacity = Chunk->Capacity;
+			FFrameChunkPool::Get().Release(Chunk);
+			Chunk = FFrameChunkPool::Get().Acquire(Capacity);
+		}
+	}
+
+private:
+	void Reserve(size_t MinFree)
+	{
+		if (Chunk->Capacity - WritePos >= MinFree)
+		{
+			return;
+		}
+
+		const size_t Buffered = WritePos - ReadPos;
+		if (FFrameChunkPool::IsUnique(Chunk) && Chunk->Capacity - Buffered >= MinFree)
+		{
+			memmove(Chunk->Data, Chunk->Data + ReadPos, Buffered);
+			WritePos = Buffered;
+			ReadPos = 0;
+			return;
+		}
+
+		// Slices point into this chunk, or it is too small: carry the unread tail over to a new one.
+		size_t NewCapacity = Chunk->Capacity;
+		while (NewCapacity - Buffered < MinFree)
+		{
+			NewCapacity *= 2;
+		}
+
+		FFrameChunk* NewChunk = FFrameChunkPool::Get().Acquire(NewCapacity);
+		memcpy(NewChunk->Data, Chunk->Data + ReadPos, Buffered);
+		FFrameChunkPool::Get().Release(Chunk);
+		Chunk = NewChunk;
+		WritePos = Buffered;
+		ReadPos = 0;
+	}
+
+	FFrameChunk* Chunk = nullptr;
+
+	size_t ReadPos = 0;
+
+	size_t WritePos = 0;
+
+	bool bError = false;
+};
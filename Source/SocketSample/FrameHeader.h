@@ -0,0 +1,121 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "MsgId.h"
+
+namespace FrameFlags
+{
+	enum : uint8_t
+	{
+		None = 0,
+		/** Body is compressed. Reserved, nothing produces it yet. */
+		Compressed = 1 << 0,
+		/** Body is a sequence of complete frames, each with its own header. */
+		Batched = 1 << 1,
+	};
+}
+
+/**
+ * Header in front of every message on the wire. Fixed 8 bytes, little endian:
+ *
+ *   uint32 BodySize | uint16 MsgId | uint8 Flags | uint8 Version
+ *
+ * The 32-bit length lets a whole world snapshot travel as a single frame, and the fixed
+ * layout keeps decoding to one copy and one range check. The header size is a multiple of
+ * the FlatBuffers scalar alignment, so a body that starts on an aligned frame stays aligned.
+ */
+struct FFrameHeader
+{
+	static const size_t Size = 8;
+
+	static const uint8_t CurrentVersion = 1;
+
+	/** Anything larger is treated as a corrupt stream rather than a legitimately huge message. */
+	static const uint32_t MaxBodySize = 16 * 1024 * 1024;
+
+	uint32_t BodySize = 0;
+
+	MsgId Id = MsgId(0);
+
+	uint8_t Flags = FrameFlags::None;
+
+	uint8_t Version = CurrentVersion;
+
+	FFrameHeader() = default;
+
+	FFrameHeader(MsgId InId, uint32_t InBodySize, uint8_t InFlags = FrameFlags::None)
+		: BodySize(InBodySize)
+		, Id(InId)
+		, Flags(InFlags)
+	{
+	}
+
+	uint32_t GetFrameSize() const
+	{
+		return static_cast<uint32_t>(Size) + BodySize;
+	}
+
+	void Encode(uint8_t* Out) const
+	{
+		memcpy(Out, this, Size);
+	}
+
+	/** Reads a header from In. Returns false if the bytes cannot be the start of a valid frame. */
+	bool Decode(const uint8_t* In)
+	{
+		memcpy(this, In, Size);
+		return Version == CurrentVersion && BodySize <= MaxBodySize;
+	}
+};
+
+static_assert(sizeof(FFrameHeader) == FFrameHeader::Size, "FFrameHeader must match the wire layout");
+
+/** Walks the frames packed inside the body of a FrameFlags::Batched frame. */
+class FFrameBatchReader
+{
+public:
+	FFrameBatchReader(const uint8_t* InData, size_t InSize)
+		: Data(InData)
+		, Size(InSize)
+	{
+	}
+
+	/** Returns false at the end of the batch, or if the batch is malformed (see HasError). */
+	bool Next(FFrameHeader& OutHeader, const uint8_t*& OutBody)
+	{
+		if (bError || Size - Offset < FFrameHeader::Size)
+		{
+			bError = bError || Offset != Size;
+			return false;
+		}
+
+		if (!OutHeader.Decode(Data + Offset) || Size - Offset - FFrameHeader::Size < OutHeader.BodySize)
+		{
+			bError = true;
+			return false;
+		}
+
+		OutBody = Data + Offset + FFrameHeader::Size;
+		Offset += OutHeader.GetFrameSize();
+		return true;
+	}
+
+	bool HasError() const
+	{
+		return bError;
+	}
+
+private:
+	const uint8_t* Data;
+
+	size_t Size;
+
+	size_t Offset = 0;
+
+	bool bError = false;
+};
@@ -0,0 +1,221 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include "flatbuffers/flatbuffers.h"
+
+#include "MsgId.h"
+
+namespace MessageHandlerFlags
+{
+	enum : uint32_t
+	{
+		None = 0,
+		/** Run the FlatBuffers verifier on the body first and drop the message if it fails. */
+		Verify = 1 << 0,
+		/** Accumulate time spent in the handler. */
+		Time = 1 << 1,
+	};
+}
+
+/** Per-MsgId counters kept by a TMessageHandlers::TDispatcher. */
+struct FMessageDispatchStats
+{
+	static const size_t NumIds = static_cast<size_t>(MsgId::MAX);
+
+	struct FEntry
+	{
+		uint64_t Handled = 0;
+
+		/** Received, but no handler is registered for the id. */
+		uint64_t Unhandled = 0;
+
+		/** Failed verification, or its handler returned false. */
+		uint64_t Rejected = 0;
+
+		/** Handler time, for handlers registered with MessageHandlerFlags::Time. */
+		uint64_t Nanoseconds = 0;
+	};
+
+	FEntry Entries[NumIds];
+
+	/** Ids outside the MsgId range. */
+	uint64_t Unknown = 0;
+
+	void Reset()
+	{
+		*this = FMessageDispatchStats();
+	}
+};
+
+/**
+ * Compile-time MsgId -> handler table.
+ *
+ * Handlers are member functions of ContextType taking the rooted ProjectM table and an extra
+ * argument (the frame, for the client). They return false for a message they cannot use, such
+ * as one missing a field the verifier does not require; it is then counted as Rejected rather
+ * than Handled. Each one is registered as a THandler type, and
+ * TDispatcher turns its list of THandlers into a dense constant table indexed by MsgId, so
+ * dispatching is a bounds check and an indirect call however many messages exist:
+ *
+ *   using FHandlers = TMessageHandlers<AMyController, const FNetFrame&>;
+ *   using FDispatcher = FHandlers::TDispatcher<
+ *       FHandlers::THandler<MsgId::S2C_Login, ProjectM::Actor::S2C_Login, &AMyController::OnLogin>,
+ *       ...>;
+ *
+ *   FDispatcher::Dispatch(*this, Stats, Frame.Id, Data, Size, Frame);
+ *
+ * Registering the same id twice, or an id outside MsgId, fails to compile.
+ */
+template<typename ContextType, typename ArgType>
+struct TMessageHandlers
+{
+	using FInvoke = bool (*)(ContextType&, const uint8_t*, ArgType);
+
+	using FVerify = bool (*)(const uint8_t*, size_t);
+
+	struct FEntry
+	{
+		FInvoke Invoke;
+
+		FVerify Verify;
+
+		uint32_t Flags;
+	};
+
+	template<MsgId InId, typename TableType, bool (ContextType::*Method)(const TableType&, ArgType), uint32_t InFlags = MessageHandlerFlags::None>
+	struct THandler
+	{
+		static constexpr MsgId Id = InId;
+
+		static bool Invoke(ContextType& Context, const uint8_t* Data, ArgType Arg)
+		{
+			return (Context.*Method)(*flatbuffers::GetRoot<TableType>(Data), Arg);
+		}
+
+		static bool Verify(const uint8_t* Data, size_t Size)
+		{
+			flatbuffers::Verifier Verifier(Data, Size);
+			return Verifier.VerifyBuffer<TableType>(nullptr);
+		}
+
+		static constexpr FEntry MakeEntry()
+		{
+			return FEntry{ &Invoke, &Verify, InFlags };
+		}
+	};
+
+	template<typename... Handlers>
+	class TDispatcher
+	{
+	public:
+		static const size_t NumIds = FMessageDispatchStats::NumIds;
+
+		/** Returns false if the message was not handled; the reason is counted in Stats. */
+		static bool Dispatch(ContextType& Context, FMessageDispatchStats& Stats, MsgId Id, const uint8_t* Data, size_t Size, ArgType Arg)
+		{
+			static constexpr FTable Table = MakeTable(std::make_index_sequence<NumIds>());
+
+			const size_t Index = static_cast<size_t>(Id);
+			if (Index >= NumIds)
+			{
+				++Stats.Unknown;
+				return false;
+			}
+
+			const FEntry& Entry = Table.Entries[Index];
+			FMessageDispatchStats::FEntry& EntryStats = Stats.Entries[Index];
+			if (Entry.Invoke == nullptr)
+			{
+				++EntryStats.Unhandled;
+				return false;
+			}
+
+			if ((Entry.Flags & MessageHandlerFlags::Verify) && !Entry.Verify(Data, Size))
+			{
+				++EntryStats.Rejected;
+				return false;
+			}
+
+			bool bAccepted = false;
+			if (Entry.Flags & MessageHandlerFlags::Time)
+			{
+				const std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+				bAccepted = Entry.Invoke(Context, Data, Arg);
+				EntryStats.Nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - Start).count();
+			}
+			else
+			{
+				bAccepted = Entry.Invoke(Context, Data, Arg);
+			}
+
+			if (!bAccepted)
+			{
+				++EntryStats.Rejected;
+				return false;
+			}
+
+			++EntryStats.Handled;
+			return true;
+		}
+
+		/** Whether Id has a registered handler. */
+		static constexpr bool IsHandled(MsgId Id)
+		{
+			return FindEntry(static_cast<size_t>(Id)).Invoke != nullptr;
+		}
+
+	private:
+		struct FTable
+		{
+			FEntry Entries[NumIds];
+		};
+
+		template<size_t... Indices>
+		static constexpr FTable MakeTable(std::index_sequence<Indices...>)
+		{
+			return FTable{ { FindEntry(Indices)... } };
+		}
+
+		static constexpr FEntry FindEntry(size_t Index)
+		{
+			const size_t Ids[] = { static_cast<size_t>(Handlers::Id)..., NumIds };
+			const FEntry Entries[] = { Handlers::MakeEntry()..., FEntry{ nullptr, nullptr, MessageHandlerFlags::None } };
+			for (size_t i = 0; i < sizeof...(Handlers); ++i)
+			{
+				if (Ids[i] == Index)
+				{
+					return Entries[i];
+				}
+			}
+			return Entries[sizeof...(Handlers)];
+		}
+
+		static constexpr bool AreIdsValid()
+		{
+			const size_t Ids[] = { static_cast<size_t>(Handlers::Id)..., NumIds };
+			for (size_t i = 0; i < sizeof...(Handlers); ++i)
+			{
+				if (Ids[i] >= NumIds)
+				{
+					return false;
+				}
+				for (size_t j = i + 1; j < sizeof...(Handlers); ++j)
+				{
+					if (Ids[i] == Ids[j])
+					{
+						return false;
+					}
+				}
+			}
+			return true;
+		}
+
+		static_assert(AreIdsValid(), "Each MsgId may have at most one handler, and it must be below MsgId::MAX");
+	};
+};
@@ -1,3 +1,5 @@
+#pragma once
+
 enum class MsgId : unsigned short {
 	C2S_Login = 1,
 	S2C_Login,
@@ -5,4 +7,12 @@ enum class MsgId : unsigned short {
 	S2C_DestroyActor,
 	C2S_SyncLocation,
 	S2C_SyncLocation,
+	S2C_WorldSnapshot,
+	S2C_CompactSnapshot,
+	C2S_SnapshotAck,
+	C2S_Ping,
+	S2C_Pong,
+
+	/** One past the last id. Keep new ids above this line. */
+	MAX,
 };
@@ -0,0 +1,43 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "NetActorRegistry.h"
+
+#include "SocketSampleCharacter.h"
+
+
+void UNetActorRegistry::Register(uint64 UID, ASocketSampleCharacter* Character)
+{
+	if (UID == 0 || Character == nullptr)
+	{
+		return;
+	}
+
+	Characters.Add(UID, Character);
+}
+
+void UNetActorRegistry::Unregister(uint64 UID, const ASocketSampleCharacter* Character)
+{
+	const TWeakObjectPtr<ASocketSampleCharacter>* Found = Characters.Find(UID);
+	if (Found && (!Found->IsValid() || Found->Get() == Character))
+	{
+		Characters.Remove(UID);
+	}
+}
+
+ASocketSampleCharacter* UNetActorRegistry::Find(uint64 UID) const
+{
+	const TWeakObjectPtr<ASocketSampleCharacter>* Found = Characters.Find(UID);
+	return Found ? Found->Get() : nullptr;
+}
+
+void UNetActorRegistry::GetCharacters(TArray<ASocketSampleCharacter*>& OutCharacters) const
+{
+	for (const TPair<uint64, TWeakObjectPtr<ASocketSampleCharacter>>& Entry : Characters)
+	{
+		if (ASocketSampleCharacter* Character = Entry.Value.Get())
+		{
+			OutCharacters.Add(Character);
+		}
+	}
+}
@@ -0,0 +1,37 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+
+#include "NetActorRegistry.generated.h"
+
+class ASocketSampleCharacter;
+
+/**
+ * Maps server ActorUIDs to the characters that represent them in this world, so network
+ * handlers can find a character in O(1) instead of scanning every actor per message.
+ * Characters keep it up to date themselves through ASocketSampleCharacter::SetActorUID and EndPlay.
+ */
+UCLASS()
+class UNetActorRegistry : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	void Register(uint64 UID, ASocketSampleCharacter* Character);
+
+	/** Removes UID only if it still points at Character, so a stale unregister cannot evict a newer owner. */
+	void Unregister(uint64 UID, const ASocketSampleCharacter* Character);
+
+	ASocketSampleCharacter* Find(uint64 UID) const;
+
+	int32 Num() const { return Characters.Num(); }
+
+	/** Appends every live registered character, e.g. to clear the world after a disconnect. */
+	void GetCharacters(TArray<ASocketSampleCharacter*>& OutCharacters) const;
+
+private:
+	TMap<uint64, TWeakObjectPtr<ASocketSampleCharacter>> Characters;
+};
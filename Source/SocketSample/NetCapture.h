@@ -0,0 +1,129 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "MsgId.h"
+#include "FrameHeader.h"
+
+/**
+ * File format of a capture of the inbound message stream, written by FNetworkTransport and
+ * replayed by it (see FNetworkTransport::StartCapture and StartReplay):
+ *
+ *   "PMCP" | uint32 Version
+ *   then per message: uint64 Nanoseconds | FFrameHeader | body | zero padding to 8 bytes
+ *
+ * Nanoseconds are on a monotonic clock since the capture started. Batches are recorded as the
+ * messages they carry, the way the game thread sees them. Records are 8-byte aligned, so a
+ * capture loaded into an aligned buffer can be read in place with flatbuffers::GetRoot. The
+ * file is append-only; a capture cut short by a crash reads up to its last whole record.
+ */
+namespace NetCapture
+{
+	static const uint32_t Version = 1;
+
+	static const size_t FileHeaderSize = 8;
+
+	static const size_t RecordHeaderSize = sizeof(uint64_t) + FFrameHeader::Size;
+
+	inline size_t GetPaddedSize(size_t Size)
+	{
+		return (Size + 7) & ~size_t(7);
+	}
+
+	inline void AppendFileHeader(std::vector<uint8_t>& Out)
+	{
+		const uint8_t Header[FileHeaderSize] = { 'P', 'M', 'C', 'P', 0, 0, 0, 0 };
+		const size_t Offset = Out.size();
+		Out.insert(Out.end(), Header, Header + FileHeaderSize);
+		memcpy(Out.data() + Offset + 4, &Version, sizeof(Version));
+	}
+
+	inline void AppendRecord(std::vector<uint8_t>& Out, uint64_t Nanoseconds, MsgId Id, const uint8_t* Body, size_t Size)
+	{
+		const size_t Offset = Out.size();
+		Out.resize(Offset + RecordHeaderSize + GetPaddedSize(Size), 0);
+
+		uint8_t* Record = Out.data() + Offset;
+		memcpy(Record, &Nanoseconds, sizeof(Nanoseconds));
+		FFrameHeader(Id, static_cast<uint32_t>(Size)).Encode(Record + sizeof(Nanoseconds));
+		memcpy(Record + RecordHeaderSize, Body, Size);
+	}
+}
+
+struct FNetCaptureRecord
+{
+	uint64_t Nanoseconds = 0;
+
+	MsgId Id = MsgId(0);
+
+	const uint8_t* Body = nullptr;
+
+	size_t Size = 0;
+};
+
+/** Walks the records of a capture held in memory. */
+class FNetCaptureReader
+{
+public:
+	FNetCaptureReader(const uint8_t* InData, size_t InSize)
+		: Data(InData)
+		, Size(InSize)
+	{
+		uint32_t FileVersion = 0;
+		if (Size >= NetCapture::FileHeaderSize && memcmp(Data, "PMCP", 4) == 0)
+		{
+			memcpy(&FileVersion, Data + 4, sizeof(FileVersion));
+		}
+		bValid = FileVersion == NetCapture::Version;
+		Offset = NetCapture::FileHeaderSize;
+	}
+
+	/** The file starts with a header this version can read. */
+	bool IsValid() const { return bValid; }
+
+	/** Returns false at the end of the capture or at the first record that does not fit in it. */
+	bool Next(FNetCaptureRecord& Out)
+	{
+		if (!bValid || Size - Offset < NetCapture::RecordHeaderSize)
+		{
+			return false;
+		}
+
+		const uint8_t* Record = Data + Offset;
+		FFrameHeader Header;
+		if (!Header.Decode(Record + sizeof(uint64_t)) || Size - Offset - NetCapture::RecordHeaderSize < Header.BodySize)
+		{
+			bTruncated = true;
+			return false;
+		}
+
+		memcpy(&Out.Nanoseconds, Record, sizeof(uint64_t));
+		Out.Id = Header.Id;
+		Out.Body = Record + NetCapture::RecordHeaderSize;
+		Out.Size = Header.BodySize;
+
+		// The padding of the last record may be missing if the writer stopped mid-record.
+		Offset = std::min(Size, Offset + NetCapture::RecordHeaderSize + NetCapture::GetPaddedSize(Header.BodySize));
+		return true;
+	}
+
+	/** Next stopped at a partial or corrupt record rather than the end of the file. */
+	bool IsTruncated() const { return bTruncated || (bValid && Offset < Size && Size - Offset < NetCapture::RecordHeaderSize); }
+
+private:
+	const uint8_t* Data;
+
+	size_t Size;
+
+	size_t Offset = 0;
+
+	bool bValid = false;
+
+	bool bTruncated = false;
+};
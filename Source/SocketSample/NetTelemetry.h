@@ -0,0 +1,380 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#include "MsgId.h"
+#include "ProtocolCore.h"
+
+enum class ENetDirection : uint8_t
+{
+	In,
+	Out,
+};
+
+/**
+ * Per-MsgId, per-direction message and byte counts, handler time and queue depth.
+ *
+ * Counters are relaxed atomics written by one thread per direction (on the client, the game
+ * thread for received messages and the network thread for sent ones), so recording is a load and a store with no locking, and any thread may Take() a
+ * copy. Handler time is sampled: one message in 2^TimingSampleShift per MsgId is timed, and
+ * totals are scaled up from the sample, which keeps the clock reads off most messages. Times
+ * and depths also go into power-of-two histograms. Engine-independent.
+ */
+class FNetTelemetry
+{
+public:
+	static const size_t NumIds = static_cast<size_t>(MsgId::MAX);
+
+	static const size_t NumDirections = 2;
+
+	/** Bucket i counts values in [2^(i-1), 2^i), bucket 0 counts zero. */
+	static const size_t NumBuckets = 40;
+
+	/** Plain copy of one MsgId and direction. */
+	struct FEntryCounts
+	{
+		uint64_t Messages = 0;
+
+		uint64_t Bytes = 0;
+
+		/** Messages whose handler was timed, and the time they took. */
+		uint64_t TimedMessages = 0;
+
+		uint64_t TimedNanoseconds = 0;
+
+		uint64_t MaxNanoseconds = 0;
+
+		uint64_t HandlerHistogram[NumBuckets] = {};
+
+		/** Handler time of every message, estimated from the timed ones. */
+		double GetEstimatedNanoseconds() const
+		{
+			return TimedMessages > 0 ? static_cast<double>(TimedNanoseconds) * Messages / TimedMessages : 0.0;
+		}
+	};
+
+	/** Plain copy of one direction's queue: the inbox in frames, the outbox in bytes on the client. */
+	struct FQueueCounts
+	{
+		uint64_t Samples = 0;
+
+		uint64_t Last = 0;
+
+		uint64_t Max = 0;
+
+		uint64_t Histogram[NumBuckets] = {};
+	};
+
+	struct FCounts
+	{
+		FEntryCounts Entries[NumDirections][NumIds];
+
+		FQueueCounts Queues[NumDirections];
+
+		/** Messages with an id outside MsgId, per direction. */
+		uint64_t Unknown[NumDirections] = {};
+	};
+
+	/** Time one message in 2^TimingSampleShift per MsgId; 0 times them all. */
+	uint32_t TimingSampleShift = 7;
+
+	FNetTelemetry()
+	{
+		Reset();
+	}
+
+	/** Counts a message. Single writer per direction. */
+	void Record(ENetDirection Direction, MsgId Id, size_t Bytes)
+	{
+		FEntry* Entry = Find(Direction, Id);
+		if (Entry == nullptr)
+		{
+			Add(Unknown[static_cast<size_t>(Direction)], 1);
+			return;
+		}
+
+		Add(Entry->Messages, 1);
+		Add(Entry->Bytes, Bytes);
+	}
+
+	/**
+	 * Counts a received message and runs Handler(), timing it if this message is in the sample.
+	 * Game thread only on the client.
+	 */
+	template<typename HandlerType>
+	void RecordHandled(MsgId Id, size_t Bytes, HandlerType&& Handler)
+	{
+		FEntry* Entry = Find(ENetDirection::In, Id);
+		if (Entry == nullptr)
+		{
+			Add(Unknown[static_cast<size_t>(ENetDirection::In)], 1);
+			Handler();
+			return;
+		}
+
+		const uint64_t Count = Entry->Messages.load(std::memory_order_relaxed);
+		Entry->Messages.store(Count + 1, std::memory_order_relaxed);
+		Add(Entry->Bytes, Bytes);
+
+		if ((Count & ((uint64_t(1) << TimingSampleShift) - 1)) != 0)
+		{
+			Handler();
+			return;
+		}
+
+		const std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+		Handler();
+		const uint64_t Nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - Start).count();
+
+		Add(Entry->TimedMessages, 1);
+		Add(Entry->TimedNanoseconds, Nanoseconds);
+		Add(Entry->HandlerHistogram[GetBucketIndex(Nanoseconds)], 1);
+		if (Nanoseconds > Entry->MaxNanoseconds.load(std::memory_order_relaxed))
+		{
+			Entry->MaxNanoseconds.store(Nanoseconds, std::memory_order_relaxed);
+		}
+	}
+
+	/** Samples a queue's depth. Single writer per direction. */
+	void RecordQueueDepth(ENetDirection Direction, uint64_t Depth)
+	{
+		FQueue& Queue = Queues[static_cast<size_t>(Direction)];
+		Add(Queue.Samples, 1);
+		Queue.Last.store(Depth, std::memory_order_relaxed);
+		if (Depth > Queue.Max.load(std::memory_order_relaxed))
+		{
+			Queue.Max.store(Depth, std::memory_order_relaxed);
+		}
+		Add(Queue.Histogram[GetBucketIndex(Depth)], 1);
+	}
+
+	/** Copies every counter into Out. Any thread; the copy is not one atomic snapshot. */
+	void Take(FCounts& Out) const
+	{
+		for (size_t Direction = 0; Direction < NumDirections; ++Direction)
+		{
+			for (size_t Index = 0; Index < NumIds; ++Index)
+			{
+				const FEntry& Entry = Entries[Direction][Index];
+				FEntryCounts& Counts = Out.Entries[Direction][Index];
+				Counts.Messages = Entry.Messages.load(std::memory_order_relaxed);
+				Counts.Bytes = Entry.Bytes.load(std::memory_order_relaxed);
+				Counts.TimedMessages = Entry.TimedMessages.load(std::memory_order_relaxed);
+				Counts.TimedNanoseconds = Entry.TimedNanoseconds.load(std::memory_order_relaxed);
+				Counts.MaxNanoseconds = Entry.MaxNanoseconds.load(std::memory_order_relaxed);
+				for (size_t Bucket = 0; Bucket < NumBuckets; ++Bucket)
+				{
+					Counts.HandlerHistogram[Bucket] = Entry.HandlerHistogram[Bucket].load(std::memory_order_relaxed);
+				}
+			}
+
+			const FQueue& Queue = Queues[Direction];
+			FQueueCounts& QueueCounts = Out.Queues[Direction];
+			QueueCounts.Samples = Queue.Samples.load(std::memory_order_relaxed);
+			QueueCounts.Last = Queue.Last.load(std::memory_order_relaxed);
+			QueueCounts.Max = Queue.Max.load(std::memory_order_relaxed);
+			for (size_t Bucket = 0; Bucket < NumBuckets; ++Bucket)
+			{
+				QueueCounts.Histogram[Bucket] = Queue.Histogram[Bucket].load(std::memory_order_relaxed);
+			}
+
+			Out.Unknown[Direction] = Unknown[Direction].load(std::memory_order_relaxed);
+		}
+	}
+
+	/** Zeroes every counter. A message recorded meanwhile may be partly kept. */
+	void Reset()
+	{
+		for (size_t Direction = 0; Direction < NumDirections; ++Direction)
+		{
+			for (FEntry& Entry : Entries[Direction])
+			{
+				Entry.Messages.store(0, std::memory_order_relaxed);
+				Entry.Bytes.store(0, std::memory_order_relaxed);
+				Entry.TimedMessages.store(0, std::memory_order_relaxed);
+				Entry.TimedNanoseconds.store(0, std::memory_order_relaxed);
+				Entry.MaxNanoseconds.store(0, std::memory_order_relaxed);
+				for (std::atomic<uint64_t>& Bucket : Entry.HandlerHistogram)
+				{
+					Bucket.store(0, std::memory_order_relaxed);
+				}
+			}
+
+			FQueue& Queue = Queues[Direction];
+			Queue.Samples.store(0, std::memory_order_relaxed);
+			Queue.Last.store(0, std::memory_order_relaxed);
+			Queue.Max.store(0, std::memory_order_relaxed);
+			for (std::atomic<uint64_t>& Bucket : Queue.Histogram)
+			{
+				Bucket.store(0, std::memory_order_relaxed);
+			}
+
+			Unknown[Direction].store(0, std::memory_order_relaxed);
+		}
+	}
+
+	static size_t GetBucketIndex(uint64_t Value)
+	{
+		size_t Index = 0;
+		while (Value != 0 && Index < NumBuckets - 1)
+		{
+			Value >>= 1;
+			++Index;
+		}
+		return Index;
+	}
+
+	static const char* GetDirectionName(size_t Direction)
+	{
+		return Direction == static_cast<size_t>(ENetDirection::In) ? "in" : "out";
+	}
+
+	/**
+	 * One row per MsgId and direction that saw traffic. Rates are over Seconds; handler columns
+	 * are only filled for received messages.
+	 */
+	static std::string ToCsv(const FCounts& Counts, double Seconds)
+	{
+		std::string Out = "direction,msg_id,name,messages,bytes,messages_per_sec,bytes_per_sec,handler_ns_mean,handler_ns_max,handler_ms_total\n";
+		char Line[256];
+		for (size_t Direction = 0; Direction < NumDirections; ++Direction)
+		{
+			for (size_t Index = 0; Index < NumIds; ++Index)
+			{
+				const FEntryCounts& Entry = Counts.Entries[Direction][Index];
+				if (Entry.Messages == 0)
+				{
+					continue;
+				}
+
+				snprintf(Line, sizeof(Line), "%s,%zu,%s,%llu,%llu,%.2f,%.2f,%.1f,%llu,%.3f\n",
+					GetDirectionName(Direction), Index, ProtocolCore::GetMsgIdName(static_cast<MsgId>(Index)),
+					static_cast<unsigned long long>(Entry.Messages), static_cast<unsigned long long>(Entry.Bytes),
+					Entry.Messages / Seconds, Entry.Bytes / Seconds,
+					Entry.TimedMessages > 0 ? static_cast<double>(Entry.TimedNanoseconds) / Entry.TimedMessages : 0.0,
+					static_cast<unsigned long long>(Entry.MaxNanoseconds), Entry.GetEstimatedNanoseconds() / 1e6);
+				Out += Line;
+			}
+		}
+		return Out;
+	}
+
+	/** Everything ToCsv has, plus the handler and queue depth histograms. */
+	static std::string ToJson(const FCounts& Counts, double Seconds)
+	{
+		char Buffer[256];
+		snprintf(Buffer, sizeof(Buffer), "{\"seconds\":%.3f,\"bucket\":\"log2\",\"messages\":[", Seconds);
+		std::string Out = Buffer;
+
+		bool bFirst = true;
+		for (size_t Direction = 0; Direction < NumDirections; ++Direction)
+		{
+			for (size_t Index = 0; Index < NumIds; ++Index)
+			{
+				const FEntryCounts& Entry = Counts.Entries[Direction][Index];
+				if (Entry.Messages == 0)
+				{
+					continue;
+				}
+
+				snprintf(Buffer, sizeof(Buffer), "%s{\"direction\":\"%s\",\"msg_id\":%zu,\"name\":\"%s\",\"messages\":%llu,\"bytes\":%llu,\"timed\":%llu,\"timed_ns\":%llu,\"max_ns\":%llu,\"handler_ns\":",
+					bFirst ? "" : ",", GetDirectionName(Direction), Index, ProtocolCore::GetMsgIdName(static_cast<MsgId>(Index)),
+					static_cast<unsigned long long>(Entry.Messages), static_cast<unsigned long long>(Entry.Bytes),
+					static_cast<unsigned long long>(Entry.TimedMessages), static_cast<unsigned long long>(Entry.TimedNanoseconds),
+					static_cast<unsigned long long>(Entry.MaxNanoseconds));
+				Out += Buffer;
+				AppendHistogram(Out, Entry.HandlerHistogram);
+				Out += "}";
+				bFirst = false;
+			}
+		}
+
+		Out += "],\"queues\":[";
+		for (size_t Direction = 0; Direction < NumDirections; ++Direction)
+		{
+			const FQueueCounts& Queue = Counts.Queues[Direction];
+			snprintf(Buffer, sizeof(Buffer), "%s{\"direction\":\"%s\",\"samples\":%llu,\"last\":%llu,\"max\":%llu,\"depth\":",
+				Direction == 0 ? "" : ",", GetDirectionName(Direction), static_cast<unsigned long long>(Queue.Samples),
+				static_cast<unsigned long long>(Queue.Last), static_cast<unsigned long long>(Queue.Max));
+			Out += Buffer;
+			AppendHistogram(Out, Queue.Histogram);
+			Out += "}";
+		}
+
+		snprintf(Buffer, sizeof(Buffer), "],\"unknown\":{\"in\":%llu,\"out\":%llu}}",
+			static_cast<unsigned long long>(Counts.Unknown[0]), static_cast<unsigned long long>(Counts.Unknown[1]));
+		Out += Buffer;
+		return Out;
+	}
+
+private:
+	struct FEntry
+	{
+		std::atomic<uint64_t> Messages;
+
+		std::atomic<uint64_t> Bytes;
+
+		std::atomic<uint64_t> TimedMessages;
+
+		std::atomic<uint64_t> TimedNanoseconds;
+
+		std::atomic<uint64_t> MaxNanoseconds;
+
+		std::atomic<uint64_t> HandlerHistogram[NumBuckets];
+	};
+
+	struct FQueue
+	{
+		std::atomic<uint64_t> Samples;
+
+		std::atomic<uint64_t> Last;
+
+		std::atomic<uint64_t> Max;
+
+		std::atomic<uint64_t> Histogram[NumBuckets];
+	};
+
+	/** Single-writer increment: no locked instruction, readers see the value or the one before. */
+	static void Add(std::atomic<uint64_t>& Counter, uint64_t Value)
+	{
+		Counter.store(Counter.load(std::memory_order_relaxed) + Value, std::memory_order_relaxed);
+	}
+
+	FEntry* Find(ENetDirection Direction, MsgId Id)
+	{
+		const size_t Index = static_cast<size_t>(Id);
+		return Index < NumIds ? &Entries[static_cast<size_t>(Direction)][Index] : nullptr;
+	}
+
+	/** As a JSON array, trailing empty buckets trimmed. */
+	static void AppendHistogram(std::string& Out, const uint64_t (&Histogram)[NumBuckets])
+	{
+		size_t Used = NumBuckets;
+		while (Used > 0 && Histogram[Used - 1] == 0)
+		{
+			--Used;
+		}
+
+		Out += "[";
+		char Number[32];
+		for (size_t Bucket = 0; Bucket < Used; ++Bucket)
+		{
+			snprintf(Number, sizeof(Number), Bucket == 0 ? "%llu" : ",%llu", static_cast<unsigned long long>(Histogram[Bucket]));
+			Out += Number;
+		}
+		Out += "]";
+	}
+
+	FEntry Entries[NumDirections][NumIds];
+
+	FQueue Queues[NumDirections];
+
+	std::atomic<uint64_t> Unknown[NumDirections];
+};
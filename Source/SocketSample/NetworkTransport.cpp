@@ -0,0 +1,438 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "NetworkTransport.h"
+
+#include "HAL/RunnableThread.h"
+#include "HAL/PlatformProcess.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+#include "IPAddress.h"
+#include "Interfaces/IPv4/IPv4Address.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+
+#include "ProtocolCore.h"
+#include "NetCapture.h"
+
+
+namespace
+{
+	/** Smallest free space we hand to a single Recv call. */
+	const int32 MinRecvSize = 16 * 1024;
+
+	/** Capture records are written out in chunks of about this size. */
+	const size_t CaptureFlushSize = 64 * 1024;
+}
+
+
+FNetworkTransport::FNetworkTransport(uint32 InboxCapacity, uint32 OutboxBytes)
+	: Inbox(InboxCapacity + 1)
+	, Outbox(OutboxBytes)
+{
+}
+
+FNetworkTransport::~FNetworkTransport()
+{
+	Shutdown();
+}
+
+bool FNetworkTransport::Start(const FString& Address, int32 Port)
+{
+	check(Thread == nullptr);
+
+	ISocketSubsystem* SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+
+	Socket = SocketSubsystem->CreateSocket(NAME_Stream, TEXT("default"), false);
+	if (Socket == nullptr)
+	{
+		return false;
+	}
+
+	FIPv4Address ip;
+	FIPv4Address::Parse(Address, ip);
+
+	TSharedRef<FInternetAddr> addr = SocketSubsystem->CreateInternetAddr();
+	addr->SetIp(ip.Value);
+	addr->SetPort(Port);
+
+	Socket->SetNoDelay(true);
+
+	// A full send buffer must not stall the worker, or reads stop too; see FlushOutbox. Being
+	// non-blocking also makes Connect return at once and the worker finish it, see FinishConnect.
+	Socket->SetNonBlocking(true);
+
+	if (!Socket->Connect(*addr))
+	{
+		SocketSubsystem->DestroySocket(Socket);
+		Socket = nullptr;
+		return false;
+	}
+
+	bConnected = false;
+	bFailed = false;
+	bRunning = true;
+	Thread = FRunnableThread::Create(this, TEXT("FNetworkTransport"), 128 * 1024, TPri_AboveNormal);
+
+	return Thread != nullptr;
+}
+
+bool FNetworkTransport::StartReplay(const FString& Path, bool bRealTime)
+{
+	check(Thread == nullptr);
+
+	if (!FFileHelper::LoadFileToArray(ReplayData, *Path))
+	{
+		return false;
+	}
+
+	if (!FNetCaptureReader(ReplayData.GetData(), ReplayData.Num()).IsValid())
+	{
+		UE_LOG(LogTemp, Error, TEXT("FNetworkTransport: %s is not a capture this build can read"), *Path);
+		ReplayData.Empty();
+		return false;
+	}
+
+	bReplay = true;
+	bReplayRealTime = bRealTime;
+	bReplayFinished = false;
+	bConnected = true;
+	bFailed = false;
+	bRunning = true;
+	Thread = FRunnableThread::Create(this, TEXT("FNetworkTransport"), 128 * 1024, TPri_AboveNormal);
+
+	return Thread != nullptr;
+}
+
+void FNetworkTransport::Shutdown()
+{
+	if (Thread)
+	{
+		Thread->Kill(true);
+		delete Thread;
+		Thread = nullptr;
+	}
+
+	StopCapture();
+
+	if (Socket)
+	{
+		Socket->Close();
+		ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Socket);
+		Socket = nullptr;
+	}
+
+	bConnected = false;
+}
+
+bool FNetworkTransport::Send(flatbuffers::DetachedBuffer&& Frame, uint64 Key)
+{
+	if (!bConnected)
+	{
+		return false;
+	}
+
+	Outbox.Push(MoveTemp(Frame), Key);
+	return true;
+}
+
+bool FNetworkTransport::Receive(FNetFrame& OutFrame)
+{
+	return Inbox.Dequeue(OutFrame);
+}
+
+bool FNetworkTransport::Init()
+{
+	Decoder.Reset();
+	InFlight = flatbuffers::DetachedBuffer();
+	InFlightOffset = 0;
+	return true;
+}
+
+uint32 FNetworkTransport::Run()
+{
+	if (bReplay)
+	{
+		return RunReplay();
+	}
+
+	if (!FinishConnect())
+	{
+		return 0;
+	}
+
+	while (bRunning && bConnected)
+	{
+		if (!FlushOutbox())
+		{
+			Fail();
+			break;
+		}
+
+		// The game thread is behind; stop reading and let TCP flow control push back on the server.
+		if (Inbox.IsFull())
+		{
+			FPlatformProcess::SleepNoStats(PollInterval.GetTotalSeconds());
+			ParseFrames();
+			continue;
+		}
+
+		if (Socket->Wait(ESocketWaitConditions::WaitForRead, PollInterval))
+		{
+			if (!ReadSocket())
+			{
+				Fail();
+				break;
+			}
+		}
+
+		ParseFrames();
+	}
+
+	return 0;
+}
+
+uint32 FNetworkTransport::RunReplay()
+{
+	FNetCaptureReader Reader(ReplayData.GetData(), ReplayData.Num());
+	const double StartTime = FPlatformTime::Seconds();
+
+	FNetCaptureRecord Record;
+	while (bRunning && Reader.Next(Record))
+	{
+		// Nobody reads what the game sends during a replay.
+		while (Outbox.Pop(InFlight))
+		{
+		}
+
+		if (bReplayRealTime)
+		{
+			const double DueTime = StartTime + Record.Nanoseconds / 1e9;
+			for (double Now = FPlatformTime::Seconds(); Now < DueTime && bRunning; Now = FPlatformTime::Seconds())
+			{
+				FPlatformProcess::SleepNoStats(FMath::Min(DueTime - Now, PollInterval.GetTotalSeconds()));
+			}
+		}
+
+		// ReplayData outlives every frame queued from it.
+		EnqueueFrame(Record.Id, FFrameSlice(Record.Body, Record.Size));
+	}
+
+	if (Reader.IsTruncated())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("FNetworkTransport: replay stopped at a truncated record"));
+	}
+
+	InFlight = flatbuffers::DetachedBuffer();
+	bReplayFinished = true;
+	return 0;
+}
+
+bool FNetworkTransport::StartCapture(const FString& Path)
+{
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	PlatformFile.CreateDirectoryTree(*FPaths::GetPath(Path));
+
+	IFileHandle* File = PlatformFile.OpenWrite(*Path);
+	if (File == nullptr)
+	{
+		return false;
+	}
+
+	FScopeLock Lock(&CaptureLock);
+	if (CaptureFile)
+	{
+		FlushCapture();
+	}
+
+	CaptureFile.Reset(File);
+	CaptureBuffer.clear();
+	NetCapture::AppendFileHeader(CaptureBuffer);
+	CaptureStartTime = FPlatformTime::Seconds();
+	bCapturing = true;
+	return true;
+}
+
+void FNetworkTransport::StopCapture()
+{
+	FScopeLock Lock(&CaptureLock);
+	bCapturing = false;
+	if (CaptureFile)
+	{
+		FlushCapture();
+		CaptureFile->Flush();
+		CaptureFile.Reset();
+	}
+}
+
+void FNetworkTransport::FlushCapture()
+{
+	if (!CaptureBuffer.empty())
+	{
+		CaptureFile->Write(CaptureBuffer.data(), (int64)CaptureBuffer.size());
+		CaptureBuffer.clear();
+	}
+}
+
+bool FNetworkTransport::FinishConnect()
+{
+	// The caller owns the connect timeout and shuts us down when it expires.
+	while (bRunning)
+	{
+		if (Socket->Wait(ESocketWaitConditions::WaitForWrite, PollInterval))
+		{
+			if (Socket->GetConnectionState() != SCS_Connected)
+			{
+				Fail();
+				return false;
+			}
+
+			bConnected = true;
+			return true;
+		}
+
+		if (Socket->GetConnectionState() == SCS_ConnectionError)
+		{
+			Fail();
+			return false;
+		}
+	}
+	return false;
+}
+
+void FNetworkTransport::Fail()
+{
+	bConnected = false;
+	bFailed = true;
+}
+
+void FNetworkTransport::Stop()
+{
+	bRunning = false;
+}
+
+void FNetworkTransport::Exit()
+{
+}
+
+bool FNetworkTransport::FlushOutbox()
+{
+	for (;;)
+	{
+		if (InFlightOffset >= (int32)InFlight.size())
+		{
+			InFlightOffset = 0;
+			if (!Outbox.Pop(InFlight))
+			{
+				InFlight = flatbuffers::DetachedBuffer();
+				return true;
+			}
+		}
+
+		int32 Sent = 0;
+		if (!Socket->Send(InFlight.data() + InFlightOffset, (int32)InFlight.size() - InFlightOffset, Sent))
+		{
+			// Full send buffer: keep the rest for the next pass while the outbox coalesces behind it.
+			return ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->GetLastErrorCode() == SE_EWOULDBLOCK;
+		}
+
+		if (Sent <= 0)
+		{
+			return true;
+		}
+		InFlightOffset += Sent;
+
+		if (InFlightOffset >= (int32)InFlight.size())
+		{
+			FramesSent.Increment();
+			BytesSent.Add(InFlight.size());
+
+			FFrameHeader Header;
+			if (Telemetry && InFlight.size() >= FFrameHeader::Size && Header.Decode(InFlight.data()))
+			{
+				Telemetry->Record(ENetDirection::Out, Header.Id, InFlight.size());
+			}
+		}
+	}
+}
+
+bool FNetworkTransport::ReadSocket()
+{
+	uint8* Dest = Decoder.GetWriteBuffer(MinRecvSize);
+
+	int32 Read = 0;
+	const bool bSuccess = Socket->Recv(Dest, (int32)Decoder.GetWritableSize(), Read);
+
+	// FSocketBSD::Recv turns the two cases around from recv(): a graceful close by the peer
+	// comes back as false, and EWOULDBLOCK comes back as true with nothing read.
+	if (!bSuccess)
+	{
+		return ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->GetLastErrorCode() == SE_EWOULDBLOCK;
+	}
+
+	if (Read == 0)
+	{
+		return true;
+	}
+
+	Decoder.CommitWrite(Read);
+	return true;
+}
+
+void FNetworkTransport::ParseFrames()
+{
+	FFrameView View;
+	while (!Inbox.IsFull() && Decoder.Next(View))
+	{
+		const ProtocolCore::EUnpackResult Result = ProtocolCore::UnpackFrame(View, [this](MsgId Id, const uint8* Data, size_t Size)
+		{
+			EnqueueFrame(Id, Decoder.Slice(Data, Size));
+		});
+
+		if (Result == ProtocolCore::EUnpackResult::Compressed)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("FNetworkTransport: dropping compressed frame %d, compression is not supported"), (int32)View.Id);
+		}
+		else if (Result == ProtocolCore::EUnpackResult::MalformedBatch)
+		{
+			UE_LOG(LogTemp, Error, TEXT("FNetworkTransport: malformed batch %d"), (int32)View.Id);
+		}
+	}
+
+	if (Decoder.HasError())
+	{
+		UE_LOG(LogTemp, Error, TEXT("FNetworkTransport: malformed frame header, dropping connection"));
+		Fail();
+	}
+}
+
+void FNetworkTransport::EnqueueFrame(MsgId Id, FFrameSlice&& Body)
+{
+	FNetFrame Frame;
+	Frame.Id = Id;
+	Frame.ReceiveTime = FPlatformTime::Seconds();
+	Frame.Body = MoveTemp(Body);
+	const uint8* Data = Frame.Body.GetData();
+	const size_t Size = Frame.Body.GetSize();
+
+	if (bCapturing && !bReplay)
+	{
+		FScopeLock Lock(&CaptureLock);
+		if (CaptureFile)
+		{
+			NetCapture::AppendRecord(CaptureBuffer, (uint64)((Frame.ReceiveTime - CaptureStartTime) * 1e9), Id, Data, Size);
+			if (CaptureBuffer.size() >= CaptureFlushSize)
+			{
+				FlushCapture();
+			}
+		}
+	}
+
+	// A batch can hold more frames than the inbox has room for; wait for the game thread rather than drop them.
+	while (!Inbox.Enqueue(MoveTemp(Frame)) && bRunning)
+	{
+		FPlatformProcess::SleepNoStats(PollInterval.GetTotalSeconds());
+	}
+}
@@ -0,0 +1,187 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "HAL/ThreadSafeBool.h"
+#include "HAL/ThreadSafeCounter64.h"
+#include "Containers/CircularQueue.h"
+
+#include "flatbuffers/flatbuffers.h"
+
+#include "MsgId.h"
+#include "FrameDecoder.h"
+#include "CoalescingOutbox.h"
+#include "NetTelemetry.h"
+
+#include <vector>
+
+class FSocket;
+class FRunnableThread;
+class IFileHandle;
+
+/**
+ * One complete message taken off the wire. Body is the FlatBuffer without the frame header, read
+ * in place from the receive buffer it arrived in; dropping the frame releases that buffer.
+ */
+struct FNetFrame
+{
+	MsgId Id = MsgId(0);
+
+	/** FPlatformTime::Seconds() when the network thread took the frame off the socket. */
+	double ReceiveTime = 0.0;
+
+	FFrameSlice Body;
+};
+
+/**
+ * Owns the client socket and runs all socket I/O on a dedicated thread.
+ * The game thread only talks to it through two bounded queues: Outbox (game thread -> worker,
+ * see FCoalescingOutbox) and Inbox (worker -> game thread, SPSC).
+ */
+class FNetworkTransport : public FRunnable
+{
+public:
+	FNetworkTransport(uint32 InboxCapacity = 1024, uint32 OutboxBytes = 64 * 1024);
+	virtual ~FNetworkTransport();
+
+	/**
+	 * Starts a non-blocking connect and the I/O thread, which finishes connecting; poll
+	 * IsConnected and HasFailed. Returns false if the attempt failed immediately. Game thread only.
+	 */
+	bool Start(const FString& Address, int32 Port);
+
+	/**
+	 * Starts the I/O thread on a capture (see NetCapture.h) instead of a socket: its messages are
+	 * delivered through Receive exactly as received ones, at their recorded pace if bRealTime or
+	 * as fast as the inbox drains otherwise. Sent frames are discarded. Game thread only.
+	 */
+	bool StartReplay(const FString& Path, bool bRealTime);
+
+	/** Every message of the replay has been queued for Receive. */
+	bool IsReplayFinished() const { return bReplayFinished; }
+
+	/** Stops the I/O thread and closes the socket. Game thread only. */
+	void Shutdown();
+
+	/** Appends every message received from now on to a new capture file at Path. Game thread only. */
+	bool StartCapture(const FString& Path);
+
+	/** Flushes and closes the capture file, if any. Also done by Shutdown. Game thread only. */
+	void StopCapture();
+
+	/**
+	 * Queues a finished frame (see FinishFrame) for sending. The buffer is handed to the network thread
+	 * as is and freed there once written. Key is FCoalescingOutbox::Reliable or a latest-value key
+	 * from FCoalescingOutbox::MakeKey. Never blocks; returns false only if we are not connected.
+	 */
+	bool Send(flatbuffers::DetachedBuffer&& Frame, uint64 Key = FCoalescingOutbox::Reliable);
+
+	/** Outbox depth, coalesce and drop counters. Any thread. */
+	FCoalescingOutbox::FStats GetOutboxStats() const { return Outbox.GetStats(); }
+
+	/**
+	 * Counts every frame into Telemetry, as ENetDirection::Out, once the socket has taken all of
+	 * it; frames the outbox coalesced or dropped never are. Set before Start; Telemetry must
+	 * outlive the I/O thread.
+	 */
+	void SetTelemetry(FNetTelemetry* InTelemetry) { Telemetry = InTelemetry; }
+
+	/** Frames and bytes written to the socket so far. Any thread. */
+	int64 GetFramesSent() const { return FramesSent.GetValue(); }
+
+	int64 GetBytesSent() const { return BytesSent.GetValue(); }
+
+	/** Received frames waiting for Receive. Game thread only; the worker may be adding more. */
+	uint32 GetInboxDepth() const { return Inbox.Count(); }
+
+	/** Pops the next received frame. Game thread only. */
+	bool Receive(FNetFrame& OutFrame);
+
+	bool IsConnected() const { return bConnected; }
+
+	/** The connect attempt failed, or the established connection dropped. */
+	bool HasFailed() const { return bFailed; }
+
+	// Begin FRunnable interface.
+	virtual bool Init() override;
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+	virtual void Exit() override;
+	// End FRunnable interface
+
+	/** How long the worker blocks waiting for the socket to become readable before it checks the outbox again. */
+	FTimespan PollInterval = FTimespan::FromMilliseconds(1);
+
+private:
+	/** Waits on the I/O thread for the connect started by Start to complete. */
+	bool FinishConnect();
+
+	void Fail();
+
+	/** Sends as much as the socket takes without blocking. Returns false if the connection failed. */
+	bool FlushOutbox();
+
+	bool ReadSocket();
+
+	void ParseFrames();
+
+	void EnqueueFrame(MsgId Id, FFrameSlice&& Body);
+
+	/** Run() for StartReplay. */
+	uint32 RunReplay();
+
+	/** Writes CaptureBuffer out. Caller holds CaptureLock. */
+	void FlushCapture();
+
+	FSocket* Socket = nullptr;
+
+	FRunnableThread* Thread = nullptr;
+
+	FThreadSafeBool bRunning;
+
+	FThreadSafeBool bConnected;
+
+	FThreadSafeBool bFailed;
+
+	TCircularQueue<FNetFrame> Inbox;
+
+	FCoalescingOutbox Outbox;
+
+	/** Frame taken from Outbox that the socket has only partly accepted. Worker thread only. */
+	flatbuffers::DetachedBuffer InFlight;
+
+	int32 InFlightOffset = 0;
+
+	FNetTelemetry* Telemetry = nullptr;
+
+	FThreadSafeCounter64 FramesSent;
+
+	FThreadSafeCounter64 BytesSent;
+
+	/** Bytes read from the socket that do not form a complete frame yet. Worker thread only. */
+	FFrameDecoder Decoder;
+
+	/** Whole capture being replayed. Set before the worker starts, then worker thread only. */
+	TArray<uint8> ReplayData;
+
+	bool bReplay = false;
+
+	bool bReplayRealTime = false;
+
+	FThreadSafeBool bReplayFinished;
+
+	/** Guards the capture state, which the game thread opens and closes while the worker writes. */
+	FCriticalSection CaptureLock;
+
+	TUniquePtr<IFileHandle> CaptureFile;
+
+	/** CaptureFile is open; lets the worker skip the lock when it is not. */
+	FThreadSafeBool bCapturing;
+
+	/** Records not written to CaptureFile yet. */
+	std::vector<uint8_t> CaptureBuffer;
+
+	double CaptureStartTime = 0.0;
+};
@@ -37,6 +37,26 @@ struct S2C_SyncLocation;
 struct S2C_SyncLocationBuilder;
 struct S2C_SyncLocationT;
 
+struct S2C_WorldSnapshot;
+struct S2C_WorldSnapshotBuilder;
+struct S2C_WorldSnapshotT;
+
+struct S2C_CompactSnapshot;
+struct S2C_CompactSnapshotBuilder;
+struct S2C_CompactSnapshotT;
+
+struct C2S_SnapshotAck;
+struct C2S_SnapshotAckBuilder;
+struct C2S_SnapshotAckT;
+
+struct C2S_Ping;
+struct C2S_PingBuilder;
+struct C2S_PingT;
+
+struct S2C_Pong;
+struct S2C_PongBuilder;
+struct S2C_PongT;
+
 FLATBUFFERS_MANUALLY_ALIGNED_STRUCT(4) Vec3 FLATBUFFERS_FINAL_CLASS {
  private:
   float x_;
@@ -509,6 +529,413 @@ inline flatbuffers::Offset<S2C_SyncLocation> CreateS2C_SyncLocation(
 
 flatbuffers::Offset<S2C_SyncLocation> CreateS2C_SyncLocation(flatbuffers::FlatBufferBuilder &_fbb, const S2C_SyncLocationT *_o, const flatbuffers::rehasher_function_t *_rehasher = nullptr);
 
+struct S2C_WorldSnapshotT : public flatbuffers::NativeTable {
+  typedef S2C_WorldSnapshot TableType;
+  uint32_t server_tick = 0;
+  std::vector<uint64_t> actor_id{};
+  std::vector<ProjectM::Actor::Transform> transform{};
+};
+
+struct S2C_WorldSnapshot FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
+  typedef S2C_WorldSnapshotT NativeTableType;
+  typedef S2C_WorldSnapshotBuilder Builder;
+  enum FlatBuffersVTableOffset FLATBUFFERS_VTABLE_UNDERLYING_TYPE {
+    VT_SERVER_TICK = 4,
+    VT_ACTOR_ID = 6,
+    VT_TRANSFORM = 8
+  };
+  uint32_t server_tick() const {
+    return GetField<uint32_t>(VT_SERVER_TICK, 0);
+  }
+  bool mutate_server_tick(uint32_t _server_tick) {
+    return SetField<uint32_t>(VT_SERVER_TICK, _server_tick, 0);
+  }
+  const flatbuffers::Vector<uint64_t> *actor_id() const {
+    return GetPointer<const flatbuffers::Vector<uint64_t> *>(VT_ACTOR_ID);
+  }
+  flatbuffers::Vector<uint64_t> *mutable_actor_id() {
+    return GetPointer<flatbuffers::Vector<uint64_t> *>(VT_ACTOR_ID);
+  }
+  const flatbuffers::Vector<const ProjectM::Actor::Transform *> *transform() const {
+    return GetPointer<const flatbuffers::Vector<const ProjectM::Actor::Transform *> *>(VT_TRANSFORM);
+  }
+  flatbuffers::Vector<const ProjectM::Actor::Transform *> *mutable_transform() {
+    return GetPointer<flatbuffers::Vector<const ProjectM::Actor::Transform *> *>(VT_TRANSFORM);
+  }
+  bool Verify(flatbuffers::Verifier &verifier) const {
+    return VerifyTableStart(verifier) &&
+           VerifyField<uint32_t>(verifier, VT_SERVER_TICK) &&
+           VerifyOffset(verifier, VT_ACTOR_ID) &&
+           verifier.VerifyVector(actor_id()) &&
+           VerifyOffset(verifier, VT_TRANSFORM) &&
+           verifier.VerifyVector(transform()) &&
+           verifier.EndTable();
+  }
+  S2C_WorldSnapshotT *UnPack(const flatbuffers::resolver_function_t *_resolver = nullptr) const;
+  void UnPackTo(S2C_WorldSnapshotT *_o, const flatbuffers::resolver_function_t *_resolver = nullptr) const;
+  static flatbuffers::Offset<S2C_WorldSnapshot> Pack(flatbuffers::FlatBufferBuilder &_fbb, const S2C_WorldSnapshotT* _o, const flatbuffers::rehasher_function_t *_rehasher = nullptr);
+};
+
+struct S2C_WorldSnapshotBuilder {
+  typedef S2C_WorldSnapshot Table;
+  flatbuffers::FlatBufferBuilder &fbb_;
+  flatbuffers::uoffset_t start_;
+  void add_server_tick(uint32_t server_tick) {
+    fbb_.AddElement<uint32_t>(S2C_WorldSnapshot::VT_SERVER_TICK, server_tick, 0);
+  }
+  void add_actor_id(flatbuffers::Offset<flatbuffers::Vector<uint64_t>> actor_id) {
+    fbb_.AddOffset(S2C_WorldSnapshot::VT_ACTOR_ID, actor_id);
+  }
+  void add_transform(flatbuffers::Offset<flatbuffers::Vector<const ProjectM::Actor::Transform *>> transform) {
+    fbb_.AddOffset(S2C_WorldSnapshot::VT_TRANSFORM, transform);
+  }
+  explicit S2C_WorldSnapshotBuilder(flatbuffers::FlatBufferBuilder &_fbb)
+        : fbb_(_fbb) {
+    start_ = fbb_.StartTable();
+  }
+  flatbuffers::Offset<S2C_WorldSnapshot> Finish() {
+    const auto end = fbb_.EndTable(start_);
+    auto o = flatbuffers::Offset<S2C_WorldSnapshot>(end);
+    return o;
+  }
+};
+
+inline flatbuffers::Offset<S2C_WorldSnapshot> CreateS2C_WorldSnapshot(
+    flatbuffers::FlatBufferBuilder &_fbb,
+    uint32_t server_tick = 0,
+    flatbuffers::Offset<flatbuffers::Vector<uint64_t>> actor_id = 0,
+    flatbuffers::Offset<flatbuffers::Vector<const ProjectM::Actor::Transform *>> transform = 0) {
+  S2C_WorldSnapshotBuilder builder_(_fbb);
+  builder_.add_transform(transform);
+  builder_.add_actor_id(actor_id);
+  builder_.add_server_tick(server_tick);
+  return builder_.Finish();
+}
+
+inline flatbuffers::Offset<S2C_WorldSnapshot> CreateS2C_WorldSnapshotDirect(
+    flatbuffers::FlatBufferBuilder &_fbb,
+    uint32_t server_tick = 0,
+    const std::vector<uint64_t> *actor_id = nullptr,
+    const std::vector<ProjectM::Actor::Transform> *transform = nullptr) {
+  auto actor_id__ = actor_id ? _fbb.CreateVector<uint64_t>(*actor_id) : 0;
+  auto transform__ = transform ? _fbb.CreateVectorOfStructs<ProjectM::Actor::Transform>(*transform) : 0;
+  return ProjectM::Actor::CreateS2C_WorldSnapshot(
+      _fbb,
+      server_tick,
+      actor_id__,
+      transform__);
+}
+
+flatbuffers::Offset<S2C_WorldSnapshot> CreateS2C_WorldSnapshot(flatbuffers::FlatBufferBuilder &_fbb, const S2C_WorldSnapshotT *_o, const flatbuffers::rehasher_function_t *_rehasher = nullptr);
+
+struct S2C_CompactSnapshotT : public flatbuffers::NativeTable {
+  typedef S2C_CompactSnapshot TableType;
+  uint32_t server_tick = 0;
+  uint32_t baseline_tick = 0;
+  std::vector<uint64_t> actor_id{};
+  std::vector<uint8_t> data{};
+};
+
+struct S2C_CompactSnapshot FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
+  typedef S2C_CompactSnapshotT NativeTableType;
+  typedef S2C_CompactSnapshotBuilder Builder;
+  enum FlatBuffersVTableOffset FLATBUFFERS_VTABLE_UNDERLYING_TYPE {
+    VT_SERVER_TICK = 4,
+    VT_BASELINE_TICK = 6,
+    VT_ACTOR_ID = 8,
+    VT_DATA = 10
+  };
+  uint32_t server_tick() const {
+    return GetField<uint32_t>(VT_SERVER_TICK, 0);
+  }
+  bool mutate_server_tick(uint32_t _server_tick) {
+    return SetField<uint32_t>(VT_SERVER_TICK, _server_tick, 0);
+  }
+  uint32_t baseline_tick() const {
+    return GetField<uint32_t>(VT_BASELINE_TICK, 0);
+  }
+  bool mutate_baseline_tick(uint32_t _baseline_tick) {
+    return SetField<uint32_t>(VT_BASELINE_TICK, _baseline_tick, 0);
+  }
+  const flatbuffers::Vector<uint64_t> *actor_id() const {
+    return GetPointer<const flatbuffers::Vector<uint64_t> *>(VT_ACTOR_ID);
+  }
+  flatbuffers::Vector<uint64_t> *mutable_actor_id() {
+    return GetPointer<flatbuffers::Vector<uint64_t> *>(VT_ACTOR_ID);
+  }
+  const flatbuffers::Vector<uint8_t> *data() const {
+    return GetPointer<const flatbuffers::Vector<uint8_t> *>(VT_DATA);
+  }
+  flatbuffers::Vector<uint8_t> *mutable_data() {
+    return GetPointer<flatbuffers::Vector<uint8_t> *>(VT_DATA);
+  }
+  bool Verify(flatbuffers::Verifier &verifier) const {
+    return VerifyTableStart(verifier) &&
+           VerifyField<uint32_t>(verifier, VT_SERVER_TICK) &&
+           VerifyField<uint32_t>(verifier, VT_BASELINE_TICK) &&
+           VerifyOffset(verifier, VT_ACTOR_ID) &&
+           verifier.VerifyVector(actor_id()) &&
+           VerifyOffset(verifier, VT_DATA) &&
+           verifier.VerifyVector(data()) &&
+           verifier.EndTable();
+  }
+  S2C_CompactSnapshotT *UnPack(const flatbuffers::resolver_function_t *_resolver = nullptr) const;
+  void UnPackTo(S2C_CompactSnapshotT *_o, const flatbuffers::resolver_function_t *_resolver = nullptr) const;
+  static flatbuffers::Offset<S2C_CompactSnapshot> Pack(flatbuffers::FlatBufferBuilder &_fbb, const S2C_CompactSnapshotT* _o, const flatbuffers::rehasher_function_t *_rehasher = nullptr);
+};
+
+struct S2C_CompactSnapshotBuilder {
+  typedef S2C_CompactSnapshot Table;
+  flatbuffers::FlatBufferBuilder &fbb_;
+  flatbuffers::uoffset_t start_;
+  void add_server_tick(uint32_t server_tick) {
+    fbb_.AddElement<uint32_t>(S2C_CompactSnapshot::VT_SERVER_TICK, server_tick, 0);
+  }
+  void add_baseline_tick(uint32_t baseline_tick) {
+    fbb_.AddElement<uint32_t>(S2C_CompactSnapshot::VT_BASELINE_TICK, baseline_tick, 0);
+  }
+  void add_actor_id(flatbuffers::Offset<flatbuffers::Vector<uint64_t>> actor_id) {
+    fbb_.AddOffset(S2C_CompactSnapshot::VT_ACTOR_ID, actor_id);
+  }
+  void add_data(flatbuffers::Offset<flatbuffers::Vector<uint8_t>> data) {
+    fbb_.AddOffset(S2C_CompactSnapshot::VT_DATA, data);
+  }
+  explicit S2C_CompactSnapshotBuilder(flatbuffers::FlatBufferBuilder &_fbb)
+        : fbb_(_fbb) {
+    start_ = fbb_.StartTable();
+  }
+  flatbuffers::Offset<S2C_CompactSnapshot> Finish() {
+    const auto end = fbb_.EndTable(start_);
+    auto o = flatbuffers::Offset<S2C_CompactSnapshot>(end);
+    return o;
+  }
+};
+
+inline flatbuffers::Offset<S2C_CompactSnapshot> CreateS2C_CompactSnapshot(
+    flatbuffers::FlatBufferBuilder &_fbb,
+    uint32_t server_tick = 0,
+    uint32_t baseline_tick = 0,
+    flatbuffers::Offset<flatbuffers::Vector<uint64_t>> actor_id = 0,
+    flatbuffers::Offset<flatbuffers::Vector<uint8_t>> data = 0) {
+  S2C_CompactSnapshotBuilder builder_(_fbb);
+  builder_.add_data(data);
+  builder_.add_actor_id(actor_id);
+  builder_.add_baseline_tick(baseline_tick);
+  builder_.add_server_tick(server_tick);
+  return builder_.Finish();
+}
+
+inline flatbuffers::Offset<S2C_CompactSnapshot> CreateS2C_CompactSnapshotDirect(
+    flatbuffers::FlatBufferBuilder &_fbb,
+    uint32_t server_tick = 0,
+    uint32_t baseline_tick = 0,
+    const std::vector<uint64_t> *actor_id = nullptr,
+    const std::vector<uint8_t> *data = nullptr) {
+  auto actor_id__ = actor_id ? _fbb.CreateVector<uint64_t>(*actor_id) : 0;
+  auto data__ = data ? _fbb.CreateVector<uint8_t>(*data) : 0;
+  return ProjectM::Actor::CreateS2C_CompactSnapshot(
+      _fbb,
+      server_tick,
+      baseline_tick,
+      actor_id__,
+      data__);
+}
+
+flatbuffers::Offset<S2C_CompactSnapshot> CreateS2C_CompactSnapshot(flatbuffers::FlatBufferBuilder &_fbb, const S2C_CompactSnapshotT *_o, const flatbuffers::rehasher_function_t *_rehasher = nullptr);
+
+struct C2S_SnapshotAckT : public flatbuffers::NativeTable {
+  typedef C2S_SnapshotAck TableType;
+  uint32_t server_tick = 0;
+};
+
+struct C2S_SnapshotAck FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
+  typedef C2S_SnapshotAckT NativeTableType;
+  typedef C2S_SnapshotAckBuilder Builder;
+  enum FlatBuffersVTableOffset FLATBUFFERS_VTABLE_UNDERLYING_TYPE {
+    VT_SERVER_TICK = 4
+  };
+  uint32_t server_tick() const {
+    return GetField<uint32_t>(VT_SERVER_TICK, 0);
+  }
+  bool mutate_server_tick(uint32_t _server_tick) {
+    return SetField<uint32_t>(VT_SERVER_TICK, _server_tick, 0);
+  }
+  bool Verify(flatbuffers::Verifier &verifier) const {
+    return VerifyTableStart(verifier) &&
+           VerifyField<uint32_t>(verifier, VT_SERVER_TICK) &&
+           verifier.EndTable();
+  }
+  C2S_SnapshotAckT *UnPack(const flatbuffers::resolver_function_t *_resolver = nullptr) const;
+  void UnPackTo(C2S_SnapshotAckT *_o, const flatbuffers::resolver_function_t *_resolver = nullptr) const;
+  static flatbuffers::Offset<C2S_SnapshotAck> Pack(flatbuffers::FlatBufferBuilder &_fbb, const C2S_SnapshotAckT* _o, const flatbuffers::rehasher_function_t *_rehasher = nullptr);
+};
+
+struct C2S_SnapshotAckBuilder {
+  typedef C2S_SnapshotAck Table;
+  flatbuffers::FlatBufferBuilder &fbb_;
+  flatbuffers::uoffset_t start_;
+  void add_server_tick(uint32_t server_tick) {
+    fbb_.AddElement<uint32_t>(C2S_SnapshotAck::VT_SERVER_TICK, server_tick, 0);
+  }
+  explicit C2S_SnapshotAckBuilder(flatbuffers::FlatBufferBuilder &_fbb)
+        : fbb_(_fbb) {
+    start_ = fbb_.StartTable();
+  }
+  flatbuffers::Offset<C2S_SnapshotAck> Finish() {
+    const auto end = fbb_.EndTable(start_);
+    auto o = flatbuffers::Offset<C2S_SnapshotAck>(end);
+    return o;
+  }
+};
+
+inline flatbuffers::Offset<C2S_SnapshotAck> CreateC2S_SnapshotAck(
+    flatbuffers::FlatBufferBuilder &_fbb,
+    uint32_t server_tick = 0) {
+  C2S_SnapshotAckBuilder builder_(_fbb);
+  builder_.add_server_tick(server_tick);
+  return builder_.Finish();
+}
+
+flatbuffers::Offset<C2S_SnapshotAck> CreateC2S_SnapshotAck(flatbuffers::FlatBufferBuilder &_fbb, const C2S_SnapshotAckT *_o, const flatbuffers::rehasher_function_t *_rehasher = nullptr);
+
+struct C2S_PingT : public flatbuffers::NativeTable {
+  typedef C2S_Ping TableType;
+  uint64_t client_time = 0;
+};
+
+struct C2S_Ping FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
+  typedef C2S_PingT NativeTableType;
+  typedef C2S_PingBuilder Builder;
+  enum FlatBuffersVTableOffset FLATBUFFERS_VTABLE_UNDERLYING_TYPE {
+    VT_CLIENT_TIME = 4
+  };
+  uint64_t client_time() const {
+    return GetField<uint64_t>(VT_CLIENT_TIME, 0);
+  }
+  bool mutate_client_time(uint64_t _client_time) {
+    return SetField<uint64_t>(VT_CLIENT_TIME, _client_time, 0);
+  }
+  bool Verify(flatbuffers::Verifier &verifier) const {
+    return VerifyTableStart(verifier) &&
+           VerifyField<uint64_t>(verifier, VT_CLIENT_TIME) &&
+           verifier.EndTable();
+  }
+  C2S_PingT *UnPack(const flatbuffers::resolver_function_t *_resolver = nullptr) const;
+  void UnPackTo(C2S_PingT *_o, const flatbuffers::resolver_function_t *_resolver = nullptr) const;
+  static flatbuffers::Offset<C2S_Ping> Pack(flatbuffers::FlatBufferBuilder &_fbb, const C2S_PingT* _o, const flatbuffers::rehasher_function_t *_rehasher = nullptr);
+};
+
+struct C2S_PingBuilder {
+  typedef C2S_Ping Table;
+  flatbuffers::FlatBufferBuilder &fbb_;
+  flatbuffers::uoffset_t start_;
+  void add_client_time(uint64_t client_time) {
+    fbb_.AddElement<uint64_t>(C2S_Ping::VT_CLIENT_TIME, client_time, 0);
+  }
+  explicit C2S_PingBuilder(flatbuffers::FlatBufferBuilder &_fbb)
+        : fbb_(_fbb) {
+    start_ = fbb_.StartTable();
+  }
+  flatbuffers::Offset<C2S_Ping> Finish() {
+    const auto end = fbb_.EndTable(start_);
+    auto o = flatbuffers::Offset<C2S_Ping>(end);
+    return o;
+  }
+};
+
+inline flatbuffers::Offset<C2S_Ping> CreateC2S_Ping(
+    flatbuffers::FlatBufferBuilder &_fbb,
+    uint64_t client_time = 0) {
+  C2S_PingBuilder builder_(_fbb);
+  builder_.add_client_time(client_time);
+  return builder_.Finish();
+}
+
+flatbuffers::Offset<C2S_Ping> CreateC2S_Ping(flatbuffers::FlatBufferBuilder &_fbb, const C2S_PingT *_o, const flatbuffers::rehasher_function_t *_rehasher = nullptr);
+
+struct S2C_PongT : public flatbuffers::NativeTable {
+  typedef S2C_Pong TableType;
+  uint64_t client_time = 0;
+  uint64_t server_receive_time = 0;
+  uint64_t server_send_time = 0;
+};
+
+struct S2C_Pong FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
+  typedef S2C_PongT NativeTableType;
+  typedef S2C_PongBuilder Builder;
+  enum FlatBuffersVTableOffset FLATBUFFERS_VTABLE_UNDERLYING_TYPE {
+    VT_CLIENT_TIME = 4,
+    VT_SERVER_RECEIVE_TIME = 6,
+    VT_SERVER_SEND_TIME = 8
+  };
+  uint64_t client_time() const {
+    return GetField<uint64_t>(VT_CLIENT_TIME, 0);
+  }
+  bool mutate_client_time(uint64_t _client_time) {
+    return SetField<uint64_t>(VT_CLIENT_TIME, _client_time, 0);
+  }
+  uint64_t server_receive_time() const {
+    return GetField<uint64_t>(VT_SERVER_RECEIVE_TIME, 0);
+  }
+  bool mutate_server_receive_time(uint64_t _server_receive_time) {
+    return SetField<uint64_t>(VT_SERVER_RECEIVE_TIME, _server_receive_time, 0);
+  }
+  uint64_t server_send_time() const {
+    return GetField<uint64_t>(VT_SERVER_SEND_TIME, 0);
+  }
+  bool mutate_server_send_time(uint64_t _server_send_time) {
+    return SetField<uint64_t>(VT_SERVER_SEND_TIME, _server_send_time, 0);
+  }
+  bool Verify(flatbuffers::Verifier &verifier) const {
+    return VerifyTableStart(verifier) &&
+           VerifyField<uint64_t>(verifier, VT_CLIENT_TIME) &&
+           VerifyField<uint64_t>(verifier, VT_SERVER_RECEIVE_TIME) &&
+           VerifyField<uint64_t>(verifier, VT_SERVER_SEND_TIME) &&
+           verifier.EndTable();
+  }
+  S2C_PongT *UnPack(const flatbuffers::resolver_function_t *_resolver = nullptr) const;
+  void UnPackTo(S2C_PongT *_o, const flatbuffers::resolver_function_t *_resolver = nullptr) const;
+  static flatbuffers::Offset<S2C_Pong> Pack(flatbuffers::FlatBufferBuilder &_fbb, const S2C_PongT* _o, const flatbuffers::rehasher_function_t *_rehasher = nullptr);
+};
+
+struct S2C_PongBuilder {
+  typedef S2C_Pong Table;
+  flatbuffers::FlatBufferBuilder &fbb_;
+  flatbuffers::uoffset_t start_;
+  void add_client_time(uint64_t client_time) {
+    fbb_.AddElement<uint64_t>(S2C_Pong::VT_CLIENT_TIME, client_time, 0);
+  }
+  void add_server_receive_time(uint64_t server_receive_time) {
+    fbb_.AddElement<uint64_t>(S2C_Pong::VT_SERVER_RECEIVE_TIME, server_receive_time, 0);
+  }
+  void add_server_send_time(uint64_t server_send_time) {
+    fbb_.AddElement<uint64_t>(S2C_Pong::VT_SERVER_SEND_TIME, server_send_time, 0);
+  }
+  explicit S2C_PongBuilder(flatbuffers::FlatBufferBuilder &_fbb)
+        : fbb_(_fbb) {
+    start_ = fbb_.StartTable();
+  }
+  flatbuffers::Offset<S2C_Pong> Finish() {
+    const auto end = fbb_.EndTable(start_);
+    auto o = flatbuffers::Offset<S2C_Pong>(end);
+    return o;
+  }
+};
+
+inline flatbuffers::Offset<S2C_Pong> CreateS2C_Pong(
+    flatbuffers::FlatBufferBuilder &_fbb,
+    uint64_t client_time = 0,
+    uint64_t server_receive_time = 0,
+    uint64_t server_send_time = 0) {
+  S2C_PongBuilder builder_(_fbb);
+  builder_.add_server_send_time(server_send_time);
+  builder_.add_server_receive_time(server_receive_time);
+  builder_.add_client_time(client_time);
+  return builder_.Finish();
+}
+
+flatbuffers::Offset<S2C_Pong> CreateS2C_Pong(flatbuffers::FlatBufferBuilder &_fbb, const S2C_PongT *_o, const flatbuffers::rehasher_function_t *_rehasher = nullptr);
+
 inline C2S_LoginT *C2S_Login::UnPack(const flatbuffers::resolver_function_t *_resolver) const {
   auto _o = std::unique_ptr<C2S_LoginT>(new C2S_LoginT());
   UnPackTo(_o.get(), _resolver);
@@ -674,6 +1101,157 @@ inline flatbuffers::Offset<S2C_SyncLocation> CreateS2C_SyncLocation(flatbuffers:
       _transform);
 }
 
+inline S2C_WorldSnapshotT *S2C_WorldSnapshot::UnPack(const flatbuffers::resolver_function_t *_resolver) const {
+  auto _o = std::unique_ptr<S2C_WorldSnapshotT>(new S2C_WorldSnapshotT());
+  UnPackTo(_o.get(), _resolver);
+  return _o.release();
+}
+
+inline void S2C_WorldSnapshot::UnPackTo(S2C_WorldSnapshotT *_o, const flatbuffers::resolver_function_t *_resolver) const {
+  (void)_o;
+  (void)_resolver;
+  { auto _e = server_tick(); _o->server_tick = _e; }
+  { auto _e = actor_id(); if (_e) { _o->actor_id.resize(_e->size()); for (flatbuffers::uoffset_t _i = 0; _i < _e->size(); _i++) { _o->actor_id[_i] = _e->Get(_i); } } }
+  { auto _e = transform(); if (_e) { _o->transform.resize(_e->size()); for (flatbuffers::uoffset_t _i = 0; _i < _e->size(); _i++) { _o->transform[_i] = *_e->Get(_i); } } }
+}
+
+inline flatbuffers::Offset<S2C_WorldSnapshot> S2C_WorldSnapshot::Pack(flatbuffers::FlatBufferBuilder &_fbb, const S2C_WorldSnapshotT* _o, const flatbuffers::rehasher_function_t *_rehasher) {
+  return CreateS2C_WorldSnapshot(_fbb, _o, _rehasher);
+}
+
+inline flatbuffers::Offset<S2C_WorldSnapshot> CreateS2C_WorldSnapshot(flatbuffers::FlatBufferBuilder &_fbb, const S2C_WorldSnapshotT *_o, const flatbuffers::rehasher_function_t *_rehasher) {
+  (void)_rehasher;
+  (void)_o;
+  struct _VectorArgs { flatbuffers::FlatBufferBuilder *__fbb; const S2C_WorldSnapshotT* __o; const flatbuffers::rehasher_function_t *__rehasher; } _va = { &_fbb, _o, _rehasher}; (void)_va;
+  auto _server_tick = _o->server_tick;
+  auto _actor_id = _o->actor_id.size() ? _fbb.CreateVector(_o->actor_id) : 0;
+  auto _transform = _o->transform.size() ? _fbb.CreateVectorOfStructs(_o->transform) : 0;
+  return ProjectM::Actor::CreateS2C_WorldSnapshot(
+      _fbb,
+      _server_tick,
+      _actor_id,
+      _transform);
+}
+
+inline S2C_CompactSnapshotT *S2C_CompactSnapshot::UnPack(const flatbuffers::resolver_function_t *_resolver) const {
+  auto _o = std::unique_ptr<S2C_CompactSnapshotT>(new S2C_CompactSnapshotT());
+  UnPackTo(_o.get(), _resolver);
+  return _o.release();
+}
+
+inline void S2C_CompactSnapshot::UnPackTo(S2C_CompactSnapshotT *_o, const flatbuffers::resolver_function_t *_resolver) const {
+  (void)_o;
+  (void)_resolver;
+  { auto _e = server_tick(); _o->server_tick = _e; }
+  { auto _e = baseline_tick(); _o->baseline_tick = _e; }
+  { auto _e = actor_id(); if (_e) { _o->actor_id.resize(_e->size()); for (flatbuffers::uoffset_t _i = 0; _i < _e->size(); _i++) { _o->actor_id[_i] = _e->Get(_i); } } }
+  { auto _e = data(); if (_e) { _o->data.resize(_e->size()); std::copy(_e->begin(), _e->end(), _o->data.begin()); } }
+}
+
+inline flatbuffers::Offset<S2C_CompactSnapshot> S2C_CompactSnapshot::Pack(flatbuffers::FlatBufferBuilder &_fbb, const S2C_CompactSnapshotT* _o, const flatbuffers::rehasher_function_t *_rehasher) {
+  return CreateS2C_CompactSnapshot(_fbb, _o, _rehasher);
+}
+
+inline flatbuffers::Offset<S2C_CompactSnapshot> CreateS2C_CompactSnapshot(flatbuffers::FlatBufferBuilder &_fbb, const S2C_CompactSnapshotT *_o, const flatbuffers::rehasher_function_t *_rehasher) {
+  (void)_rehasher;
+  (void)_o;
+  struct _VectorArgs { flatbuffers::FlatBufferBuilder *__fbb; const S2C_CompactSnapshotT* __o; const flatbuffers::rehasher_function_t *__rehasher; } _va = { &_fbb, _o, _rehasher}; (void)_va;
+  auto _server_tick = _o->server_tick;
+  auto _baseline_tick = _o->baseline_tick;
+  auto _actor_id = _o->actor_id.size() ? _fbb.CreateVector(_o->actor_id) : 0;
+  auto _data = _o->data.size() ? _fbb.CreateVector(_o->data) : 0;
+  return ProjectM::Actor::CreateS2C_CompactSnapshot(
+      _fbb,
+      _server_tick,
+      _baseline_tick,
+      _actor_id,
+      _data);
+}
+
+inline C2S_SnapshotAckT *C2S_SnapshotAck::UnPack(const flatbuffers::resolver_function_t *_resolver) const {
+  auto _o = std::unique_ptr<C2S_SnapshotAckT>(new C2S_SnapshotAckT());
+  UnPackTo(_o.get(), _resolver);
+  return _o.release();
+}
+
+inline void C2S_SnapshotAck::UnPackTo(C2S_SnapshotAckT *_o, const flatbuffers::resolver_function_t *_resolver) const {
+  (void)_o;
+  (void)_resolver;
+  { auto _e = server_tick(); _o->server_tick = _e; }
+}
+
+inline flatbuffers::Offset<C2S_SnapshotAck> C2S_SnapshotAck::Pack(flatbuffers::FlatBufferBuilder &_fbb, const C2S_SnapshotAckT* _o, const flatbuffers::rehasher_function_t *_rehasher) {
+  return CreateC2S_SnapshotAck(_fbb, _o, _rehasher);
+}
+
+inline flatbuffers::Offset<C2S_SnapshotAck> CreateC2S_SnapshotAck(flatbuffers::FlatBufferBuilder &_fbb, const C2S_SnapshotAckT *_o, const flatbuffers::rehasher_function_t *_rehasher) {
+  (void)_rehasher;
+  (void)_o;
+  struct _VectorArgs { flatbuffers::FlatBufferBuilder *__fbb; const C2S_SnapshotAckT* __o; const flatbuffers::rehasher_function_t *__rehasher; } _va = { &_fbb, _o, _rehasher}; (void)_va;
+  auto _server_tick = _o->server_tick;
+  return ProjectM::Actor::CreateC2S_SnapshotAck(
+      _fbb,
+      _server_tick);
+}
+
+inline C2S_PingT *C2S_Ping::UnPack(const flatbuffers::resolver_function_t *_resolver) const {
+  auto _o = std::unique_ptr<C2S_PingT>(new C2S_PingT());
+  UnPackTo(_o.get(), _resolver);
+  return _o.release();
+}
+
+inline void C2S_Ping::UnPackTo(C2S_PingT *_o, const flatbuffers::resolver_function_t *_resolver) const {
+  (void)_o;
+  (void)_resolver;
+  { auto _e = client_time(); _o->client_time = _e; }
+}
+
+inline flatbuffers::Offset<C2S_Ping> C2S_Ping::Pack(flatbuffers::FlatBufferBuilder &_fbb, const C2S_PingT* _o, const flatbuffers::rehasher_function_t *_rehasher) {
+  return CreateC2S_Ping(_fbb, _o, _rehasher);
+}
+
+inline flatbuffers::Offset<C2S_Ping> CreateC2S_Ping(flatbuffers::FlatBufferBuilder &_fbb, const C2S_PingT *_o, const flatbuffers::rehasher_function_t *_rehasher) {
+  (void)_rehasher;
+  (void)_o;
+  struct _VectorArgs { flatbuffers::FlatBufferBuilder *__fbb; const C2S_PingT* __o; const flatbuffers::rehasher_function_t *__rehasher; } _va = { &_fbb, _o, _rehasher}; (void)_va;
+  auto _client_time = _o->client_time;
+  return ProjectM::Actor::CreateC2S_Ping(
+      _fbb,
+      _client_time);
+}
+
+inline S2C_PongT *S2C_Pong::UnPack(const flatbuffers::resolver_function_t *_resolver) const {
+  auto _o = std::unique_ptr<S2C_PongT>(new S2C_PongT());
+  UnPackTo(_o.get(), _resolver);
+  return _o.release();
+}
+
+inline void S2C_Pong::UnPackTo(S2C_PongT *_o, const flatbuffers::resolver_function_t *_resolver) const {
+  (void)_o;
+  (void)_resolver;
+  { auto _e = client_time(); _o->client_time = _e; }
+  { auto _e = server_receive_time(); _o->server_receive_time = _e; }
+  { auto _e = server_send_time(); _o->server_send_time = _e; }
+}
+
+inline flatbuffers::Offset<S2C_Pong> S2C_Pong::Pack(flatbuffers::FlatBufferBuilder &_fbb, const S2C_PongT* _o, const flatbuffers::rehasher_function_t *_rehasher) {
+  return CreateS2C_Pong(_fbb, _o, _rehasher);
+}
+
+inline flatbuffers::Offset<S2C_Pong> CreateS2C_Pong(flatbuffers::FlatBufferBuilder &_fbb, const S2C_PongT *_o, const flatbuffers::rehasher_function_t *_rehasher) {
+  (void)_rehasher;
+  (void)_o;
+  struct _VectorArgs { flatbuffers::FlatBufferBuilder *__fbb; const S2C_PongT* __o; const flatbuffers::rehasher_function_t *__rehasher; } _va = { &_fbb, _o, _rehasher}; (void)_va;
+  auto _client_time = _o->client_time;
+  auto _server_receive_time = _o->server_receive_time;
+  auto _server_send_time = _o->server_send_time;
+  return ProjectM::Actor::CreateS2C_Pong(
+      _fbb,
+      _client_time,
+      _server_receive_time,
+      _server_send_time);
+}
+
 }  // namespace Actor
 }  // namespace ProjectM
 
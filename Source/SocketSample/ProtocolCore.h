@@ -0,0 +1,109 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "flatbuffers/flatbuffers.h"
+
+#include "MsgId.h"
+#include "FrameHeader.h"
+#include "FrameDecoder.h"
+#include "FrameBuilder.h"
+#include "BuilderPool.h"
+#include "ProjectM_generated.h"
+
+/**
+ * The client side of the protocol without the engine: building the messages a client sends
+ * and unpacking the frames it receives. ASocketPlayerController and FNetworkTransport use it
+ * in game, and the headless tools under Server/ use the same code.
+ */
+namespace ProtocolCore
+{
+	inline const char* GetMsgIdName(MsgId Id)
+	{
+		switch (Id)
+		{
+		case MsgId::C2S_Login: return "C2S_Login";
+		case MsgId::S2C_Login: return "S2C_Login";
+		case MsgId::S2C_SpawnActors: return "S2C_SpawnActors";
+		case MsgId::S2C_DestroyActor: return "S2C_DestroyActor";
+		case MsgId::C2S_SyncLocation: return "C2S_SyncLocation";
+		case MsgId::S2C_SyncLocation: return "S2C_SyncLocation";
+		case MsgId::S2C_WorldSnapshot: return "S2C_WorldSnapshot";
+		case MsgId::S2C_CompactSnapshot: return "S2C_CompactSnapshot";
+		case MsgId::C2S_SnapshotAck: return "C2S_SnapshotAck";
+		case MsgId::C2S_Ping: return "C2S_Ping";
+		case MsgId::S2C_Pong: return "S2C_Pong";
+		default: return "Unknown";
+		}
+	}
+
+	inline flatbuffers::DetachedBuffer MakeLogin(const char* Token)
+	{
+		FBuilderPool::FHandle fbb = FBuilderPool::Get().Acquire(MsgId::C2S_Login);
+		FinishFrame(*fbb, MsgId::C2S_Login, ProjectM::Actor::CreateC2S_LoginDirect(*fbb, Token));
+		return fbb.Release();
+	}
+
+	inline flatbuffers::DetachedBuffer MakeSyncLocation(uint64_t ActorUID, const ProjectM::Actor::Transform& Transform)
+	{
+		// Built directly rather than through C2S_SyncLocationT, whose unique_ptr<Transform> costs a heap allocation per send.
+		FBuilderPool::FHandle fbb = FBuilderPool::Get().Acquire(MsgId::C2S_SyncLocation);
+		FinishFrame(*fbb, MsgId::C2S_SyncLocation, ProjectM::Actor::CreateC2S_SyncLocation(*fbb, ActorUID, &Transform));
+		return fbb.Release();
+	}
+
+	inline flatbuffers::DetachedBuffer MakeSnapshotAck(uint32_t ServerTick)
+	{
+		FBuilderPool::FHandle fbb = FBuilderPool::Get().Acquire(MsgId::C2S_SnapshotAck);
+		FinishFrame(*fbb, MsgId::C2S_SnapshotAck, ProjectM::Actor::CreateC2S_SnapshotAck(*fbb, ServerTick));
+		return fbb.Release();
+	}
+
+	/** ClientTime is echoed back in S2C_Pong, see FClockSync. Microseconds on any clock the client likes. */
+	inline flatbuffers::DetachedBuffer MakePing(uint64_t ClientTime)
+	{
+		FBuilderPool::FHandle fbb = FBuilderPool::Get().Acquire(MsgId::C2S_Ping);
+		FinishFrame(*fbb, MsgId::C2S_Ping, ProjectM::Actor::CreateC2S_Ping(*fbb, ClientTime));
+		return fbb.Release();
+	}
+
+	enum class EUnpackResult : uint8_t
+	{
+		Ok,
+		/** Compressed frames are not supported yet and are dropped. */
+		Compressed,
+		/** The messages before the malformed part were still delivered. */
+		MalformedBatch,
+	};
+
+	/**
+	 * Calls Handle(MsgId, const uint8_t* Body, size_t Size) for every message in a frame taken
+	 * from FFrameDecoder: once for a plain frame, once per sub-frame for a batch.
+	 */
+	template<typename HandlerType>
+	inline EUnpackResult UnpackFrame(const FFrameView& Frame, HandlerType&& Handle)
+	{
+		if (Frame.Flags & FrameFlags::Compressed)
+		{
+			return EUnpackResult::Compressed;
+		}
+
+		if (Frame.Flags & FrameFlags::Batched)
+		{
+			FFrameBatchReader Batch(Frame.Data, Frame.Size);
+			FFrameHeader Header;
+			const uint8_t* Body = nullptr;
+			while (Batch.Next(Header, Body))
+			{
+				Handle(Header.Id, Body, static_cast<size_t>(Header.BodySize));
+			}
+			return Batch.HasError() ? EUnpackResult::MalformedBatch : EUnpackResult::Ok;
+		}
+
+		Handle(Frame.Id, Frame.Data, Frame.Size);
+		return EUnpackResult::Ok;
+	}
+}
@@ -0,0 +1,93 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "RemoteCharacterPool.h"
+
+#include "SocketSampleCharacter.h"
+
+
+ASocketSampleCharacter* URemoteCharacterPool::Acquire(TSubclassOf<ASocketSampleCharacter> Class, const FTransform& Transform)
+{
+	UClass* WantedClass = Class ? Class.Get() : ASocketSampleCharacter::StaticClass();
+
+	for (int32 Index = Free.Num() - 1; Index >= 0; --Index)
+	{
+		ASocketSampleCharacter* Character = Free[Index];
+		if (!IsValid(Character))
+		{
+			Free.RemoveAtSwap(Index);
+			continue;
+		}
+
+		if (Character->GetClass() == WantedClass)
+		{
+			Free.RemoveAtSwap(Index);
+			Character->SetActorTransform(Transform, false, nullptr, ETeleportType::ResetPhysics);
+			Character->SetPooled(false);
+			++NumReused;
+			return Character;
+		}
+	}
+
+	ASocketSampleCharacter* Character = Spawn(Class, Transform);
+	if (Character)
+	{
+		++NumSpawned;
+	}
+	return Character;
+}
+
+void URemoteCharacterPool::Release(ASocketSampleCharacter* Character)
+{
+	if (!IsValid(Character) || Character->IsPooled())
+	{
+		return;
+	}
+
+	Character->SetActorUID(0);
+
+	if (Free.Num() >= MaxFree)
+	{
+		Character->Destroy();
+		return;
+	}
+
+	Character->SetPooled(true);
+	Free.Add(Character);
+}
+
+void URemoteCharacterPool::Prewarm(TSubclassOf<ASocketSampleCharacter> Class, int32 Count)
+{
+	UClass* WantedClass = Class ? Class.Get() : ASocketSampleCharacter::StaticClass();
+
+	int32 Available = 0;
+	for (ASocketSampleCharacter* Character : Free)
+	{
+		Available += IsValid(Character) && Character->GetClass() == WantedClass ? 1 : 0;
+	}
+
+	for (; Available < Count && Free.Num() < MaxFree; ++Available)
+	{
+		ASocketSampleCharacter* Character = Spawn(Class, FTransform::Identity);
+		if (Character == nullptr)
+		{
+			return;
+		}
+
+		Character->SetPooled(true);
+		Free.Add(Character);
+	}
+}
+
+ASocketSampleCharacter* URemoteCharacterPool::Spawn(TSubclassOf<ASocketSampleCharacter> Class, const FTransform& Transform)
+{
+	UWorld* World = GetWorld();
+	if (World == nullptr)
+	{
+		return nullptr;
+	}
+
+	// The same spawn as SpawnRemoteCharacter's unpooled path, so pooling does not change where
+	// characters may be placed.
+	return World->SpawnActor<ASocketSampleCharacter>(Class ? Class.Get() : ASocketSampleCharacter::StaticClass(), Transform);
+}
@@ -0,0 +1,47 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+
+#include "RemoteCharacterPool.generated.h"
+
+class ASocketSampleCharacter;
+
+/**
+ * Keeps despawned remote characters parked (see ASocketSampleCharacter::SetPooled) instead of
+ * destroying them, so the next S2C_SpawnActors reuses one rather than paying for SpawnActor's
+ * construction and component registration. The pool lives and dies with its world.
+ */
+UCLASS()
+class URemoteCharacterPool : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** Returns a parked character of exactly Class, moved to Transform and unparked, or spawns a new one. */
+	ASocketSampleCharacter* Acquire(TSubclassOf<ASocketSampleCharacter> Class, const FTransform& Transform);
+
+	/** Clears Character's ActorUID and parks it, or destroys it if MaxFree characters are already parked. */
+	void Release(ASocketSampleCharacter* Character);
+
+	/** Spawns and parks characters until Count of Class are available, e.g. behind a loading screen. */
+	void Prewarm(TSubclassOf<ASocketSampleCharacter> Class, int32 Count);
+
+	int32 NumFree() const { return Free.Num(); }
+
+	/** Parked characters beyond this are destroyed on release. */
+	int32 MaxFree = 256;
+
+	/** Acquires that had to spawn, and acquires served from the pool. */
+	uint64 NumSpawned = 0;
+
+	uint64 NumReused = 0;
+
+private:
+	ASocketSampleCharacter* Spawn(TSubclassOf<ASocketSampleCharacter> Class, const FTransform& Transform);
+
+	UPROPERTY()
+	TArray<ASocketSampleCharacter*> Free;
+};
@@ -0,0 +1,231 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+#include "TransformCodec.h"
+
+/**
+ * Decides when the local pawn's transform is worth sending.
+ *
+ * Called every frame with the current location and rotation. Nothing is sent while the pawn
+ * stays within PositionThreshold / RotationThreshold of what was last sent, except a keep-alive
+ * every KeepAliveInterval. While it moves, a priority accumulator fills at one unit per
+ * BaseInterval, faster in proportion to how sharply velocity or turn rate has changed since the
+ * last send, and a send happens when it reaches one. MinInterval caps the rate.
+ * Evaluate only decides; the caller reports the send with Commit once it has actually been
+ * queued, so a failed send is retried on the next Evaluate. Engine-independent; the caller owns
+ * the clock.
+ */
+class FSendScheduler
+{
+public:
+	enum class EDecision : uint8_t
+	{
+		Skip,
+		Send,
+		KeepAlive,
+	};
+
+	struct FStats
+	{
+		uint64_t Sent = 0;
+
+		uint64_t KeepAlives = 0;
+
+		uint64_t Skipped = 0;
+	};
+
+	/** Movement below this distance (cm) from the last sent location does not need a send. */
+	float PositionThreshold = 1.f;
+
+	/** Rotation below this angle (degrees, per axis) from the last sent rotation does not need a send. */
+	float RotationThreshold = 1.f;
+
+	/** Shortest time between two sends. */
+	double MinInterval = 1.0 / 30.0;
+
+	/** Time between sends while moving steadily. Remote interpolation delays should cover about two. */
+	double BaseInterval = 0.05;
+
+	/** Time between sends while idle. */
+	double KeepAliveInterval = 1.0;
+
+	/** A velocity change of this many cm/s since the last send doubles the accumulation rate. */
+	float VelocityChangeScale = 100.f;
+
+	/** A turn rate change of this many degrees/s since the last send doubles the accumulation rate. */
+	float TurnRateChangeScale = 90.f;
+
+	/** Rotation is Pitch/Yaw/Roll in degrees. */
+	EDecision Evaluate(double Now, const float Location[3], const float Rotation[3])
+	{
+		const double DeltaTime = bHasPrevious ? Now - PreviousTime : 0.0;
+		UpdateRates(Now, DeltaTime, Location, Rotation);
+
+		const EDecision Decision = Decide(Now, DeltaTime, Location, Rotation);
+		if (Decision == EDecision::Skip)
+		{
+			++Stats.Skipped;
+		}
+		return Decision;
+	}
+
+	/** Records that the transform Evaluate decided to send has been sent. */
+	void Commit(EDecision Decision, double Now, const float Location[3], const float Rotation[3])
+	{
+		switch (Decision)
+		{
+		case EDecision::Send:
+			++Stats.Sent;
+			break;
+		case EDecision::KeepAlive:
+			++Stats.KeepAlives;
+			break;
+		default:
+			return;
+		}
+
+		MarkSent(Now, Location, Rotation);
+	}
+
+	/** Forces the next Evaluate to send, e.g. after (re)logging in. */
+	void Reset()
+	{
+		bHasSent = false;
+		bHasPrevious = false;
+		Priority = 0.f;
+	}
+
+	const FStats& GetStats() const
+	{
+		return Stats;
+	}
+
+private:
+	void UpdateRates(double Now, double DeltaTime, const float Location[3], const float Rotation[3])
+	{
+		if (DeltaTime > 0.0)
+		{
+			for (int32_t i = 0; i < 3; ++i)
+			{
+				Velocity[i] = static_cast<float>((Location[i] - PreviousLocation[i]) / DeltaTime);
+			}
+			TurnRate = static_cast<float>(TransformCodec::NormalizeAxis(Rotation[1] - PreviousRotation[1]) / DeltaTime);
+		}
+
+		for (int32_t i = 0; i < 3; ++i)
+		{
+			PreviousLocation[i] = Location[i];
+			PreviousRotation[i] = Rotation[i];
+		}
+		PreviousTime = Now;
+		bHasPrevious = true;
+	}
+
+	EDecision Decide(double Now, double DeltaTime, const float Location[3], const float Rotation[3])
+	{
+		if (!bHasSent)
+		{
+			return EDecision::Send;
+		}
+
+		const double SinceSent = Now - SentTime;
+		if (SinceSent < MinInterval)
+		{
+			Accumulate(DeltaTime);
+			return EDecision::Skip;
+		}
+
+		if (!HasChanged(Location, Rotation))
+		{
+			Priority = 0.f;
+			return SinceSent >= KeepAliveInterval ? EDecision::KeepAlive : EDecision::Skip;
+		}
+
+		Accumulate(DeltaTime);
+		return Priority >= 1.f || SinceSent >= KeepAliveInterval ? EDecision::Send : EDecision::Skip;
+	}
+
+	void Accumulate(double DeltaTime)
+	{
+		float VelocityChange = 0.f;
+		for (int32_t i = 0; i < 3; ++i)
+		{
+			const float Delta = Velocity[i] - SentVelocity[i];
+			VelocityChange += Delta * Delta;
+		}
+		VelocityChange = std::sqrt(VelocityChange);
+		const float TurnRateChange = std::fabs(TurnRate - SentTurnRate);
+
+		const float Urgency = 1.f + VelocityChange / VelocityChangeScale + TurnRateChange / TurnRateChangeScale;
+		Priority += static_cast<float>(DeltaTime / BaseInterval) * Urgency;
+	}
+
+	bool HasChanged(const float Location[3], const float Rotation[3]) const
+	{
+		float DistanceSquared = 0.f;
+		for (int32_t i = 0; i < 3; ++i)
+		{
+			const float Delta = Location[i] - SentLocation[i];
+			DistanceSquared += Delta * Delta;
+		}
+		if (DistanceSquared >= PositionThreshold * PositionThreshold)
+		{
+			return true;
+		}
+
+		for (int32_t i = 0; i < 3; ++i)
+		{
+			if (std::fabs(TransformCodec::NormalizeAxis(Rotation[i] - SentRotation[i])) >= RotationThreshold)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void MarkSent(double Now, const float Location[3], const float Rotation[3])
+	{
+		for (int32_t i = 0; i < 3; ++i)
+		{
+			SentLocation[i] = Location[i];
+			SentRotation[i] = Rotation[i];
+			SentVelocity[i] = Velocity[i];
+		}
+		SentTurnRate = TurnRate;
+		SentTime = Now;
+		bHasSent = true;
+		Priority = 0.f;
+	}
+
+	FStats Stats;
+
+	float Priority = 0.f;
+
+	bool bHasSent = false;
+
+	double SentTime = 0.0;
+
+	float SentLocation[3] = { 0.f, 0.f, 0.f };
+
+	float SentRotation[3] = { 0.f, 0.f, 0.f };
+
+	float SentVelocity[3] = { 0.f, 0.f, 0.f };
+
+	float SentTurnRate = 0.f;
+
+	bool bHasPrevious = false;
+
+	double PreviousTime = 0.0;
+
+	float PreviousLocation[3] = { 0.f, 0.f, 0.f };
+
+	float PreviousRotation[3] = { 0.f, 0.f, 0.f };
+
+	float Velocity[3] = { 0.f, 0.f, 0.f };
+
+	float TurnRate = 0.f;
+};
@@ -0,0 +1,352 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "ProjectM_generated.h"
+#include "TransformCodec.h"
+
+/** A remote actor's transform at a point in time. Rotation is a quaternion (X, Y, Z, W). */
+struct FTransformSample
+{
+	double Time = 0.0;
+
+	float Location[3] = { 0.f, 0.f, 0.f };
+
+	float Rotation[4] = { 0.f, 0.f, 0.f, 1.f };
+
+	float Scale[3] = { 1.f, 1.f, 1.f };
+
+	FTransformSample() = default;
+
+	FTransformSample(double InTime, const ProjectM::Actor::Transform& Transform)
+		: Time(InTime)
+	{
+		Location[0] = Transform.location().x();
+		Location[1] = Transform.location().y();
+		Location[2] = Transform.location().z();
+		TransformCodec::EulerToQuat(Transform.rotation().x(), Transform.rotation().y(), Transform.rotation().z(), Rotation);
+		Scale[0] = Transform.scale().x();
+		Scale[1] = Transform.scale().y();
+		Scale[2] = Transform.scale().z();
+	}
+
+	/** Location and scale are lerped; rotation is nlerped along the shorter arc. Alpha may exceed 1 to extrapolate location. */
+	static FTransformSample Blend(const FTransformSample& A, const FTransformSample& B, float Alpha, double Time)
+	{
+		FTransformSample Out;
+		Out.Time = Time;
+		for (int32_t i = 0; i < 3; ++i)
+		{
+			Out.Location[i] = A.Location[i] + (B.Location[i] - A.Location[i]) * Alpha;
+		}
+
+		// Only location is extrapolated; rotation and scale stop at B.
+		const float ClampedAlpha = Alpha > 1.f ? 1.f : Alpha;
+		for (int32_t i = 0; i < 3; ++i)
+		{
+			Out.Scale[i] = A.Scale[i] + (B.Scale[i] - A.Scale[i]) * ClampedAlpha;
+		}
+
+		const float Dot = A.Rotation[0] * B.Rotation[0] + A.Rotation[1] * B.Rotation[1] + A.Rotation[2] * B.Rotation[2] + A.Rotation[3] * B.Rotation[3];
+		const float BSign = Dot < 0.f ? -1.f : 1.f;
+		float LengthSquared = 0.f;
+		for (int32_t i = 0; i < 4; ++i)
+		{
+			Out.Rotation[i] = A.Rotation[i] + (B.Rotation[i] * BSign - A.Rotation[i]) * ClampedAlpha;
+			LengthSquared += Out.Rotation[i] * Out.Rotation[i];
+		}
+
+		const float InvLength = LengthSquared > 0.f ? 1.f / std::sqrt(LengthSquared) : 0.f;
+		for (float& Component : Out.Rotation)
+		{
+			Component *= InvLength;
+		}
+		return Out;
+	}
+};
+
+/**
+ * The last few timestamped samples of one actor, oldest to newest.
+ *
+ * Sample() renders the actor at a time in the past (now minus the render delay), so there is
+ * usually a received sample on either side to interpolate between. If packets are late and the
+ * render time passes the newest sample, location is extrapolated along the last velocity, but
+ * no further than MaxExtrapolation past the newest sample; after that the actor holds still.
+ */
+class FSnapshotBuffer
+{
+public:
+	static const uint32_t Capacity = 16;
+
+	/**
+	 * Appends a sample. Samples that are not newer than the newest one are out of order and
+	 * ignored. One less than MinInterval newer replaces the newest instead of being appended, so
+	 * two updates that arrived in the same read never become a velocity over microseconds.
+	 */
+	bool Push(const FTransformSample& Sample, double MinInterval = 0.0)
+	{
+		if (Count > 0 && Sample.Time <= Newest().Time)
+		{
+			return false;
+		}
+
+		if (Count > 0 && Sample.Time - Newest().Time < MinInterval)
+		{
+			Samples[(Head + Count - 1) % Capacity] = Sample;
+			return true;
+		}
+
+		Samples[(Head + Count) % Capacity] = Sample;
+		if (Count < Capacity)
+		{
+			++Count;
+		}
+		else
+		{
+			Head = (Head + 1) % Capacity;
+		}
+		return true;
+	}
+
+	bool Sample(double RenderTime, double MaxExtrapolation, FTransformSample& Out) const
+	{
+		if (Count == 0)
+		{
+			return false;
+		}
+
+		if (RenderTime <= Oldest().Time)
+		{
+			Out = Oldest();
+			return true;
+		}
+
+		if (Count == 1)
+		{
+			Out = Newest();
+			return true;
+		}
+
+		if (RenderTime >= Newest().Time)
+		{
+			const FTransformSample& From = At(Count - 2);
+			const FTransformSample& To = Newest();
+			const double Limit = To.Time + MaxExtrapolation;
+			const double Time = RenderTime < Limit ? RenderTime : Limit;
+			Out = FTransformSample::Blend(From, To, static_cast<float>((Time - From.Time) / (To.Time - From.Time)), RenderTime);
+			return true;
+		}
+
+		// The render time trails the newest sample by about the render delay, so search from the newest end.
+		uint32_t Index = Count - 1;
+		while (At(Index - 1).Time > RenderTime)
+		{
+			--Index;
+		}
+
+		const FTransformSample& From = At(Index - 1);
+		const FTransformSample& To = At(Index);
+		Out = FTransformSample::Blend(From, To, static_cast<float>((RenderTime - From.Time) / (To.Time - From.Time)), RenderTime);
+		return true;
+	}
+
+	uint32_t Num() const
+	{
+		return Count;
+	}
+
+	void Reset()
+	{
+		Head = Count = 0;
+	}
+
+private:
+	const FTransformSample& At(uint32_t Index) const
+	{
+		return Samples[(Head + Index) % Capacity];
+	}
+
+	const FTransformSample& Oldest() const
+	{
+		return At(0);
+	}
+
+	const FTransformSample& Newest() const
+	{
+		return At(Count - 1);
+	}
+
+	FTransformSample Samples[Capacity];
+
+	uint32_t Head = 0;
+
+	uint32_t Count = 0;
+};
+
+/**
+ * Maps server ticks to local time, so snapshot samples are spaced the way the server produced
+ * them rather than the way they happened to arrive. A tick's local time is Base + Tick *
+ * TickInterval, where Base tracks the earliest arrival seen (the least delayed one): an earlier
+ * arrival lowers it, by at most half a tick per snapshot so consecutive ticks never collapse
+ * onto one time, and later ones raise it only slowly, which follows clock drift without passing
+ * jitter on. A jump of more than a second, such as a server restart resetting its tick, starts
+ * over.
+ *
+ * Messages without a tick are put on the same time base with ToLocalTime, so samples from both
+ * kinds can share one FSnapshotBuffer.
+ */
+class FServerTickClock
+{
+public:
+	/** Must match the server's snapshot interval (the reference server's --relevancy-interval). */
+	double TickInterval = 0.05;
+
+	/** Fraction of the distance to a new arrival delay Lag moves per snapshot. */
+	double LagSmoothing = 0.1;
+
+	/** Fraction of the distance to a later estimate Base moves per snapshot. */
+	double Relax = 0.001;
+
+	/** Records that Tick arrived at ReceiveTime and returns the local time Tick stands for. */
+	double Update(uint32_t Tick, double ReceiveTime)
+	{
+		const double Estimate = ReceiveTime - Tick * TickInterval;
+		if (!bHasBase || std::fabs(Estimate - Base) > 1.0)
+		{
+			Base = Estimate;
+			Lag = 0.0;
+			bHasBase = true;
+		}
+		else if (Estimate < Base)
+		{
+			Base = Estimate > Base - TickInterval * 0.5 ? Estimate : Base - TickInterval * 0.5;
+		}
+		else
+		{
+			Base += (Estimate - Base) * Relax;
+		}
+
+		const double LocalTime = Base + Tick * TickInterval;
+		Lag += (ReceiveTime - LocalTime - Lag) * LagSmoothing;
+		return LocalTime;
+	}
+
+	/**
+	 * The local time, on the base Update returns, for a message without a tick that arrived at
+	 * ReceiveTime: the arrival less the average delay snapshots see beyond the least delayed one.
+	 * Before the first snapshot, ReceiveTime itself.
+	 */
+	double ToLocalTime(double ReceiveTime) const
+	{
+		return bHasBase ? ReceiveTime - Lag : ReceiveTime;
+	}
+
+	void Reset()
+	{
+		bHasBase = false;
+		Lag = 0.0;
+	}
+
+private:
+	double Base = 0.0;
+
+	/** Smoothed ReceiveTime - local time over recent snapshots. */
+	double Lag = 0.0;
+
+	bool bHasBase = false;
+};
+
+/**
+ * Snapshot buffers for every remote actor. Network handlers only Push() samples; Update() then
+ * samples all actors in one pass over contiguous storage, once per frame, and hands each result
+ * to the caller to apply. Engine-independent so it can be exercised outside the game.
+ */
+class FSnapshotInterpolator
+{
+public:
+	/** How far behind the newest data actors are rendered. About two send intervals hides one lost or late packet. */
+	double RenderDelay = 0.1;
+
+	/** Longest time past its newest sample an actor keeps moving on its last velocity. */
+	double MaxExtrapolation = 0.25;
+
+	/** Samples of one actor closer together than this are merged; see FSnapshotBuffer::Push. */
+	double MinSampleInterval = 0.01;
+
+	void Push(uint64_t ActorId, const FTransformSample& Sample)
+	{
+		const auto Found = Index.find(ActorId);
+		if (Found != Index.end())
+		{
+			Actors[Found->second].Buffer.Push(Sample, MinSampleInterval);
+			return;
+		}
+
+		Index.emplace(ActorId, Actors.size());
+		Actors.emplace_back();
+		Actors.back().Id = ActorId;
+		Actors.back().Buffer.Push(Sample, MinSampleInterval);
+	}
+
+	/** Calls Apply(ActorId, const FTransformSample&) for every actor, rendered at Now - RenderDelay. */
+	template<typename FunctorType>
+	void Update(double Now, FunctorType&& Apply) const
+	{
+		const double RenderTime = Now - RenderDelay;
+		FTransformSample Sample;
+		for (const FActor& Actor : Actors)
+		{
+			if (Actor.Buffer.Sample(RenderTime, MaxExtrapolation, Sample))
+			{
+				Apply(Actor.Id, Sample);
+			}
+		}
+	}
+
+	void Remove(uint64_t ActorId)
+	{
+		const auto Found = Index.find(ActorId);
+		if (Found == Index.end())
+		{
+			return;
+		}
+
+		const size_t Slot = Found->second;
+		Index.erase(Found);
+		if (Slot != Actors.size() - 1)
+		{
+			Actors[Slot] = Actors.back();
+			Index[Actors[Slot].Id] = Slot;
+		}
+		Actors.pop_back();
+	}
+
+	void Reset()
+	{
+		Actors.clear();
+		Index.clear();
+	}
+
+	size_t Num() const
+	{
+		return Actors.size();
+	}
+
+private:
+	struct FActor
+	{
+		uint64_t Id = 0;
+
+		FSnapshotBuffer Buffer;
+	};
+
+	std::vector<FActor> Actors;
+
+	std::unordered_map<uint64_t, size_t> Index;
+};
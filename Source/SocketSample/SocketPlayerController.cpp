@@ -3,19 +3,35 @@
 
 #include "SocketPlayerController.h"
 
-#include "NetWorking/Public/Interfaces/IPv4/IPv4Address.h"
-#include "TimerManager.h"
-#include "Kismet/GamePlayStatics.h"
 
 #include "MsgId.h"
+#include "FrameArena.h"
+#include "BuilderPool.h"
+#include "ProtocolCore.h"
+#include "MessageDispatcher.h"
 #include "ProjectM_generated.h"
 
 
 #include "SocketSampleCharacter.h"
+#include "NetActorRegistry.h"
+#include "RemoteCharacterPool.h"
 
 #include "GameFramework/CharacterMovementComponent.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
 
 
+DECLARE_STATS_GROUP(TEXT("SocketNet"), STATGROUP_SocketNet, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT(TEXT("Recv"), STAT_NetRecv, STATGROUP_SocketNet);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Messages In"), STAT_NetMessagesIn, STATGROUP_SocketNet);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Bytes In"), STAT_NetBytesIn, STATGROUP_SocketNet);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Messages Out"), STAT_NetMessagesOut, STATGROUP_SocketNet);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Bytes Out"), STAT_NetBytesOut, STATGROUP_SocketNet);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Inbox Depth (frames)"), STAT_NetInboxDepth, STATGROUP_SocketNet);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Outbox Depth (bytes)"), STAT_NetOutboxBytes, STATGROUP_SocketNet);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("RTT (ms)"), STAT_NetRtt, STATGROUP_SocketNet);
+
 
 void ASocketPlayerController::BeginPlay()
 {
@@ -26,8 +42,17 @@ void ASocketPlayerController::BeginPlay()
 		return;
 	}
 
+	TelemetryStartTime = FPlatformTime::Seconds();
 
+	FBuilderPool::Get().SetFrameArena(bUseFrameArena ? &FFrameArena::Get() : nullptr);
 
+	if (bPoolRemoteCharacters && PrewarmRemoteCharacters > 0)
+	{
+		if (URemoteCharacterPool* Pool = GetWorld()->GetSubsystem<URemoteCharacterPool>())
+		{
+			Pool->Prewarm(SpawnCharacterClass, PrewarmRemoteCharacters);
+		}
+	}
 }
 
 void ASocketPlayerController::Connect(FString UserID)
@@ -37,27 +62,133 @@ void ASocketPlayerController::Connect(FString UserID)
 		return;
 	}
 
-	Socket = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->CreateSocket(NAME_Stream, TEXT("default"), false);
+	GEngine->AddOnScreenDebugMessage(-1, 5.f, FColor::Red, FString::Printf(TEXT("Trying to connect.")));
 
-	FString address = TEXT("127.0.0.1");
-	int32 port = 9810;
-	FIPv4Address ip;
-	FIPv4Address::Parse(address, ip);
+	CloseTransport();
+	LoginToken = TCHAR_TO_ANSI(*UserID);
 
-	TSharedRef<FInternetAddr> addr = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->CreateInternetAddr();
-	addr->SetIp(ip.Value);
-	addr->SetPort(port);
+	Connection.ConnectTimeout = ConnectTimeout;
+	Connection.LoginTimeout = ConnectTimeout;
+	Connection.InitialBackoff = ReconnectInitialDelay;
+	Connection.MaxBackoff = ReconnectMaxDelay;
+	Connection.Open(FPlatformTime::Seconds());
+
+	UpdateConnection();
+}
+
+
+void ASocketPlayerController::Disconnect()
+{
+	Connection.Close(FPlatformTime::Seconds());
+	CloseTransport();
+	ResetRemoteWorld();
+
+	UpdateConnection();
+}
 
-	GEngine->AddOnScreenDebugMessage(-1, 5.f, FColor::Red, FString::Printf(TEXT("Trying to connect.")));
 
-	bConnected = Socket->Connect(*addr);
+ENetConnectionState ASocketPlayerController::GetConnectionState() const
+{
+	return static_cast<ENetConnectionState>(Connection.GetState());
+}
+
+
+void ASocketPlayerController::UpdateConnection()
+{
+	using FStatus = FConnectionStateMachine::ETransportStatus;
 
-	if (bConnected)
+	FStatus Status = FStatus::Failed;
+	if (Transport && !Transport->HasFailed())
 	{
-		GetWorldTimerManager().SetTimer(RecvTimer, this, &ASocketPlayerController::Recv, 0.01, true);
-		
-		Login(TCHAR_TO_ANSI(*UserID));
+		Status = Transport->IsConnected() ? FStatus::Connected : FStatus::Connecting;
+	}
+
+	switch (Connection.Update(FPlatformTime::Seconds(), Status))
+	{
+	case FConnectionStateMachine::EAction::Connect:
+		ClockSync.Reset();
+		Transport = MakeUnique<FNetworkTransport>();
+		Transport->SetTelemetry(&Telemetry);
+		LastFramesSent = LastBytesSent = 0;
+		if (!Transport->Start(ServerAddress, ServerPort))
+		{
+			// Reported as Failed on the next update, which backs off.
+			Transport.Reset();
+		}
+		else if (bCaptureInbound)
+		{
+			StartCapture();
+		}
+		break;
+
+	case FConnectionStateMachine::EAction::Login:
+		if (!Login(LoginToken))
+		{
+			// Only fails without a connected transport, which the next update reports as Failed.
+			UE_LOG(LogTemp, Warning, TEXT("Could not queue C2S_Login"));
+		}
+		break;
+
+	case FConnectionStateMachine::EAction::Disconnect:
+		UE_LOG(LogTemp, Warning, TEXT("Disconnected from server, retrying in %.1f s (attempt %d)"),
+			Connection.GetRetryTime() - FPlatformTime::Seconds(), Connection.GetAttempt());
+		CloseTransport();
+		ResetRemoteWorld();
+		break;
+
+	default:
+		break;
+	}
+
+	bConnected = Connection.GetState() == FConnectionStateMachine::EState::Online;
+
+	const ENetConnectionState NewState = GetConnectionState();
+	if (NewState != BroadcastConnectionState)
+	{
+		BroadcastConnectionState = NewState;
+		UE_LOG(LogTemp, Log, TEXT("Connection state: %s"), *UEnum::GetValueAsString(NewState));
+		OnConnectionStateChanged.Broadcast(NewState);
+	}
+}
+
+
+void ASocketPlayerController::CloseTransport()
+{
+	if (Transport)
+	{
+		Transport->Shutdown();
+		Transport.Reset();
+	}
+
+	// A replay runs through the transport, so closing it ends the replay too; Connect and
+	// Disconnect go back to driving a live connection.
+	bReplaying = false;
+	ReplayStartTime = 0.0;
+	ReplayRecvSeconds = 0.0;
+	ReplayMessages = 0;
+}
+
+
+void ASocketPlayerController::ResetRemoteWorld()
+{
+	// The next session may give us, and everyone else, different ids; nothing received so far applies.
+	if (UNetActorRegistry* Registry = GetWorld()->GetSubsystem<UNetActorRegistry>())
+	{
+		TArray<ASocketSampleCharacter*> Characters;
+		Registry->GetCharacters(Characters);
+		for (ASocketSampleCharacter* Character : Characters)
+		{
+			if (Character != GetPawn())
+			{
+				DespawnRemoteCharacter(Character);
+			}
+		}
 	}
+
+	PendingSpawns.Reset();
+	RemoteInterpolation.Reset();
+	SnapshotClock.Reset();
+	TransformBaselines.Reset();
 }
 
 
@@ -66,40 +197,79 @@ void ASocketPlayerController::Connect(FString UserID)
 void ASocketPlayerController::Tick(float DeltaSeconds)
 {
 	Super::Tick(DeltaSeconds);
+
+	if (bUseFrameArena)
+	{
+		FFrameArena::Get().Reset();
+	}
+
+	if (bReplaying)
+	{
+		TickReplay();
+	}
+	else
+	{
+		UpdateConnection();
+
+		UpdateClockSync();
+
+		Recv();
+	}
+
+	ProcessSpawnQueue();
+
+	UpdateRemoteCharacters();
+
+	if (Churn.FramesLeft > 0)
+	{
+		TickChurnBenchmark(DeltaSeconds);
+	}
 }
 
 void ASocketPlayerController::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
 	Super::EndPlay(EndPlayReason);
 
-	if (bConnected)
+	if (Transport)
 	{
-		//Socket->Shutdown(ESocketShutdownMode::Read);
-		Socket->Close();
+		const FCoalescingOutbox::FStats OutboxStats = Transport->GetOutboxStats();
+		UE_LOG(LogTemp, Log, TEXT("Outbox: %llu pushed, %llu coalesced, %llu dropped, peak %llu bytes"),
+			(uint64)OutboxStats.Pushed, (uint64)OutboxStats.Coalesced, (uint64)OutboxStats.Dropped, (uint64)OutboxStats.PeakQueuedBytes);
 	}
-}
+	Connection.Close(FPlatformTime::Seconds());
+	CloseTransport();
+	bConnected = false;
 
+	LogDispatchStats();
 
+	if (ClockSync.HasSamples())
+	{
+		UE_LOG(LogTemp, Log, TEXT("RTT: %.2f ms smoothed, %.2f ms min, %.2f ms jitter, offset error %.2f ms, %llu samples, %llu unanswered"),
+			ClockSync.GetRtt() * 1000.0, ClockSync.GetMinRtt() * 1000.0, ClockSync.GetJitter() * 1000.0, ClockSync.GetOffsetError() * 1000.0,
+			(uint64)ClockSync.GetNumSamples(), (uint64)ClockSync.GetNumLost());
+	}
 
-bool ASocketPlayerController::Login(std::string token)
+	const FSendScheduler::FStats& MoveStats = MoveScheduler.GetStats();
+	UE_LOG(LogTemp, Log, TEXT("C2S_SyncLocation: %llu sent, %llu keep-alives, %llu skipped"), MoveStats.Sent, MoveStats.KeepAlives, MoveStats.Skipped);
+}
+
+
+void ASocketPlayerController::OnPossess(APawn* InPawn)
 {
-	bool r = false;
+	Super::OnPossess(InPawn);
 
-	flatbuffers::FlatBufferBuilder fbb;
-	ProjectM::Actor::C2S_LoginT log;
-	log.token = token;
-	fbb.Finish(ProjectM::Actor::C2S_Login::Pack(fbb, &log));
+	ASocketSampleCharacter* NetworkChracter = Cast<ASocketSampleCharacter>(InPawn);
+	if (NetworkChracter && ActorUID != 0)
+	{
+		NetworkChracter->SetActorUID(ActorUID);
+	}
+}
 
-	uint32_t head = ((uint32_t)MsgId::C2S_Login << 16) | (4 + fbb.GetSize());
-	std::vector<uint8_t> buf(4 + fbb.GetSize());
-	memcpy(&buf[0], &head, sizeof(head));
-	memcpy(&buf[sizeof(head)], fbb.GetBufferPointer(), fbb.GetSize());
-	int32 sentByets = 0;
-	r = Socket->Send(buf.data(), buf.size(), sentByets);
 
-	assert(r);
 
-	return true;
+bool ASocketPlayerController::Login(std::string token)
+{
+	return SendFrame(ProtocolCore::MakeLogin(token.c_str()));
 }
 
 
@@ -109,9 +279,22 @@ bool ASocketPlayerController::Move()
 
 	if (NetworkChracter && bConnected)
 	{
-		flatbuffers::FlatBufferBuilder fbb;
-		ProjectM::Actor::C2S_SyncLocationT loc;
-		loc.actor_id = NetworkChracter->ActorUID;
+		MoveScheduler.PositionThreshold = MovePositionThreshold;
+		MoveScheduler.RotationThreshold = MoveRotationThreshold;
+		MoveScheduler.MinInterval = MoveMinInterval;
+		MoveScheduler.BaseInterval = MoveBaseInterval;
+		MoveScheduler.KeepAliveInterval = MoveKeepAliveInterval;
+
+		const double Now = GetWorld()->GetTimeSeconds();
+		const FVector Location = NetworkChracter->GetActorLocation();
+		const FRotator Rotation = NetworkChracter->GetActorRotation();
+		const float SchedulerLocation[3] = { Location.X, Location.Y, Location.Z };
+		const float SchedulerRotation[3] = { Rotation.Pitch, Rotation.Yaw, Rotation.Roll };
+		const FSendScheduler::EDecision Decision = MoveScheduler.Evaluate(Now, SchedulerLocation, SchedulerRotation);
+		if (Decision == FSendScheduler::EDecision::Skip)
+		{
+			return false;
+		}
 
 		ProjectM::Actor::Transform _trans;
 		_trans.mutable_location().mutate_x(NetworkChracter->GetActorLocation().X);
@@ -123,127 +306,618 @@ bool ASocketPlayerController::Move()
 		_trans.mutable_scale().mutate_x(NetworkChracter->GetActorScale().X);
 		_trans.mutable_scale().mutate_y(NetworkChracter->GetActorScale().Y);
 		_trans.mutable_scale().mutate_z(NetworkChracter->GetActorScale().Z);
-		loc.transform = std::make_unique<ProjectM::Actor::Transform>(_trans);
 
-		fbb.Finish(ProjectM::Actor::C2S_SyncLocation::Pack(fbb, &loc));
-
-		uint32_t head = ((uint32_t)MsgId::C2S_SyncLocation << 16) | (4 + fbb.GetSize());
-		std::vector<uint8_t> buf(4 + fbb.GetSize());
-		memcpy(&buf[0], &head, sizeof(head));
-		memcpy(&buf[sizeof(head)], fbb.GetBufferPointer(), fbb.GetSize());
-		int32 sentByets = 0;
-		bool r = Socket->Send(buf.data(), buf.size(), sentByets);
-		assert(r);
+		// Only the newest position matters, so a backed-up socket keeps one per actor.
+		if (!SendFrame(ProtocolCore::MakeSyncLocation(NetworkChracter->ActorUID, _trans), FCoalescingOutbox::MakeKey(MsgId::C2S_SyncLocation, NetworkChracter->ActorUID)))
+		{
+			// Not committed, so the scheduler asks again next frame.
+			return false;
+		}
 
+		MoveScheduler.Commit(Decision, Now, SchedulerLocation, SchedulerRotation);
 	}
 	return true;
 }
 
 
-void ASocketPlayerController::Recv()
+int64 ASocketPlayerController::GetMovesSent() const
 {
-	ASocketSampleCharacter* NetworkChracter = Cast<ASocketSampleCharacter>(GetPawn());
+	return MoveScheduler.GetStats().Sent + MoveScheduler.GetStats().KeepAlives;
+}
+
+
+int64 ASocketPlayerController::GetMovesSkipped() const
+{
+	return MoveScheduler.GetStats().Skipped;
+}
+
+
+bool ASocketPlayerController::SendFrame(flatbuffers::DetachedBuffer&& Frame, uint64 Key)
+{
+	if (!Transport)
+	{
+		return false;
+	}
+
+	// Counted by the transport once written, so frames the outbox replaces or drops are not.
+	return Transport->Send(MoveTemp(Frame), Key);
+}
+
+
+int32 ASocketPlayerController::Recv()
+{
+	SCOPE_CYCLE_COUNTER(STAT_NetRecv);
+
+	if (!Transport)
+	{
+		return 0;
+	}
+
+	// What waits in the inbox now is what queued up since the last frame.
+	const uint32 InboxDepth = Transport->GetInboxDepth();
+
+	uint32 Received = 0;
+	FNetFrame Frame;
+	while (Transport->Receive(Frame))
+	{
+		const size_t Bytes = FFrameHeader::Size + Frame.Body.GetSize();
+		INC_DWORD_STAT_BY(STAT_NetBytesIn, Bytes);
+
+		if (IsWaitingForPawn(Frame.Id))
+		{
+			// Received, but never reaches a handler.
+			++FramesWithoutPawn;
+			Telemetry.Record(ENetDirection::In, Frame.Id, Bytes);
+		}
+		else
+		{
+			Telemetry.RecordHandled(Frame.Id, Bytes, [this, &Frame]()
+			{
+				HandleMessage(Frame);
+			});
+		}
+		++Received;
+	}
+
+	const uint64 OutboxBytes = Transport->GetOutboxStats().QueuedBytes;
+	Telemetry.RecordQueueDepth(ENetDirection::In, InboxDepth);
+	Telemetry.RecordQueueDepth(ENetDirection::Out, OutboxBytes);
+
+	const int64 FramesSent = Transport->GetFramesSent();
+	const int64 BytesSent = Transport->GetBytesSent();
+	INC_DWORD_STAT_BY(STAT_NetMessagesOut, FramesSent - LastFramesSent);
+	INC_DWORD_STAT_BY(STAT_NetBytesOut, BytesSent - LastBytesSent);
+	LastFramesSent = FramesSent;
+	LastBytesSent = BytesSent;
+
+	INC_DWORD_STAT_BY(STAT_NetMessagesIn, Received);
+	SET_DWORD_STAT(STAT_NetInboxDepth, InboxDepth);
+	SET_DWORD_STAT(STAT_NetOutboxBytes, OutboxBytes);
+	SET_FLOAT_STAT(STAT_NetRtt, ClockSync.GetRtt() * 1000.0);
+
+	return (int32)Received;
+}
+
+
+void ASocketPlayerController::NetCapture(bool bEnable)
+{
+	if (!Transport || bReplaying)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("NetCapture: not connected"));
+		return;
+	}
+
+	if (bEnable)
+	{
+		StartCapture();
+	}
+	else
+	{
+		Transport->StopCapture();
+		UE_LOG(LogTemp, Log, TEXT("NetCapture: stopped"));
+	}
+}
+
+
+void ASocketPlayerController::StartCapture()
+{
+	const FString Path = FPaths::Combine(FPaths::ProfilingDir(), TEXT("NetCapture"), FString::Printf(TEXT("NetCapture-%s.pmcap"), *FDateTime::Now().ToString()));
+	if (Transport->StartCapture(Path))
+	{
+		UE_LOG(LogTemp, Log, TEXT("NetCapture: writing %s"), *Path);
+	}
+	else
+	{
+		UE_LOG(LogTemp, Warning, TEXT("NetCapture: cannot write %s"), *Path);
+	}
+}
+
+
+void ASocketPlayerController::NetReplay(const FString& File, bool bRealTime)
+{
+	if (!IsLocalController())
+	{
+		return;
+	}
+
+	Connection.Close(FPlatformTime::Seconds());
+	CloseTransport();
+	ResetRemoteWorld();
+	ClockSync.Reset();
+	DispatchStats.Reset();
+	FramesWithoutPawn = 0;
+	NetTelemetryReset();
+	UpdateConnection();
+
+	const FString Path = FPaths::IsRelative(File) ? FPaths::Combine(FPaths::ProfilingDir(), TEXT("NetCapture"), File) : File;
+
+	// A deep inbox, so a fast replay is not held to 1024 messages per frame.
+	Transport = MakeUnique<FNetworkTransport>(64 * 1024);
+	LastFramesSent = LastBytesSent = 0;
+	if (!Transport->StartReplay(Path, bRealTime))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("NetReplay: cannot replay %s"), *Path);
+		Transport.Reset();
+		return;
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("NetReplay: replaying %s %s"), *Path, bRealTime ? TEXT("in real time") : TEXT("as fast as possible"));
+	bReplaying = true;
+	ReplayStartTime = FPlatformTime::Seconds();
+	ReplayRecvSeconds = 0.0;
+	ReplayMessages = 0;
+}
+
 
-	if (NetworkChracter && !bConnected)
+void ASocketPlayerController::TickReplay()
+{
+	if (!Transport)
 	{
+		FinishReplay();
 		return;
 	}
 
+	// Read first: once the worker says it is done, this Recv drains everything it queued.
+	const bool bFinished = Transport->IsReplayFinished();
 
-	//Binary Array!
-	TArray<uint8> ReceivedData;
-	uint32_t Head = 0;
+	const double Start = FPlatformTime::Seconds();
+	ReplayMessages += Recv();
+	ReplayRecvSeconds += FPlatformTime::Seconds() - Start;
 
-	uint32 Size;
-	while (Socket->HasPendingData(Size))
+	if (bFinished)
 	{
-		//ReceivedData.Init(0, FMath::Min(Size, 65507u));
+		FinishReplay();
+	}
+}
+
 
-		//int32 Read = 0;
-		//Socket->Recv(ReceivedData.GetData(), ReceivedData.Num(), Read);
+void ASocketPlayerController::FinishReplay()
+{
+	const double Elapsed = FPlatformTime::Seconds() - ReplayStartTime;
+	const FString Summary = FString::Printf(TEXT("NetReplay: %llu messages in %.2f s, %.2f ms in Recv, %.0f ns per message"),
+		ReplayMessages, Elapsed, ReplayRecvSeconds * 1000.0, ReplayMessages > 0 ? ReplayRecvSeconds * 1e9 / ReplayMessages : 0.0);
+	UE_LOG(LogTemp, Log, TEXT("%s"), *Summary);
+	GEngine->AddOnScreenDebugMessage(-1, 10.f, FColor::Yellow, Summary);
+
+	LogDispatchStats();
+
+	bReplaying = false;
+	CloseTransport();
+}
+
+
+void ASocketPlayerController::NetTelemetryDump(const FString& Format)
+{
+	const bool bJson = Format.Equals(TEXT("json"), ESearchCase::IgnoreCase);
+	const double Seconds = FMath::Max(FPlatformTime::Seconds() - TelemetryStartTime, 1e-3);
 
+	TUniquePtr<FNetTelemetry::FCounts> Counts = MakeUnique<FNetTelemetry::FCounts>();
+	Telemetry.Take(*Counts);
+	const std::string Text = bJson ? FNetTelemetry::ToJson(*Counts, Seconds) : FNetTelemetry::ToCsv(*Counts, Seconds);
 
-		int32 Read = 0;
-		Socket->Recv((uint8*)&Head, 4, Read);
+	const FString Path = FPaths::Combine(FPaths::ProfilingDir(), TEXT("NetTelemetry"),
+		FString::Printf(TEXT("NetTelemetry-%s.%s"), *FDateTime::Now().ToString(), bJson ? TEXT("json") : TEXT("csv")));
+	if (FFileHelper::SaveStringToFile(UTF8_TO_TCHAR(Text.c_str()), *Path))
+	{
+		UE_LOG(LogTemp, Log, TEXT("NetTelemetryDump: %.1f s written to %s"), Seconds, *Path);
+	}
+	else
+	{
+		UE_LOG(LogTemp, Warning, TEXT("NetTelemetryDump: cannot write %s"), *Path);
+	}
+}
 
-		//UE_LOG(LogTemp, Warning, TEXT("Header %d"), Read);
 
-		////~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-		MsgId id = (MsgId)HIWORD(Head);
-		uint16 sz = LOWORD(Head) - 4;
+void ASocketPlayerController::NetTelemetryReset()
+{
+	Telemetry.Reset();
+	TelemetryStartTime = FPlatformTime::Seconds();
+}
 
-		//UE_LOG(LogTemp, Warning, TEXT("MesageSize %d"), sz);
 
+namespace
+{
+	/** Server data is verified before it is read everywhere but shipping builds. */
+	constexpr uint32 VerifyOutsideShipping = UE_BUILD_SHIPPING ? MessageHandlerFlags::None : MessageHandlerFlags::Verify;
+
+	using FClientHandlers = TMessageHandlers<ASocketPlayerController, const FNetFrame&>;
+
+	using FClientDispatcher = FClientHandlers::TDispatcher<
+		FClientHandlers::THandler<MsgId::S2C_Login, ProjectM::Actor::S2C_Login, &ASocketPlayerController::OnLogin, VerifyOutsideShipping>,
+		FClientHandlers::THandler<MsgId::S2C_SpawnActors, ProjectM::Actor::S2C_SpawnActors, &ASocketPlayerController::OnSpawnActors, VerifyOutsideShipping>,
+		FClientHandlers::THandler<MsgId::S2C_DestroyActor, ProjectM::Actor::S2C_DestroyActor, &ASocketPlayerController::OnDestroyActor, VerifyOutsideShipping>,
+		FClientHandlers::THandler<MsgId::S2C_SyncLocation, ProjectM::Actor::S2C_SyncLocation, &ASocketPlayerController::SyncTransform, VerifyOutsideShipping>,
+		FClientHandlers::THandler<MsgId::S2C_WorldSnapshot, ProjectM::Actor::S2C_WorldSnapshot, &ASocketPlayerController::ApplySnapshot, VerifyOutsideShipping>,
+		FClientHandlers::THandler<MsgId::S2C_CompactSnapshot, ProjectM::Actor::S2C_CompactSnapshot, &ASocketPlayerController::ApplyCompactSnapshot, VerifyOutsideShipping>,
+		FClientHandlers::THandler<MsgId::S2C_Pong, ProjectM::Actor::S2C_Pong, &ASocketPlayerController::OnPong, VerifyOutsideShipping>>;
+}
 
-		ReceivedData.Init(0, FMath::Min((uint32)sz, 4096u));
-		Socket->Recv(ReceivedData.GetData(), sz, Read);
 
+bool ASocketPlayerController::IsWaitingForPawn(MsgId Id) const
+{
+	// Login, pings and spawn queueing work without the pawn. Remote characters are only created
+	// beside it, so until it exists transform updates have nothing to move, and each one is
+	// superseded by the next.
+	switch (Id)
+	{
+	case MsgId::S2C_SyncLocation:
+	case MsgId::S2C_WorldSnapshot:
+	case MsgId::S2C_CompactSnapshot:
+		return Cast<ASocketSampleCharacter>(GetPawn()) == nullptr;
+	default:
+		return false;
+	}
+}
 
-		if (id == MsgId::S2C_Login)
+
+void ASocketPlayerController::HandleMessage(const FNetFrame& Frame)
+{
+	FClientDispatcher::Dispatch(*this, DispatchStats, Frame.Id, Frame.Body.GetData(), Frame.Body.GetSize(), Frame);
+}
+
+
+void ASocketPlayerController::LogDispatchStats() const
+{
+	for (size_t Index = 0; Index < FMessageDispatchStats::NumIds; ++Index)
+	{
+		const FMessageDispatchStats::FEntry& Entry = DispatchStats.Entries[Index];
+		if (Entry.Handled + Entry.Unhandled + Entry.Rejected == 0)
 		{
-			const ProjectM::Actor::S2C_Login& msg = *flatbuffers::GetRoot<ProjectM::Actor::S2C_Login>(ReceivedData.GetData());
-			if (NetworkChracter->ActorUID == 0)
-			{
-				ActorUID = msg.actor_id();
-				NetworkChracter->ActorUID = msg.actor_id();
-				UE_LOG(LogTemp, Warning, TEXT("set S2C_Login actor id %d"), NetworkChracter->ActorUID);
+			continue;
+		}
 
-			}
+		// Handler time is in Telemetry, see NetTelemetryDump.
+		UE_LOG(LogTemp, Log, TEXT("MsgId %d: %llu handled, %llu unhandled, %llu rejected"),
+			(int32)Index, Entry.Handled, Entry.Unhandled, Entry.Rejected);
+	}
+
+	if (DispatchStats.Unknown > 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%llu messages with unknown MsgId"), DispatchStats.Unknown);
+	}
+
+	if (FramesWithoutPawn > 0)
+	{
+		UE_LOG(LogTemp, Log, TEXT("%llu transform updates dropped before the pawn existed"), FramesWithoutPawn);
+	}
+}
+
+
+bool ASocketPlayerController::OnLogin(const ProjectM::Actor::S2C_Login& msg, const FNetFrame& Frame)
+{
+	// Every session, including each reconnect, is given a new actor id. A replay logs in as the
+	// captured session did.
+	if (Connection.GetState() == FConnectionStateMachine::EState::LoggingIn || bReplaying)
+	{
+		ActorUID = msg.actor_id();
+		// Without a pawn yet, OnPossess passes the id on.
+		if (ASocketSampleCharacter* NetworkChracter = Cast<ASocketSampleCharacter>(GetPawn()))
+		{
+			NetworkChracter->SetActorUID(msg.actor_id());
 		}
-		else if (id == MsgId::S2C_SpawnActors)
+		MoveScheduler.Reset();
+		UE_LOG(LogTemp, Warning, TEXT("set S2C_Login actor id %llu"), (unsigned long long)ActorUID);
+
+		Connection.OnLoggedIn(FPlatformTime::Seconds());
+		UpdateConnection();
+	}
+	return true;
+}
+
+
+void ASocketPlayerController::UpdateClockSync()
+{
+	const double Now = FPlatformTime::Seconds();
+	ClockSync.PingInterval = PingInterval;
+	if (bConnected && ClockSync.ShouldPing(Now))
+	{
+		// Not coalesced: ClockSync counts every ping it asked for, so one replaced in the outbox
+		// would be reported as lost. A ping that waited behind our own queue measures it too.
+		SendFrame(ProtocolCore::MakePing(static_cast<uint64>(Now * 1e6)));
+	}
+}
+
+
+bool ASocketPlayerController::OnPong(const ProjectM::Actor::S2C_Pong& msg, const FNetFrame& Frame)
+{
+	// ReceiveTime is stamped on the network thread, so game thread frame time is not counted as delay.
+	ClockSync.AddSample(msg.client_time() / 1e6, msg.server_receive_time() / 1e6, msg.server_send_time() / 1e6, Frame.ReceiveTime);
+	return true;
+}
+
+
+float ASocketPlayerController::GetRoundTripTimeMs() const
+{
+	return static_cast<float>(ClockSync.GetRtt() * 1000.0);
+}
+
+
+float ASocketPlayerController::GetJitterMs() const
+{
+	return static_cast<float>(ClockSync.GetJitter() * 1000.0);
+}
+
+
+void ASocketPlayerController::GetRoundTripHistogram(TArray<int32>& OutCounts, float& OutBucketMs) const
+{
+	OutCounts.SetNumUninitialized(FClockSync::NumHistogramBuckets);
+	for (int32 Index = 0; Index < FClockSync::NumHistogramBuckets; ++Index)
+	{
+		OutCounts[Index] = static_cast<int32>(ClockSync.GetHistogram()[Index]);
+	}
+	OutBucketMs = static_cast<float>(ClockSync.HistogramBucketWidth * 1000.0);
+}
+
+
+bool ASocketPlayerController::OnSpawnActors(const ProjectM::Actor::S2C_SpawnActors& msg, const FNetFrame& Frame)
+{
+	const flatbuffers::Vector<uint64_t>* ids = msg.actor_id();
+	const flatbuffers::Vector<const ProjectM::Actor::Transform*>* transforms = msg.transform();
+	if (ids == nullptr || transforms == nullptr)
+	{
+		return false;
+	}
+
+	// Characters are created by ProcessSpawnQueue under a frame budget; a big spawn list would
+	// otherwise stall this frame for as long as it takes to spawn all of them.
+	for (flatbuffers::uoffset_t i = 0; i < FMath::Min(ids->size(), transforms->size()); ++i)
+	{
+		const uint64_t UID = ids->Get(i);
+		UE_LOG(LogTemp, Verbose, TEXT("S2C_SpawnActors %llu"), UID);
+
+		//New Player
+		if (UID != ActorUID && !FindCharacterByUID(UID))
 		{
-			const ProjectM::Actor::S2C_SpawnActors& msg = *flatbuffers::GetRoot<ProjectM::Actor::S2C_SpawnActors>(ReceivedData.GetData());
+			const ProjectM::Actor::Transform* transform = transforms->Get(i);
+			PendingSpawns.Push(UID, *transform, Frame.ReceiveTime);
+			PushRemoteTransform(UID, *transform, SnapshotClock.ToLocalTime(Frame.ReceiveTime));
+		}
+	}
+	return true;
+}
 
-			const flatbuffers::Vector<uint64_t>* ids = msg.actor_id();
 
-			for (size_t i = 0; i < ids->Length(); ++i)
-			{
-				UE_LOG(LogTemp, Warning, TEXT("S2C_SpawnActors %d"), (*ids)[i]);
-				//New Player
-				if (!FindCharacterByUID((*ids)[i]))
-				{
-					ASocketSampleCharacter* SpawnedCharacter =  GetWorld()->SpawnActor<ASocketSampleCharacter>(SpawnCharacterClass, GetPawn()->GetActorTransform());
-					if (SpawnedCharacter)
-					{
-						UE_LOG(LogClass, Warning, TEXT("Spawn %d"), SpawnedCharacter->ActorUID);
-						SpawnedCharacter->ActorUID = (*ids)[i];
+void ASocketPlayerController::ProcessSpawnQueue()
+{
+	APawn* MyPawn = GetPawn();
+	if (MyPawn == nullptr || PendingSpawns.Num() == 0)
+	{
+		return;
+	}
 
-						const flatbuffers::Vector<const ProjectM::Actor::Transform*>* transforms = msg.transform();
-						const ProjectM::Actor::Transform* transform = (*transforms)[i];
+	const FVector PawnLocation = MyPawn->GetActorLocation();
+	const float Origin[3] = { PawnLocation.X, PawnLocation.Y, PawnLocation.Z };
+	const FTransform SpawnTransform = MyPawn->GetActorTransform();
 
-						FTransform NewTransform;
-						NewTransform.SetLocation(FVector(transform->location().x(), transform->location().y(), transform->location().z()));
-						NewTransform.SetRotation(FRotator(transform->rotation().x(), transform->rotation().y(), transform->rotation().z()).Quaternion());
-						NewTransform.SetScale3D(FVector(transform->scale().x(), transform->scale().y(), transform->scale().z()));
+	PendingSpawns.Drain(Origin, SpawnBudgetMs / 1000.0, []() { return FPlatformTime::Seconds(); }, [this, &SpawnTransform](const FPendingSpawn& Spawn)
+	{
+		ASocketSampleCharacter* SpawnedCharacter = SpawnRemoteCharacter(Spawn.ActorId, SpawnTransform);
+		if (SpawnedCharacter)
+		{
+			// The newest transform received while it was queued, not necessarily the spawn's.
+			ApplyTransform(SpawnedCharacter, Spawn.Transform);
 
-						SpawnedCharacter->SetActorTransform(NewTransform);
+			SpawnedCharacter->GetCharacterMovement()->Activate(false);
 
-						SpawnedCharacter->GetCharacterMovement()->Activate(false);
+			//SetControlRotation(FRotator(transform->rotation().x(), transform->rotation().y(), transform->rotation().z()));
+		}
+	});
+}
 
-						//SetControlRotation(FRotator(transform->rotation().x(), transform->rotation().y(), transform->rotation().z()));
 
-					}
-				}
-			}
+int32 ASocketPlayerController::GetPendingSpawns() const
+{
+	return static_cast<int32>(PendingSpawns.Num());
+}
+
+
+bool ASocketPlayerController::OnDestroyActor(const ProjectM::Actor::S2C_DestroyActor& msg, const FNetFrame& Frame)
+{
+	const uint64_t UID = msg.actor_id();
+	if (UID == ActorUID)
+	{
+		return true;
+	}
+
+	if (ASocketSampleCharacter* Character = FindCharacter(UID))
+	{
+		DespawnRemoteCharacter(Character);
+	}
+	else
+	{
+		// Still queued, or samples and baselines arrived without a spawn; drop them all the same.
+		PendingSpawns.Remove(UID);
+		RemoteInterpolation.Remove(UID);
+		TransformBaselines.Remove(UID);
+	}
+	return true;
+}
+
+
+ASocketSampleCharacter* ASocketPlayerController::SpawnRemoteCharacter(uint64 UID, const FTransform& Transform)
+{
+	ASocketSampleCharacter* Character = nullptr;
+
+	URemoteCharacterPool* Pool = GetWorld()->GetSubsystem<URemoteCharacterPool>();
+	if (bPoolRemoteCharacters && Pool)
+	{
+		Character = Pool->Acquire(SpawnCharacterClass, Transform);
+	}
+	else
+	{
+		Character = GetWorld()->SpawnActor<ASocketSampleCharacter>(SpawnCharacterClass, Transform);
+	}
+
+	if (Character)
+	{
+		Character->SetActorUID(UID);
+	}
+	return Character;
+}
+
+
+void ASocketPlayerController::DespawnRemoteCharacter(ASocketSampleCharacter* Character)
+{
+	const uint64 UID = Character->ActorUID;
+	RemoteInterpolation.Remove(UID);
+	TransformBaselines.Remove(UID);
+
+	URemoteCharacterPool* Pool = GetWorld()->GetSubsystem<URemoteCharacterPool>();
+	if (bPoolRemoteCharacters && Pool)
+	{
+		Pool->Release(Character);
+	}
+	else
+	{
+		Character->Destroy();
+	}
+}
+
+
+void ASocketPlayerController::NetChurnBenchmark(int32 PerFrame, int32 Frames, bool bUsePool)
+{
+	if (Churn.FramesLeft > 0 || PerFrame <= 0 || Frames <= 0)
+	{
+		return;
+	}
+
+	Churn = FChurnBenchmark();
+	Churn.PerFrame = PerFrame;
+	Churn.FramesLeft = Frames + 1;
+	Churn.bUsePool = bUsePool;
+	Churn.bSavedUsePool = bPoolRemoteCharacters;
+	// Far above anything the server allocates, so benchmark characters never shadow real ones.
+	Churn.NextUID = 1ull << 62;
+	Churn.FrameMs.Reserve(Frames);
+	Churn.ChurnMs.Reserve(Frames);
+
+	UE_LOG(LogTemp, Log, TEXT("NetChurnBenchmark: %d despawns and spawns per frame for %d frames, pool %s"), PerFrame, Frames, bUsePool ? TEXT("on") : TEXT("off"));
+}
+
+
+void ASocketPlayerController::TickChurnBenchmark(float DeltaSeconds)
+{
+	APawn* MyPawn = GetPawn();
+	if (MyPawn == nullptr)
+	{
+		FinishChurnBenchmark();
+		return;
+	}
+
+	// The first frame's delta predates the benchmark, so that frame is run but not recorded.
+	const bool bRecord = Churn.bStarted;
+	Churn.bStarted = true;
+	if (bRecord)
+	{
+		Churn.FrameMs.Add(DeltaSeconds * 1000.f);
+	}
+
+	bPoolRemoteCharacters = Churn.bUsePool;
+	const double Start = FPlatformTime::Seconds();
+
+	// Oldest characters go first, the way players leave relevancy.
+	const int32 NumDespawn = FMath::Min(Churn.PerFrame, Churn.Live.Num());
+	for (int32 Index = 0; Index < NumDespawn; ++Index)
+	{
+		if (ASocketSampleCharacter* Character = Churn.Live[Index].Get())
+		{
+			DespawnRemoteCharacter(Character);
 		}
-		else if (id == MsgId::S2C_SyncLocation)
+	}
+	Churn.Live.RemoveAt(0, NumDespawn, false);
+
+	const FVector Origin = MyPawn->GetActorLocation();
+	for (int32 Index = 0; Index < Churn.PerFrame; ++Index)
+	{
+		const float Angle = 2.f * PI * Index / Churn.PerFrame;
+		const FTransform Transform(FRotator::ZeroRotator, Origin + FVector(FMath::Cos(Angle), FMath::Sin(Angle), 0.f) * 500.f);
+		if (ASocketSampleCharacter* Character = SpawnRemoteCharacter(Churn.NextUID++, Transform))
+		{
+			Churn.Live.Add(Character);
+		}
+	}
+
+	if (bRecord)
+	{
+		Churn.ChurnMs.Add(static_cast<float>((FPlatformTime::Seconds() - Start) * 1000.0));
+	}
+	bPoolRemoteCharacters = Churn.bSavedUsePool;
+
+	if (--Churn.FramesLeft == 0)
+	{
+		FinishChurnBenchmark();
+	}
+}
+
+
+void ASocketPlayerController::FinishChurnBenchmark()
+{
+	bPoolRemoteCharacters = Churn.bUsePool;
+	for (const TWeakObjectPtr<ASocketSampleCharacter>& Character : Churn.Live)
+	{
+		if (Character.IsValid())
 		{
-			const ProjectM::Actor::S2C_SyncLocation& msg = *flatbuffers::GetRoot<ProjectM::Actor::S2C_SyncLocation>(ReceivedData.GetData());
-			SyncTransform(msg);
+			DespawnRemoteCharacter(Character.Get());
 		}
-		//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 	}
-	//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+	Churn.Live.Reset();
+	bPoolRemoteCharacters = Churn.bSavedUsePool;
+	Churn.FramesLeft = 0;
 
-	if (ReceivedData.Num() <= 0)
+	if (Churn.FrameMs.Num() == 0)
 	{
-		//No Data Received
 		return;
 	}
 
-	//const FString ReceivedUE4String = StringFromBinaryArray(ReceivedData);
+	TArray<float> FrameMs = Churn.FrameMs;
+	TArray<float> ChurnMs = Churn.ChurnMs;
+	FrameMs.Sort();
+	ChurnMs.Sort();
+
+	auto Percentile = [](const TArray<float>& Sorted, float Fraction)
+	{
+		return Sorted.Num() > 0 ? Sorted[FMath::Min(Sorted.Num() - 1, FMath::FloorToInt(Fraction * Sorted.Num()))] : 0.f;
+	};
+
+	// A hitch is a frame at least twice as long as the run's median frame.
+	const float MedianFrameMs = Percentile(FrameMs, 0.5f);
+	int32 Hitches = 0;
+	for (float Ms : Churn.FrameMs)
+	{
+		Hitches += Ms >= 2.f * MedianFrameMs ? 1 : 0;
+	}
+
+	const FString Summary = FString::Printf(
+		TEXT("NetChurnBenchmark pool %s, %d/frame: frame ms p50 %.2f p99 %.2f max %.2f, %d hitches in %d frames | churn ms p50 %.3f p99 %.3f max %.3f"),
+		Churn.bUsePool ? TEXT("on") : TEXT("off"), Churn.PerFrame,
+		MedianFrameMs, Percentile(FrameMs, 0.99f), FrameMs.Last(), Hitches, FrameMs.Num(),
+		Percentile(ChurnMs, 0.5f), Percentile(ChurnMs, 0.99f), ChurnMs.Num() > 0 ? ChurnMs.Last() : 0.f);
+
+	UE_LOG(LogTemp, Log, TEXT("%s"), *Summary);
+	GEngine->AddOnScreenDebugMessage(-1, 10.f, FColor::Yellow, Summary);
 }
 
+
 FString ASocketPlayerController::StringFromBinaryArray(const TArray<uint8>& BinaryArray)
 {
 	//Create a string from a byte array!
@@ -252,63 +926,165 @@ FString ASocketPlayerController::StringFromBinaryArray(const TArray<uint8>& Bina
 }
 
 
+ASocketSampleCharacter* ASocketPlayerController::FindCharacter(uint64 UID) const
+{
+	UNetActorRegistry* Registry = GetWorld()->GetSubsystem<UNetActorRegistry>();
+	return Registry ? Registry->Find(UID) : nullptr;
+}
+
+
 bool ASocketPlayerController::FindCharacterByUID(uint64 UID)
 {
-	TArray<AActor*> AllCharacters;
-	UGameplayStatics::GetAllActorsOfClass(GetWorld(), ASocketSampleCharacter::StaticClass(), AllCharacters);
-	for (AActor* SelectedCharacter : AllCharacters)
+	return FindCharacter(UID) != nullptr;
+}
+
+
+bool ASocketPlayerController::SyncTransform(const ProjectM::Actor::S2C_SyncLocation& msg, const FNetFrame& Frame)
+{
+	// The verifier accepts a table without its transform; like the server, reject it.
+	if (msg.transform() == nullptr)
 	{
-		ASocketSampleCharacter* NetworkCharacter = Cast<ASocketSampleCharacter>(SelectedCharacter);
-		if (NetworkCharacter != nullptr)
-		{
-			//UE_LOG(LogTemp, Warning, TEXT("FindCharacterByUID %d"), NetworkCharacter->_uid);
+		return false;
+	}
 
-			if (NetworkCharacter->ActorUID == UID)
-			{
-				return true;
-			}
-		}
+	ProjectM::Actor::Transform transform = *msg.transform();
+	uint64_t UID = msg.actor_id();
+
+	if (ActorUID == UID)
+	{
+		return true;
 	}
 
-	return false;
+	if (FindCharacter(UID) == nullptr && !PendingSpawns.Update(UID, transform, Frame.ReceiveTime))
+	{
+		return true;
+	}
+
+	// Carries no server tick, so it is put on the snapshot clock's time base, which the same
+	// actor's snapshot samples use. Updates that arrived together are merged by the interpolator.
+	PushRemoteTransform(UID, transform, SnapshotClock.ToLocalTime(Frame.ReceiveTime));
+
+	//SetControlRotation(FRotator(transform.rotation().x(), transform.rotation().y(), transform.rotation().z()));
+	return true;
 }
 
 
-bool ASocketPlayerController::SyncTransform(const ProjectM::Actor::S2C_SyncLocation& msg)
+bool ASocketPlayerController::ApplySnapshot(const ProjectM::Actor::S2C_WorldSnapshot& msg, const FNetFrame& Frame)
 {
-	ProjectM::Actor::Transform transform = *msg.transform();
-	uint64_t UID = msg.actor_id();
+	const flatbuffers::Vector<uint64_t>* ids = msg.actor_id();
+	const flatbuffers::Vector<const ProjectM::Actor::Transform*>* transforms = msg.transform();
+	if (ids == nullptr || transforms == nullptr)
+	{
+		return false;
+	}
+
+	SnapshotClock.TickInterval = SnapshotTickInterval;
+	const double SampleTime = SnapshotClock.Update(msg.server_tick(), Frame.ReceiveTime);
 
-	TArray<AActor*> AllCharacters;
-	UGameplayStatics::GetAllActorsOfClass(GetWorld(), ASocketSampleCharacter::StaticClass(), AllCharacters);
-	for (AActor* SelectedCharacter : AllCharacters)
+	const flatbuffers::uoffset_t Count = FMath::Min(ids->size(), transforms->size());
+	for (flatbuffers::uoffset_t i = 0; i < Count; ++i)
 	{
-		ASocketSampleCharacter* NetworkCharacter = Cast<ASocketSampleCharacter>(SelectedCharacter);
-		if (NetworkCharacter != nullptr)
+		const uint64_t UID = ids->Get(i);
+		if (UID == ActorUID)
 		{
-			if (ActorUID == UID)
-			{
-				continue;
-			}
-			//UE_LOG(LogTemp, Warning, TEXT("SyncTransform %d"), NetworkCharacter->_uid);
+			continue;
+		}
 
-			if (NetworkCharacter->ActorUID == UID)
-			{
-				FTransform NewTransform;
-				NewTransform.SetLocation(FVector(transform.location().x(), transform.location().y(), transform.location().z()));
-				NewTransform.SetRotation(FRotator(transform.rotation().x(), transform.rotation().y(), transform.rotation().z()).Quaternion());
-				NewTransform.SetScale3D(FVector(transform.scale().x(), transform.scale().y(), transform.scale().z()));
+		if (FindCharacter(UID) || PendingSpawns.Update(UID, *transforms->Get(i), Frame.ReceiveTime))
+		{
+			PushRemoteTransform(UID, *transforms->Get(i), SampleTime);
+		}
+	}
+	return true;
+}
 
 
-				NetworkCharacter->SetActorTransform(NewTransform);
+bool ASocketPlayerController::ApplyCompactSnapshot(const ProjectM::Actor::S2C_CompactSnapshot& msg, const FNetFrame& Frame)
+{
+	const flatbuffers::Vector<uint64_t>* ids = msg.actor_id();
+	const flatbuffers::Vector<uint8_t>* data = msg.data();
+	if (ids == nullptr || data == nullptr)
+	{
+		return false;
+	}
 
-				//SetControlRotation(FRotator(transform.rotation().x(), transform.rotation().y(), transform.rotation().z()));
+	const uint32 Tick = msg.server_tick();
+	const uint32 BaselineTick = msg.baseline_tick();
 
+	SnapshotClock.TickInterval = SnapshotTickInterval;
+	const double SampleTime = SnapshotClock.Update(Tick, Frame.ReceiveTime);
 
-				return true;
-			}
+	FBitReader Reader(data->data(), data->size());
+	for (flatbuffers::uoffset_t i = 0; i < ids->size(); ++i)
+	{
+		const uint64_t UID = ids->Get(i);
+
+		FQuantizedTransform State;
+		if (!TransformCodec::Decode(Reader, State, TransformBaselines.Find(UID, BaselineTick)))
+		{
+			// The rest of the bit stream cannot be located without this entry. Not acking makes the
+			// server keep encoding against our last acknowledged tick.
+			UE_LOG(LogTemp, Warning, TEXT("S2C_CompactSnapshot %u: cannot decode actor %llu against baseline %u"), Tick, UID, BaselineTick);
+			return false;
+		}
+
+		TransformBaselines.Record(UID, Tick, State);
+
+		if (UID == ActorUID)
+		{
+			continue;
+		}
+
+		const ProjectM::Actor::Transform Transform = TransformCodec::Dequantize(State);
+		if (FindCharacter(UID) || PendingSpawns.Update(UID, Transform, Frame.ReceiveTime))
+		{
+			PushRemoteTransform(UID, Transform, SampleTime);
 		}
 	}
 
-	return false;
-}
\ No newline at end of file
+	// A newer ack supersedes an unsent older one.
+	SendFrame(ProtocolCore::MakeSnapshotAck(Tick), FCoalescingOutbox::MakeKey(MsgId::C2S_SnapshotAck));
+	return true;
+}
+
+
+void ASocketPlayerController::PushRemoteTransform(uint64 UID, const ProjectM::Actor::Transform& transform, double SampleTime)
+{
+	RemoteInterpolation.Push(UID, FTransformSample(SampleTime, transform));
+}
+
+
+void ASocketPlayerController::UpdateRemoteCharacters()
+{
+	RemoteInterpolation.RenderDelay = InterpolationDelay;
+	RemoteInterpolation.MaxExtrapolation = MaxExtrapolation;
+
+	UNetActorRegistry* Registry = GetWorld()->GetSubsystem<UNetActorRegistry>();
+	if (Registry == nullptr)
+	{
+		return;
+	}
+
+	RemoteInterpolation.Update(FPlatformTime::Seconds(), [Registry](uint64_t UID, const FTransformSample& Sample)
+	{
+		if (ASocketSampleCharacter* NetworkCharacter = Registry->Find(UID))
+		{
+			const FTransform NewTransform(
+				FQuat(Sample.Rotation[0], Sample.Rotation[1], Sample.Rotation[2], Sample.Rotation[3]),
+				FVector(Sample.Location[0], Sample.Location[1], Sample.Location[2]),
+				FVector(Sample.Scale[0], Sample.Scale[1], Sample.Scale[2]));
+			NetworkCharacter->SetActorTransform(NewTransform);
+		}
+	});
+}
+
+
+void ASocketPlayerController::ApplyTransform(ASocketSampleCharacter* Character, const ProjectM::Actor::Transform& transform)
+{
+	FTransform NewTransform;
+	NewTransform.SetLocation(FVector(transform.location().x(), transform.location().y(), transform.location().z()));
+	NewTransform.SetRotation(FRotator(transform.rotation().x(), transform.rotation().y(), transform.rotation().z()).Quaternion());
+	NewTransform.SetScale3D(FVector(transform.scale().x(), transform.scale().y(), transform.scale().z()));
+
+	Character->SetActorTransform(NewTransform);
+}
@@ -12,6 +12,15 @@
 
 
 #include "ProjectM_generated.h"
+#include "NetworkTransport.h"
+#include "TransformCodec.h"
+#include "SnapshotInterpolation.h"
+#include "SendScheduler.h"
+#include "SpawnQueue.h"
+#include "ConnectionStateMachine.h"
+#include "ClockSync.h"
+#include "NetTelemetry.h"
+#include "MessageDispatcher.h"
 
 #include <memory>
 #include <unordered_map>
@@ -21,6 +30,19 @@
 
 class ASocketSampleCharacter;
 
+/** Blueprint view of FConnectionStateMachine::EState, in the same order. */
+UENUM(BlueprintType)
+enum class ENetConnectionState : uint8
+{
+	Closed,
+	Connecting,
+	LoggingIn,
+	Online,
+	Backoff,
+};
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FNetConnectionStateChangedSignature, ENetConnectionState, NewState);
+
 UCLASS()
 class SOCKETSAMPLE_API ASocketPlayerController : public APlayerController
 {
@@ -29,40 +51,325 @@ class SOCKETSAMPLE_API ASocketPlayerController : public APlayerController
 protected:
 	virtual void BeginPlay() override;
 
+	/** Connects without blocking and keeps reconnecting and logging in as UserID until Disconnect. */
 	UFUNCTION(BlueprintCallable, Category="Network")
 	void Connect(FString UserID);
 
+	UFUNCTION(BlueprintCallable, Category="Network")
+	void Disconnect();
+
 	virtual void Tick(float DeltaSeconds) override;
 
 	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
+	/** Gives the pawn the actor id of the current session, which S2C_Login may have brought before it existed. */
+	virtual void OnPossess(APawn* InPawn) override;
+
 public:
+	UFUNCTION(BlueprintPure, Category = "Network")
+	ENetConnectionState GetConnectionState() const;
+
+	UPROPERTY(BlueprintAssignable, Category = "Network")
+	FNetConnectionStateChangedSignature OnConnectionStateChanged;
+
+	UPROPERTY(EditAnywhere, Category = "Network", BlueprintReadWrite)
+	FString ServerAddress = TEXT("127.0.0.1");
+
+	UPROPERTY(EditAnywhere, Category = "Network", BlueprintReadWrite)
+	int32 ServerPort = 9810;
+
+	/** Seconds a connection attempt, and then the login, may take before it is retried. */
+	UPROPERTY(EditAnywhere, Category = "Network", BlueprintReadWrite)
+	float ConnectTimeout = 5.f;
+
+	/** First reconnect delay in seconds; it doubles per failed attempt up to ReconnectMaxDelay, with jitter. */
+	UPROPERTY(EditAnywhere, Category = "Network", BlueprintReadWrite)
+	float ReconnectInitialDelay = 0.5f;
 
+	UPROPERTY(EditAnywhere, Category = "Network", BlueprintReadWrite)
+	float ReconnectMaxDelay = 30.f;
 
+	/** Runs the connection state machine: connects, logs in, and tears down and retries on failure. Called first in Tick. */
+	void UpdateConnection();
+
+	/** Closes the transport, if any. */
+	void CloseTransport();
+
+	/** Despawns every remote character and forgets everything received about them, before a reconnect. */
+	void ResetRemoteWorld();
 
 	bool Login(std::string token);
 
+	/** Smoothed round-trip time to the server, 0 until the first S2C_Pong. */
+	UFUNCTION(BlueprintPure, Category = "Network")
+	float GetRoundTripTimeMs() const;
+
+	/** Smoothed deviation of the round-trip time. */
+	UFUNCTION(BlueprintPure, Category = "Network")
+	float GetJitterMs() const;
+
+	/** This session's round-trip times, one count per BucketMs wide bucket; the last bucket also holds anything slower. */
+	UFUNCTION(BlueprintCallable, Category = "Network")
+	void GetRoundTripHistogram(TArray<int32>& OutCounts, float& OutBucketMs) const;
+
+	/** RTT, jitter and server clock offset, for gameplay code that needs server time (ClockSync.ToServerTime(FPlatformTime::Seconds())). */
+	const FClockSync& GetClockSync() const { return ClockSync; }
+
+	/** Seconds between C2S_Pings while online. */
+	UPROPERTY(EditAnywhere, Category = "Network", BlueprintReadWrite)
+	float PingInterval = 0.5f;
+
+	/** Sends the pawn's transform if MoveScheduler says it is due. Called every frame by the pawn. */
 	bool Move();
 
+	UFUNCTION(BlueprintPure, Category = "Network")
+	int64 GetMovesSent() const;
+
+	UFUNCTION(BlueprintPure, Category = "Network")
+	int64 GetMovesSkipped() const;
+
+	/**
+	 * Console: despawns and spawns PerFrame local remote characters every frame for Frames frames,
+	 * through the same paths as S2C_DestroyActor and S2C_SpawnActors, then logs frame-time
+	 * percentiles and hitches. Run once with bUsePool 0 and once with 1 to compare.
+	 */
+	UFUNCTION(Exec)
+	void NetChurnBenchmark(int32 PerFrame = 20, int32 Frames = 300, bool bUsePool = true);
+
+
+	/**
+	 * Console: writes per-MsgId message, byte and handler-time totals and the queue depth
+	 * histograms, as "csv" or "json", under Saved/Profiling/NetTelemetry. The per-frame totals
+	 * are in "stat SocketNet".
+	 */
+	UFUNCTION(Exec)
+	void NetTelemetryDump(const FString& Format = TEXT("csv"));
 
-	void Recv();
+	UFUNCTION(Exec)
+	void NetTelemetryReset();
+
+	/** Console: starts or stops writing every received message to a capture under Saved/Profiling/NetCapture. */
+	UFUNCTION(Exec)
+	void NetCapture(bool bEnable = true);
+
+	/**
+	 * Console: disconnects and feeds a capture through Recv and the usual handlers instead, at its
+	 * recorded pace if bRealTime or as fast as possible, then logs how long handling took. File is
+	 * relative to Saved/Profiling/NetCapture unless absolute.
+	 */
+	UFUNCTION(Exec)
+	void NetReplay(const FString& File, bool bRealTime = false);
+
+	/** Every connection writes a capture from its first message, see NetCapture. */
+	UPROPERTY(EditAnywhere, Category = "Network", BlueprintReadWrite)
+	bool bCaptureInbound = false;
+
+	/** Drains every frame the network thread has received since the last call. Called once per frame from Tick. Returns how many. */
+	int32 Recv();
+
+	/** Recv for a replay, timed, until the capture runs out. */
+	void TickReplay();
+
+	void FinishReplay();
+
+	/** Starts a new capture file on Transport. */
+	void StartCapture();
+
+	/** Routes a frame to its handler through a compile-time MsgId table (see MessageDispatcher.h). */
+	void HandleMessage(const FNetFrame& Frame);
+
+	/** Whether a message of this id would be dropped now because the pawn does not exist yet. */
+	bool IsWaitingForPawn(MsgId Id) const;
+
+	void LogDispatchStats() const;
+
+	bool OnLogin(const ProjectM::Actor::S2C_Login& msg, const FNetFrame& Frame);
+
+	bool OnSpawnActors(const ProjectM::Actor::S2C_SpawnActors& msg, const FNetFrame& Frame);
+
+	bool OnDestroyActor(const ProjectM::Actor::S2C_DestroyActor& msg, const FNetFrame& Frame);
+
+	bool OnPong(const ProjectM::Actor::S2C_Pong& msg, const FNetFrame& Frame);
+
+	/** Sends a C2S_Ping when one is due. Called once per frame while online. */
+	void UpdateClockSync();
+
+	/** Creates characters for queued spawns, nearest first, within SpawnBudgetMs. Called once per frame after Recv. */
+	void ProcessSpawnQueue();
+
+	/** Characters queued by S2C_SpawnActors that ProcessSpawnQueue has not created yet. */
+	UFUNCTION(BlueprintPure, Category = "Network")
+	int32 GetPendingSpawns() const;
+
+	/** Takes a character from URemoteCharacterPool, or spawns one if bPoolRemoteCharacters is off, and gives it UID. */
+	ASocketSampleCharacter* SpawnRemoteCharacter(uint64 UID, const FTransform& Transform);
+
+	/** Drops everything known about Character's UID and returns it to the pool, or destroys it. */
+	void DespawnRemoteCharacter(ASocketSampleCharacter* Character);
+
+	/** Hands a frame finished with FinishFrame to the network thread. Key as in FNetworkTransport::Send. */
+	bool SendFrame(flatbuffers::DetachedBuffer&& Frame, uint64 Key = FCoalescingOutbox::Reliable);
 
 	FString StringFromBinaryArray(const TArray<uint8>& BinaryArray);
 
 
-	FTimerHandle RecvTimer;
+	TUniquePtr<FNetworkTransport> Transport;
+
+	/** Logged in and online; moves are only sent in this state. */
+	bool bConnected = false;
+
+	FConnectionStateMachine Connection;
+
+	/** Token given to Connect, sent again on every reconnect. */
+	std::string LoginToken;
 
-	FSocket* Socket;
+	ENetConnectionState BroadcastConnectionState = ENetConnectionState::Closed;
 
-	bool bConnected;
+	/** Fed by S2C_Pong; reset for every new connection. */
+	FClockSync ClockSync;
 
 
+	ASocketSampleCharacter* FindCharacter(uint64 UID) const;
+
 	bool FindCharacterByUID(const uint64 UID);
 
-	bool SyncTransform(const ProjectM::Actor::S2C_SyncLocation& msg);
+	bool SyncTransform(const ProjectM::Actor::S2C_SyncLocation& msg, const FNetFrame& Frame);
+
+	/** Applies every transform in a world snapshot in one pass over its parallel id/transform vectors. */
+	bool ApplySnapshot(const ProjectM::Actor::S2C_WorldSnapshot& msg, const FNetFrame& Frame);
+
+	/** Decodes a quantised, baseline-delta snapshot (see TransformCodec.h) and acknowledges its tick. */
+	bool ApplyCompactSnapshot(const ProjectM::Actor::S2C_CompactSnapshot& msg, const FNetFrame& Frame);
+
+	/** Queues a received transform for a remote character; it is applied by UpdateRemoteCharacters. */
+	void PushRemoteTransform(uint64 UID, const ProjectM::Actor::Transform& transform, double SampleTime);
+
+	/** Moves every remote character to its interpolated transform. One pass per frame, after Recv. */
+	void UpdateRemoteCharacters();
+
+	void ApplyTransform(ASocketSampleCharacter* Character, const ProjectM::Actor::Transform& transform);
 
 	UPROPERTY(EditAnywhere, Category = "Data", BlueprintReadWrite)
 	TSubclassOf<ASocketSampleCharacter> SpawnCharacterClass;
 
+	/** Build outgoing messages in the game thread's FFrameArena, rewound every Tick, instead of pooled buffers. */
+	UPROPERTY(EditAnywhere, Category = "Network", BlueprintReadWrite)
+	bool bUseFrameArena = true;
+
+	/** Reuse despawned remote characters instead of destroying them and spawning new ones. */
+	UPROPERTY(EditAnywhere, Category = "Network", BlueprintReadWrite)
+	bool bPoolRemoteCharacters = true;
+
+	/** Milliseconds per frame spent creating queued remote characters. At least one is created per frame. */
+	UPROPERTY(EditAnywhere, Category = "Network", BlueprintReadWrite)
+	float SpawnBudgetMs = 2.f;
+
+	/** Remote characters parked up front on BeginPlay, so the first spawns do not hitch either. */
+	UPROPERTY(EditAnywhere, Category = "Network", BlueprintReadWrite)
+	int32 PrewarmRemoteCharacters = 0;
+
 	uint64 ActorUID = 0;
+
+	/** Seconds remote characters are rendered behind the newest data received for them; about two send or snapshot intervals. */
+	UPROPERTY(EditAnywhere, Category = "Network", BlueprintReadWrite)
+	float InterpolationDelay = 0.1f;
+
+	/** Seconds a remote character keeps moving on its last velocity when its updates are late. */
+	UPROPERTY(EditAnywhere, Category = "Network", BlueprintReadWrite)
+	float MaxExtrapolation = 0.25f;
+
+	/** Seconds between the server's snapshot ticks; snapshot samples are timed by tick rather than arrival. */
+	UPROPERTY(EditAnywhere, Category = "Network", BlueprintReadWrite)
+	float SnapshotTickInterval = 0.05f;
+
+	FSnapshotInterpolator RemoteInterpolation;
+
+	/** Local time of each snapshot's server_tick. */
+	FServerTickClock SnapshotClock;
+
+	/** Movement (cm) from the last sent location below which no C2S_SyncLocation is needed. */
+	UPROPERTY(EditAnywhere, Category = "Network", BlueprintReadWrite)
+	float MovePositionThreshold = 1.f;
+
+	/** Rotation (degrees, per axis) from the last sent rotation below which no C2S_SyncLocation is needed. */
+	UPROPERTY(EditAnywhere, Category = "Network", BlueprintReadWrite)
+	float MoveRotationThreshold = 1.f;
+
+	/** Shortest time between two C2S_SyncLocation sends. */
+	UPROPERTY(EditAnywhere, Category = "Network", BlueprintReadWrite)
+	float MoveMinInterval = 1.f / 30.f;
+
+	/** Seconds between C2S_SyncLocation sends while moving steadily. InterpolationDelay should cover about two. */
+	UPROPERTY(EditAnywhere, Category = "Network", BlueprintReadWrite)
+	float MoveBaseInterval = 0.05f;
+
+	/** Seconds between C2S_SyncLocation keep-alives while idle. */
+	UPROPERTY(EditAnywhere, Category = "Network", BlueprintReadWrite)
+	float MoveKeepAliveInterval = 1.f;
+
+	/** Thresholds, intervals and counters for upstream C2S_SyncLocation traffic; configured from the Move* properties. */
+	FSendScheduler MoveScheduler;
+
+	/** Per-MsgId handled/unhandled/rejected counts and handler time. */
+	FMessageDispatchStats DispatchStats;
+
+	/** Transform updates dropped before dispatch because the pawn did not exist yet. */
+	uint64 FramesWithoutPawn = 0;
+
+	/** Per-MsgId traffic and handler time in both directions, and queue depths; see NetTelemetryDump. */
+	FNetTelemetry Telemetry;
+
+	/** FPlatformTime::Seconds() when Telemetry was last reset. */
+	double TelemetryStartTime = 0.0;
+
+	/** Transport's sent counters at the last Recv, for the per-frame Messages Out / Bytes Out stats. */
+	int64 LastFramesSent = 0;
+
+	int64 LastBytesSent = 0;
+
+	/** Transport is replaying a capture rather than connected; see NetReplay. */
+	bool bReplaying = false;
+
+	double ReplayStartTime = 0.0;
+
+	/** Time spent in Recv during the replay, and the messages it handled. */
+	double ReplayRecvSeconds = 0.0;
+
+	uint64 ReplayMessages = 0;
+
+	/** Spawned remote actors waiting for a character, see ProcessSpawnQueue. */
+	FSpawnQueue PendingSpawns;
+
+	/** Decoded compact-snapshot states, the baselines the server deltas against. */
+	FTransformBaselineHistory TransformBaselines;
+
+private:
+	/** State of a running NetChurnBenchmark. */
+	struct FChurnBenchmark
+	{
+		int32 PerFrame = 0;
+
+		int32 FramesLeft = 0;
+
+		bool bUsePool = true;
+
+		bool bSavedUsePool = true;
+
+		bool bStarted = false;
+
+		uint64 NextUID = 0;
+
+		TArray<TWeakObjectPtr<ASocketSampleCharacter>> Live;
+
+		/** Whole frame, and the churn step alone, in milliseconds. */
+		TArray<float> FrameMs;
+
+		TArray<float> ChurnMs;
+	};
+
+	void TickChurnBenchmark(float DeltaSeconds);
+
+	void FinishChurnBenchmark();
+
+	FChurnBenchmark Churn;
 };
@@ -5,10 +5,12 @@
 #include "Camera/CameraComponent.h"
 #include "Components/CapsuleComponent.h"
 #include "Components/InputComponent.h"
+#include "Components/SkeletalMeshComponent.h"
 #include "GameFramework/CharacterMovementComponent.h"
 #include "GameFramework/Controller.h"
 #include "GameFramework/SpringArmComponent.h"
 #include "SocketPlayerController.h"
+#include "NetActorRegistry.h"
 
 
 
@@ -109,16 +111,58 @@ void ASocketSampleCharacter::Tick(float DeltaSeconds)
 {
 	Super::Tick(DeltaSeconds);
 
-	ElapsedTime += DeltaSeconds;
-
+	// The controller's send scheduler decides whether this frame's transform goes out.
 	ASocketPlayerController* PC = Cast<ASocketPlayerController>(GetController());
-	if (PC && ElapsedTime >= 0.05)
+	if (PC)
 	{
-		ElapsedTime = 0;
 		PC->Move();
 	}
 }
 
+void ASocketSampleCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	SetActorUID(0);
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void ASocketSampleCharacter::SetActorUID(uint64_t NewUID)
+{
+	UWorld* World = GetWorld();
+	UNetActorRegistry* Registry = World ? World->GetSubsystem<UNetActorRegistry>() : nullptr;
+	if (Registry)
+	{
+		Registry->Unregister(ActorUID, this);
+		Registry->Register(NewUID, this);
+	}
+
+	ActorUID = NewUID;
+}
+
+void ASocketSampleCharacter::SetPooled(bool bInPooled)
+{
+	bPooled = bInPooled;
+
+	SetActorHiddenInGame(bInPooled);
+	SetActorEnableCollision(!bInPooled);
+	SetActorTickEnabled(!bInPooled);
+
+	if (USkeletalMeshComponent* MeshComponent = GetMesh())
+	{
+		MeshComponent->SetComponentTickEnabled(!bInPooled);
+	}
+
+	// Movement is only stopped here; whoever unparks the character decides whether it moves.
+	if (bInPooled)
+	{
+		if (UCharacterMovementComponent* Movement = GetCharacterMovement())
+		{
+			Movement->StopMovementImmediately();
+			Movement->Deactivate();
+		}
+	}
+}
+
 void ASocketSampleCharacter::TurnAtRate(float Rate)
 {
 	// calculate delta for this frame from the rate information
@@ -65,6 +65,8 @@ protected:
 
 	virtual void Tick(float DeltaSeconds) override;
 
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 
 protected:
 	// APawn interface
@@ -78,9 +80,21 @@ public:
 	FORCEINLINE class UCameraComponent* GetFollowCamera() const { return FollowCamera; }
 
 
+	/** Server id of this actor. Assign through SetActorUID so the world's UNetActorRegistry stays in sync. */
 	uint64_t ActorUID = 0;
 
-	float ElapsedTime = 0;
+	void SetActorUID(uint64_t NewUID);
+
+	/**
+	 * Parks or unparks a remote character for URemoteCharacterPool. A parked character is hidden
+	 * and has collision, actor and component ticks and movement disabled.
+	 */
+	void SetPooled(bool bInPooled);
+
+	bool IsPooled() const { return bPooled; }
+
+private:
+	bool bPooled = false;
 
 };
 
@@ -0,0 +1,168 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "ProjectM_generated.h"
+
+/** A remote actor the server has spawned that has no character yet. */
+struct FPendingSpawn
+{
+	uint64_t ActorId = 0;
+
+	/** Newest transform received for it, from the spawn or any sync that arrived since. */
+	ProjectM::Actor::Transform Transform;
+
+	double ReceiveTime = 0.0;
+};
+
+/**
+ * Spreads the characters of a large S2C_SpawnActors over several frames. Spawns are queued as
+ * they arrive and Drain creates as many as fit in a per-frame time budget, nearest to the local
+ * pawn first. Transforms received for an actor still in the queue replace its pending one, so it
+ * appears where it is rather than where it spawned.
+ * Engine-independent; the caller owns the clock and the actual spawning.
+ */
+class FSpawnQueue
+{
+public:
+	/** Queues ActorId, or refreshes its transform if it is already queued. */
+	void Push(uint64_t ActorId, const ProjectM::Actor::Transform& Transform, double ReceiveTime)
+	{
+		auto Found = Index.find(ActorId);
+		if (Found != Index.end())
+		{
+			Update(Pending[Found->second], Transform, ReceiveTime);
+			return;
+		}
+
+		Index.emplace(ActorId, Pending.size());
+		FPendingSpawn Spawn;
+		Spawn.ActorId = ActorId;
+		Spawn.Transform = Transform;
+		Spawn.ReceiveTime = ReceiveTime;
+		Pending.push_back(Spawn);
+	}
+
+	/** If ActorId is queued, keeps Transform as its pending one if it is newer and returns true. */
+	bool Update(uint64_t ActorId, const ProjectM::Actor::Transform& Transform, double ReceiveTime)
+	{
+		auto Found = Index.find(ActorId);
+		if (Found == Index.end())
+		{
+			return false;
+		}
+
+		Update(Pending[Found->second], Transform, ReceiveTime);
+		return true;
+	}
+
+	/** Forgets ActorId, e.g. when it is destroyed before its character was created. */
+	bool Remove(uint64_t ActorId)
+	{
+		auto Found = Index.find(ActorId);
+		if (Found == Index.end())
+		{
+			return false;
+		}
+
+		const size_t Slot = Found->second;
+		Index.erase(Found);
+		if (Slot + 1 < Pending.size())
+		{
+			Pending[Slot] = Pending.back();
+			Index[Pending[Slot].ActorId] = Slot;
+		}
+		Pending.pop_back();
+		return true;
+	}
+
+	bool Contains(uint64_t ActorId) const
+	{
+		return Index.find(ActorId) != Index.end();
+	}
+
+	size_t Num() const
+	{
+		return Pending.size();
+	}
+
+	void Reset()
+	{
+		Pending.clear();
+		Index.clear();
+	}
+
+	/**
+	 * Calls Spawn(const FPendingSpawn&) for queued actors, nearest to Origin first, until Clock()
+	 * has advanced BudgetSeconds past the start. At least one actor is spawned per call so the
+	 * queue always drains. Returns how many were spawned.
+	 */
+	template<typename ClockType, typename SpawnType>
+	size_t Drain(const float Origin[3], double BudgetSeconds, ClockType&& Clock, SpawnType&& Spawn)
+	{
+		if (Pending.empty())
+		{
+			return 0;
+		}
+
+		const double Start = Clock();
+
+		Order.clear();
+		for (size_t Slot = 0; Slot < Pending.size(); ++Slot)
+		{
+			const ProjectM::Actor::Vec3& Location = Pending[Slot].Transform.location();
+			const float DX = Location.x() - Origin[0];
+			const float DY = Location.y() - Origin[1];
+			const float DZ = Location.z() - Origin[2];
+			Order.emplace_back(DX * DX + DY * DY + DZ * DZ, Pending[Slot].ActorId);
+		}
+		std::sort(Order.begin(), Order.end());
+
+		size_t Spawned = 0;
+		for (const std::pair<float, uint64_t>& Entry : Order)
+		{
+			if (Spawned > 0 && Clock() - Start >= BudgetSeconds)
+			{
+				break;
+			}
+
+			// Copied out, since Spawn may call back into Push or Update.
+			auto Found = Index.find(Entry.second);
+			if (Found == Index.end())
+			{
+				continue;
+			}
+			const FPendingSpawn Next = Pending[Found->second];
+			Remove(Entry.second);
+
+			Spawn(Next);
+			++Spawned;
+		}
+		return Spawned;
+	}
+
+private:
+	static void Update(FPendingSpawn& Spawn, const ProjectM::Actor::Transform& Transform, double ReceiveTime)
+	{
+		if (ReceiveTime >= Spawn.ReceiveTime)
+		{
+			Spawn.Transform = Transform;
+			Spawn.ReceiveTime = ReceiveTime;
+		}
+	}
+
+	std::vector<FPendingSpawn> Pending;
+
+	/** ActorId to its position in Pending. */
+	std::unordered_map<uint64_t, size_t> Index;
+
+	/** Scratch for Drain: squared distance and ActorId. */
+	std::vector<std::pair<float, uint64_t>> Order;
+};
@@ -0,0 +1,533 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+#include "ProjectM_generated.h"
+
+/**
+ * Compact encoding for ProjectM::Actor::Transform, used by S2C_CompactSnapshot.
+ *
+ * A raw Transform is 36 bytes. This codec sends:
+ *  - location as fixed point (1/LocationScale cm) inside +-LocationBound,
+ *  - rotation as a smallest-three packed quaternion in 32 bits,
+ *  - scale as a single bit when it is (1,1,1),
+ * and, when both sides share a baseline for the actor, only the fields that changed since it,
+ * with location deltas in the smallest of a few bit widths.
+ *
+ * Engine-independent so the server side can share it. The Euler <-> quaternion conversions
+ * follow FRotator::Quaternion and FQuat::Rotator so the result matches what the client applies.
+ */
+
+/** Little-endian bit packer over a growable byte vector. */
+class FBitWriter
+{
+public:
+	explicit FBitWriter(std::vector<uint8_t>& InBytes)
+		: Bytes(InBytes)
+	{
+	}
+
+	~FBitWriter()
+	{
+		Flush();
+	}
+
+	void Write(uint32_t Value, uint32_t NumBits)
+	{
+		Accumulator |= static_cast<uint64_t>(Value & Mask(NumBits)) << NumPending;
+		NumPending += NumBits;
+		while (NumPending >= 8)
+		{
+			Bytes.push_back(static_cast<uint8_t>(Accumulator));
+			Accumulator >>= 8;
+			NumPending -= 8;
+		}
+	}
+
+	void WriteBit(bool bValue)
+	{
+		Write(bValue ? 1 : 0, 1);
+	}
+
+	/** Pads the last partial byte with zero bits. */
+	void Flush()
+	{
+		if (NumPending > 0)
+		{
+			Bytes.push_back(static_cast<uint8_t>(Accumulator));
+			Accumulator = 0;
+			NumPending = 0;
+		}
+	}
+
+	static uint32_t Mask(uint32_t NumBits)
+	{
+		return NumBits >= 32 ? 0xFFFFFFFFu : ((1u << NumBits) - 1);
+	}
+
+private:
+	std::vector<uint8_t>& Bytes;
+
+	uint64_t Accumulator = 0;
+
+	uint32_t NumPending = 0;
+};
+
+class FBitReader
+{
+public:
+	FBitReader(const uint8_t* InData, size_t InSize)
+		: Data(InData)
+		, Size(InSize)
+	{
+	}
+
+	uint32_t Read(uint32_t NumBits)
+	{
+		while (NumPending < NumBits)
+		{
+			if (Offset >= Size)
+			{
+				bOverflow = true;
+				return 0;
+			}
+			Accumulator |= static_cast<uint64_t>(Data[Offset++]) << NumPending;
+			NumPending += 8;
+		}
+
+		const uint32_t Value = static_cast<uint32_t>(Accumulator) & FBitWriter::Mask(NumBits);
+		Accumulator >>= NumBits;
+		NumPending -= NumBits;
+		return Value;
+	}
+
+	bool ReadBit()
+	{
+		return Read(1) != 0;
+	}
+
+	/** Set if a read ran past the end of the data. */
+	bool IsOverflowed() const
+	{
+		return bOverflow;
+	}
+
+private:
+	const uint8_t* Data;
+
+	size_t Size;
+
+	size_t Offset = 0;
+
+	uint64_t Accumulator = 0;
+
+	uint32_t NumPending = 0;
+
+	bool bOverflow = false;
+};
+
+/** A Transform after quantisation. Two equal FQuantizedTransforms decode to identical Transforms. */
+struct FQuantizedTransform
+{
+	int32_t Location[3] = { 0, 0, 0 };
+
+	uint32_t Rotation = 0;
+
+	bool bUnitScale = true;
+
+	float Scale[3] = { 1.f, 1.f, 1.f };
+
+	bool operator==(const FQuantizedTransform& Other) const
+	{
+		return Location[0] == Other.Location[0] && Location[1] == Other.Location[1] && Location[2] == Other.Location[2]
+			&& Rotation == Other.Rotation && HasSameScale(Other);
+	}
+
+	bool HasSameScale(const FQuantizedTransform& Other) const
+	{
+		return bUnitScale == Other.bUnitScale && (bUnitScale || memcmp(Scale, Other.Scale, sizeof(Scale)) == 0);
+	}
+};
+
+namespace TransformCodec
+{
+	/** Fixed-point steps per world unit (cm). */
+	const float LocationScale = 8.f;
+
+	/** Locations are clamped to +-LocationBound on every axis. */
+	const float LocationBound = 1048576.f;
+
+	/** Bits for an absolute location axis: LocationBound * LocationScale = 2^23, plus sign. */
+	const uint32_t LocationBits = 24;
+
+	/** Widths tried for a zigzagged location delta, selected by a 2-bit prefix. */
+	const uint32_t DeltaBits[4] = { 4, 8, 14, 25 };
+
+	const uint32_t QuatComponentBits = 10;
+
+	const float Pi = 3.14159265358979323846f;
+
+	inline int32_t QuantizeLocation(float Value)
+	{
+		const float Clamped = Value < -LocationBound ? -LocationBound : (Value > LocationBound ? LocationBound : Value);
+		const int32_t Max = (1 << (LocationBits - 1)) - 1;
+		const int32_t Quantized = static_cast<int32_t>(std::lround(Clamped * LocationScale));
+		return Quantized > Max ? Max : (Quantized < -Max ? -Max : Quantized);
+	}
+
+	inline float DequantizeLocation(int32_t Value)
+	{
+		return static_cast<float>(Value) / LocationScale;
+	}
+
+	inline uint32_t ZigZag(int32_t Value)
+	{
+		return (static_cast<uint32_t>(Value) << 1) ^ static_cast<uint32_t>(Value >> 31);
+	}
+
+	inline int32_t UnZigZag(uint32_t Value)
+	{
+		return static_cast<int32_t>(Value >> 1) ^ -static_cast<int32_t>(Value & 1);
+	}
+
+	/** Pitch/Yaw/Roll in degrees to (X, Y, Z, W), as FRotator::Quaternion. */
+	inline void EulerToQuat(float Pitch, float Yaw, float Roll, float Out[4])
+	{
+		const float HalfDegToRad = Pi / 360.f;
+		const float SP = std::sin(Pitch * HalfDegToRad), CP = std::cos(Pitch * HalfDegToRad);
+		const float SY = std::sin(Yaw * HalfDegToRad), CY = std::cos(Yaw * HalfDegToRad);
+		const float SR = std::sin(Roll * HalfDegToRad), CR = std::cos(Roll * HalfDegToRad);
+
+		Out[0] = CR * SP * SY - SR * CP * CY;
+		Out[1] = -CR * SP * CY - SR * CP * SY;
+		Out[2] = CR * CP * SY - SR * SP * CY;
+		Out[3] = CR * CP * CY + SR * SP * SY;
+	}
+
+	inline float NormalizeAxis(float Angle)
+	{
+		Angle = std::fmod(Angle, 360.f);
+		if (Angle < 0.f)
+		{
+			Angle += 360.f;
+		}
+		return Angle > 180.f ? Angle - 360.f : Angle;
+	}
+
+	/** (X, Y, Z, W) to Pitch/Yaw/Roll in degrees, as FQuat::Rotator. */
+	inline void QuatToEuler(const float Q[4], float& OutPitch, float& OutYaw, float& OutRoll)
+	{
+		const float X = Q[0], Y = Q[1], Z = Q[2], W = Q[3];
+		const float RadToDeg = 180.f / Pi;
+		const float SingularityTest = Z * X - W * Y;
+		const float YawY = 2.f * (W * Z + X * Y);
+		const float YawX = 1.f - 2.f * (Y * Y + Z * Z);
+		const float SingularityThreshold = 0.4999995f;
+
+		OutYaw = std::atan2(YawY, YawX) * RadToDeg;
+		if (SingularityTest < -SingularityThreshold)
+		{
+			OutPitch = -90.f;
+			OutRoll = NormalizeAxis(-OutYaw - 2.f * std::atan2(X, W) * RadToDeg);
+		}
+		else if (SingularityTest > SingularityThreshold)
+		{
+			OutPitch = 90.f;
+			OutRoll = NormalizeAxis(OutYaw - 2.f * std::atan2(X, W) * RadToDeg);
+		}
+		else
+		{
+			OutPitch = std::asin(2.f * SingularityTest) * RadToDeg;
+			OutRoll = std::atan2(-2.f * (W * X + Y * Z), 1.f - 2.f * (X * X + Y * Y)) * RadToDeg;
+		}
+	}
+
+	/** Smallest-three: index of the largest component in 2 bits, the other three in QuatComponentBits each. */
+	inline uint32_t PackQuat(const float InQ[4])
+	{
+		float Q[4] = { InQ[0], InQ[1], InQ[2], InQ[3] };
+		const float Length = std::sqrt(Q[0] * Q[0] + Q[1] * Q[1] + Q[2] * Q[2] + Q[3] * Q[3]);
+		if (Length <= 0.f)
+		{
+			return 3u << 30;
+		}
+
+		uint32_t Largest = 0;
+		for (uint32_t i = 0; i < 4; ++i)
+		{
+			Q[i] /= Length;
+			if (std::fabs(Q[i]) > std::fabs(Q[Largest]))
+			{
+				Largest = i;
+			}
+		}
+
+		// q and -q are the same rotation; make the dropped component positive so it can be rebuilt.
+		const float Sign = Q[Largest] < 0.f ? -1.f : 1.f;
+		const float Range = 1.f / std::sqrt(2.f);
+		const uint32_t MaxValue = (1u << QuatComponentBits) - 1;
+
+		uint32_t Packed = Largest;
+		for (uint32_t i = 0; i < 4; ++i)
+		{
+			if (i == Largest)
+			{
+				continue;
+			}
+			float Normalized = (Q[i] * Sign + Range) / (2.f * Range);
+			Normalized = Normalized < 0.f ? 0.f : (Normalized > 1.f ? 1.f : Normalized);
+			Packed = (Packed << QuatComponentBits) | static_cast<uint32_t>(std::lround(Normalized * MaxValue));
+		}
+		return Packed;
+	}
+
+	inline void UnpackQuat(uint32_t Packed, float Out[4])
+	{
+		const float Range = 1.f / std::sqrt(2.f);
+		const uint32_t MaxValue = (1u << QuatComponentBits) - 1;
+		const uint32_t Largest = Packed >> (3 * QuatComponentBits);
+
+		float SumSquares = 0.f;
+		for (int32_t i = 3, Shift = 0; i >= 0; --i)
+		{
+			if (static_cast<uint32_t>(i) == Largest)
+			{
+				continue;
+			}
+			const uint32_t Bits = (Packed >> Shift) & MaxValue;
+			Out[i] = (static_cast<float>(Bits) / MaxValue) * (2.f * Range) - Range;
+			SumSquares += Out[i] * Out[i];
+			Shift += QuatComponentBits;
+		}
+		Out[Largest] = std::sqrt(SumSquares < 1.f ? 1.f - SumSquares : 0.f);
+	}
+
+	inline FQuantizedTransform Quantize(const ProjectM::Actor::Transform& Transform)
+	{
+		FQuantizedTransform Out;
+		Out.Location[0] = QuantizeLocation(Transform.location().x());
+		Out.Location[1] = QuantizeLocation(Transform.location().y());
+		Out.Location[2] = QuantizeLocation(Transform.location().z());
+
+		float Q[4];
+		EulerToQuat(Transform.rotation().x(), Transform.rotation().y(), Transform.rotation().z(), Q);
+		Out.Rotation = PackQuat(Q);
+
+		Out.Scale[0] = Transform.scale().x();
+		Out.Scale[1] = Transform.scale().y();
+		Out.Scale[2] = Transform.scale().z();
+		Out.bUnitScale = Out.Scale[0] == 1.f && Out.Scale[1] == 1.f && Out.Scale[2] == 1.f;
+		return Out;
+	}
+
+	inline ProjectM::Actor::Transform Dequantize(const FQuantizedTransform& In)
+	{
+		float Q[4];
+		UnpackQuat(In.Rotation, Q);
+		float Pitch, Yaw, Roll;
+		QuatToEuler(Q, Pitch, Yaw, Roll);
+
+		return ProjectM::Actor::Transform(
+			ProjectM::Actor::Vec3(DequantizeLocation(In.Location[0]), DequantizeLocation(In.Location[1]), DequantizeLocation(In.Location[2])),
+			ProjectM::Actor::Vec3(Pitch, Yaw, Roll),
+			In.bUnitScale ? ProjectM::Actor::Vec3(1.f, 1.f, 1.f) : ProjectM::Actor::Vec3(In.Scale[0], In.Scale[1], In.Scale[2]));
+	}
+
+	inline void WriteFloat(FBitWriter& Writer, float Value)
+	{
+		uint32_t Bits;
+		memcpy(&Bits, &Value, sizeof(Bits));
+		Writer.Write(Bits, 32);
+	}
+
+	inline float ReadFloat(FBitReader& Reader)
+	{
+		const uint32_t Bits = Reader.Read(32);
+		float Value;
+		memcpy(&Value, &Bits, sizeof(Value));
+		return Value;
+	}
+
+	/**
+	 * Writes Value, as a delta against Baseline when one is given. The reader must be handed the
+	 * same baseline, which is why only acknowledged states are used as baselines.
+	 */
+	inline void Encode(FBitWriter& Writer, const FQuantizedTransform& Value, const FQuantizedTransform* Baseline)
+	{
+		Writer.WriteBit(Baseline != nullptr);
+
+		if (Baseline)
+		{
+			const bool bMoved = Value.Location[0] != Baseline->Location[0] || Value.Location[1] != Baseline->Location[1] || Value.Location[2] != Baseline->Location[2];
+			Writer.WriteBit(bMoved);
+			if (bMoved)
+			{
+				for (int32_t Axis = 0; Axis < 3; ++Axis)
+				{
+					const uint32_t Delta = ZigZag(Value.Location[Axis] - Baseline->Location[Axis]);
+					uint32_t Class = 0;
+					while (Class < 3 && Delta > FBitWriter::Mask(DeltaBits[Class]))
+					{
+						++Class;
+					}
+					Writer.Write(Class, 2);
+					Writer.Write(Delta, DeltaBits[Class]);
+				}
+			}
+		}
+		else
+		{
+			for (int32_t Axis = 0; Axis < 3; ++Axis)
+			{
+				Writer.Write(static_cast<uint32_t>(Value.Location[Axis]), LocationBits);
+			}
+		}
+
+		const bool bRotated = Baseline == nullptr || Value.Rotation != Baseline->Rotation;
+		if (Baseline)
+		{
+			Writer.WriteBit(bRotated);
+		}
+		if (bRotated)
+		{
+			Writer.Write(Value.Rotation, 32);
+		}
+
+		Writer.WriteBit(Value.bUnitScale);
+		if (!Value.bUnitScale)
+		{
+			const bool bScaled = Baseline == nullptr || !Value.HasSameScale(*Baseline);
+			if (Baseline)
+			{
+				Writer.WriteBit(bScaled);
+			}
+			if (bScaled)
+			{
+				WriteFloat(Writer, Value.Scale[0]);
+				WriteFloat(Writer, Value.Scale[1]);
+				WriteFloat(Writer, Value.Scale[2]);
+			}
+		}
+	}
+
+	/**
+	 * Reads a transform written by Encode. Baseline is only used when the writer used one; returns
+	 * false if the writer used a baseline and none was given, or if the data is truncated.
+	 */
+	inline bool Decode(FBitReader& Reader, FQuantizedTransform& Out, const FQuantizedTransform* Baseline)
+	{
+		const bool bHasBaseline = Reader.ReadBit();
+		if (bHasBaseline && Baseline == nullptr)
+		{
+			return false;
+		}
+
+		if (bHasBaseline)
+		{
+			Out = *Baseline;
+			if (Reader.ReadBit())
+			{
+				for (int32_t Axis = 0; Axis < 3; ++Axis)
+				{
+					const uint32_t Class = Reader.Read(2);
+					Out.Location[Axis] = Baseline->Location[Axis] + UnZigZag(Reader.Read(DeltaBits[Class]));
+				}
+			}
+		}
+		else
+		{
+			for (int32_t Axis = 0; Axis < 3; ++Axis)
+			{
+				// Sign-extend the LocationBits-wide field.
+				const uint32_t Raw = Reader.Read(LocationBits) << (32 - LocationBits);
+				Out.Location[Axis] = static_cast<int32_t>(Raw) >> (32 - LocationBits);
+			}
+		}
+
+		if (!bHasBaseline || Reader.ReadBit())
+		{
+			Out.Rotation = Reader.Read(32);
+		}
+
+		Out.bUnitScale = Reader.ReadBit();
+		if (Out.bUnitScale)
+		{
+			Out.Scale[0] = Out.Scale[1] = Out.Scale[2] = 1.f;
+		}
+		else if (!bHasBaseline || Reader.ReadBit())
+		{
+			Out.Scale[0] = ReadFloat(Reader);
+			Out.Scale[1] = ReadFloat(Reader);
+			Out.Scale[2] = ReadFloat(Reader);
+		}
+
+		return !Reader.IsOverflowed();
+	}
+}
+
+/**
+ * Recent quantised states per actor, keyed by server tick. Both ends keep one: the server records
+ * what it sent to a client, the client records what it decoded, and a snapshot's baseline_tick
+ * (the last tick the client acknowledged) selects the shared baseline for each actor.
+ */
+class FTransformBaselineHistory
+{
+public:
+	/** Ticks kept per actor. A baseline older than this is unusable and the actor is sent in full. */
+	static const uint32_t HistorySize = 32;
+
+	void Record(uint64_t ActorId, uint32_t Tick, const FQuantizedTransform& State)
+	{
+		FActorHistory& History = Actors[ActorId];
+		FEntry& Entry = History.Entries[Tick % HistorySize];
+		Entry.Tick = Tick;
+		Entry.bValid = true;
+		Entry.State = State;
+	}
+
+	const FQuantizedTransform* Find(uint64_t ActorId, uint32_t Tick) const
+	{
+		const auto Found = Actors.find(ActorId);
+		if (Found == Actors.end())
+		{
+			return nullptr;
+		}
+
+		const FEntry& Entry = Found->second.Entries[Tick % HistorySize];
+		return Entry.bValid && Entry.Tick == Tick ? &Entry.State : nullptr;
+	}
+
+	void Remove(uint64_t ActorId)
+	{
+		Actors.erase(ActorId);
+	}
+
+	void Reset()
+	{
+		Actors.clear();
+	}
+
+private:
+	struct FEntry
+	{
+		uint32_t Tick = 0;
+
+		bool bValid = false;
+
+		FQuantizedTransform State;
+	};
+
+	struct FActorHistory
+	{
+		FEntry Entries[HistorySize];
+	};
+
+	std::unordered_map<uint64_t, FActorHistory> Actors;
+};
@@ -1154,10 +1154,14 @@ class FlatBufferBuilder {
   /// minimum alignment upon reallocation. Only needed if you intend to store
   /// types with custom alignment AND you wish to read the buffer in-place
   /// directly after creation.
+  /// @param[in] hash_string_pool Keep the strings of CreateSharedString in a
+  /// hash table rather than a `std::set`, which is faster when many strings are
+  /// shared. The buffer built is the same either way.
   explicit FlatBufferBuilder(
       size_t initial_size = 1024, Allocator *allocator = nullptr,
       bool own_allocator = false,
-      size_t buffer_minalign = AlignOf<largest_scalar_t>())
+      size_t buffer_minalign = AlignOf<largest_scalar_t>(),
+      bool hash_string_pool = false)
       : buf_(initial_size, allocator, own_allocator, buffer_minalign),
         num_field_loc(0),
         max_voffset_(0),
@@ -1166,6 +1170,8 @@ class FlatBufferBuilder {
         minalign_(1),
         force_defaults_(false),
         dedup_vtables_(true),
+        index_vtables_(false),
+        hash_string_pool_(hash_string_pool),
         string_pool(nullptr) {
     EndianCheck();
   }
@@ -1185,6 +1191,8 @@ class FlatBufferBuilder {
       minalign_(1),
       force_defaults_(false),
       dedup_vtables_(true),
+      index_vtables_(false),
+      hash_string_pool_(false),
       string_pool(nullptr) {
     EndianCheck();
     // Default construct and swap idiom.
@@ -1217,6 +1225,10 @@ class FlatBufferBuilder {
     swap(minalign_, other.minalign_);
     swap(force_defaults_, other.force_defaults_);
     swap(dedup_vtables_, other.dedup_vtables_);
+    swap(index_vtables_, other.index_vtables_);
+    vtable_index_.Swap(other.vtable_index_);
+    swap(hash_string_pool_, other.hash_string_pool_);
+    string_hash_pool_.Swap(other.string_hash_pool_);
     swap(string_pool, other.string_pool);
   }
 
@@ -1237,6 +1249,8 @@ class FlatBufferBuilder {
     nested = false;
     finished = false;
     minalign_ = 1;
+    vtable_index_.Clear();
+    string_hash_pool_.Clear();
     if (string_pool) string_pool->clear();
   }
 
@@ -1327,6 +1341,24 @@ class FlatBufferBuilder {
   /// @param[in] dedup When set to `true`, dedup vtables.
   void DedupVtables(bool dedup) { dedup_vtables_ = dedup; }
 
+  /// @brief By default a new vtable is compared against every vtable written
+  /// so far, which gets slow for buffers holding many different tables.
+  /// @param[in] index When set to `true`, keep a hash index of the vtables
+  /// instead, so finding a duplicate takes constant time. The buffer built is
+  /// the same either way.
+  void IndexVtables(bool index) {
+    index_vtables_ = index;
+    vtable_index_.Clear();
+    if (!index) return;
+    // Index the vtables already written, so it can be switched on at any time.
+    auto vt_bytes = buf_.scratch_size() - num_field_loc * sizeof(FieldLoc);
+    for (size_t i = 0; i < vt_bytes; i += sizeof(uoffset_t)) {
+      auto vt_offset = *reinterpret_cast<uoffset_t *>(buf_.scratch_data() + i);
+      auto vt = reinterpret_cast<voffset_t *>(buf_.data_at(vt_offset));
+      vtable_index_.Insert(HashBytes(vt, ReadScalar<voffset_t>(vt)), vt_offset);
+    }
+  }
+
   /// @cond FLATBUFFERS_INTERNAL
   void Pad(size_t num_bytes) { buf_.fill(num_bytes); }
 
@@ -1478,7 +1510,20 @@ class FlatBufferBuilder {
     auto vt_use = GetSize();
     // See if we already have generated a vtable with this exact same
     // layout before. If so, make it point to the old one, remove this one.
-    if (dedup_vtables_) {
+    if (dedup_vtables_ && index_vtables_) {
+      auto vt_hash = HashBytes(vt1, vt1_size);
+      auto vt_found = vtable_index_.Find(vt_hash, [&](uoffset_t vt_offset) {
+        auto vt2 = reinterpret_cast<voffset_t *>(buf_.data_at(vt_offset));
+        return ReadScalar<voffset_t>(vt2) == vt1_size &&
+               0 == memcmp(vt2, vt1, vt1_size);
+      });
+      if (vt_found) {
+        vt_use = vt_found;
+        buf_.pop(GetSize() - vtableoffsetloc);
+      } else {
+        vtable_index_.Insert(vt_hash, vt_use);
+      }
+    } else if (dedup_vtables_) {
       for (auto it = buf_.scratch_data(); it < buf_.scratch_end();
            it += sizeof(uoffset_t)) {
         auto vt_offset_ptr = reinterpret_cast<uoffset_t *>(it);
@@ -1606,6 +1651,18 @@ class FlatBufferBuilder {
   /// @param[in] len The number of bytes that should be stored from `str`.
   /// @return Returns the offset in the buffer where the string starts.
   Offset<String> CreateSharedString(const char *str, size_t len) {
+    if (hash_string_pool_) {
+      // Looked up before serializing, since the hash is of the input.
+      auto hash = HashBytes(str, len);
+      auto found = string_hash_pool_.Find(hash, [&](uoffset_t offset) {
+        auto existing = reinterpret_cast<const String *>(buf_.data_at(offset));
+        return existing->size() == len && 0 == memcmp(existing->data(), str, len);
+      });
+      if (found) return Offset<String>(found);
+      auto off = CreateString(str, len);
+      string_hash_pool_.Insert(hash, off.o);
+      return off;
+    }
     if (!string_pool)
       string_pool = new StringOffsetMap(StringOffsetCompare(buf_));
     auto size_before_string = buf_.size();
@@ -2141,6 +2198,7 @@ class FlatBufferBuilder {
   void Finish(uoffset_t root, const char *file_identifier, bool size_prefix) {
     NotNested();
     buf_.clear_scratch();
+    vtable_index_.Clear();
     // This will cause the whole buffer to be aligned.
     PreAlign((size_prefix ? sizeof(uoffset_t) : 0) + sizeof(uoffset_t) +
                  (file_identifier ? kFileIdentifierLength : 0),
@@ -2181,6 +2239,97 @@ class FlatBufferBuilder {
 
   bool dedup_vtables_;
 
+  // Open-addressing hash index of offsets into the buffer, with each entry's
+  // hash cached next to it: a slot holds the hash in the high and the offset in
+  // the low 32 bits, and 0 is an empty slot, since nothing is stored at offset
+  // 0. Kept at most half full. Finding an entry is one probe sequence with no
+  // allocation, and only entries with an equal hash are compared.
+  class OffsetIndex {
+   public:
+    OffsetIndex() : count_(0) {}
+
+    // Returns the first offset stored under `hash` for which `matches` is
+    // true, or 0.
+    template<typename F> uoffset_t Find(uint32_t hash, F matches) const {
+      if (!count_) return 0;
+      auto mask = slots_.size() - 1;
+      for (auto i = hash & mask;; i = (i + 1) & mask) {
+        auto slot = slots_[i];
+        if (!slot) return 0;
+        if (static_cast<uint32_t>(slot >> 32) != hash) continue;
+        auto offset = static_cast<uoffset_t>(slot);
+        if (matches(offset)) return offset;
+      }
+    }
+
+    void Insert(uint32_t hash, uoffset_t offset) {
+      if ((count_ + 1) * 2 > slots_.size()) {
+        std::vector<uint64_t> old;
+        old.swap(slots_);
+        slots_.resize((std::max)(old.size() * 2, static_cast<size_t>(64)));
+        for (auto slot : old) {
+          if (slot) Place(slot);
+        }
+      }
+      Place((static_cast<uint64_t>(hash) << 32) | offset);
+      count_++;
+    }
+
+    void Clear() {
+      if (count_) {
+        std::fill(slots_.begin(), slots_.end(), 0);
+        count_ = 0;
+      }
+    }
+
+    void Swap(OffsetIndex &other) {
+      slots_.swap(other.slots_);
+      std::swap(count_, other.count_);
+    }
+
+   private:
+    void Place(uint64_t slot) {
+      auto mask = slots_.size() - 1;
+      auto i = static_cast<uint32_t>(slot >> 32) & mask;
+      while (slots_[i]) i = (i + 1) & mask;
+      slots_[i] = slot;
+    }
+
+    std::vector<uint64_t> slots_;
+    size_t count_;
+  };
+
+  // Hash for OffsetIndex, 8 bytes at a time. Only ever compared within one
+  // process, so it may depend on the platform's byte order.
+  static uint32_t HashBytes(const void *data, size_t len) {
+    auto bytes = static_cast<const uint8_t *>(data);
+    uint64_t hash = 0xcbf29ce484222645ULL ^ len;
+    uint64_t word;
+    for (; len >= sizeof(word); bytes += sizeof(word), len -= sizeof(word)) {
+      memcpy(&word, bytes, sizeof(word));
+      hash = (hash ^ word) * 0x00000100000001b3ULL;
+      hash ^= hash >> 29;
+    }
+    if (len) {
+      word = 0;
+      memcpy(&word, bytes, len);
+      hash = (hash ^ word) * 0x00000100000001b3ULL;
+    }
+    hash ^= hash >> 32;
+    hash *= 0x9E3779B97F4A7C15ULL;
+    return static_cast<uint32_t>(hash >> 32);
+  }
+
+  // Index of the vtables in the scratch area, used by EndTable after
+  // IndexVtables(true).
+  bool index_vtables_;
+  OffsetIndex vtable_index_;
+
+  // Used by CreateSharedString instead of string_pool if the builder was
+  // constructed with hash_string_pool.
+  bool hash_string_pool_;
+  OffsetIndex string_hash_pool_;
+
   struct StringOffsetCompare {
     StringOffsetCompare(const vector_downward &buf) : buf_(&buf) {}
     bool operator()(const Offset<String> &a, const Offset<String> &b) const {